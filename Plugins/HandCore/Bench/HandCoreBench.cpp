@@ -0,0 +1,189 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+// HandCoreBench [frames] [iterations]
+//
+// Runs the HandCore kernels over fixed, seeded datasets and prints the time
+// per frame of each. The datasets are the same on every run and machine, so
+// numbers from two builds can be compared directly.
+
+#include "HandCoreAhrs.h"
+#include "HandCoreJoints.h"
+#include "HandCoreText.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Calibration the glove ships with, in raw sensor units.
+const float DefaultMin[HandCore::NumJointSensors] = {
+    1814, 1638, 1123, 1017, 955, 872, 1232, 1041, 1369, 1003};
+const float DefaultMax[HandCore::NumJointSensors] = {
+    2200, 1946, 1237, 1227, 1191, 1076, 1457, 1335, 1539, 1259};
+
+// Small deterministic generator so datasets do not depend on the C library.
+class FRandom {
+ public:
+  explicit FRandom(uint32_t seed) : State(seed) {}
+
+  float Next(float min, float max) {
+    State = State * 1664525u + 1013904223u;
+    return min + (max - min) * (float)(State >> 8) / (float)(1u << 24);
+  }
+
+ private:
+  uint32_t State;
+};
+
+std::vector<float> MakeSensorFrames(int frames) {
+  FRandom random(1);
+  std::vector<float> data(frames * HandCore::NumJointSensors);
+  for (int f = 0; f < frames; ++f) {
+    for (int s = 0; s < HandCore::NumJointSensors; ++s) {
+      // Slightly beyond the calibrated range, like a real glove.
+      data[f * HandCore::NumJointSensors + s] =
+          random.Next(DefaultMin[s] - 20.0f, DefaultMax[s] + 20.0f);
+    }
+  }
+  return data;
+}
+
+std::vector<std::string> MakeLandmarkFrames(int frames) {
+  FRandom random(2);
+  std::vector<std::string> data(frames);
+  float values[HandCore::NumLandmarks * 3];
+  char text[HandCore::NumLandmarks * 3 * 16];
+  for (int f = 0; f < frames; ++f) {
+    for (float &value : values) {
+      value = random.Next(-1.0f, 1.0f);
+    }
+    const int length = HandCore::FormatFloatList(
+        values, HandCore::NumLandmarks * 3, text, (int)sizeof(text));
+    data[f].assign(text, length > 0 ? length - 1 : 0);
+  }
+  return data;
+}
+
+// Gyroscope (rad/s), accelerometer (g) and magnetometer (uT) samples of a
+// slowly turning, slightly shaking glove.
+std::vector<float> MakeImuSamples(int frames) {
+  FRandom random(3);
+  std::vector<float> data(frames * 9);
+  for (int f = 0; f < frames; ++f) {
+    float *sample = &data[f * 9];
+    for (int i = 0; i < 3; ++i) {
+      sample[i] = random.Next(-0.5f, 0.5f);
+      sample[3 + i] = random.Next(-0.05f, 0.05f);
+      sample[6 + i] = random.Next(-2.0f, 2.0f);
+    }
+    sample[5] += 1.0f;
+    sample[6] += 20.0f;
+    sample[8] -= 40.0f;
+  }
+  return data;
+}
+
+template <typename F>
+double NanosecondsPerFrame(int frames, int iterations, F &&run) {
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    run();
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::nano>(elapsed).count() /
+         ((double)frames * iterations);
+}
+
+// Keeps results alive so the optimizer cannot drop the work.
+volatile float Sink;
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  const int frames = argc > 1 ? std::max(1, atoi(argv[1])) : 10000;
+  const int iterations = argc > 2 ? std::max(1, atoi(argv[2])) : 20;
+
+  const std::vector<float> sensors = MakeSensorFrames(frames);
+  const std::vector<std::string> landmarks = MakeLandmarkFrames(frames);
+  const std::vector<float> imu = MakeImuSamples(frames);
+
+  const double joints = NanosecondsPerFrame(frames, iterations, [&]() {
+    float previous[HandCore::NumJointSensors] = {};
+    float values[HandCore::NumJointSensors];
+    float ratios[HandCore::NumJointRatios];
+    for (int f = 0; f < frames; ++f) {
+      HandCore::Calibrate(&sensors[f * HandCore::NumJointSensors],
+                          DefaultMin, DefaultMax, HandCore::NumJointSensors,
+                          values);
+      HandCore::ApplyHysteresis(values, previous, HandCore::NumJointSensors,
+                                0.04f);
+      HandCore::ExpandJointRatios(values, HandCore::NumJointSensors, ratios,
+                                  HandCore::NumJointRatios);
+      Sink = ratios[HandCore::NumJointRatios - 1];
+    }
+  });
+
+  const double parse = NanosecondsPerFrame(frames, iterations, [&]() {
+    float values[HandCore::NumLandmarks * 3];
+    for (const std::string &frame : landmarks) {
+      HandCore::ParseFloatList(frame.data(), frame.size(), values,
+                               HandCore::NumLandmarks * 3);
+      Sink = values[0];
+    }
+  });
+
+  std::vector<float> parsed(frames * HandCore::NumLandmarks * 3);
+  for (int f = 0; f < frames; ++f) {
+    HandCore::ParseFloatList(landmarks[f].data(), landmarks[f].size(),
+                             &parsed[f * HandCore::NumLandmarks * 3],
+                             HandCore::NumLandmarks * 3);
+  }
+
+  const double format = NanosecondsPerFrame(frames, iterations, [&]() {
+    char text[HandCore::NumLandmarks * 3 * 16];
+    for (int f = 0; f < frames; ++f) {
+      HandCore::FormatFloatList(&parsed[f * HandCore::NumLandmarks * 3],
+                                HandCore::NumLandmarks * 3, text,
+                                (int)sizeof(text));
+      Sink = text[0];
+    }
+  });
+
+  // One sample per frame at the glove's 400 Hz.
+  const float dt = 1.0f / 400.0f;
+
+  const double madgwick = NanosecondsPerFrame(frames, iterations, [&]() {
+    HandCore::AhrsState state;
+    for (int f = 0; f < frames; ++f) {
+      const float *sample = &imu[f * 9];
+      HandCore::MadgwickUpdate(state, sample, sample + 3, sample + 6, dt,
+                               HandCore::MadgwickDefaultBeta);
+    }
+    Sink = state.q[0];
+  });
+
+  const double mahony = NanosecondsPerFrame(frames, iterations, [&]() {
+    HandCore::AhrsState state;
+    for (int f = 0; f < frames; ++f) {
+      const float *sample = &imu[f * 9];
+      HandCore::MahonyUpdate(state, sample, sample + 3, sample + 6, dt,
+                             HandCore::MahonyDefaultKp, 0.1f);
+    }
+    Sink = state.q[0];
+  });
+
+  printf("HandCoreBench: %d frames x %d iterations\n", frames, iterations);
+  printf("  joints (calibrate, hysteresis, expand): %8.1f ns/frame\n", joints);
+  printf("  landmarks parse (63 floats):           %8.1f ns/frame\n", parse);
+  printf("  landmarks format (63 floats):          %8.1f ns/frame\n", format);
+  printf("  ahrs madgwick (gyro, accel, mag):       %8.1f ns/frame\n",
+         madgwick);
+  printf("  ahrs mahony (gyro, accel, mag):         %8.1f ns/frame\n", mahony);
+
+  return 0;
+}
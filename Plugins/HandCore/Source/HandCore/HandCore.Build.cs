@@ -0,0 +1,18 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+using System.IO;
+using UnrealBuildTool;
+
+public class HandCore : ModuleRules
+{
+    public HandCore(ReadOnlyTargetRules Target) : base(Target)
+    {
+        PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+
+        PublicIncludePaths.Add(Path.Combine(ModuleDirectory, "Public"));
+
+        // Only the module boilerplate uses Core; the kernels are plain C++ and
+        // are also built by the CMakeLists.txt next to the plugin.
+        PublicDependencyModuleNames.Add("Core");
+    }
+}
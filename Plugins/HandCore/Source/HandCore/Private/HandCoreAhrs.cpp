@@ -0,0 +1,216 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#include "HandCoreAhrs.h"
+
+#include <cmath>
+
+// Both filters follow the reference implementations of Madgwick, "An
+// efficient orientation filter for inertial and inertial/magnetic sensor
+// arrays" (2010), and of Mahony et al., "Nonlinear complementary filters on
+// the special orthogonal group" (2008).
+
+namespace HandCore {
+
+namespace {
+
+bool IsZero(const float *v) {
+  return v == nullptr || (v[0] == 0.0f && v[1] == 0.0f && v[2] == 0.0f);
+}
+
+/** Normalize v into out; false if v has no direction. */
+bool Normalize3(const float *v, float *out) {
+  const float norm = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+  if (!(norm > 0.0f)) {
+    return false;
+  }
+  const float inv = 1.0f / norm;
+  out[0] = v[0] * inv;
+  out[1] = v[1] * inv;
+  out[2] = v[2] * inv;
+  return true;
+}
+
+void NormalizeQuat(float *q) {
+  const float norm =
+      std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+  if (!(norm > 0.0f) || !std::isfinite(norm)) {
+    q[0] = 1.0f;
+    q[1] = q[2] = q[3] = 0.0f;
+    return;
+  }
+  const float inv = 1.0f / norm;
+  for (int i = 0; i < 4; ++i) {
+    q[i] *= inv;
+  }
+}
+
+/** Gradient of the accelerometer objective function. */
+void MadgwickGradientImu(const float *q, const float *a, float *s) {
+  const float q0 = q[0], q1 = q[1], q2 = q[2], q3 = q[3];
+  const float q0q0 = q0 * q0, q1q1 = q1 * q1, q2q2 = q2 * q2,
+              q3q3 = q3 * q3;
+
+  s[0] = 4.0f * q0 * q2q2 + 2.0f * q2 * a[0] + 4.0f * q0 * q1q1 -
+         2.0f * q1 * a[1];
+  s[1] = 4.0f * q1 * q3q3 - 2.0f * q3 * a[0] + 4.0f * q0q0 * q1 -
+         2.0f * q0 * a[1] - 4.0f * q1 + 8.0f * q1 * q1q1 + 8.0f * q1 * q2q2 +
+         4.0f * q1 * a[2];
+  s[2] = 4.0f * q0q0 * q2 + 2.0f * q0 * a[0] + 4.0f * q2 * q3q3 -
+         2.0f * q3 * a[1] - 4.0f * q2 + 8.0f * q2 * q1q1 + 8.0f * q2 * q2q2 +
+         4.0f * q2 * a[2];
+  s[3] = 4.0f * q1q1 * q3 - 2.0f * q1 * a[0] + 4.0f * q2q2 * q3 -
+         2.0f * q2 * a[1];
+}
+
+/** Gradient of the accelerometer and magnetometer objective functions. */
+void MadgwickGradientMarg(const float *q, const float *a, const float *m,
+                          float *s) {
+  const float q0 = q[0], q1 = q[1], q2 = q[2], q3 = q[3];
+  const float q0q0 = q0 * q0, q0q1 = q0 * q1, q0q2 = q0 * q2, q0q3 = q0 * q3;
+  const float q1q1 = q1 * q1, q1q2 = q1 * q2, q1q3 = q1 * q3;
+  const float q2q2 = q2 * q2, q2q3 = q2 * q3, q3q3 = q3 * q3;
+  const float mx = m[0], my = m[1], mz = m[2];
+
+  // Earth's magnetic field in the earth frame, on the x-z plane.
+  const float hx = mx * q0q0 - 2.0f * q0 * my * q3 + 2.0f * q0 * mz * q2 +
+                   mx * q1q1 + 2.0f * q1 * my * q2 + 2.0f * q1 * mz * q3 -
+                   mx * q2q2 - mx * q3q3;
+  const float hy = 2.0f * q0 * mx * q3 + my * q0q0 - 2.0f * q0 * mz * q1 +
+                   2.0f * q1 * mx * q2 - my * q1q1 + my * q2q2 +
+                   2.0f * q2 * mz * q3 - my * q3q3;
+  const float bx2 = std::sqrt(hx * hx + hy * hy);
+  const float bz2 = -2.0f * q0 * mx * q2 + 2.0f * q0 * my * q1 + mz * q0q0 +
+                    2.0f * q1 * mx * q3 - mz * q1q1 + 2.0f * q2 * my * q3 -
+                    mz * q2q2 + mz * q3q3;
+  const float bx4 = 2.0f * bx2, bz4 = 2.0f * bz2;
+
+  // Objective function residuals.
+  const float fax = 2.0f * q1q3 - 2.0f * q0q2 - a[0];
+  const float fay = 2.0f * q0q1 + 2.0f * q2q3 - a[1];
+  const float faz = 1.0f - 2.0f * q1q1 - 2.0f * q2q2 - a[2];
+  const float fmx = bx2 * (0.5f - q2q2 - q3q3) + bz2 * (q1q3 - q0q2) - mx;
+  const float fmy = bx2 * (q1q2 - q0q3) + bz2 * (q0q1 + q2q3) - my;
+  const float fmz = bx2 * (q0q2 + q1q3) + bz2 * (0.5f - q1q1 - q2q2) - mz;
+
+  s[0] = -2.0f * q2 * fax + 2.0f * q1 * fay - bz2 * q2 * fmx +
+         (-bx2 * q3 + bz2 * q1) * fmy + bx2 * q2 * fmz;
+  s[1] = 2.0f * q3 * fax + 2.0f * q0 * fay - 4.0f * q1 * faz +
+         bz2 * q3 * fmx + (bx2 * q2 + bz2 * q0) * fmy +
+         (bx2 * q3 - bz4 * q1) * fmz;
+  s[2] = -2.0f * q0 * fax + 2.0f * q3 * fay - 4.0f * q2 * faz +
+         (-bx4 * q2 - bz2 * q0) * fmx + (bx2 * q1 + bz2 * q3) * fmy +
+         (bx2 * q0 - bz4 * q2) * fmz;
+  s[3] = 2.0f * q1 * fax + 2.0f * q2 * fay +
+         (-bx4 * q3 + bz2 * q1) * fmx + (-bx2 * q0 + bz2 * q2) * fmy +
+         bx2 * q1 * fmz;
+}
+
+}  // namespace
+
+void ResetAhrs(AhrsState &state) {
+  state = AhrsState();
+}
+
+void MadgwickUpdate(AhrsState &state, const float *gyro, const float *accel,
+                    const float *mag, float dt, float beta) {
+  float *q = state.q;
+
+  // Rate of change of the orientation from the gyroscope.
+  float qDot[4] = {
+      0.5f * (-q[1] * gyro[0] - q[2] * gyro[1] - q[3] * gyro[2]),
+      0.5f * (q[0] * gyro[0] + q[2] * gyro[2] - q[3] * gyro[1]),
+      0.5f * (q[0] * gyro[1] - q[1] * gyro[2] + q[3] * gyro[0]),
+      0.5f * (q[0] * gyro[2] + q[1] * gyro[1] - q[2] * gyro[0])};
+
+  float a[3];
+  if (!IsZero(accel) && Normalize3(accel, a)) {
+    float m[3];
+    float s[4];
+    if (!IsZero(mag) && Normalize3(mag, m)) {
+      MadgwickGradientMarg(q, a, m, s);
+    } else {
+      MadgwickGradientImu(q, a, s);
+    }
+
+    const float norm =
+        std::sqrt(s[0] * s[0] + s[1] * s[1] + s[2] * s[2] + s[3] * s[3]);
+    if (norm > 0.0f) {
+      const float step = beta / norm;
+      for (int i = 0; i < 4; ++i) {
+        qDot[i] -= step * s[i];
+      }
+    }
+  }
+
+  for (int i = 0; i < 4; ++i) {
+    q[i] += qDot[i] * dt;
+  }
+  NormalizeQuat(q);
+}
+
+void MahonyUpdate(AhrsState &state, const float *gyro, const float *accel,
+                  const float *mag, float dt, float kp, float ki) {
+  float *q = state.q;
+  float g[3] = {gyro[0], gyro[1], gyro[2]};
+
+  float a[3];
+  if (!IsZero(accel) && Normalize3(accel, a)) {
+    const float q0 = q[0], q1 = q[1], q2 = q[2], q3 = q[3];
+    const float q0q0 = q0 * q0, q0q1 = q0 * q1, q0q2 = q0 * q2,
+                q0q3 = q0 * q3;
+    const float q1q1 = q1 * q1, q1q2 = q1 * q2, q1q3 = q1 * q3;
+    const float q2q2 = q2 * q2, q2q3 = q2 * q3, q3q3 = q3 * q3;
+
+    // Half the estimated direction of gravity in the sensor frame.
+    const float vx = q1q3 - q0q2;
+    const float vy = q0q1 + q2q3;
+    const float vz = q0q0 - 0.5f + q3q3;
+
+    // Half the error between measured and estimated directions.
+    float e[3] = {a[1] * vz - a[2] * vy, a[2] * vx - a[0] * vz,
+                  a[0] * vy - a[1] * vx};
+
+    float m[3];
+    if (!IsZero(mag) && Normalize3(mag, m)) {
+      const float hx = 2.0f * (m[0] * (0.5f - q2q2 - q3q3) +
+                               m[1] * (q1q2 - q0q3) + m[2] * (q1q3 + q0q2));
+      const float hy = 2.0f * (m[0] * (q1q2 + q0q3) +
+                               m[1] * (0.5f - q1q1 - q3q3) +
+                               m[2] * (q2q3 - q0q1));
+      const float bx = std::sqrt(hx * hx + hy * hy);
+      const float bz = 2.0f * (m[0] * (q1q3 - q0q2) + m[1] * (q2q3 + q0q1) +
+                               m[2] * (0.5f - q1q1 - q2q2));
+
+      // Half the estimated direction of the magnetic field.
+      const float wx = bx * (0.5f - q2q2 - q3q3) + bz * (q1q3 - q0q2);
+      const float wy = bx * (q1q2 - q0q3) + bz * (q0q1 + q2q3);
+      const float wz = bx * (q0q2 + q1q3) + bz * (0.5f - q1q1 - q2q2);
+
+      e[0] += m[1] * wz - m[2] * wy;
+      e[1] += m[2] * wx - m[0] * wz;
+      e[2] += m[0] * wy - m[1] * wx;
+    }
+
+    for (int i = 0; i < 3; ++i) {
+      if (ki > 0.0f) {
+        state.integral[i] += 2.0f * ki * e[i] * dt;
+        g[i] += state.integral[i];
+      } else {
+        state.integral[i] = 0.0f;
+      }
+      g[i] += 2.0f * kp * e[i];
+    }
+  }
+
+  for (int i = 0; i < 3; ++i) {
+    g[i] *= 0.5f * dt;
+  }
+  const float qa = q[0], qb = q[1], qc = q[2];
+  q[0] += -qb * g[0] - qc * g[1] - q[3] * g[2];
+  q[1] += qa * g[0] + qc * g[2] - q[3] * g[1];
+  q[2] += qa * g[1] - qb * g[2] + q[3] * g[0];
+  q[3] += qa * g[2] + qb * g[1] - qc * g[0];
+  NormalizeQuat(q);
+}
+
+}  // namespace HandCore
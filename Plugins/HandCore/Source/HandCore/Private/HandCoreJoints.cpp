@@ -0,0 +1,52 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#include "HandCoreJoints.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace HandCore {
+
+void Calibrate(const float *raw, const float *min, const float *max, int count,
+               float *out) {
+  for (int i = 0; i < count; ++i) {
+    float ratio = (raw[i] - min[i]) / (max[i] - min[i]);
+    if (std::isnan(ratio)) {
+      ratio = 0.0f;
+    }
+    out[i] = std::min(std::max(ratio, -0.1f), 1.0f);
+  }
+}
+
+void ApplyHysteresis(float *values, float *previous, int count,
+                     float sensitivity) {
+  for (int i = 0; i < count; ++i) {
+    if (std::fabs(previous[i] - values[i]) < sensitivity) {
+      values[i] = previous[i];
+    }
+    previous[i] = values[i];
+  }
+}
+
+int ExpandJointRatios(const float *values, int count, float *out,
+                      int outCount) {
+  if (outCount <= 0) {
+    return 0;
+  }
+
+  out[0] = 0.0f;
+  int written = 1;
+
+  for (int i = 0; i < count && written < outCount; ++i) {
+    out[written++] = values[i];
+    // The second sensor of the index to little finger also drives the
+    // distal joint, which has no sensor of its own.
+    if (i > 1 && i % 2 == 1 && written < outCount) {
+      out[written++] = values[i] * DistalJointWeight;
+    }
+  }
+
+  return written;
+}
+
+}  // namespace HandCore
@@ -0,0 +1,6 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#include "Modules/ModuleManager.h"
+
+// Unreal build only; the CMake build compiles the kernels without it.
+IMPLEMENT_MODULE(FDefaultModuleImpl, HandCore)
@@ -0,0 +1,64 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#include "HandCoreText.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+namespace HandCore {
+
+namespace {
+
+inline bool IsNumberStart(char c) {
+  return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.';
+}
+
+}  // namespace
+
+int ParseFloatList(const char *str, size_t len, float *out, int maxCount) {
+  const char *end = str + len;
+  int count = 0;
+
+  while (str < end && count < maxCount) {
+    while (str < end && !IsNumberStart(*str)) {
+      ++str;
+    }
+    if (str >= end) {
+      break;
+    }
+
+    char *next = nullptr;
+    const float value = strtof(str, &next);
+    if (next > str) {
+      out[count++] = value;
+      str = next;
+    } else {
+      ++str;
+    }
+  }
+
+  return count;
+}
+
+int FormatFloatList(const float *values, int count, char *out, int size) {
+  if (size <= 0) {
+    return 0;
+  }
+
+  int length = 0;
+  out[0] = '\0';
+
+  for (int i = 0; i < count && length < size - 1; ++i) {
+    const int written =
+        snprintf(out + length, size - length, "%.6g,", values[i]);
+    if (written < 0) {
+      break;
+    }
+    length = std::min(length + written, size - 1);
+  }
+
+  return length;
+}
+
+}  // namespace HandCore
@@ -0,0 +1,52 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#pragma once
+
+#include "HandCoreDefines.h"
+
+/**
+ * Attitude and heading reference filters for the glove IMU: fuse gyroscope,
+ * accelerometer and magnetometer samples into a drift-corrected orientation.
+ *
+ * Orientations are unit quaternions (w, x, y, z) rotating the sensor frame
+ * into the earth frame. Gyroscope samples are in rad/s; accelerometer and
+ * magnetometer samples may be in any unit since only their direction is
+ * used. A zero magnetometer sample fuses gyroscope and accelerometer only,
+ * which keeps pitch and roll but lets heading drift.
+ */
+namespace HandCore {
+
+struct AhrsState {
+  /** Orientation, w first. */
+  float q[4] = {1.0f, 0.0f, 0.0f, 0.0f};
+  /** Integral feedback of the Mahony filter, unused by Madgwick. */
+  float integral[3] = {0.0f, 0.0f, 0.0f};
+};
+
+/** Default gain of the Madgwick filter: sqrt(3/4) times 5 deg/s of drift. */
+constexpr float MadgwickDefaultBeta = 0.0755f;
+
+/** Default proportional and integral gains of the Mahony filter. */
+constexpr float MahonyDefaultKp = 1.0f;
+constexpr float MahonyDefaultKi = 0.0f;
+
+/** Reset to the identity orientation and clear the integral feedback. */
+HANDCORE_API void ResetAhrs(AhrsState &state);
+
+/**
+ * One step of Madgwick's gradient descent filter over dt seconds. beta trades
+ * gyroscope drift correction against accelerometer noise.
+ */
+HANDCORE_API void MadgwickUpdate(AhrsState &state, const float *gyro,
+                                 const float *accel, const float *mag,
+                                 float dt, float beta);
+
+/**
+ * One step of Mahony's complementary filter over dt seconds. ki > 0 also
+ * estimates the gyroscope bias.
+ */
+HANDCORE_API void MahonyUpdate(AhrsState &state, const float *gyro,
+                               const float *accel, const float *mag, float dt,
+                               float kp, float ki);
+
+}  // namespace HandCore
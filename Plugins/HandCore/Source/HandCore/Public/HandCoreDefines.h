@@ -0,0 +1,8 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#pragma once
+
+// Defined by UnrealBuildTool for the module; empty in the CMake build.
+#ifndef HANDCORE_API
+#define HANDCORE_API
+#endif
@@ -0,0 +1,49 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#pragma once
+
+#include "HandCoreDefines.h"
+
+/**
+ * Glove joint kernels, free of engine types so they can be built and measured
+ * outside the editor (see Plugins/HandCore/CMakeLists.txt).
+ */
+namespace HandCore {
+
+/** Bend sensors of one glove: two per finger. */
+constexpr int NumJointSensors = 10;
+
+/**
+ * Joint ratios handed to animation: one leading zero, then per finger the
+ * sensor values, with a derived distal joint after each finger's second
+ * sensor from the index finger on.
+ */
+constexpr int NumJointRatios = 15;
+
+/** Share of the middle joint's bend applied to a derived distal joint. */
+constexpr float DistalJointWeight = 2.0f / 3.0f;
+
+/**
+ * Map raw sensor values to 0..1 between their calibrated min and max. Results
+ * are clamped to [-0.1, 1]; a sensor with min == max at its min gives 0.
+ */
+HANDCORE_API void Calibrate(const float *raw, const float *min,
+                            const float *max, int count, float *out);
+
+/**
+ * Suppress sensor noise: values that moved less than sensitivity from the
+ * previous frame keep the previous value. values and previous are updated in
+ * place.
+ */
+HANDCORE_API void ApplyHysteresis(float *values, float *previous, int count,
+                                  float sensitivity);
+
+/**
+ * Expand filtered sensor values into NumJointRatios joint ratios. Returns the
+ * number of ratios written, which is less than outCount only if there are
+ * too few values.
+ */
+HANDCORE_API int ExpandJointRatios(const float *values, int count, float *out,
+                                   int outCount);
+
+}  // namespace HandCore
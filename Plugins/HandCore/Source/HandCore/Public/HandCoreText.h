@@ -0,0 +1,34 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#pragma once
+
+#include "HandCoreDefines.h"
+
+#include <cstddef>
+
+/**
+ * Text kernels for the comma separated landmark lists of the MQTT hand
+ * messages, e.g. "0.1,0.2,0.3,...".
+ */
+namespace HandCore {
+
+/** Landmarks of a hand message; landmark 0 is the palm. */
+constexpr int NumLandmarks = 21;
+
+/**
+ * Parse up to maxCount numbers from a comma separated list without splitting
+ * it into strings first. Quotes, brackets and spaces are skipped. Returns the
+ * number of values read.
+ */
+HANDCORE_API int ParseFloatList(const char *str, size_t len, float *out,
+                                int maxCount);
+
+/**
+ * Append count values as "a,b,c," to out, the format ParseFloatList reads.
+ * Returns the number of characters written, excluding the terminator; the
+ * output is cut off at size - 1 characters.
+ */
+HANDCORE_API int FormatFloatList(const float *values, int count, char *out,
+                                 int size);
+
+}  // namespace HandCore
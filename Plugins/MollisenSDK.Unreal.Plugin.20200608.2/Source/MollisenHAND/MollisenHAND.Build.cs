@@ -17,6 +17,7 @@ public class MollisenHAND : ModuleRules
 		});
 		PublicDependencyModuleNames.AddRange(new string[] {
 			"Core",
+			"HandCore",
 			// ... add other public dependencies that you statically link with here ...
 		});
 		PrivateDependencyModuleNames.AddRange(new string[] {
@@ -24,6 +25,7 @@ public class MollisenHAND : ModuleRules
 			"Engine",
 			"Slate",
 			"SlateCore",
+			"TraceLog",
 			// ... add private dependencies that you statically link with here ...	
             "Projects"
         });
@@ -2,8 +2,11 @@
 
 #include "MollisenHAND.h"
 #include "MollisenHANDBPLibrary.h"
+#include "MollisenHANDSampler.h"
+#include "MollisenHANDTrace.h"
 
 #include "Core.h"
+#include "Async/Async.h"
 #include "Modules/ModuleManager.h"
 #include "Interfaces/IPluginManager.h"
 
@@ -12,6 +15,8 @@
 #include "Engine/World.h"
 
 #include "fts.device.h"
+#include "HandCoreAhrs.h"
+#include "HandCoreJoints.h"
 
 #include <functional>
 #include <vector>
@@ -20,6 +25,23 @@
 
 #define LOCTEXT_NAMESPACE "FMollisenHANDModule"
 
+#if MOLLISEN_PROFILING_ENABLED && CPUPROFILERTRACE_ENABLED
+UE_TRACE_CHANNEL_DEFINE(MollisenChannel)
+#endif
+
+#if MOLLISEN_PROFILING_ENABLED && ENABLE_LOW_LEVEL_MEM_TRACKER
+DEFINE_STAT(STAT_MollisenLLM);
+#endif
+
+namespace
+{
+    // Filter quaternions are (w, x, y, z) in the right-handed sensor frame, Unreal's frame is left-handed: mirror Y.
+    FQuat ToUnrealQuat(const float* q)
+    {
+        return FQuat(-q[1], q[2], -q[3], q[0]);
+    }
+}
+
 void DelegateOnCallback(int type, const wchar_t* message);
 void DelegateOnCallbackConnect(int device_type, FTS::Handle handler);
 void DelegateOnCallbackDisconnect(int device_type, FTS::Handle handler);
@@ -28,6 +50,11 @@ void FMollisenHANDModule::StartupModule()
 {
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
 	
+    MOLLISEN_LLM_SCOPE();
+
+    this->SetStateDegreeRange(0.0f, 90.0f);
+    this->SetStateSensitivity(0.04f);
+
     // Get the base directory of this plugin
     FString strBaseDir = IPluginManager::Get().FindPlugin(TEXT("MollisenHAND"))->GetBaseDir();
     FString LibraryPath;
@@ -44,29 +71,94 @@ void FMollisenHANDModule::StartupModule()
     #endif
 #endif
     
-    _lib = !LibraryPath.IsEmpty() ? FPlatformProcess::GetDllHandle(*LibraryPath) : nullptr;
+    _lib = nullptr;
+    _sampler = nullptr;
+    _is_ready = false;
+    _is_ready_set = false;
+    _ready_promise = TPromise<bool>();
+    _ready_future = _ready_promise.GetFuture().Share();
+
+    // FTSInitlaize brings up Bluetooth, which takes seconds without a dongle, so it runs on its own thread.
+    _init_task = Async(EAsyncExecution::Thread, [this, LibraryPath]() {
+        return this->InitializeSDK(LibraryPath);
+    });
+}
+
+bool FMollisenHANDModule::InitializeSDK(const FString& library_path)
+{
+    MOLLISEN_LLM_SCOPE();
+
+    auto is_initialized = false;
+
+    _lib = !library_path.IsEmpty() ? FPlatformProcess::GetDllHandle(*library_path) : nullptr;
     if (_lib != nullptr) {
         UE_LOG(LogTemp, Log, TEXT("Mollisen API] Init Start."));
         FTSCallback(DelegateOnCallback);
         FTSCallbackConnect(DelegateOnCallbackConnect);
         FTSCallbackDisconnect(DelegateOnCallbackDisconnect);
 
+        is_initialized = FTSInitlaize();
+    }
+
+    // Devices are created on the game thread, which also runs their connect callbacks.
+    AsyncTask(ENamedThreads::GameThread, [is_initialized]() {
+        if (auto module = FModuleManager::GetModulePtr<FMollisenHANDModule>("MollisenHAND"))
+            module->FinishInitialize(is_initialized);
+    });
+    return is_initialized;
+}
+
+void FMollisenHANDModule::FinishInitialize(bool is_initialized)
+{
+    // Shut down before the SDK came up.
+    if (_is_ready_set)
+        return;
+
+    if (is_initialized) {
         _devices.insert({ FTS::DeviceType::HandL, new FTSDevice(EDeviceType::HandL) });
         _devices.insert({ FTS::DeviceType::HandR, new FTSDevice(EDeviceType::HandR) });
+        _is_ready.store(true, std::memory_order_release);
+        _sampler = new FMollisenHANDSampler(this);
 
-        if (FTSInitlaize()) {
-            this->SetStateDegreeRange(0.0f, 90.0f);
-            this->SetStateSensitivity(0.04f);
-
-            UE_LOG(LogTemp, Log, TEXT("Mollisen API] Init Successed."));
-        }
+        UE_LOG(LogTemp, Log, TEXT("Mollisen API] Init Successed."));
     }
+    else {
+        UE_LOG(LogTemp, Log, TEXT("Mollisen API] Init Failed."));
+    }
+
+    _is_ready_set = true;
+    _ready_promise.SetValue(is_initialized);
+}
+
+bool FMollisenHANDModule::IsReady(void) const
+{
+    return _is_ready.load(std::memory_order_acquire);
+}
+
+TSharedFuture<bool> FMollisenHANDModule::GetReadyFuture(void) const
+{
+    return _ready_future;
 }
 
 void FMollisenHANDModule::ShutdownModule()
 {
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
+
+    // The SDK is only torn down once initialization is done with it.
+    if (_init_task.IsValid())
+        _init_task.Wait();
+
+    // Stopped before the SDK frees the buffers it polls.
+    delete _sampler;
+    _sampler = nullptr;
+
+    _is_ready = false;
+    if (!_is_ready_set) {
+        _is_ready_set = true;
+        _ready_promise.SetValue(false);
+    }
+
     if (_lib != nullptr) {
         UE_LOG(LogTemp, Log, TEXT("Mollisen API] Shutdown Module."));
         FTSCleanup();
@@ -79,6 +171,9 @@ void FMollisenHANDModule::ShutdownModule()
 
 FTSDevice* FMollisenHANDModule::GetDevice(FTS::DeviceType device_type)
 {
+    if (!this->IsReady())
+        return nullptr;
+
     auto it = _devices.find(device_type);
     if (it != _devices.end()) {
         return it->second;
@@ -91,15 +186,80 @@ int FMollisenHANDModule::GetBufferSize(const EDeviceDataType& type)
     static TMap<EDeviceDataType, FTS::DeviceDataType> convert_map {
         { EDeviceDataType::Quaternion, FTS::DeviceDataType::Quaternion },
         { EDeviceDataType::Joint, FTS::DeviceDataType::Joint },
-        { EDeviceDataType::Battery, FTS::DeviceDataType::Battery }
+        { EDeviceDataType::Battery, FTS::DeviceDataType::Battery },
+        { EDeviceDataType::Acceleration, FTS::DeviceDataType::Acceleration },
+        { EDeviceDataType::Gyroscope, FTS::DeviceDataType::Gyroscope },
+        { EDeviceDataType::Magnetic, FTS::DeviceDataType::Magnetic },
+        { EDeviceDataType::Rotation, FTS::DeviceDataType::Rotation }
     };
 
-    int length = 0;
-    if (FTSGetBufferSize(convert_map[type], &length))
+    auto data_type = convert_map.Find(type);
+    int  length = 0;
+    if (this->IsReady() && data_type != nullptr && FTSGetBufferSize(*data_type, &length))
         return length;
     return -1;
 }
 
+bool FMollisenHANDModule::GetJointRatios(FTS::DeviceType device_type, TArray<float>& out_ratios)
+{
+    MOLLISEN_TRACE_SCOPE(Mollisen_Module_GetJointRatios);
+
+    out_ratios.Init(0.0f, 15);
+
+    if (auto device = this->GetDevice(device_type))
+        return device->GetJointRatios(this->GetStateSensitivity(), out_ratios);
+    return false;
+}
+
+bool FMollisenHANDModule::GetJointDegrees(FTS::DeviceType device_type, TArray<float>& out_degrees)
+{
+    MOLLISEN_TRACE_SCOPE(Mollisen_Module_GetJointDegrees);
+
+    auto  result = this->GetJointRatios(device_type, out_degrees);
+    auto  degree_range = this->GetStateDegreeRange();
+    auto& min_value = degree_range.first;
+    auto& max_value = degree_range.second;
+
+    for (int n = 0; n < out_degrees.Num(); ++n) {
+        out_degrees[n] = out_degrees[n]*(max_value - min_value) + min_value;
+    }
+    return result;
+}
+
+bool FMollisenHANDModule::GetWristOrientation(FTS::DeviceType device_type, FQuat& out_orientation, double& out_timestamp)
+{
+    MOLLISEN_TRACE_SCOPE(Mollisen_Module_GetWristOrientation);
+
+    out_orientation = FQuat::Identity;
+    out_timestamp = 0.0;
+
+    if (auto device = this->GetDevice(device_type))
+        return device->GetOrientation(out_orientation, out_timestamp);
+    return false;
+}
+
+void FMollisenHANDModule::ResetWristOrientation(FTS::DeviceType device_type)
+{
+    if (auto device = this->GetDevice(device_type))
+        device->ResetOrientation();
+}
+
+FTSAhrsSettings FMollisenHANDModule::GetAhrsSettings(void) const
+{
+    FScopeLock lock(&_ahrs_lock);
+    return _ahrs_settings;
+}
+
+void FMollisenHANDModule::SetAhrsSettings(const FTSAhrsSettings& settings)
+{
+    FScopeLock lock(&_ahrs_lock);
+    _ahrs_settings = settings;
+    _ahrs_settings.beta = FMath::Max(settings.beta, 0.0f);
+    _ahrs_settings.kp = FMath::Max(settings.kp, 0.0f);
+    _ahrs_settings.ki = FMath::Max(settings.ki, 0.0f);
+    _ahrs_settings.sample_rate = FMath::Clamp(settings.sample_rate, 10.0f, 2000.0f);
+}
+
 void FMollisenHANDModule::AddCallbackTask(TFunction<void(void)> function)
 {
     if (function)
@@ -108,7 +268,8 @@ void FMollisenHANDModule::AddCallbackTask(TFunction<void(void)> function)
 
 bool FMollisenHANDModule::GetCallbackTask(TFunction<void(void)>& function)
 {
-    if (!_callback_queue.IsEmpty()) {
+    // Callbacks that arrive while the SDK initializes wait for their devices.
+    if (this->IsReady() && !_callback_queue.IsEmpty()) {
         return _callback_queue.Dequeue(function);
     }
     return false;
@@ -171,17 +332,20 @@ void FMollisenHANDModule::OnCallabckDisconnect(FTS::DeviceType device_type, Hand
 
 void FMollisenHANDModule::BluetoothPair(void)
 {
-    FTSBluetoothPair();
+    if (this->IsReady())
+        FTSBluetoothPair();
 }
 
 void FMollisenHANDModule::BluetoothUnpair(void)
 {
-    FTSBluetoothUnpair();
+    if (this->IsReady())
+        FTSBluetoothUnpair();
 }
 
 void FMollisenHANDModule::BluetoothPairDevice(FString address)
 {
-    FTSBluetoothPairTarget(TCHAR_TO_ANSI(*address));
+    if (this->IsReady())
+        FTSBluetoothPairTarget(TCHAR_TO_ANSI(*address));
 }
 
 
@@ -220,8 +384,11 @@ void DelegateOnCallbackDisconnect(int device_type, FTS::Handle handler)
 
 
 FTSDevice::FTSDevice(const EDeviceType& type)
-    : _handle(nullptr), _type(type)
+    : _handle(nullptr), _imu_sample_time(0.0), _imu_start_time(0.0), _orientation(FQuat::Identity),
+      _orientation_tare(FQuat::Identity), _orientation_time(0.0), _orientation_count(0), _type(type)
 {
+    FMemory::Memzero(_imu_sample);
+
     _calibrations.insert({ FTS::DeviceDataType::Joint, {
             {1814, 1638, 1123, 1017, 955, 872, 1232, 1041, 1369, 1003 },
             {2200, 1946, 1237, 1227, 1191, 1076, 1457, 1335, 1539, 1259 }
@@ -275,23 +442,23 @@ std::pair<float*, int> FTSDevice::GetDataRaw(FTS::DeviceDataType data_type)
 
 TArray<float> FTSDevice::GetData(FTS::DeviceDataType data_type)
 {
+    MOLLISEN_TRACE_SCOPE(Mollisen_Device_GetData);
+
     TArray<float> range_01;
 
     auto data = this->GetDataRaw(data_type);
     auto cali = _calibrations.find(data_type);
     if (cali != _calibrations.end() && data.second != -1) {
-        for (int n = 0; n < data.second; ++n) {
-            auto value = data.first[n];
-            auto min_value = cali->second.first[n];
-            auto max_value = cali->second.second[n];
-
-            auto angle01 = (value - min_value) / (max_value - min_value);
+        auto& min_values = cali->second.first;
+        auto& max_values = cali->second.second;
+        auto  count = FMath::Min3(data.second, min_values.Num(), max_values.Num());
 
-            if (FGenericPlatformMath::IsNaN(angle01))
-                angle01 = 0.0f;
-
-            range_01.Add(FMath::Clamp(angle01, -0.1f, 1.0f));
-        }
+        range_01.SetNumZeroed(data.second);
+        HandCore::Calibrate(data.first, min_values.GetData(), max_values.GetData(), count, range_01.GetData());
+    }
+    else if (data.first != nullptr && data.second > 0) {
+        // IMU and battery values are used as the device reports them.
+        range_01.Append(data.first, data.second);
     }
     else {
         int size = 0;
@@ -314,6 +481,118 @@ TArray<float> FTSDevice::GetDataPriv(FTS::DeviceDataType data_type)
     return empty;
 }
 
+bool FTSDevice::GetJointRatios(float sensitivity, TArray<float>& out_ratios)
+{
+    MOLLISEN_TRACE_SCOPE(Mollisen_Device_GetJointRatios);
+    MOLLISEN_LLM_SCOPE();
+
+    FScopeLock lock(&_joint_lock);
+
+    out_ratios.Init(0.0f, HandCore::NumJointRatios);
+
+    auto raw_data = this->GetData(FTS::DeviceDataType::Joint);
+    auto raw_data_priv = this->GetDataPriv(FTS::DeviceDataType::Joint);
+    if (_handle == nullptr || raw_data.Num() != raw_data_priv.Num())
+        return false;
+
+    HandCore::ApplyHysteresis(raw_data.GetData(), raw_data_priv.GetData(), raw_data.Num(), sensitivity);
+    HandCore::ExpandJointRatios(raw_data.GetData(), raw_data.Num(), out_ratios.GetData(), out_ratios.Num());
+    this->SetDataPriv(FTS::DeviceDataType::Joint, raw_data_priv);
+
+    return true;
+}
+
+bool FTSDevice::ReadImuSample(float* out_sample)
+{
+    FScopeLock lock(&_joint_lock);
+
+    const FTS::DeviceDataType types[] = {
+        FTS::DeviceDataType::Gyroscope,
+        FTS::DeviceDataType::Acceleration,
+        FTS::DeviceDataType::Magnetic
+    };
+
+    FMemory::Memzero(out_sample, sizeof(float) * 9);
+    for (int n = 0; n < 3; ++n) {
+        auto data = this->GetDataRaw(types[n]);
+        if (data.first != nullptr && data.second >= 3)
+            FMemory::Memcpy(out_sample + n * 3, data.first, sizeof(float) * 3);
+        else if (types[n] != FTS::DeviceDataType::Magnetic)
+            return false;
+    }
+    return true;
+}
+
+bool FTSDevice::UpdateOrientation(const FTSAhrsSettings& settings, double now)
+{
+    // Gyroscope, accelerometer, magnetometer.
+    float sample[9];
+
+    if (!this->ReadImuSample(sample)) {
+        if (_imu_sample_time != 0.0) {
+            HandCore::ResetAhrs(_ahrs);
+            _imu_sample_time = 0.0;
+
+            FScopeLock lock(&_orientation_lock);
+            _orientation = FQuat::Identity;
+            _orientation_count = 0;
+        }
+        return false;
+    }
+
+    if (_imu_sample_time != 0.0 && FMemory::Memcmp(sample, _imu_sample, sizeof(sample)) == 0)
+        return false;
+
+    // Measured between distinct samples, so a slower device is integrated correctly. Long gaps are clamped so a
+    // stall does not spin the estimate.
+    auto dt = 1.0f / settings.sample_rate;
+    if (_imu_sample_time != 0.0)
+        dt = FMath::Clamp((float)(now - _imu_sample_time), 0.0005f, 0.05f);
+    else
+        _imu_start_time = now;
+
+    FMemory::Memcpy(_imu_sample, sample, sizeof(sample));
+    _imu_sample_time = now;
+
+    const float gyro[3] = {
+        sample[0] * settings.gyro_scale,
+        sample[1] * settings.gyro_scale,
+        sample[2] * settings.gyro_scale
+    };
+
+    // Converges from the identity in a fraction of a second instead of several at the steady state gain.
+    const auto gain = (now - _imu_start_time) < 1.0 ? 10.0f : 1.0f;
+
+    if (settings.use_mahony)
+        HandCore::MahonyUpdate(_ahrs, gyro, sample + 3, sample + 6, dt, settings.kp * gain, settings.ki);
+    else
+        HandCore::MadgwickUpdate(_ahrs, gyro, sample + 3, sample + 6, dt, settings.beta * gain);
+
+    FScopeLock lock(&_orientation_lock);
+    _orientation = ToUnrealQuat(_ahrs.q);
+    _orientation_time = now;
+    ++_orientation_count;
+    return true;
+}
+
+bool FTSDevice::GetOrientation(FQuat& out_orientation, double& out_timestamp) const
+{
+    FScopeLock lock(&_orientation_lock);
+
+    if (_orientation_count == 0)
+        return false;
+
+    out_orientation = _orientation_tare * _orientation;
+    out_timestamp = _orientation_time;
+    return true;
+}
+
+void FTSDevice::ResetOrientation(void)
+{
+    FScopeLock lock(&_orientation_lock);
+    _orientation_tare = _orientation_count > 0 ? _orientation.Inverse() : FQuat::Identity;
+}
+
 bool FTSDevice::Vibrator(FTS::FingerType finger_type, int power)
 {
     return FTSVibratorPower(_handle, (int)finger_type, power);
@@ -382,24 +661,38 @@ void FTSDevice::SetDeviceHandle(FTS::Handle handle)
     std::vector<FTS::DeviceDataType> types { 
         FTS::DeviceDataType::Quaternion,
         FTS::DeviceDataType::Joint, 
-        FTS::DeviceDataType::Battery 
+        FTS::DeviceDataType::Battery,
+        FTS::DeviceDataType::Acceleration,
+        FTS::DeviceDataType::Gyroscope,
+        FTS::DeviceDataType::Magnetic,
+        FTS::DeviceDataType::Rotation
     };
 
+    FScopeLock lock(&_joint_lock);
+
     if (handle == nullptr) {
         _handle = nullptr;
         _buffers.clear();
     }
     else if (_handle != handle) {
         _handle = handle;
+        _buffers.clear();
         for (auto type : types) {
-            FTSGetBuffer(handle, type, &buffer, &length);
-            _buffers.insert({ type, {buffer, length} });
+            // Types the device does not report are left out, so their readers see no data rather than a stale buffer.
+            buffer = nullptr;
+            length = -1;
+            if (FTSGetBuffer(handle, type, &buffer, &length) && buffer != nullptr)
+                _buffers.insert({ type, {buffer, length} });
         }
     }
 }
 
 void FTSDevice::SetCalibarationData(const ECalibrationType& type, TArray<float> data, bool is_save)
 {
+    MOLLISEN_LLM_SCOPE();
+
+    FScopeLock lock(&_joint_lock);
+
     auto cali = _calibrations.find(FTS::DeviceDataType::Joint);
     if (cali != _calibrations.end() && data.Num() > 0) {
         switch (type) {
@@ -2,6 +2,7 @@
 
 #include "MollisenHANDBPLibrary.h"
 #include "MollisenHAND.h"
+#include "MollisenHANDTrace.h"
 
 #include "Runtime/Engine/Public/TimerManager.h"
 #include "Engine/World.h"
@@ -17,49 +18,26 @@ UMollisenHANDBPLibrary::UMollisenHANDBPLibrary(const FObjectInitializer& ObjectI
 
 TArray<float> UMollisenHANDBPLibrary::GetJointRatioArray(EDeviceType device_type)
 {
+    MOLLISEN_TRACE_SCOPE(Mollisen_GetJointRatioArray);
+
     auto modules = (FMollisenHANDModule*)FModuleManager::Get().GetModule("MollisenHAND");
 
-    auto sensitivity = modules->GetStateSensitivity();
-    auto dip_weight = 2.0f / 3.0f;
-    auto write_index = 1;
     auto new_data = TArray<float>();
-    new_data.Init(0.0f, 15);
+    modules->GetJointRatios(ConvertType(device_type), new_data);
 
-    auto device = modules->GetDevice(ConvertType(device_type));
-    if (device != nullptr) {
-        auto raw_data = device->GetData(FTS::DeviceDataType::Joint);
-        auto raw_data_priv = device->GetDataPriv(FTS::DeviceDataType::Joint);
-        for (int n = 0; n < raw_data.Num(); ++n) {
-            auto value = raw_data[n];
-            if (FMath::Abs(raw_data_priv[n] - value) < sensitivity) {
-                value = raw_data_priv[n];
-                raw_data[n] = raw_data_priv[n];
-            }
-            
-            new_data[write_index++] = value;
-            if (n > 1 && n % 2 == 1)
-                new_data[write_index++] = value*dip_weight;
-        }
-        device->SetDataPriv(FTS::DeviceDataType::Joint, raw_data);
-    }
-    
 	return new_data;
 }
 
 TArray<float> UMollisenHANDBPLibrary::GetJointDegreeArray(EDeviceType device_type)
 {
-    auto  modules = (FMollisenHANDModule*)FModuleManager::Get().GetModule("MollisenHAND");
-    auto  degree_range = modules->GetStateDegreeRange();
+    MOLLISEN_TRACE_SCOPE(Mollisen_GetJointDegreeArray);
 
-    auto  radio_array = GetJointRatioArray(device_type);
-    auto& min_value = degree_range.first;
-    auto& max_value = degree_range.second;
+    auto modules = (FMollisenHANDModule*)FModuleManager::Get().GetModule("MollisenHAND");
 
-    for (int n = 0; n < radio_array.Num(); ++n) {
-        radio_array[n] = radio_array[n]*(max_value - min_value) + min_value;
-    }
+    auto degree_array = TArray<float>();
+    modules->GetJointDegrees(ConvertType(device_type), degree_array);
 
-    return radio_array;
+    return degree_array;
 }
 
 float UMollisenHANDBPLibrary::GetJointRadio(EDeviceType device_type, EJointType joint_type)
@@ -164,6 +142,60 @@ FRotator UMollisenHANDBPLibrary::GetRotation(EDeviceType device_type)
     return FRotator();
 }
 
+bool UMollisenHANDBPLibrary::GetWristRotation(EDeviceType device_type, FRotator& rotation, float& sample_age)
+{
+    MOLLISEN_TRACE_SCOPE(Mollisen_GetWristRotation);
+
+    auto module = (FMollisenHANDModule*)FModuleManager::Get().GetModule("MollisenHAND");
+
+    FQuat  orientation = FQuat::Identity;
+    double timestamp = 0.0;
+    auto   result = module != nullptr && module->GetWristOrientation(ConvertType(device_type), orientation, timestamp);
+
+    rotation = orientation.Rotator();
+    sample_age = result ? (float)(FPlatformTime::Seconds() - timestamp) : -1.0f;
+    return result;
+}
+
+void UMollisenHANDBPLibrary::ResetWristRotation(EDeviceType device_type)
+{
+    auto module = (FMollisenHANDModule*)FModuleManager::Get().GetModule("MollisenHAND");
+    if (module != nullptr)
+        module->ResetWristOrientation(ConvertType(device_type));
+}
+
+FMollisenAhrsSettings UMollisenHANDBPLibrary::GetAhrsSettings()
+{
+    FMollisenAhrsSettings result;
+
+    auto module = (FMollisenHANDModule*)FModuleManager::Get().GetModule("MollisenHAND");
+    if (module != nullptr) {
+        auto settings = module->GetAhrsSettings();
+        result.Filter = settings.use_mahony ? EAhrsFilter::Mahony : EAhrsFilter::Madgwick;
+        result.Beta = settings.beta;
+        result.Kp = settings.kp;
+        result.Ki = settings.ki;
+        result.SampleRate = settings.sample_rate;
+        result.GyroScale = settings.gyro_scale;
+    }
+    return result;
+}
+
+void UMollisenHANDBPLibrary::SetAhrsSettings(const FMollisenAhrsSettings& settings)
+{
+    auto module = (FMollisenHANDModule*)FModuleManager::Get().GetModule("MollisenHAND");
+    if (module != nullptr) {
+        FTSAhrsSettings value;
+        value.use_mahony = settings.Filter == EAhrsFilter::Mahony;
+        value.beta = settings.Beta;
+        value.kp = settings.Kp;
+        value.ki = settings.Ki;
+        value.sample_rate = settings.SampleRate;
+        value.gyro_scale = settings.GyroScale;
+        module->SetAhrsSettings(value);
+    }
+}
+
 float UMollisenHANDBPLibrary::GetBatteryLevel(EDeviceType device_type)
 {
     auto module = (FMollisenHANDModule*)FModuleManager::Get().GetModule("MollisenHAND");
@@ -238,6 +270,12 @@ void UMollisenHANDBPLibrary::StopVibrator(EDeviceType device_type)
     }
 }
 
+bool UMollisenHANDBPLibrary::IsSDKReady()
+{
+    auto module = (FMollisenHANDModule*)FModuleManager::Get().GetModule("MollisenHAND");
+    return module != nullptr && module->IsReady();
+}
+
 bool UMollisenHANDBPLibrary::IsConnectDevice(EDeviceType device_type)
 {
     auto module = (FMollisenHANDModule*)FModuleManager::Get().GetModule("MollisenHAND");
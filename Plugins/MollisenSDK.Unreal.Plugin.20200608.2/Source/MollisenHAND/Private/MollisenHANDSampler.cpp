@@ -0,0 +1,54 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "MollisenHANDSampler.h"
+#include "MollisenHAND.h"
+#include "MollisenHANDTrace.h"
+
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/RunnableThread.h"
+
+FMollisenHANDSampler::FMollisenHANDSampler(FMollisenHANDModule* module)
+    : _module(module), _thread(nullptr)
+{
+    _thread = FRunnableThread::Create(this, TEXT("MollisenIMUSampler"), 0, TPri_AboveNormal);
+}
+
+FMollisenHANDSampler::~FMollisenHANDSampler(void)
+{
+    if (_thread != nullptr) {
+        _thread->Kill(true);
+        delete _thread;
+        _thread = nullptr;
+    }
+}
+
+uint32 FMollisenHANDSampler::Run()
+{
+    const FTS::DeviceType device_types[] = { FTS::DeviceType::HandL, FTS::DeviceType::HandR };
+
+    while (!_is_stopping) {
+        const auto settings = _module->GetAhrsSettings();
+        const auto period = 1.0 / FMath::Clamp(settings.sample_rate, 10.0f, 2000.0f);
+        const auto start = FPlatformTime::Seconds();
+
+        {
+            MOLLISEN_TRACE_SCOPE(Mollisen_Sampler_Update);
+
+            for (auto device_type : device_types) {
+                if (auto device = _module->GetDevice(device_type))
+                    device->UpdateOrientation(settings, start);
+            }
+        }
+
+        const auto remaining = period - (FPlatformTime::Seconds() - start);
+        if (remaining > 0.0)
+            FPlatformProcess::SleepNoStats((float)remaining);
+    }
+    return 0;
+}
+
+void FMollisenHANDSampler::Stop()
+{
+    _is_stopping = true;
+}
@@ -0,0 +1,30 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+
+class FMollisenHANDModule;
+class FRunnableThread;
+
+// Polls the IMU buffers of the connected gloves at FTSAhrsSettings::sample_rate and feeds every new sample to the
+// orientation filter of its device. The SDK writes the buffers in place at device rate, so polling faster than that
+// only skips unchanged samples. Runs from construction until destruction.
+class FMollisenHANDSampler : public FRunnable
+{
+private:
+    FMollisenHANDModule*    _module;
+    FRunnableThread*        _thread;
+    FThreadSafeBool         _is_stopping;
+
+public:
+    FMollisenHANDSampler(void) = delete;
+    FMollisenHANDSampler(FMollisenHANDModule* module);
+    virtual ~FMollisenHANDSampler(void);
+
+public:
+    // FRunnable interface
+    virtual uint32 Run() override;
+    virtual void Stop() override;
+};
@@ -0,0 +1,29 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/LowLevelMemTracker.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Stats/Stats.h"
+#include "Trace/Trace.h"
+
+// MOLLISEN_TRACE_SCOPE(name) times the enclosing scope on the Mollisen trace channel
+// ("-trace=cpu,mollisen"), MOLLISEN_LLM_SCOPE() charges its allocations to the
+// MollisenHAND tag of the low level memory tracker. Both compile out in shipping builds.
+
+#define MOLLISEN_PROFILING_ENABLED (!UE_BUILD_SHIPPING)
+
+#if MOLLISEN_PROFILING_ENABLED && CPUPROFILERTRACE_ENABLED
+UE_TRACE_CHANNEL_EXTERN(MollisenChannel)
+#define MOLLISEN_TRACE_SCOPE(name) TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(name, MollisenChannel)
+#else
+#define MOLLISEN_TRACE_SCOPE(name)
+#endif
+
+#if MOLLISEN_PROFILING_ENABLED && ENABLE_LOW_LEVEL_MEM_TRACKER
+DECLARE_LLM_MEMORY_STAT_EXTERN(TEXT("MollisenHAND"), STAT_MollisenLLM, STATGROUP_LLMFULL, );
+#define MOLLISEN_LLM_SCOPE() LLM_SCOPED_TAG_WITH_STAT(STAT_MollisenLLM, ELLMTracker::Default)
+#else
+#define MOLLISEN_LLM_SCOPE()
+#endif
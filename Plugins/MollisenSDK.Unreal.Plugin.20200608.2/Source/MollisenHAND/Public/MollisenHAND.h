@@ -4,14 +4,32 @@
 
 #include "Modules/ModuleManager.h"
 #include "fts.device.h"
+#include "Async/Future.h"
 #include "Containers/Queue.h"
+#include "HAL/CriticalSection.h"
+#include "HandCoreAhrs.h"
 
+#include <atomic>
 #include <unordered_map>
 
 enum class EDeviceType : uint8;
 enum class ECalibrationType : uint8;
 enum class EDeviceDataType : uint8;
 
+// Orientation filter of the IMU sampler thread, see FMollisenHANDModule::GetWristOrientation.
+struct FTSAhrsSettings
+{
+    bool  use_mahony = false;
+    float beta = HandCore::MadgwickDefaultBeta;
+    float kp = HandCore::MahonyDefaultKp;
+    float ki = HandCore::MahonyDefaultKi;
+
+    // How often the sampler polls the IMU buffers; unchanged samples are skipped, so this may exceed the device rate.
+    float sample_rate = 400.0f;
+    // Converts gyroscope samples to rad/s, the glove reports deg/s.
+    float gyro_scale = PI / 180.0f;
+};
+
 struct EnumClassHash
 {
     template <typename T>
@@ -22,7 +40,8 @@ struct EnumClassHash
 };
 
 class FTSDevice;
-class FMollisenHANDModule : public IModuleInterface
+class FMollisenHANDSampler;
+class MOLLISENHAND_API FMollisenHANDModule : public IModuleInterface
 {
     using Handle = void*;
 
@@ -36,15 +55,49 @@ private:
     std::pair<float, float> _state_degree_range;
     float                   _state_sensitivity;
 
+private:
+    TFuture<bool>       _init_task;
+    TPromise<bool>      _ready_promise;
+    TSharedFuture<bool> _ready_future;
+    std::atomic<bool>   _is_ready;
+    bool                _is_ready_set;
+
+private:
+    FMollisenHANDSampler*       _sampler;
+    FTSAhrsSettings             _ahrs_settings;
+    mutable FCriticalSection    _ahrs_lock;
+
 public:
 	/** IModuleInterface implementation */
 	virtual void StartupModule() override;
 	virtual void ShutdownModule() override;
 
+public:
+    // The SDK is loaded and initialized in the background after startup. Until it is ready GetDevice returns
+    // nullptr and SDK calls are skipped; the future resolves on the game thread with whether it came up.
+    bool                IsReady(void) const;
+    TSharedFuture<bool> GetReadyFuture(void) const;
+
+private:
+    bool InitializeSDK(const FString& library_path);
+    void FinishInitialize(bool is_initialized);
+
 public:
     FTSDevice*  GetDevice(FTS::DeviceType device_type);
     int         GetBufferSize(const EDeviceDataType& type);
 
+    // Thread safe, may be called from animation worker threads.
+    bool GetJointRatios(FTS::DeviceType device_type, TArray<float>& out_ratios);
+    bool GetJointDegrees(FTS::DeviceType device_type, TArray<float>& out_degrees);
+
+    // Wrist orientation fused from the glove IMU on the sampler thread, relative to the last reset. The timestamp is
+    // the FPlatformTime::Seconds() the sample was read at. Thread safe; false until a connected glove sent a sample.
+    bool GetWristOrientation(FTS::DeviceType device_type, FQuat& out_orientation, double& out_timestamp);
+    void ResetWristOrientation(FTS::DeviceType device_type);
+
+    FTSAhrsSettings GetAhrsSettings(void) const;
+    void            SetAhrsSettings(const FTSAhrsSettings& settings);
+
     void AddCallbackTask(TFunction<void(void)> function);
     bool GetCallbackTask(TFunction<void(void)>& function);
 
@@ -66,7 +119,7 @@ public:
     void OnCallabckDisconnect(FTS::DeviceType device_type, Handle handle);
 };
 
-class FTSDevice
+class MOLLISENHAND_API FTSDevice
 {
     typedef std::pair<float*, int> Buffer;
     typedef std::pair<TArray<float>, TArray<float>> Calibration;
@@ -77,6 +130,22 @@ private:
     std::unordered_map<FTS::DeviceDataType, TArray<float>, EnumClassHash>  _buffers_priv;
     std::unordered_map<FTS::DeviceDataType, Calibration, EnumClassHash>    _calibrations;
 
+    FCriticalSection _joint_lock;
+
+private:
+    // Filter state, owned by the sampler thread.
+    HandCore::AhrsState _ahrs;
+    float               _imu_sample[9];
+    double              _imu_sample_time;
+    double              _imu_start_time;
+
+    // Published orientation, in Unreal's frame.
+    FQuat                       _orientation;
+    FQuat                       _orientation_tare;
+    double                      _orientation_time;
+    uint64                      _orientation_count;
+    mutable FCriticalSection    _orientation_lock;
+
 private:
     EDeviceType _type;
 
@@ -97,6 +166,13 @@ public:
     TArray<float>           GetData(FTS::DeviceDataType data_type);
     TArray<float>           GetDataPriv(FTS::DeviceDataType data_type);
 
+    bool GetJointRatios(float sensitivity, TArray<float>& out_ratios);
+
+    // Sampler thread only: fuses the newest IMU sample, false if there was none.
+    bool UpdateOrientation(const FTSAhrsSettings& settings, double now);
+    bool GetOrientation(FQuat& out_orientation, double& out_timestamp) const;
+    void ResetOrientation(void);
+
     bool Vibrator(FTS::FingerType finger_type, int power);
     void VibratorStop(void);
 
@@ -115,5 +191,6 @@ public:
     void SetCalibarationData(const ECalibrationType& type, TArray<float> data, bool is_save = true);
 
 private:
+    bool    ReadImuSample(float* out_sample);
     FString CalibrationDataPath(void) const;
 };
@@ -91,6 +91,43 @@ enum class ECalibrationType : uint8
     Max UMETA(DisplayName = "Calibration MAX"),
 };
 
+UENUM(BlueprintType)
+enum class EAhrsFilter : uint8
+{
+    Madgwick    UMETA(DisplayName = "Madgwick"),
+    Mahony      UMETA(DisplayName = "Mahony"),
+};
+
+// Orientation filter fusing the glove IMU into the wrist rotation.
+USTRUCT(BlueprintType)
+struct FMollisenAhrsSettings
+{
+    GENERATED_BODY()
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MollisenHAND")
+    EAhrsFilter Filter = EAhrsFilter::Madgwick;
+
+    // Madgwick gain: higher corrects gyroscope drift faster but passes more accelerometer noise.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MollisenHAND", meta = (ClampMin = "0"))
+    float Beta = 0.0755f;
+
+    // Mahony proportional gain.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MollisenHAND", meta = (ClampMin = "0"))
+    float Kp = 1.0f;
+
+    // Mahony integral gain, estimates the gyroscope bias when above zero.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MollisenHAND", meta = (ClampMin = "0"))
+    float Ki = 0.0f;
+
+    // Polls per second of the IMU buffers.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MollisenHAND", meta = (ClampMin = "10", ClampMax = "2000"))
+    float SampleRate = 400.0f;
+
+    // Gyroscope samples times this give rad/s.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MollisenHAND")
+    float GyroScale = PI / 180.0f;
+};
+
 
 
 UCLASS(meta=(BlueprintThreadSafe))
@@ -132,6 +169,21 @@ public:
     UFUNCTION(BlueprintPure, Category = "MollisenHAND")
     static FRotator GetRotation(EDeviceType device_type);
 
+    // Wrist rotation fused from the IMU at device rate, relative to the last ResetWristRotation. sample_age is the
+    // time in seconds since the sample was read. False until the glove sent IMU data.
+    UFUNCTION(BlueprintPure, Category = "MollisenHAND")
+    static bool GetWristRotation(EDeviceType device_type, FRotator& rotation, float& sample_age);
+
+    // Makes the current wrist rotation the zero rotation.
+    UFUNCTION(BlueprintCallable, Category = "MollisenHAND")
+    static void ResetWristRotation(EDeviceType device_type);
+
+    UFUNCTION(BlueprintPure, Category = "MollisenHAND")
+    static FMollisenAhrsSettings GetAhrsSettings();
+
+    UFUNCTION(BlueprintCallable, Category = "MollisenHAND")
+    static void SetAhrsSettings(const FMollisenAhrsSettings& settings);
+
     UFUNCTION(BlueprintPure, Category = "MollisenHAND")
     static float GetBatteryLevel(EDeviceType device_type);
 
@@ -150,6 +202,10 @@ public:
     UFUNCTION(BlueprintCallable, Category = "MollisenHAND")
     static void StopVibrator(EDeviceType device_type);
 
+    // False while the SDK is still initializing in the background; device queries return their defaults until then.
+    UFUNCTION(BlueprintPure, Category = "MollisenHAND")
+    static bool IsSDKReady();
+
     UFUNCTION(BlueprintPure, Category = "MollisenHAND")
     static bool IsConnectDevice(EDeviceType device_type);
 
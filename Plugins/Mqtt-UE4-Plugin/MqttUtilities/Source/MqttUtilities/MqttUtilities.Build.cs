@@ -11,7 +11,8 @@ public class MqttUtilities : ModuleRules
 
         PublicIncludePaths.AddRange(
             new string[] {
-                Path.Combine (ModuleDirectory, "Public")
+                Path.Combine (ModuleDirectory, "Public"),
+                Path.Combine (ModuleDirectory, "SampleCode")
 				// ... add public include paths required here ...
 			}
             );
@@ -39,7 +40,9 @@ public class MqttUtilities : ModuleRules
             {
                 "CoreUObject",
                 "Engine",
+                "HandCore",
                 "Projects",
+                "TraceLog",
                 // ... add private dependencies that you statically link with here ...	
 			}
             );
@@ -53,6 +56,9 @@ public class MqttUtilities : ModuleRules
             );
 
 
+        // FlatBuffer (header only, used by SampleCode on every platform)
+        PublicIncludePaths.Add(Path.Combine(ModuleDirectory, "../ThirdParty/Win64/flatbuffers/include"));
+
         // Additional routine for Windows
         if (Target.Platform == UnrealTargetPlatform.Win64)
         {
@@ -60,8 +66,6 @@ public class MqttUtilities : ModuleRules
 
             LoadThirdPartyLibrary("mosquitto", Target);
             LoadThirdPartyLibrary("mosquittopp", Target);
-            // FlatBuffer
-            PublicIncludePaths.Add(Path.Combine(Path.Combine(ModuleDirectory, "../ThirdParty", Target.Platform.ToString()), "flatbuffers", "include"));
         }
 
         // Additional routine for Mac
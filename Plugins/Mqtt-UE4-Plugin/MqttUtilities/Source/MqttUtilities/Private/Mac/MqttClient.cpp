@@ -2,6 +2,7 @@
 
 #include "MqttClient.h"
 #include "HAL/RunnableThread.h"
+#include "IMqttUtilitiesModule.h"
 #include "MqttRunnable.h"
 #include "MqttTask.h"
 #include "Utils/StringUtils.h"
@@ -31,6 +32,36 @@ void UMqttClient::Connect(FMqttConnectionData connectionData,
     return;
   }
 
+  // mosquitto is loaded in the background and cannot be called before; the
+  // connection is made once it is, unless Disconnect comes first.
+  IMqttUtilitiesModule &module = IMqttUtilitiesModule::Get();
+  if (!module.IsReady()) {
+    const bool bAlreadyPending = bConnectPending;
+    bConnectPending = true;
+    if (bAlreadyPending) {
+      return;
+    }
+
+    UE_LOG(LogTemp, Log,
+           TEXT("MQTT => Libraries are still loading, connection deferred"));
+    TWeakObjectPtr<UMqttClient> weakThis(this);
+    module.WhenReady([weakThis, connectionData](bool bLoaded) {
+      UMqttClient *client = weakThis.Get();
+      if (client == nullptr || !client->bConnectPending) {
+        return;
+      }
+      client->bConnectPending = false;
+
+      if (bLoaded) {
+        client->Connect(connectionData, client->OnConnectDelegate);
+      } else {
+        client->OnErrorDelegate.ExecuteIfBound(
+            -1, TEXT("MQTT libraries failed to load"));
+      }
+    });
+    return;
+  }
+
   /**
    * All communication between client and broker should be done in a separate
    * thread. Runnable task stores thread-safe queue for output messages
@@ -55,6 +86,7 @@ void UMqttClient::Connect(FMqttConnectionData connectionData,
 void UMqttClient::Disconnect(
     const FOnDisconnectDelegate &onDisconnectCallback) {
   OnDisconnectDelegate = onDisconnectCallback;
+  bConnectPending = false;
 
   if (Task != nullptr) {
     Task->StopRunning();
@@ -37,4 +37,7 @@ private:
   FMqttRunnable *Task;
   FRunnableThread *Thread;
   FMqttClientConfig ClientConfig;
+
+  /** Connect called before the mosquitto libraries finished loading. */
+  bool bConnectPending = false;
 };
\ No newline at end of file
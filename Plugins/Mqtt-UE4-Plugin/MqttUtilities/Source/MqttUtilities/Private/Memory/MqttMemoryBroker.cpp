@@ -0,0 +1,313 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#include "MqttMemoryBroker.h"
+
+#include "Async/Async.h"
+#include "GenericPlatform/GenericPlatformAffinity.h"
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTLS.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/ScopeLock.h"
+#include "MqttTrace.h"
+
+namespace {
+
+TMap<FString, TWeakPtr<FMqttMemoryBroker, ESPMode::ThreadSafe>> Brokers;
+FCriticalSection BrokersLock;
+
+// Only QoS 0 and 1 are implemented; QoS 2 subscriptions are granted as 1.
+const int MaxQos = 1;
+
+// A session callback on the broker thread may drop the last reference, and the
+// broker thread cannot wait for itself to exit; hand the delete to a task.
+struct FMqttMemoryBrokerDeleter {
+  void operator()(FMqttMemoryBroker *broker) const {
+    if (broker->IsBrokerThread()) {
+      AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask,
+                [broker]() { delete broker; });
+    } else {
+      delete broker;
+    }
+  }
+};
+
+const TCHAR *FindLevelEnd(const TCHAR *level) {
+  while (*level != TEXT('\0') && *level != TEXT('/')) {
+    ++level;
+  }
+  return level;
+}
+
+}  // namespace
+
+TSharedRef<FMqttMemoryBroker, ESPMode::ThreadSafe>
+FMqttMemoryBroker::Get(const FString &name) {
+  FScopeLock lock(&BrokersLock);
+
+  TSharedPtr<FMqttMemoryBroker, ESPMode::ThreadSafe> broker =
+      Brokers.FindRef(name).Pin();
+  if (!broker.IsValid()) {
+    broker = MakeShareable(new FMqttMemoryBroker(name),
+                           FMqttMemoryBrokerDeleter());
+    Brokers.Add(name, broker);
+  }
+
+  return broker.ToSharedRef();
+}
+
+bool FMqttMemoryBroker::TopicMatches(const FString &filter,
+                                     const FString &topic) {
+  const TCHAR *f = *filter;
+  const TCHAR *t = *topic;
+
+  // Wildcards at the first level do not match system topics.
+  if (*t == TEXT('$') && (*f == TEXT('+') || *f == TEXT('#'))) {
+    return false;
+  }
+
+  while (true) {
+    const TCHAR *filterEnd = FindLevelEnd(f);
+    const TCHAR *topicEnd = FindLevelEnd(t);
+    const int32 filterLength = filterEnd - f;
+
+    if (filterLength == 1 && *f == TEXT('#')) {
+      return true;
+    }
+
+    if (!(filterLength == 1 && *f == TEXT('+')) &&
+        (filterLength != topicEnd - t ||
+         FCString::Strncmp(f, t, filterLength) != 0)) {
+      return false;
+    }
+
+    if (*topicEnd == TEXT('\0')) {
+      // "a/#" also matches "a".
+      return *filterEnd == TEXT('\0') ||
+             FCString::Strcmp(filterEnd, TEXT("/#")) == 0;
+    }
+
+    if (*filterEnd == TEXT('\0')) {
+      return false;
+    }
+
+    f = filterEnd + 1;
+    t = topicEnd + 1;
+  }
+}
+
+FMqttMemoryBroker::FMqttMemoryBroker(const FString &name)
+    : Name(name),
+      NumQueuedMessages(0),
+      bKeepRunning(true),
+      WakeEvent(FPlatformProcess::GetSynchEventFromPool()),
+      Thread(nullptr) {
+  Thread = FRunnableThread::Create(
+      this, *(TEXT("MQTT Broker ") + name), 0, EThreadPriority::TPri_Normal,
+      FGenericPlatformAffinity::GetNoAffinityMask());
+}
+
+FMqttMemoryBroker::~FMqttMemoryBroker() {
+  if (Thread != nullptr) {
+    Thread->Kill(true);
+    delete Thread;
+    Thread = nullptr;
+  }
+
+  FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+  WakeEvent = nullptr;
+
+  FScopeLock lock(&BrokersLock);
+  TWeakPtr<FMqttMemoryBroker, ESPMode::ThreadSafe> *entry = Brokers.Find(Name);
+  if (entry != nullptr && !entry->IsValid()) {
+    Brokers.Remove(Name);
+  }
+}
+
+bool FMqttMemoryBroker::IsBrokerThread() const {
+  return Thread != nullptr &&
+         Thread->GetThreadID() == FPlatformTLS::GetCurrentThreadId();
+}
+
+void FMqttMemoryBroker::Attach(IMqttMemorySession *session) {
+  FScopeLock lock(&SessionsLock);
+
+  FSession entry;
+  entry.Callbacks = session;
+  Sessions.Add(entry);
+}
+
+void FMqttMemoryBroker::Detach(IMqttMemorySession *session) {
+  FScopeLock lock(&SessionsLock);
+
+  Sessions.RemoveAllSwap(
+      [session](const FSession &entry) { return entry.Callbacks == session; });
+}
+
+void FMqttMemoryBroker::Subscribe(IMqttMemorySession *session,
+                                  const FString &filter, int qos, int mid) {
+  FCommand command;
+  command.Type = ECommand::Subscribe;
+  command.Session = session;
+  command.Message.Topic = filter;
+  command.Message.Qos = qos;
+  command.Mid = mid;
+  Push(MoveTemp(command));
+}
+
+void FMqttMemoryBroker::Unsubscribe(IMqttMemorySession *session,
+                                    const FString &filter, int mid) {
+  FCommand command;
+  command.Type = ECommand::Unsubscribe;
+  command.Session = session;
+  command.Message.Topic = filter;
+  command.Mid = mid;
+  Push(MoveTemp(command));
+}
+
+bool FMqttMemoryBroker::Publish(IMqttMemorySession *session,
+                                FMqttMessage message, int mid) {
+  {
+    FScopeLock lock(&QueueLock);
+    if (message.Qos == 0 && NumQueuedMessages >= MaxQueuedMessages) {
+      return false;
+    }
+    ++NumQueuedMessages;
+  }
+
+  FCommand command;
+  command.Type = ECommand::Publish;
+  command.Session = session;
+  command.Message = MoveTemp(message);
+  command.Message.Qos = FMath::Clamp(command.Message.Qos, 0, MaxQos);
+  command.Mid = mid;
+  Push(MoveTemp(command));
+  return true;
+}
+
+void FMqttMemoryBroker::Push(FCommand &&command) {
+  {
+    FScopeLock lock(&QueueLock);
+    Queue.Add(MoveTemp(command));
+  }
+
+  WakeEvent->Trigger();
+}
+
+void FMqttMemoryBroker::Stop() {
+  bKeepRunning = false;
+  WakeEvent->Trigger();
+}
+
+uint32 FMqttMemoryBroker::Run() {
+  MQTT_LLM_SCOPE();
+
+  TArray<FCommand> commands;
+
+  while (bKeepRunning) {
+    WakeEvent->Wait(100);
+
+    MQTT_TRACE_SCOPE(Mqtt_BrokerIteration);
+
+    {
+      FScopeLock lock(&QueueLock);
+      Swap(commands, Queue);
+      NumQueuedMessages = 0;
+    }
+
+    FScopeLock lock(&SessionsLock);
+    for (FCommand &command : commands) {
+      Execute(command);
+    }
+    commands.Reset();
+  }
+
+  return 0;
+}
+
+void FMqttMemoryBroker::Execute(FCommand &command) {
+  FSession *session = Sessions.FindByPredicate([&command](const FSession &s) {
+    return s.Callbacks == command.Session;
+  });
+
+  switch (command.Type) {
+    case ECommand::Publish: {
+      FMqttMessage &message = command.Message;
+
+      if (message.Retain) {
+        if (message.Message.Num() == 0) {
+          Retained.Remove(message.Topic);
+        } else {
+          Retained.Add(message.Topic, message);
+        }
+      }
+
+      Deliver(message);
+
+      if (session != nullptr) {
+        session->Callbacks->OnBrokerPublished(command.Mid);
+      }
+      break;
+    }
+    case ECommand::Subscribe: {
+      if (session == nullptr) {
+        break;
+      }
+
+      const FString &filter = command.Message.Topic;
+      const int qos = FMath::Clamp(command.Message.Qos, 0, MaxQos);
+
+      FSubscription *existing = session->Subscriptions.FindByPredicate(
+          [&filter](const FSubscription &s) { return s.Filter == filter; });
+      if (existing != nullptr) {
+        existing->Qos = qos;
+      } else {
+        session->Subscriptions.Add({filter, qos});
+      }
+
+      session->Callbacks->OnBrokerSubscribed(command.Mid, qos);
+
+      for (const TPair<FString, FMqttMessage> &retained : Retained) {
+        if (TopicMatches(filter, retained.Key)) {
+          FMqttMessage message = retained.Value;
+          message.Qos = FMath::Min(message.Qos, qos);
+          message.Retain = true;
+          session->Callbacks->OnBrokerMessage(message);
+        }
+      }
+      break;
+    }
+    case ECommand::Unsubscribe: {
+      if (session == nullptr) {
+        break;
+      }
+
+      const FString &filter = command.Message.Topic;
+      session->Subscriptions.RemoveAll(
+          [&filter](const FSubscription &s) { return s.Filter == filter; });
+      session->Callbacks->OnBrokerUnsubscribed(command.Mid);
+      break;
+    }
+  }
+}
+
+void FMqttMemoryBroker::Deliver(const FMqttMessage &message) {
+  FMqttMessage delivered = message;
+  delivered.Retain = false;
+
+  for (FSession &session : Sessions) {
+    // One copy per session at the highest QoS of its matching
+    // subscriptions, even if several of them overlap.
+    int qos = -1;
+    for (const FSubscription &subscription : session.Subscriptions) {
+      if (TopicMatches(subscription.Filter, message.Topic)) {
+        qos = FMath::Max(qos, subscription.Qos);
+      }
+    }
+
+    if (qos >= 0) {
+      delivered.Qos = FMath::Min(message.Qos, qos);
+      session.Callbacks->OnBrokerMessage(delivered);
+    }
+  }
+}
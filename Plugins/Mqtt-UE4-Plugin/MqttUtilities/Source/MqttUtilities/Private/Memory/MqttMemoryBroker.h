@@ -0,0 +1,117 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Entities/MqttMessage.h"
+#include "HAL/Runnable.h"
+
+#include <atomic>
+
+class FEvent;
+class FRunnableThread;
+
+/** Receiving end of a broker session; called on the broker thread. */
+class IMqttMemorySession {
+ public:
+  virtual ~IMqttMemorySession() {}
+
+  virtual void OnBrokerMessage(const FMqttMessage &message) = 0;
+  virtual void OnBrokerPublished(int mid) = 0;
+  virtual void OnBrokerSubscribed(int mid, int grantedQos) = 0;
+  virtual void OnBrokerUnsubscribed(int mid) = 0;
+};
+
+/**
+ * In-process MQTT broker behind the "mem://<name>" host URL. All clients that
+ * use the same name share one broker, so tests and offline sessions need no
+ * network or external broker.
+ *
+ * Supports QoS 0 and 1 (QoS 2 is granted as 1), retained messages and the +
+ * and # wildcards. Publishes, subscriptions and acknowledgements are handled
+ * in order on one broker thread, which also runs the subscribers' message
+ * callbacks, so a run is deterministic for a given sequence of calls. QoS 0
+ * messages are dropped while MaxQueuedMessages are waiting; QoS 1 messages
+ * are always queued.
+ */
+class FMqttMemoryBroker : public FRunnable {
+ public:
+  static const int32 MaxQueuedMessages = 65536;
+
+  /**
+   * Broker of the given name, started on first use. Any thread. If the last
+   * reference is released on the broker thread, the broker is deleted on a
+   * background task instead.
+   */
+  static TSharedRef<FMqttMemoryBroker, ESPMode::ThreadSafe>
+  Get(const FString &name);
+
+  /** True if the topic filter (with + and # wildcards) matches the topic. */
+  static bool TopicMatches(const FString &filter, const FString &topic);
+
+  /** Never runs on the broker thread; see Get. */
+  virtual ~FMqttMemoryBroker();
+
+  bool IsBrokerThread() const;
+
+  // Any thread. Acknowledgements arrive through the session.
+
+  void Attach(IMqttMemorySession *session);
+
+  /** No callbacks reach the session once this returns. */
+  void Detach(IMqttMemorySession *session);
+
+  void Subscribe(IMqttMemorySession *session, const FString &filter, int qos,
+                 int mid);
+  void Unsubscribe(IMqttMemorySession *session, const FString &filter,
+                   int mid);
+
+  /** False if a QoS 0 message was dropped because the queue is full. */
+  bool Publish(IMqttMemorySession *session, FMqttMessage message, int mid);
+
+  uint32 Run() override;
+  void Stop() override;
+
+ private:
+  FMqttMemoryBroker(const FString &name);
+
+  enum class ECommand { Publish, Subscribe, Unsubscribe };
+
+  struct FCommand {
+    ECommand Type;
+    IMqttMemorySession *Session;
+    FMqttMessage Message;
+    int Mid;
+  };
+
+  struct FSubscription {
+    FString Filter;
+    int Qos;
+  };
+
+  struct FSession {
+    IMqttMemorySession *Callbacks;
+    TArray<FSubscription> Subscriptions;
+  };
+
+  void Push(FCommand &&command);
+  void Execute(FCommand &command);
+  void Deliver(const FMqttMessage &message);
+
+  FString Name;
+
+  FCriticalSection QueueLock;
+  TArray<FCommand> Queue;
+  int32 NumQueuedMessages;
+
+  // Held while commands run, so Detach waits for callbacks in progress.
+  FCriticalSection SessionsLock;
+  TArray<FSession> Sessions;
+
+  // Broker thread only.
+  TMap<FString, FMqttMessage> Retained;
+
+  std::atomic<bool> bKeepRunning;
+  FEvent *WakeEvent;
+  FRunnableThread *Thread;
+};
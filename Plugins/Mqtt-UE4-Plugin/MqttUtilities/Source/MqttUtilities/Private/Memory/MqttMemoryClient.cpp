@@ -0,0 +1,253 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#include "MqttMemoryClient.h"
+
+#include "Async/Async.h"
+#include "MqttLatencyTracer.h"
+#include "MqttTrace.h"
+#include "MqttUtilitiesBPL.h"
+
+namespace {
+
+const TCHAR *MemoryScheme = TEXT("mem://");
+
+}  // namespace
+
+void UMqttMemoryClient::BeginDestroy() {
+  UMqttClientBase::BeginDestroy();
+
+  DetachBroker();
+}
+
+void UMqttMemoryClient::Connect(FMqttConnectionData connectionData) {
+  if (Broker.IsValid()) {
+    UE_LOG(LogMqtt, Warning,
+           TEXT("MQTT => In-process client is already connected. Disconnect "
+                "and try again"));
+    return;
+  }
+
+  const FString name =
+      ClientConfig.HostUrl.RightChop(FCString::Strlen(MemoryScheme));
+  if (name.IsEmpty()) {
+    OnErrorDelegate.ExecuteIfBound(
+        -1, FString::Printf(TEXT("Invalid in-process broker url %s"),
+                            *ClientConfig.HostUrl));
+    return;
+  }
+
+  Broker = FMqttMemoryBroker::Get(name);
+  Broker->Attach(this);
+
+  for (const TPair<FString, int> &subscription : Subscriptions) {
+    Broker->Subscribe(this, subscription.Key, subscription.Value,
+                      NextMessageId.Increment());
+  }
+
+  TWeakObjectPtr<UMqttMemoryClient> weakThis(this);
+  AsyncTask(ENamedThreads::GameThread, [weakThis]() {
+    if (UMqttMemoryClient *client = weakThis.Get()) {
+      client->OnConnectDelegate.ExecuteIfBound();
+    }
+  });
+}
+
+void UMqttMemoryClient::Disconnect() {
+  if (!Broker.IsValid()) {
+    return;
+  }
+
+  DetachBroker();
+
+  TWeakObjectPtr<UMqttMemoryClient> weakThis(this);
+  AsyncTask(ENamedThreads::GameThread, [weakThis]() {
+    if (UMqttMemoryClient *client = weakThis.Get()) {
+      client->OnDisconnectDelegate.ExecuteIfBound();
+    }
+  });
+}
+
+void UMqttMemoryClient::Subscribe(FString topic, int qos,
+                                  const FOnMessageHandlerDelegate &handler) {
+  {
+    FScopeLock lock(&HandlerLock);
+    if (handler.IsBound()) {
+      MsgEventHandler.Emplace(topic, handler);
+    }
+  }
+  SubscribeTopic(topic, qos);
+}
+
+void UMqttMemoryClient::Subscribe(FString topic, int qos,
+                                  IMqttMessageHandlerInterface *handler) {
+  {
+    FScopeLock lock(&HandlerLock);
+    if (handler != nullptr) {
+      MsgFuncHandler.Emplace(topic, handler);
+    }
+  }
+  SubscribeTopic(topic, qos);
+}
+
+void UMqttMemoryClient::Subscribe(FString topic, int qos,
+                                  IMqttDecodingHandlerPtr handler) {
+  {
+    FScopeLock lock(&HandlerLock);
+    if (handler.IsValid()) {
+      MsgDecodingHandler.Emplace(topic, handler);
+    }
+  }
+  SubscribeTopic(topic, qos);
+}
+
+void UMqttMemoryClient::Unsubscribe(FString topic) {
+  {
+    FScopeLock lock(&HandlerLock);
+    MsgEventHandler.Remove(topic);
+    MsgFuncHandler.Remove(topic);
+    MsgDecodingHandler.Remove(topic);
+  }
+
+  Subscriptions.Remove(topic);
+  if (Broker.IsValid()) {
+    Broker->Unsubscribe(this, topic, NextMessageId.Increment());
+  }
+}
+
+void UMqttMemoryClient::Publish(FMqttMessage message) {
+  if (!Broker.IsValid()) {
+    UE_LOG(LogMqtt, Warning,
+           TEXT("MQTT => In-process client is not connected"));
+    return;
+  }
+
+  if (message.Timestamp == 0) {
+    message.Timestamp = UMqttUtilitiesBPL::GetUnixTimeMicroseconds();
+  }
+
+  const int32 size = message.Message.Num();
+  if (!Broker->Publish(this, MoveTemp(message), NextMessageId.Increment())) {
+    Counters->Dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  Counters->AddMessageOut(size);
+}
+
+void UMqttMemoryClient::Init(FMqttClientConfig configData) {
+  ClientConfig = configData;
+}
+
+bool UMqttMemoryClient::IsMemoryUrl(const FString &url) {
+  return url.StartsWith(MemoryScheme, ESearchCase::IgnoreCase);
+}
+
+void UMqttMemoryClient::SubscribeTopic(const FString &topic, int qos) {
+  Subscriptions.Emplace(topic, qos);
+  if (Broker.IsValid()) {
+    Broker->Subscribe(this, topic, qos, NextMessageId.Increment());
+  }
+}
+
+void UMqttMemoryClient::DetachBroker() {
+  if (Broker.IsValid()) {
+    Broker->Detach(this);
+    Broker.Reset();
+  }
+}
+
+void UMqttMemoryClient::OnBrokerMessage(const FMqttMessage &message) {
+  MQTT_TRACE_SCOPE(Mqtt_OnMessage);
+
+  FScopeLock lock(&HandlerLock);
+
+  Counters->AddMessageIn(message.Message.Num());
+  FMqttLatencyTracer::Mark(EMqttLatencyStage::Received, message.Timestamp);
+
+  const uint64 received = FPlatformTime::Cycles64();
+
+  // Handlers are registered per topic filter, so every matching filter gets
+  // the message.
+  for (const TPair<FString, IMqttMessageHandlerInterface *> &handler :
+       MsgFuncHandler) {
+    if (FMqttMemoryBroker::TopicMatches(handler.Key, message.Topic)) {
+      handler.Value->MessageHandler(message);
+    }
+  }
+
+  bool bDecoded = false;
+  for (const TPair<FString, IMqttDecodingHandlerPtr> &handler :
+       MsgDecodingHandler) {
+    if (FMqttMemoryBroker::TopicMatches(handler.Key, message.Topic)) {
+      if (!handler.Value->Decode(message)) {
+        Counters->DecodeErrors.fetch_add(1, std::memory_order_relaxed);
+      }
+      bDecoded = true;
+    }
+  }
+  if (bDecoded) {
+    Counters->AddHandler(FPlatformTime::Cycles64() - received);
+  }
+
+  TArray<FOnMessageHandlerDelegate, TInlineAllocator<1>> handlers;
+  for (const TPair<FString, FOnMessageHandlerDelegate> &handler :
+       MsgEventHandler) {
+    if (FMqttMemoryBroker::TopicMatches(handler.Key, message.Topic)) {
+      handlers.Add(handler.Value);
+    }
+  }
+
+  if (handlers.Num() > 0 || OnMessageDelegate.IsBound()) {
+    TWeakObjectPtr<UMqttMemoryClient> weakThis(this);
+    AsyncTask(ENamedThreads::GameThread, [weakThis, handlers, message,
+                                          received]() {
+      UMqttMemoryClient *client = weakThis.Get();
+      if (client == nullptr) {
+        return;
+      }
+
+      const uint64 dispatched = FPlatformTime::Cycles64();
+      client->Counters->AddDispatch(dispatched - received);
+      if (handlers.Num() > 0) {
+        FMqttLatencyTracer::Mark(EMqttLatencyStage::Delivered,
+                                 message.Timestamp);
+      }
+
+      for (const FOnMessageHandlerDelegate &handler : handlers) {
+        handler.ExecuteIfBound(message);
+      }
+      client->OnMessageDelegate.ExecuteIfBound(message);
+      client->Counters->AddHandler(FPlatformTime::Cycles64() - dispatched);
+    });
+  }
+}
+
+void UMqttMemoryClient::OnBrokerPublished(int mid) {
+  if (OnPublishDelegate.IsBound()) {
+    TWeakObjectPtr<UMqttMemoryClient> weakThis(this);
+    AsyncTask(ENamedThreads::GameThread, [weakThis, mid]() {
+      if (UMqttMemoryClient *client = weakThis.Get()) {
+        client->OnPublishDelegate.ExecuteIfBound(mid);
+      }
+    });
+  }
+}
+
+void UMqttMemoryClient::OnBrokerSubscribed(int mid, int grantedQos) {
+  TWeakObjectPtr<UMqttMemoryClient> weakThis(this);
+  AsyncTask(ENamedThreads::GameThread, [weakThis, mid, grantedQos]() {
+    if (UMqttMemoryClient *client = weakThis.Get()) {
+      client->OnSubscribeDelegate.ExecuteIfBound(mid,
+                                                 TArray<int>({grantedQos}));
+    }
+  });
+}
+
+void UMqttMemoryClient::OnBrokerUnsubscribed(int mid) {
+  TWeakObjectPtr<UMqttMemoryClient> weakThis(this);
+  AsyncTask(ENamedThreads::GameThread, [weakThis, mid]() {
+    if (UMqttMemoryClient *client = weakThis.Get()) {
+      client->OnUnsubscribeDelegate.ExecuteIfBound(mid);
+    }
+  });
+}
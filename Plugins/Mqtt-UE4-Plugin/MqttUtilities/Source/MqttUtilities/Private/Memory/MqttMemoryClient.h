@@ -0,0 +1,72 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MqttClientBase.h"
+#include "MqttMemoryBroker.h"
+
+#include "MqttMemoryClient.generated.h"
+
+/**
+ * Client of the in-process broker, selected by the "mem://<name>" host URL.
+ * Needs no network, so it serves automated tests and benchmarks as well as
+ * offline sessions; see FMqttMemoryBroker for the supported features.
+ *
+ * Subscriptions made before Connect are sent once connected. Typed decoders
+ * run on the broker thread, delegates on the game thread; like the network
+ * clients, Connect and Disconnect report back on a later game thread tick.
+ */
+UCLASS()
+class UMqttMemoryClient : public UMqttClientBase, public IMqttMemorySession {
+  GENERATED_BODY()
+
+ public:
+  void BeginDestroy() override;
+
+  void Connect(FMqttConnectionData connectionData) override;
+
+  void Disconnect() override;
+
+  void Subscribe(FString topic, int qos,
+                 const FOnMessageHandlerDelegate &handler) override;
+
+  void Subscribe(FString topic, int qos,
+                 IMqttMessageHandlerInterface *handler) override;
+
+  void Subscribe(FString topic, int qos,
+                 IMqttDecodingHandlerPtr handler) override;
+
+  void Unsubscribe(FString topic) override;
+
+  void Publish(FMqttMessage message) override;
+
+ public:
+  void Init(FMqttClientConfig configData) override;
+
+  static bool IsMemoryUrl(const FString &url);
+
+ private:
+  void SubscribeTopic(const FString &topic, int qos);
+  void DetachBroker();
+
+  // IMqttMemorySession, called on the broker thread.
+  void OnBrokerMessage(const FMqttMessage &message) override;
+  void OnBrokerPublished(int mid) override;
+  void OnBrokerSubscribed(int mid, int grantedQos) override;
+  void OnBrokerUnsubscribed(int mid) override;
+
+  FMqttClientConfig ClientConfig;
+
+  TSharedPtr<FMqttMemoryBroker, ESPMode::ThreadSafe> Broker;
+
+  // Topic filters and QoS, sent to the broker on Connect.
+  TMap<FString, int> Subscriptions;
+
+  FCriticalSection HandlerLock;
+  TMap<FString, IMqttMessageHandlerInterface *> MsgFuncHandler;
+  TMap<FString, FOnMessageHandlerDelegate> MsgEventHandler;
+  TMap<FString, IMqttDecodingHandlerPtr> MsgDecodingHandler;
+
+  FThreadSafeCounter NextMessageId;
+};
@@ -4,6 +4,22 @@
 
 UMqttClientBase::~UMqttClientBase() {}
 
+void UMqttClientBase::PostInitProperties() {
+  Super::PostInitProperties();
+
+  if (!HasAnyFlags(RF_ClassDefaultObject | RF_ArchetypeObject)) {
+    FMqttStatsSampler::Register(this);
+  }
+}
+
+void UMqttClientBase::BeginDestroy() {
+  if (!HasAnyFlags(RF_ClassDefaultObject | RF_ArchetypeObject)) {
+    FMqttStatsSampler::Unregister(this);
+  }
+
+  Super::BeginDestroy();
+}
+
 void UMqttClientBase::Connect(FMqttConnectionData connectionData) {
   // Not implementable
 }
@@ -22,6 +38,26 @@ void UMqttClientBase::Subscribe(FString topic, int qos,
   // Not implementable
 }
 
+void UMqttClientBase::Subscribe(FString topic, int qos,
+                                IMqttDecodingHandlerPtr handler) {
+  // Only the Windows, in-process and shared memory clients decode typed
+  // subscriptions. The Android, IOS and Mac clients report it instead of
+  // silently dropping the subscription.
+  UE_LOG(LogMqtt, Warning,
+         TEXT("MQTT => Typed subscriptions are not supported by this client. "
+              "Subscription to %s cancelled."),
+         *topic);
+  OnErrorDelegate.ExecuteIfBound(
+      -1, FString::Printf(TEXT("Typed subscription to %s is not supported"),
+                          *topic));
+}
+
+int UMqttClientBase::GetDecodeErrorCount() {
+  return Counters->DecodeErrors.load(std::memory_order_relaxed);
+}
+
+FMqttClientStats UMqttClientBase::GetStats() { return Stats; }
+
 void UMqttClientBase::Unsubscribe(FString topic) {
   // Not implementable
 }
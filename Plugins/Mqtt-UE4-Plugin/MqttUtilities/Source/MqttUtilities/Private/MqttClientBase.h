@@ -3,6 +3,7 @@
 #pragma once
 
 #include "Interface/MqttClientInterface.h"
+#include "MqttStats.h"
 
 #include "MqttClientBase.generated.h"
 
@@ -13,6 +14,9 @@ class UMqttClientBase : public UObject, public IMqttClientInterface {
 public:
   virtual ~UMqttClientBase();
 
+  void PostInitProperties() override;
+  void BeginDestroy() override;
+
   UFUNCTION(BlueprintCallable, Category = "MQTT")
   void Connect(FMqttConnectionData connectionData) override;
 
@@ -26,6 +30,15 @@ public:
   void Subscribe(FString topic, int qos,
                  IMqttMessageHandlerInterface *handler) override;
 
+  void Subscribe(FString topic, int qos,
+                 IMqttDecodingHandlerPtr handler) override;
+
+  UFUNCTION(BlueprintCallable, Category = "MQTT")
+  int GetDecodeErrorCount() override;
+
+  UFUNCTION(BlueprintCallable, Category = "MQTT")
+  FMqttClientStats GetStats() override;
+
   UFUNCTION(BlueprintCallable, Category = "MQTT")
   void Unsubscribe(FString topic) override;
 
@@ -78,4 +91,13 @@ protected:
   FOnUnsubscribeDelegate OnUnsubscribeDelegate;
   UPROPERTY()
   FOnMqttErrorDelegate OnErrorDelegate;
+
+  /** Updated from the MQTT thread and the game thread handlers */
+  FMqttClientCountersRef Counters =
+      MakeShared<FMqttClientCounters, ESPMode::ThreadSafe>();
+
+  /** Last sample of Counters, refreshed once per second */
+  FMqttClientStats Stats;
+
+  friend class FMqttStatsSampler;
 };
\ No newline at end of file
@@ -0,0 +1,54 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#include "MqttFlexbufferBuilder.h"
+
+#include "Containers/LockFreeList.h"
+#include "HAL/ThreadSafeCounter.h"
+
+namespace {
+
+// Builders kept in the pool, and the largest buffer worth keeping; a rare huge
+// message should not pin its memory for the life of the process.
+const int32 MaxFreeBuilders = 16;
+const size_t MaxKeptBufferSize = 1024 * 1024;
+
+TLockFreePointerListUnordered<flexbuffers::Builder, PLATFORM_CACHE_LINE_SIZE>
+    FreeBuilders;
+
+// Approximate, only used to bound the pool.
+FThreadSafeCounter NumFreeBuilders;
+
+}  // namespace
+
+FMqttFlexbufferBuilderPool::FScopedBuilder
+FMqttFlexbufferBuilderPool::Acquire() {
+  if (flexbuffers::Builder *builder = FreeBuilders.Pop()) {
+    NumFreeBuilders.Decrement();
+    return FScopedBuilder(builder);
+  }
+
+  return FScopedBuilder(new flexbuffers::Builder(1024));
+}
+
+void FMqttFlexbufferBuilderPool::Empty() {
+  while (flexbuffers::Builder *builder = FreeBuilders.Pop()) {
+    NumFreeBuilders.Decrement();
+    delete builder;
+  }
+}
+
+FMqttFlexbufferBuilderPool::FScopedBuilder::~FScopedBuilder() {
+  if (Builder == nullptr) {
+    return;
+  }
+
+  // Clear keeps the capacity of the buffer for the next message.
+  if (NumFreeBuilders.GetValue() < MaxFreeBuilders &&
+      Builder->GetSize() <= MaxKeptBufferSize) {
+    Builder->Clear();
+    NumFreeBuilders.Increment();
+    FreeBuilders.Push(Builder);
+  } else {
+    delete Builder;
+  }
+}
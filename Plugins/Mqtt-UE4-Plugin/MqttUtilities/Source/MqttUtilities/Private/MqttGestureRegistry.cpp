@@ -0,0 +1,181 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#include "MqttGestureRegistry.h"
+
+#include "MqttTrace.h"
+
+#include <cstdlib>
+
+namespace {
+
+FORCEINLINE ANSICHAR ToLower(ANSICHAR c) {
+  return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+// FNV-1a over the ASCII lower case bytes, matching the case-insensitive
+// compare below.
+uint32 HashName(const ANSICHAR *name, int32 len) {
+  uint32 hash = 2166136261u;
+  for (int32 i = 0; i < len; ++i) {
+    hash = (hash ^ (uint8)ToLower(name[i])) * 16777619u;
+  }
+  return hash;
+}
+
+bool NamesEqual(const TArray<ANSICHAR> &name, const ANSICHAR *other,
+                int32 len) {
+  if (name.Num() != len) {
+    return false;
+  }
+  for (int32 i = 0; i < len; ++i) {
+    if (ToLower(name[i]) != ToLower(other[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+TArray<ANSICHAR> ToUtf8(const FString &name) {
+  FTCHARToUTF8 utf8(*name);
+  return TArray<ANSICHAR>(utf8.Get(), utf8.Length());
+}
+
+}  // namespace
+
+FMqttGestureRegistry &FMqttGestureRegistry::Get() {
+  static FMqttGestureRegistry Instance;
+  return Instance;
+}
+
+void FMqttGestureRegistry::Register(
+    FName name, int32 id, const TArray<FMqttGestureParamSchema> &params) {
+  MQTT_LLM_SCOPE();
+
+  TUniquePtr<FEntry> entry = MakeUnique<FEntry>();
+  entry->Name = ToUtf8(name.ToString());
+  entry->DisplayName = name;
+  entry->Id = id;
+
+  for (const FMqttGestureParamSchema &schema : params) {
+    FParam &param = entry->Params.AddDefaulted_GetRef();
+    param.Type = schema.Type;
+
+    if (schema.Type == EMqttGestureParamType::Enum && schema.Enum != nullptr) {
+      const int32 num = schema.Enum->ContainsExistingMax()
+                            ? schema.Enum->NumEnums() - 1
+                            : schema.Enum->NumEnums();
+      for (int32 i = 0; i < num; ++i) {
+        FNamedValue &value = param.EnumValues.AddDefaulted_GetRef();
+        value.Name = ToUtf8(schema.Enum->GetNameStringByIndex(i));
+        value.Value = (int32)schema.Enum->GetValueByIndex(i);
+      }
+    }
+  }
+
+  const uint32 hash = HashName(entry->Name.GetData(), entry->Name.Num());
+
+  FRWScopeLock lock(Lock, SLT_Write);
+
+  for (auto it = EntriesByHash.CreateKeyIterator(hash); it; ++it) {
+    if (NamesEqual(it.Value()->Name, entry->Name.GetData(),
+                   entry->Name.Num())) {
+      const FEntry *existing = it.Value();
+      it.RemoveCurrent();
+      Entries.RemoveAllSwap([existing](const TUniquePtr<FEntry> &other) {
+        return other.Get() == existing;
+      });
+      break;
+    }
+  }
+
+  EntriesByHash.Add(hash, entry.Get());
+  Entries.Add(MoveTemp(entry));
+}
+
+void FMqttGestureRegistry::RegisterEnum(
+    const UEnum *gestures, const TArray<FMqttGestureParamSchema> &params) {
+  if (gestures == nullptr) {
+    return;
+  }
+
+  const int32 num = gestures->ContainsExistingMax() ? gestures->NumEnums() - 1
+                                                    : gestures->NumEnums();
+  for (int32 i = 0; i < num; ++i) {
+    Register(FName(*gestures->GetNameStringByIndex(i)),
+             (int32)gestures->GetValueByIndex(i), params);
+  }
+}
+
+void FMqttGestureRegistry::Resolve(const flexbuffers::Reference &name,
+                                   const flexbuffers::Reference *params,
+                                   int32 numParams, FMqttGesture &out) const {
+  MQTT_TRACE_SCOPE(Mqtt_ResolveGesture);
+
+  const flexbuffers::String str = name.AsString();
+  const int32 len = (int32)str.length();
+  const uint32 hash = HashName(str.c_str(), len);
+
+  FRWScopeLock lock(Lock, SLT_ReadOnly);
+
+  const FEntry *entry = nullptr;
+  for (auto it = EntriesByHash.CreateConstKeyIterator(hash); it; ++it) {
+    if (NamesEqual(it.Value()->Name, str.c_str(), len)) {
+      entry = it.Value();
+      break;
+    }
+  }
+
+  out.Id = entry != nullptr ? entry->Id : INDEX_NONE;
+  out.Name = entry != nullptr ? entry->DisplayName : NAME_None;
+
+  out.Params.SetNum(numParams, false);
+  for (int32 i = 0; i < numParams; ++i) {
+    const FParam *schema = entry != nullptr && entry->Params.IsValidIndex(i)
+                               ? &entry->Params[i]
+                               : nullptr;
+    ParseParam(params[i], schema, out.Params[i]);
+  }
+}
+
+void FMqttGestureRegistry::ParseParam(const flexbuffers::Reference &value,
+                                      const FParam *schema,
+                                      FMqttGestureParam &out) {
+  out.Type = schema != nullptr ? schema->Type : EMqttGestureParamType::String;
+  out.Float = 0.0f;
+  out.Int = 0;
+
+  // Producers send every parameter as a string; numbers are read from it in
+  // place.
+  const bool bString = value.IsString();
+  const flexbuffers::String str =
+      bString ? value.AsString() : flexbuffers::String::EmptyString();
+
+  switch (out.Type) {
+    case EMqttGestureParamType::Float:
+      out.Float = bString ? strtof(str.c_str(), nullptr) : value.AsFloat();
+      out.String.Reset();
+      break;
+    case EMqttGestureParamType::Int:
+      out.Int = bString ? (int32)strtol(str.c_str(), nullptr, 10)
+                        : (int32)value.AsInt64();
+      out.String.Reset();
+      break;
+    case EMqttGestureParamType::Enum:
+      out.Int = INDEX_NONE;
+      for (const FNamedValue &named : schema->EnumValues) {
+        if (NamesEqual(named.Name, str.c_str(), (int32)str.length())) {
+          out.Int = named.Value;
+          break;
+        }
+      }
+      out.String.Reset();
+      break;
+    case EMqttGestureParamType::String: {
+      // Assigning into the reused string keeps its allocation.
+      FUTF8ToTCHAR converted(str.c_str(), str.length());
+      out.String.Reset(converted.Length() + 1);
+      out.String.AppendChars(converted.Get(), converted.Length());
+      break;
+    }
+  }
+}
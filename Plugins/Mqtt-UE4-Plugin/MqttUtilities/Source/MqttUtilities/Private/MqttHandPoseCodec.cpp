@@ -0,0 +1,280 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#include "MqttHandPoseCodec.h"
+
+#include "MqttTrace.h"
+
+namespace {
+
+const uint8 FormatVersion = 1;
+const uint8 KeyframeFlag = 1 << 0;
+const uint8 RightHandFlag = 1 << 1;
+
+const int32 NumValues = (FMqttHandPoseEncoder::NumLandmarks - 1) * 3;
+const int32 HeaderSize = 3;
+const int32 KeyframeSize = HeaderSize + 4 + 12 + NumValues * 2;
+const int32 DeltaHeaderSize = HeaderSize + 12 + 1;
+
+// Residuals are int16 differences, so 17 bits would be needed in the worst
+// case; widths above this force a keyframe instead.
+const int32 MaxResidualBits = 16;
+
+FORCEINLINE uint32 ZigZag(int32 value) {
+  return ((uint32)value << 1) ^ (uint32)(value >> 31);
+}
+
+FORCEINLINE int32 UnZigZag(uint32 value) {
+  return (int32)(value >> 1) ^ -(int32)(value & 1);
+}
+
+template <typename T>
+FORCEINLINE void Write(uint8 *&cursor, T value) {
+  FMemory::Memcpy(cursor, &value, sizeof(T));
+  cursor += sizeof(T);
+}
+
+template <typename T>
+FORCEINLINE T Read(const uint8 *&cursor) {
+  T value;
+  FMemory::Memcpy(&value, cursor, sizeof(T));
+  cursor += sizeof(T);
+  return value;
+}
+
+}  // namespace
+
+FMqttHandPoseEncoder::FMqttHandPoseEncoder(
+    const FMqttHandPoseCodecSettings &settings)
+    : Settings(settings),
+      Step(FMath::Max(settings.ErrorBound, SMALL_NUMBER) * 2.0f) {}
+
+void FMqttHandPoseEncoder::ForceKeyframe() {
+  Hands[0].FramesSinceKeyframe = -1;
+  Hands[1].FramesSinceKeyframe = -1;
+}
+
+void FMqttHandPoseEncoder::Encode(const FVector *landmarks, bool bRightHand,
+                                  TArray<uint8> &out) {
+  MQTT_TRACE_SCOPE(Mqtt_EncodeHandPose);
+
+  FHandState &hand = Hands[bRightHand ? 1 : 0];
+  const FVector palm = landmarks[0];
+
+  int16 quantized[NumValues];
+  const float invStep = 1.0f / Step;
+  for (int32 i = 0; i < NumValues; ++i) {
+    const float relative = landmarks[1 + i / 3][i % 3] - palm[i % 3];
+    quantized[i] = (int16)FMath::Clamp(FMath::RoundToInt(relative * invStep),
+                                       -32767, 32767);
+  }
+
+  // Residual width of a delta frame; OR-ing the zigzag values gives the
+  // highest bit any of them needs.
+  uint32 combined = 0;
+  int32 residuals[NumValues];
+  for (int32 i = 0; i < NumValues; ++i) {
+    residuals[i] = (int32)quantized[i] - (int32)hand.Quantized[i];
+    combined |= ZigZag(residuals[i]);
+  }
+  const uint32 bits = 32 - FMath::CountLeadingZeros(combined);
+
+  const bool bKeyframe =
+      hand.FramesSinceKeyframe < 0 ||
+      hand.FramesSinceKeyframe + 1 >=
+          FMath::Max(Settings.KeyframeInterval, 1) ||
+      bits > (uint32)MaxResidualBits;
+
+  ++hand.Sequence;
+  hand.FramesSinceKeyframe = bKeyframe ? 0 : hand.FramesSinceKeyframe + 1;
+
+  const uint8 flags = (FormatVersion << 4) |
+                      (bRightHand ? RightHandFlag : 0) |
+                      (bKeyframe ? KeyframeFlag : 0);
+
+  if (bKeyframe) {
+    out.SetNumUninitialized(KeyframeSize, false);
+    uint8 *cursor = out.GetData();
+    Write<uint8>(cursor, flags);
+    Write<uint16>(cursor, hand.Sequence);
+    Write<float>(cursor, Step);
+    Write<float>(cursor, palm.X);
+    Write<float>(cursor, palm.Y);
+    Write<float>(cursor, palm.Z);
+    FMemory::Memcpy(cursor, quantized, sizeof(quantized));
+  } else {
+    const int32 packedSize = (NumValues * bits + 7) / 8;
+    out.SetNumUninitialized(DeltaHeaderSize + packedSize, false);
+    uint8 *cursor = out.GetData();
+    Write<uint8>(cursor, flags);
+    Write<uint16>(cursor, hand.Sequence);
+    Write<float>(cursor, palm.X);
+    Write<float>(cursor, palm.Y);
+    Write<float>(cursor, palm.Z);
+    Write<uint8>(cursor, (uint8)bits);
+
+    uint64 buffer = 0;
+    uint32 buffered = 0;
+    for (int32 i = 0; i < NumValues; ++i) {
+      buffer |= (uint64)ZigZag(residuals[i]) << buffered;
+      buffered += bits;
+      while (buffered >= 8) {
+        *cursor++ = (uint8)buffer;
+        buffer >>= 8;
+        buffered -= 8;
+      }
+    }
+    if (buffered > 0) {
+      *cursor++ = (uint8)buffer;
+    }
+  }
+
+  FMemory::Memcpy(hand.Quantized, quantized, sizeof(quantized));
+}
+
+bool FMqttHandPoseDecoder::Decode(const uint8 *data, int32 size,
+                                  FVector *outLandmarks, bool &bRightHand) {
+  MQTT_TRACE_SCOPE(Mqtt_DecodeHandPose);
+
+  if (data == nullptr || size < HeaderSize) {
+    return false;
+  }
+
+  const uint8 *cursor = data;
+  const uint8 flags = Read<uint8>(cursor);
+  const uint16 sequence = Read<uint16>(cursor);
+
+  if ((flags >> 4) != FormatVersion) {
+    return false;
+  }
+
+  bRightHand = (flags & RightHandFlag) != 0;
+  FHandState &hand = Hands[bRightHand ? 1 : 0];
+  FVector palm;
+
+  if (flags & KeyframeFlag) {
+    if (size < KeyframeSize) {
+      return false;
+    }
+
+    hand.Step = Read<float>(cursor);
+    palm.X = Read<float>(cursor);
+    palm.Y = Read<float>(cursor);
+    palm.Z = Read<float>(cursor);
+    FMemory::Memcpy(hand.Quantized, cursor, sizeof(hand.Quantized));
+    hand.bValid = true;
+  } else {
+    if (!hand.bValid || sequence != (uint16)(hand.Sequence + 1) ||
+        size < DeltaHeaderSize) {
+      hand.bValid = false;
+      return false;
+    }
+
+    palm.X = Read<float>(cursor);
+    palm.Y = Read<float>(cursor);
+    palm.Z = Read<float>(cursor);
+    const uint32 bits = Read<uint8>(cursor);
+    const int32 packedSize = (NumValues * bits + 7) / 8;
+    if (bits > (uint32)MaxResidualBits ||
+        size < DeltaHeaderSize + packedSize) {
+      hand.bValid = false;
+      return false;
+    }
+
+    // Copy into a zero padded buffer so every value can be read with one
+    // unaligned 64-bit load, without bounds checks or per-value branches.
+    uint8 packed[(NumValues * MaxResidualBits + 7) / 8 + sizeof(uint64)] = {};
+    FMemory::Memcpy(packed, cursor, packedSize);
+
+    const uint64 mask = (1ull << bits) - 1;
+    for (int32 i = 0; i < NumValues; ++i) {
+      const uint32 bit = i * bits;
+      uint64 word;
+      FMemory::Memcpy(&word, packed + (bit >> 3), sizeof(word));
+      const uint32 zigzag = (uint32)((word >> (bit & 7)) & mask);
+      hand.Quantized[i] = (int16)(hand.Quantized[i] + UnZigZag(zigzag));
+    }
+  }
+
+  hand.Sequence = sequence;
+
+  // Dequantize as one flat loop over floats, which the compiler vectorizes.
+  float values[NumValues];
+  const float step = hand.Step;
+  for (int32 i = 0; i < NumValues; ++i) {
+    values[i] = (float)hand.Quantized[i] * step;
+  }
+
+  outLandmarks[0] = palm;
+  for (int32 i = 1; i < NumLandmarks; ++i) {
+    const float *v = &values[(i - 1) * 3];
+    outLandmarks[i] = FVector(palm.X + v[0], palm.Y + v[1], palm.Z + v[2]);
+  }
+
+  return true;
+}
+
+UMqttHandPoseCodec *UMqttHandPoseCodec::CreateHandPoseCodec(
+    const FMqttHandPoseCodecSettings &settings) {
+  UMqttHandPoseCodec *codec = NewObject<UMqttHandPoseCodec>();
+  codec->Encoder = MakeUnique<FMqttHandPoseEncoder>(settings);
+  codec->Decoder = MakeUnique<FMqttHandPoseDecoder>();
+  return codec;
+}
+
+TArray<uint8> UMqttHandPoseCodec::EncodeFingerPose(const FFingerPose &pose) {
+  TArray<uint8> out;
+  if (!Encoder.IsValid()) {
+    Encoder = MakeUnique<FMqttHandPoseEncoder>();
+  }
+
+  FVector landmarks[FMqttHandPoseEncoder::NumLandmarks];
+  PoseToLandmarks(pose, landmarks);
+  Encoder->Encode(landmarks,
+                  pose.hand.Equals(TEXT("right"), ESearchCase::IgnoreCase),
+                  out);
+  return out;
+}
+
+bool UMqttHandPoseCodec::DecodeFingerPose(const TArray<uint8> &data,
+                                          FFingerPose &pose) {
+  if (!Decoder.IsValid()) {
+    Decoder = MakeUnique<FMqttHandPoseDecoder>();
+  }
+
+  FVector landmarks[FMqttHandPoseDecoder::NumLandmarks];
+  bool bRightHand = false;
+  if (!Decoder->Decode(data.GetData(), data.Num(), landmarks, bRightHand)) {
+    return false;
+  }
+
+  LandmarksToPose(landmarks, bRightHand, pose);
+  return true;
+}
+
+void UMqttHandPoseCodec::PoseToLandmarks(const FFingerPose &pose,
+                                         FVector *landmarks) {
+  const TArray<FVector> *fingers[] = {&pose.Thumb, &pose.Index, &pose.Middle,
+                                      &pose.Ring, &pose.Pinky};
+
+  landmarks[0] = pose.Palm;
+  for (int32 finger = 0; finger < 5; ++finger) {
+    for (int32 joint = 0; joint < 4; ++joint) {
+      landmarks[1 + finger * 4 + joint] =
+          fingers[finger]->IsValidIndex(joint) ? (*fingers[finger])[joint]
+                                               : pose.Palm;
+    }
+  }
+}
+
+void UMqttHandPoseCodec::LandmarksToPose(const FVector *landmarks,
+                                         bool bRightHand, FFingerPose &pose) {
+  TArray<FVector> *fingers[] = {&pose.Thumb, &pose.Index, &pose.Middle,
+                                &pose.Ring, &pose.Pinky};
+
+  pose.hand = bRightHand ? TEXT("right") : TEXT("left");
+  pose.Palm = landmarks[0];
+  for (int32 finger = 0; finger < 5; ++finger) {
+    fingers[finger]->Reset(4);
+    fingers[finger]->Append(&landmarks[1 + finger * 4], 4);
+  }
+}
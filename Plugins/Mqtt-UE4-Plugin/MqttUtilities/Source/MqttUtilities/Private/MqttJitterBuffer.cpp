@@ -0,0 +1,117 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#include "MqttJitterBuffer.h"
+
+#include "Misc/ScopeLock.h"
+#include "MqttTrace.h"
+
+FMqttPlayoutClock::FMqttPlayoutClock(const FMqttJitterBufferSettings &settings)
+    : Settings(settings), TransitCount(0), TransitIndex(0), Offset(0.0),
+      Jitter(0.0), Delay(settings.MinDelayMs * 0.001) {}
+
+void FMqttPlayoutClock::AddSample(double captureTime, double arrivalTime) {
+  const double transit = arrivalTime - captureTime;
+
+  Transit[TransitIndex] = transit;
+  TransitIndex = (TransitIndex + 1) % OffsetWindow;
+  TransitCount = FMath::Min(TransitCount + 1, OffsetWindow);
+
+  Offset = Transit[0];
+  for (int32 i = 1; i < TransitCount; ++i) {
+    Offset = FMath::Min(Offset, Transit[i]);
+  }
+
+  // Smoothed like the RFC 3550 interarrival jitter.
+  Jitter += ((transit - Offset) - Jitter) / 16.0;
+
+  const double minDelay = Settings.MinDelayMs * 0.001;
+  const double maxDelay = FMath::Max(Settings.MaxDelayMs * 0.001, minDelay);
+  const double target =
+      FMath::Clamp(minDelay + Settings.JitterFactor * Jitter, minDelay, maxDelay);
+
+  Delay += (target - Delay) * FMath::Clamp(Settings.AdaptRate, 0.0f, 1.0f);
+}
+
+void FMqttPlayoutClock::Reset() {
+  TransitCount = 0;
+  TransitIndex = 0;
+  Offset = 0.0;
+}
+
+void FMqttPlayoutClock::OnUnderrun() {
+  const double maxDelay = Settings.MaxDelayMs * 0.001;
+  Delay = FMath::Min(Delay + FMath::Max(Settings.MinDelayMs * 0.001, 0.005),
+                     FMath::Max(maxDelay, Delay));
+}
+
+bool MqttReadFrameHeader(const TArray<uint8> &payload,
+                         const FMqttJitterBufferSettings &settings,
+                         int64 &sequence, double &captureTime) {
+  const FMqttFlexbufferKey sequenceKey(settings.SequenceKey);
+  const FMqttFlexbufferKey timestampKey(settings.TimestampKey);
+  return MqttReadFrameHeader(payload.GetData(), payload.Num(), sequenceKey,
+                             timestampKey, settings.TimestampUnit, sequence,
+                             captureTime);
+}
+
+bool MqttReadFrameHeader(const uint8 *data, int32 size,
+                         const FMqttFlexbufferKey &sequenceKey,
+                         const FMqttFlexbufferKey &timestampKey,
+                         double timestampUnit, int64 &sequence,
+                         double &captureTime) {
+  MQTT_TRACE_SCOPE(Mqtt_ReadFrameHeader);
+
+  if (data == nullptr || size < 3) {
+    return false;
+  }
+
+  flexbuffers::Reference root = flexbuffers::GetRoot(data, size);
+  if (!root.IsMap()) {
+    return false;
+  }
+
+  flexbuffers::Map map = root.AsMap();
+  flexbuffers::Reference seq = sequenceKey.Find(map);
+  flexbuffers::Reference ts = timestampKey.Find(map);
+  if (!seq.IsNumeric() || !ts.IsNumeric()) {
+    return false;
+  }
+
+  sequence = seq.AsInt64();
+  captureTime = ts.AsDouble() * timestampUnit;
+  return true;
+}
+
+namespace {
+
+FCriticalSection RegistryLock;
+TMap<FString, TWeakPtr<IMqttJitterBuffer, ESPMode::ThreadSafe>> Registry;
+
+}  // namespace
+
+void IMqttJitterBuffer::Register(
+    const FString &topic,
+    const TSharedRef<IMqttJitterBuffer, ESPMode::ThreadSafe> &buffer) {
+  FScopeLock lock(&RegistryLock);
+  Registry.Add(topic, buffer);
+}
+
+bool IMqttJitterBuffer::FindStats(const FString &topic,
+                                  FMqttJitterBufferStats &out) {
+  TSharedPtr<IMqttJitterBuffer, ESPMode::ThreadSafe> buffer;
+  {
+    FScopeLock lock(&RegistryLock);
+    const TWeakPtr<IMqttJitterBuffer, ESPMode::ThreadSafe> *entry =
+        Registry.Find(topic);
+    if (entry != nullptr) {
+      buffer = entry->Pin();
+    }
+  }
+
+  if (!buffer.IsValid()) {
+    return false;
+  }
+
+  out = buffer->GetStats();
+  return true;
+}
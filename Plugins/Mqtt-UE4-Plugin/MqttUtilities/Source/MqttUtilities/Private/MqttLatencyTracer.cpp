@@ -0,0 +1,347 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#include "MqttLatencyTracer.h"
+
+#include "Containers/Ticker.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTLS.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/ScopeLock.h"
+#include "MqttStats.h"
+#include "MqttUtilitiesBPL.h"
+#include "Trace/Trace.h"
+
+#include <atomic>
+
+#if UE_TRACE_ENABLED
+
+UE_TRACE_CHANNEL(MqttLatencyChannel)
+
+UE_TRACE_EVENT_BEGIN(MqttLatency, Sample)
+  UE_TRACE_EVENT_FIELD(uint64, Cycle)
+  UE_TRACE_EVENT_FIELD(int64, CaptureUs)
+  UE_TRACE_EVENT_FIELD(int64, LatencyUs)
+  UE_TRACE_EVENT_FIELD(uint32, ThreadId)
+  UE_TRACE_EVENT_FIELD(uint8, Stage)
+UE_TRACE_EVENT_END()
+
+#endif
+
+namespace {
+
+const int32 NumStages = (int32)EMqttLatencyStage::Presented + 1;
+
+TAutoConsoleVariable<int32> CVarLatencyTrace(
+    TEXT("mqtt.LatencyTrace"), 0,
+    TEXT("Stamp hand pipeline latency markers for messages with a capture "
+         "timestamp. See Mqtt.LatencyReport."));
+
+struct FSample {
+  uint64 Cycle;
+  int64 CaptureUs;
+  int64 TimeUs;
+  uint8 Stage;
+};
+
+/** Single producer (the owning thread), single consumer (the game thread). */
+struct FThreadBuffer {
+  static const uint32 Capacity = 4096;
+
+  FSample Samples[Capacity];
+  std::atomic<uint32> Head{0};
+  std::atomic<uint32> Tail{0};
+  uint32 ThreadId = 0;
+};
+
+/**
+ * Log-linear histogram of microseconds: eight buckets per power of two, so
+ * every bucket is within 12.5% of its values, up to about 16 seconds.
+ */
+struct FHistogram {
+  static const int32 SubBuckets = 8;
+  static const int32 MaxExponent = 24;
+  static const int32 NumBuckets = (MaxExponent - 1) * SubBuckets;
+
+  uint32 Buckets[NumBuckets];
+  int64 Count;
+  int64 Negative;
+  int64 Sum;
+  int64 Max;
+
+  FHistogram() { Reset(); }
+
+  void Reset() {
+    FMemory::Memzero(Buckets);
+    Count = 0;
+    Negative = 0;
+    Sum = 0;
+    Max = 0;
+  }
+
+  static int32 BucketOf(int64 us) {
+    if (us < SubBuckets) {
+      return (int32)us;
+    }
+    const int32 exponent = (int32)FMath::FloorLog2_64((uint64)us);
+    if (exponent >= MaxExponent) {
+      return NumBuckets - 1;
+    }
+    const int32 mantissa = (int32)(us >> (exponent - 3)) & (SubBuckets - 1);
+    return (exponent - 2) * SubBuckets + mantissa;
+  }
+
+  static int64 LowerBound(int32 bucket) {
+    if (bucket < SubBuckets) {
+      return bucket;
+    }
+    const int32 exponent = bucket / SubBuckets + 2;
+    const int64 mantissa = SubBuckets + bucket % SubBuckets;
+    return mantissa << (exponent - 3);
+  }
+
+  void Add(int64 us) {
+    if (us < 0) {
+      ++Negative;
+      us = 0;
+    }
+    ++Buckets[BucketOf(us)];
+    ++Count;
+    Sum += us;
+    Max = FMath::Max(Max, us);
+  }
+
+  int64 Percentile(double p) const {
+    const int64 rank = (int64)(p * (Count - 1));
+    int64 seen = 0;
+    for (int32 i = 0; i < NumBuckets; ++i) {
+      seen += Buckets[i];
+      if (seen > rank) {
+        return FMath::Min(LowerBound(i), Max);
+      }
+    }
+    return Max;
+  }
+};
+
+FCriticalSection BuffersLock;
+TArray<TUniquePtr<FThreadBuffer>> Buffers;
+thread_local FThreadBuffer *LocalBuffer = nullptr;
+
+std::atomic<int64> Dropped{0};
+std::atomic<int64> Latest[NumStages][FMqttLatencyTracer::MaxSources];
+
+// Game thread only.
+FHistogram Histograms[NumStages];
+FDelegateHandle TickerHandle;
+FDelegateHandle EndFrameHandle;
+
+const TCHAR *StageName(int32 stage) {
+  static const TCHAR *Names[NumStages] = {TEXT("Received"), TEXT("Decoded"),
+                                          TEXT("Delivered"), TEXT("Applied"),
+                                          TEXT("Presented")};
+  return Names[stage];
+}
+
+/** UTC microseconds from the cycle counter, which is much cheaper to read. */
+int64 CyclesToUtcMicroseconds(uint64 cycles) {
+  static const double Offset =
+      (double)UMqttUtilitiesBPL::GetUnixTimeMicroseconds() -
+      FPlatformTime::ToSeconds64(FPlatformTime::Cycles64()) * 1e6;
+  return (int64)(FPlatformTime::ToSeconds64(cycles) * 1e6 + Offset);
+}
+
+FThreadBuffer &GetLocalBuffer() {
+  if (LocalBuffer == nullptr) {
+    TUniquePtr<FThreadBuffer> buffer = MakeUnique<FThreadBuffer>();
+    buffer->ThreadId = FPlatformTLS::GetCurrentThreadId();
+    LocalBuffer = buffer.Get();
+
+    FScopeLock lock(&BuffersLock);
+    Buffers.Add(MoveTemp(buffer));
+  }
+  return *LocalBuffer;
+}
+
+void Push(EMqttLatencyStage stage, int64 captureUs) {
+  FThreadBuffer &buffer = GetLocalBuffer();
+  const uint32 head = buffer.Head.load(std::memory_order_relaxed);
+  if (head - buffer.Tail.load(std::memory_order_acquire) >=
+      FThreadBuffer::Capacity) {
+    Dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  FSample &sample = buffer.Samples[head % FThreadBuffer::Capacity];
+  sample.Cycle = FPlatformTime::Cycles64();
+  sample.CaptureUs = captureUs;
+  sample.TimeUs = CyclesToUtcMicroseconds(sample.Cycle);
+  sample.Stage = (uint8)stage;
+  buffer.Head.store(head + 1, std::memory_order_release);
+}
+
+void OnEndFrameRT() {
+  FMqttLatencyTracer::MarkLatest(EMqttLatencyStage::Presented);
+}
+
+void LogReport() {
+  TArray<FMqttLatencyStageStats> stats;
+  FMqttLatencyTracer::GetStats(stats);
+
+  UE_LOG(LogMqtt, Log,
+         TEXT("MQTT => Latency since capture (ms), %lld samples dropped"),
+         Dropped.load(std::memory_order_relaxed));
+  UE_LOG(LogMqtt, Log,
+         TEXT("MQTT =>   stage       count    p50    p90    p99    max   "
+              "+p50"));
+
+  float previous = 0.0f;
+  for (const FMqttLatencyStageStats &stage : stats) {
+    UE_LOG(LogMqtt, Log,
+           TEXT("MQTT =>   %-10s %6d %6.2f %6.2f %6.2f %6.2f %+6.2f%s"),
+           StageName((int32)stage.Stage), stage.Count, stage.P50Ms,
+           stage.P90Ms, stage.P99Ms, stage.MaxMs, stage.P50Ms - previous,
+           stage.Negative > 0 ? TEXT(" (clock skew)") : TEXT(""));
+    if (stage.Count > 0) {
+      previous = stage.P50Ms;
+    }
+  }
+}
+
+void RunReport(const TArray<FString> &args) {
+  if (args.Num() > 0 && args[0] == TEXT("reset")) {
+    FMqttLatencyTracer::Reset();
+    return;
+  }
+  LogReport();
+}
+
+FAutoConsoleCommand ReportCommand(
+    TEXT("Mqtt.LatencyReport"),
+    TEXT("Logs per-stage latency since capture of the hand pipeline. Usage: "
+         "Mqtt.LatencyReport [reset]"),
+    FConsoleCommandWithArgsDelegate::CreateStatic(&RunReport));
+
+}  // namespace
+
+void FMqttLatencyTracer::Startup() {
+  for (std::atomic<int64>(&stage)[MaxSources] : Latest) {
+    for (std::atomic<int64> &latest : stage) {
+      latest.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  TickerHandle = FTicker::GetCoreTicker().AddTicker(
+      FTickerDelegate::CreateStatic(&FMqttLatencyTracer::Tick), 0.0f);
+  EndFrameHandle = FCoreDelegates::OnEndFrameRT.AddStatic(&OnEndFrameRT);
+}
+
+void FMqttLatencyTracer::Shutdown() {
+  FTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+  FCoreDelegates::OnEndFrameRT.Remove(EndFrameHandle);
+  TickerHandle.Reset();
+  EndFrameHandle.Reset();
+}
+
+bool FMqttLatencyTracer::IsEnabled() {
+  return CVarLatencyTrace.GetValueOnAnyThread() != 0;
+}
+
+void FMqttLatencyTracer::SetEnabled(bool bEnabled) {
+  CVarLatencyTrace->Set(bEnabled ? 1 : 0, ECVF_SetByCode);
+}
+
+void FMqttLatencyTracer::Mark(EMqttLatencyStage stage, int64 captureUs) {
+  if (captureUs == 0 || !IsEnabled()) {
+    return;
+  }
+
+  Push(stage, captureUs);
+}
+
+void FMqttLatencyTracer::MarkOnce(EMqttLatencyStage stage, int64 captureUs,
+                                  int32 source) {
+  if (captureUs == 0 || source < 0 || source >= MaxSources || !IsEnabled()) {
+    return;
+  }
+
+  // Exchanged so that threads racing on the same capture record it once.
+  if (Latest[(int32)stage][source].exchange(
+          captureUs, std::memory_order_relaxed) != captureUs) {
+    Push(stage, captureUs);
+  }
+}
+
+void FMqttLatencyTracer::MarkLatest(EMqttLatencyStage stage) {
+  if (stage == EMqttLatencyStage::Received || !IsEnabled()) {
+    return;
+  }
+
+  for (int32 source = 0; source < MaxSources; ++source) {
+    MarkOnce(stage,
+             Latest[(int32)stage - 1][source].load(std::memory_order_relaxed),
+             source);
+  }
+}
+
+void FMqttLatencyTracer::GetStats(TArray<FMqttLatencyStageStats> &out) {
+  check(IsInGameThread());
+  Drain();
+
+  out.SetNum(NumStages);
+  for (int32 i = 0; i < NumStages; ++i) {
+    const FHistogram &histogram = Histograms[i];
+    FMqttLatencyStageStats &stats = out[i];
+    stats = FMqttLatencyStageStats();
+    stats.Stage = (EMqttLatencyStage)i;
+    stats.Count = (int32)histogram.Count;
+    stats.Negative = (int32)histogram.Negative;
+    if (histogram.Count > 0) {
+      stats.MeanMs = histogram.Sum * 0.001f / histogram.Count;
+      stats.P50Ms = histogram.Percentile(0.50) * 0.001f;
+      stats.P90Ms = histogram.Percentile(0.90) * 0.001f;
+      stats.P99Ms = histogram.Percentile(0.99) * 0.001f;
+      stats.MaxMs = histogram.Max * 0.001f;
+    }
+  }
+}
+
+void FMqttLatencyTracer::Reset() {
+  check(IsInGameThread());
+  Drain();
+
+  for (FHistogram &histogram : Histograms) {
+    histogram.Reset();
+  }
+  Dropped.store(0, std::memory_order_relaxed);
+}
+
+bool FMqttLatencyTracer::Tick(float deltaTime) {
+  Drain();
+  return true;
+}
+
+void FMqttLatencyTracer::Drain() {
+  FScopeLock lock(&BuffersLock);
+
+  for (const TUniquePtr<FThreadBuffer> &buffer : Buffers) {
+    const uint32 tail = buffer->Tail.load(std::memory_order_relaxed);
+    const uint32 head = buffer->Head.load(std::memory_order_acquire);
+
+    for (uint32 i = tail; i != head; ++i) {
+      const FSample &sample = buffer->Samples[i % FThreadBuffer::Capacity];
+      const int64 latency = sample.TimeUs - sample.CaptureUs;
+
+      Histograms[sample.Stage].Add(latency);
+
+#if UE_TRACE_ENABLED
+      UE_TRACE_LOG(MqttLatency, Sample, MqttLatencyChannel)
+          << Sample.Cycle(sample.Cycle) << Sample.CaptureUs(sample.CaptureUs)
+          << Sample.LatencyUs(latency) << Sample.ThreadId(buffer->ThreadId)
+          << Sample.Stage(sample.Stage);
+#endif
+    }
+
+    buffer->Tail.store(head, std::memory_order_release);
+  }
+}
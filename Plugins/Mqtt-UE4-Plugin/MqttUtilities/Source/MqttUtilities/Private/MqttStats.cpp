@@ -0,0 +1,204 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#include "MqttStats.h"
+
+#include "Containers/Ticker.h"
+#include "HAL/PlatformTime.h"
+#include "MqttClientBase.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "Stats/Stats.h"
+
+DEFINE_LOG_CATEGORY(LogMqtt);
+
+DECLARE_STATS_GROUP(TEXT("MQTT"), STATGROUP_Mqtt, STATCAT_Advanced);
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Clients"), STAT_MqttClients,
+                               STATGROUP_Mqtt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Messages in/s"), STAT_MqttMessagesIn,
+                               STATGROUP_Mqtt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Messages out/s"), STAT_MqttMessagesOut,
+                               STATGROUP_Mqtt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Bytes in/s"), STAT_MqttBytesIn,
+                               STATGROUP_Mqtt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Bytes out/s"), STAT_MqttBytesOut,
+                               STATGROUP_Mqtt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Queue depth"), STAT_MqttQueueDepth,
+                               STATGROUP_Mqtt);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Dispatch latency (ms)"),
+                               STAT_MqttDispatchLatency, STATGROUP_Mqtt);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Handler time (ms)"), STAT_MqttHandlerTime,
+                               STATGROUP_Mqtt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Reconnects"), STAT_MqttReconnects,
+                               STATGROUP_Mqtt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Decode errors"), STAT_MqttDecodeErrors,
+                               STATGROUP_Mqtt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Dropped messages"), STAT_MqttDropped,
+                               STATGROUP_Mqtt);
+
+CSV_DEFINE_CATEGORY(Mqtt, true);
+
+namespace {
+
+struct FSnapshot {
+  int64 MessagesIn = 0;
+  int64 BytesIn = 0;
+  int64 MessagesOut = 0;
+  int64 BytesOut = 0;
+  uint64 DispatchCycles = 0;
+  int64 Dispatched = 0;
+  uint64 HandlerCycles = 0;
+  int64 Handled = 0;
+};
+
+struct FClientEntry {
+  TWeakObjectPtr<UMqttClientBase> Client;
+  FSnapshot Previous;
+  /** FPlatformTime::Seconds() of Previous. */
+  double PreviousTime = 0.0;
+};
+
+TArray<FClientEntry> Clients;
+FDelegateHandle TickerHandle;
+
+double AverageMs(uint64 cycles, int64 count) {
+  return count > 0 ? FPlatformTime::ToMilliseconds64(cycles) / count : 0.0;
+}
+
+void Sample(const FMqttClientCounters &counters, FSnapshot &previous,
+            double elapsed, FMqttClientStats &stats) {
+  FSnapshot current;
+  current.MessagesIn = counters.MessagesIn.load(std::memory_order_relaxed);
+  current.BytesIn = counters.BytesIn.load(std::memory_order_relaxed);
+  current.MessagesOut = counters.MessagesOut.load(std::memory_order_relaxed);
+  current.BytesOut = counters.BytesOut.load(std::memory_order_relaxed);
+  current.DispatchCycles =
+      counters.DispatchCycles.load(std::memory_order_relaxed);
+  current.Dispatched = counters.Dispatched.load(std::memory_order_relaxed);
+  current.HandlerCycles =
+      counters.HandlerCycles.load(std::memory_order_relaxed);
+  current.Handled = counters.Handled.load(std::memory_order_relaxed);
+
+  const float rate = elapsed > 0.0 ? (float)(1.0 / elapsed) : 0.0f;
+
+  stats.MessagesInPerSecond = (current.MessagesIn - previous.MessagesIn) * rate;
+  stats.MessagesOutPerSecond =
+      (current.MessagesOut - previous.MessagesOut) * rate;
+  stats.BytesInPerSecond = (current.BytesIn - previous.BytesIn) * rate;
+  stats.BytesOutPerSecond = (current.BytesOut - previous.BytesOut) * rate;
+
+  stats.MessagesIn = current.MessagesIn;
+  stats.MessagesOut = current.MessagesOut;
+  stats.BytesIn = current.BytesIn;
+  stats.BytesOut = current.BytesOut;
+
+  stats.DispatchLatencyMs =
+      AverageMs(current.DispatchCycles - previous.DispatchCycles,
+                current.Dispatched - previous.Dispatched);
+  stats.HandlerTimeMs =
+      AverageMs(current.HandlerCycles - previous.HandlerCycles,
+                current.Handled - previous.Handled);
+
+  stats.QueueDepth = counters.QueueDepth.load(std::memory_order_relaxed);
+  stats.Reconnects = counters.Reconnects.load(std::memory_order_relaxed);
+  stats.DecodeErrors = counters.DecodeErrors.load(std::memory_order_relaxed);
+  stats.DroppedMessages = counters.Dropped.load(std::memory_order_relaxed);
+
+  previous = current;
+}
+
+}  // namespace
+
+bool FMqttStatsSampler::Tick(float deltaTime) {
+  FMqttClientStats total;
+  int32 numClients = 0;
+
+  // deltaTime is the frame time, not the time since the last sample.
+  const double now = FPlatformTime::Seconds();
+
+  for (int32 i = Clients.Num() - 1; i >= 0; --i) {
+    UMqttClientBase *client = Clients[i].Client.Get();
+    if (client == nullptr) {
+      Clients.RemoveAtSwap(i);
+      continue;
+    }
+
+    FMqttClientStats &stats = client->Stats;
+    Sample(*client->Counters, Clients[i].Previous,
+           now - Clients[i].PreviousTime, stats);
+    Clients[i].PreviousTime = now;
+    ++numClients;
+
+    total.MessagesInPerSecond += stats.MessagesInPerSecond;
+    total.MessagesOutPerSecond += stats.MessagesOutPerSecond;
+    total.BytesInPerSecond += stats.BytesInPerSecond;
+    total.BytesOutPerSecond += stats.BytesOutPerSecond;
+    total.QueueDepth += stats.QueueDepth;
+    total.DispatchLatencyMs =
+        FMath::Max(total.DispatchLatencyMs, stats.DispatchLatencyMs);
+    total.HandlerTimeMs = FMath::Max(total.HandlerTimeMs, stats.HandlerTimeMs);
+    total.Reconnects += stats.Reconnects;
+    total.DecodeErrors += stats.DecodeErrors;
+    total.DroppedMessages += stats.DroppedMessages;
+  }
+
+  // Latencies are the worst client's, so one slow client is not averaged
+  // away by many idle ones.
+  SET_DWORD_STAT(STAT_MqttClients, numClients);
+  SET_DWORD_STAT(STAT_MqttMessagesIn, (uint32)total.MessagesInPerSecond);
+  SET_DWORD_STAT(STAT_MqttMessagesOut, (uint32)total.MessagesOutPerSecond);
+  SET_DWORD_STAT(STAT_MqttBytesIn, (uint32)total.BytesInPerSecond);
+  SET_DWORD_STAT(STAT_MqttBytesOut, (uint32)total.BytesOutPerSecond);
+  SET_DWORD_STAT(STAT_MqttQueueDepth, total.QueueDepth);
+  SET_FLOAT_STAT(STAT_MqttDispatchLatency, total.DispatchLatencyMs);
+  SET_FLOAT_STAT(STAT_MqttHandlerTime, total.HandlerTimeMs);
+  SET_DWORD_STAT(STAT_MqttReconnects, total.Reconnects);
+  SET_DWORD_STAT(STAT_MqttDecodeErrors, total.DecodeErrors);
+  SET_DWORD_STAT(STAT_MqttDropped, total.DroppedMessages);
+
+  CSV_CUSTOM_STAT(Mqtt, MessagesInPerSecond, total.MessagesInPerSecond,
+                  ECsvCustomStatOp::Set);
+  CSV_CUSTOM_STAT(Mqtt, MessagesOutPerSecond, total.MessagesOutPerSecond,
+                  ECsvCustomStatOp::Set);
+  CSV_CUSTOM_STAT(Mqtt, BytesInPerSecond, total.BytesInPerSecond,
+                  ECsvCustomStatOp::Set);
+  CSV_CUSTOM_STAT(Mqtt, BytesOutPerSecond, total.BytesOutPerSecond,
+                  ECsvCustomStatOp::Set);
+  CSV_CUSTOM_STAT(Mqtt, QueueDepth, total.QueueDepth, ECsvCustomStatOp::Set);
+  CSV_CUSTOM_STAT(Mqtt, DispatchLatencyMs, total.DispatchLatencyMs,
+                  ECsvCustomStatOp::Set);
+  CSV_CUSTOM_STAT(Mqtt, HandlerTimeMs, total.HandlerTimeMs,
+                  ECsvCustomStatOp::Set);
+  CSV_CUSTOM_STAT(Mqtt, Reconnects, total.Reconnects, ECsvCustomStatOp::Set);
+  CSV_CUSTOM_STAT(Mqtt, DecodeErrors, total.DecodeErrors,
+                  ECsvCustomStatOp::Set);
+  CSV_CUSTOM_STAT(Mqtt, DroppedMessages, total.DroppedMessages,
+                  ECsvCustomStatOp::Set);
+
+  if (Clients.Num() == 0) {
+    TickerHandle.Reset();
+    return false;
+  }
+
+  return true;
+}
+
+void FMqttStatsSampler::Register(UMqttClientBase *client) {
+  check(IsInGameThread());
+
+  FClientEntry entry;
+  entry.Client = client;
+  entry.PreviousTime = FPlatformTime::Seconds();
+  Clients.Add(entry);
+
+  if (!TickerHandle.IsValid()) {
+    TickerHandle = FTicker::GetCoreTicker().AddTicker(
+        FTickerDelegate::CreateStatic(&Tick), 1.0f);
+  }
+}
+
+void FMqttStatsSampler::Unregister(UMqttClientBase *client) {
+  check(IsInGameThread());
+
+  Clients.RemoveAllSwap(
+      [client](const FClientEntry &entry) { return entry.Client == client; });
+}
@@ -0,0 +1,71 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Entities/MqttClientStats.h"
+
+#include <atomic>
+
+class UMqttClientBase;
+
+DECLARE_LOG_CATEGORY_EXTERN(LogMqtt, Log, All);
+
+/**
+ * Raw counters of one client. Updated lock-free by the network thread and the
+ * game thread handlers; FMqttStatsSampler turns them into FMqttClientStats.
+ */
+struct FMqttClientCounters {
+  std::atomic<int64> MessagesIn{0};
+  std::atomic<int64> BytesIn{0};
+  std::atomic<int64> MessagesOut{0};
+  std::atomic<int64> BytesOut{0};
+
+  std::atomic<int32> QueueDepth{0};
+  std::atomic<int32> Reconnects{0};
+  std::atomic<int32> DecodeErrors{0};
+  std::atomic<int32> Dropped{0};
+
+  std::atomic<uint64> DispatchCycles{0};
+  std::atomic<int64> Dispatched{0};
+  std::atomic<uint64> HandlerCycles{0};
+  std::atomic<int64> Handled{0};
+
+  void AddMessageIn(int32 bytes) {
+    MessagesIn.fetch_add(1, std::memory_order_relaxed);
+    BytesIn.fetch_add(bytes, std::memory_order_relaxed);
+  }
+
+  void AddMessageOut(int32 bytes) {
+    MessagesOut.fetch_add(1, std::memory_order_relaxed);
+    BytesOut.fetch_add(bytes, std::memory_order_relaxed);
+  }
+
+  void AddDispatch(uint64 cycles) {
+    DispatchCycles.fetch_add(cycles, std::memory_order_relaxed);
+    Dispatched.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void AddHandler(uint64 cycles) {
+    HandlerCycles.fetch_add(cycles, std::memory_order_relaxed);
+    Handled.fetch_add(1, std::memory_order_relaxed);
+  }
+};
+
+/** Shared by the client and its network thread, which may outlive it. */
+typedef TSharedRef<FMqttClientCounters, ESPMode::ThreadSafe>
+    FMqttClientCountersRef;
+
+/**
+ * Samples the counters of every client once per second on the core ticker,
+ * and publishes the totals to the MQTT stat group ("stat MQTT") and the Mqtt
+ * CSV profiler category.
+ */
+class FMqttStatsSampler {
+ public:
+  static void Register(UMqttClientBase *client);
+  static void Unregister(UMqttClientBase *client);
+
+ private:
+  static bool Tick(float deltaTime);
+};
@@ -0,0 +1,391 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#include "MqttStructCodec.h"
+
+#include "Misc/ScopeLock.h"
+#include "MqttFlexbufferBuilder.h"
+#include "MqttTrace.h"
+#include "UObject/EnumProperty.h"
+#include "UObject/UnrealType.h"
+
+struct FMqttStructCodec::FField {
+  enum class EKind {
+    Bool,
+    Int8,
+    Int16,
+    Int32,
+    Int64,
+    UInt8,
+    UInt16,
+    UInt32,
+    UInt64,
+    Float,
+    Double,
+    String,
+    Name,
+    FloatTuple,
+    Struct,
+    Array,
+  };
+
+  EKind Kind = EKind::Int32;
+  int32 Offset = 0;
+
+  // Map fields only; array elements have no key.
+  TUniquePtr<FMqttFlexbufferKey> Key;
+
+  // Bool: needed for bitfield bools.
+  const FBoolProperty *BoolProperty = nullptr;
+
+  // FloatTuple: number of float components.
+  int32 NumFloats = 0;
+
+  // Struct
+  const FMqttStructCodec *Codec = nullptr;
+
+  // Array
+  const FArrayProperty *ArrayProperty = nullptr;
+  TUniquePtr<FField> Inner;
+
+  static TUniquePtr<FField> Make(const FProperty *property, int32 offset);
+
+  void Encode(flexbuffers::Builder &fbb, const uint8 *value) const;
+  void Decode(const flexbuffers::Reference &ref, uint8 *value) const;
+
+ private:
+  template <typename TVector>
+  void DecodeArray(const TVector &vector, uint8 *value) const;
+};
+
+namespace {
+
+FCriticalSection CodecsLock;
+TMap<const UScriptStruct *, TUniquePtr<FMqttStructCodec>> Codecs;
+
+/** Core math structs written as fixed float vectors instead of maps. */
+int32 GetNumFloats(const UScriptStruct *structType) {
+  if (structType == TBaseStructure<FVector>::Get() ||
+      structType == TBaseStructure<FRotator>::Get()) {
+    return 3;
+  }
+  if (structType == TBaseStructure<FVector2D>::Get()) {
+    return 2;
+  }
+  if (structType == TBaseStructure<FVector4>::Get() ||
+      structType == TBaseStructure<FQuat>::Get() ||
+      structType == TBaseStructure<FLinearColor>::Get()) {
+    return 4;
+  }
+  return 0;
+}
+
+template <typename T>
+FORCEINLINE T &As(uint8 *value) {
+  return *reinterpret_cast<T *>(value);
+}
+
+template <typename T>
+FORCEINLINE const T &As(const uint8 *value) {
+  return *reinterpret_cast<const T *>(value);
+}
+
+void WriteString(flexbuffers::Builder &fbb, const TCHAR *str) {
+  FTCHARToUTF8 utf8(str);
+  fbb.String(utf8.Get(), utf8.Length());
+}
+
+FString ReadString(const flexbuffers::Reference &ref) {
+  flexbuffers::String str = ref.AsString();
+  FUTF8ToTCHAR converted(str.c_str(), str.length());
+  return FString(converted.Length(), converted.Get());
+}
+
+}  // namespace
+
+TUniquePtr<FMqttStructCodec::FField> FMqttStructCodec::FField::Make(
+    const FProperty *property, int32 offset) {
+  // Static arrays are not supported.
+  if (property->ArrayDim != 1) {
+    return nullptr;
+  }
+
+  TUniquePtr<FField> field = MakeUnique<FField>();
+  field->Offset = offset;
+
+  if (const FBoolProperty *boolProperty = CastField<FBoolProperty>(property)) {
+    field->Kind = EKind::Bool;
+    field->BoolProperty = boolProperty;
+  } else if (CastField<FInt8Property>(property)) {
+    field->Kind = EKind::Int8;
+  } else if (CastField<FInt16Property>(property)) {
+    field->Kind = EKind::Int16;
+  } else if (CastField<FIntProperty>(property)) {
+    field->Kind = EKind::Int32;
+  } else if (CastField<FInt64Property>(property)) {
+    field->Kind = EKind::Int64;
+  } else if (CastField<FByteProperty>(property)) {
+    field->Kind = EKind::UInt8;
+  } else if (CastField<FUInt16Property>(property)) {
+    field->Kind = EKind::UInt16;
+  } else if (CastField<FUInt32Property>(property)) {
+    field->Kind = EKind::UInt32;
+  } else if (CastField<FUInt64Property>(property)) {
+    field->Kind = EKind::UInt64;
+  } else if (CastField<FFloatProperty>(property)) {
+    field->Kind = EKind::Float;
+  } else if (CastField<FDoubleProperty>(property)) {
+    field->Kind = EKind::Double;
+  } else if (const FEnumProperty *enumProperty =
+                 CastField<FEnumProperty>(property)) {
+    // Sent as the underlying integer, which sits at the same offset.
+    return Make(enumProperty->GetUnderlyingProperty(), offset);
+  } else if (CastField<FStrProperty>(property)) {
+    field->Kind = EKind::String;
+  } else if (CastField<FNameProperty>(property)) {
+    field->Kind = EKind::Name;
+  } else if (const FStructProperty *structProperty =
+                 CastField<FStructProperty>(property)) {
+    field->NumFloats = GetNumFloats(structProperty->Struct);
+    if (field->NumFloats > 0) {
+      field->Kind = EKind::FloatTuple;
+    } else {
+      field->Kind = EKind::Struct;
+      field->Codec = &FMqttStructCodec::Get(structProperty->Struct);
+    }
+  } else if (const FArrayProperty *arrayProperty =
+                 CastField<FArrayProperty>(property)) {
+    field->Kind = EKind::Array;
+    field->ArrayProperty = arrayProperty;
+    field->Inner = Make(arrayProperty->Inner, 0);
+    if (!field->Inner.IsValid()) {
+      return nullptr;
+    }
+  } else {
+    return nullptr;
+  }
+
+  return field;
+}
+
+void FMqttStructCodec::FField::Encode(flexbuffers::Builder &fbb,
+                                      const uint8 *value) const {
+  switch (Kind) {
+    case EKind::Bool:
+      fbb.Bool(BoolProperty->GetPropertyValue(value));
+      break;
+    case EKind::Int8:
+      fbb.Int(As<int8>(value));
+      break;
+    case EKind::Int16:
+      fbb.Int(As<int16>(value));
+      break;
+    case EKind::Int32:
+      fbb.Int(As<int32>(value));
+      break;
+    case EKind::Int64:
+      fbb.Int(As<int64>(value));
+      break;
+    case EKind::UInt8:
+      fbb.UInt(As<uint8>(value));
+      break;
+    case EKind::UInt16:
+      fbb.UInt(As<uint16>(value));
+      break;
+    case EKind::UInt32:
+      fbb.UInt(As<uint32>(value));
+      break;
+    case EKind::UInt64:
+      fbb.UInt(As<uint64>(value));
+      break;
+    case EKind::Float:
+      fbb.Float(As<float>(value));
+      break;
+    case EKind::Double:
+      fbb.Double(As<double>(value));
+      break;
+    case EKind::String:
+      WriteString(fbb, *As<FString>(value));
+      break;
+    case EKind::Name:
+      WriteString(fbb, *As<FName>(value).ToString());
+      break;
+    case EKind::FloatTuple:
+      fbb.FixedTypedVector(reinterpret_cast<const float *>(value), NumFloats);
+      break;
+    case EKind::Struct:
+      Codec->EncodeMap(fbb, value);
+      break;
+    case EKind::Array: {
+      FScriptArrayHelper array(ArrayProperty, value);
+      const size_t start = fbb.StartVector();
+      for (int32 i = 0; i < array.Num(); ++i) {
+        Inner->Encode(fbb, array.GetRawPtr(i));
+      }
+      fbb.EndVector(start, false, false);
+      break;
+    }
+  }
+}
+
+void FMqttStructCodec::FField::Decode(const flexbuffers::Reference &ref,
+                                      uint8 *value) const {
+  switch (Kind) {
+    case EKind::Bool:
+      BoolProperty->SetPropertyValue(value, ref.AsBool());
+      break;
+    case EKind::Int8:
+      As<int8>(value) = (int8)ref.AsInt64();
+      break;
+    case EKind::Int16:
+      As<int16>(value) = (int16)ref.AsInt64();
+      break;
+    case EKind::Int32:
+      As<int32>(value) = (int32)ref.AsInt64();
+      break;
+    case EKind::Int64:
+      As<int64>(value) = ref.AsInt64();
+      break;
+    case EKind::UInt8:
+      As<uint8>(value) = (uint8)ref.AsUInt64();
+      break;
+    case EKind::UInt16:
+      As<uint16>(value) = (uint16)ref.AsUInt64();
+      break;
+    case EKind::UInt32:
+      As<uint32>(value) = (uint32)ref.AsUInt64();
+      break;
+    case EKind::UInt64:
+      As<uint64>(value) = ref.AsUInt64();
+      break;
+    case EKind::Float:
+      As<float>(value) = ref.AsFloat();
+      break;
+    case EKind::Double:
+      As<double>(value) = ref.AsDouble();
+      break;
+    case EKind::String:
+      if (ref.IsString()) {
+        As<FString>(value) = ReadString(ref);
+      }
+      break;
+    case EKind::Name:
+      if (ref.IsString()) {
+        As<FName>(value) = FName(*ReadString(ref));
+      }
+      break;
+    case EKind::FloatTuple:
+      if (ref.IsFixedTypedVector()) {
+        flexbuffers::FixedTypedVector vector = ref.AsFixedTypedVector();
+        float *floats = reinterpret_cast<float *>(value);
+        const int32 num = FMath::Min((int32)vector.size(), NumFloats);
+        for (int32 i = 0; i < num; ++i) {
+          floats[i] = vector[i].AsFloat();
+        }
+      }
+      break;
+    case EKind::Struct:
+      if (ref.IsMap()) {
+        Codec->DecodeMap(ref.AsMap(), value);
+      }
+      break;
+    case EKind::Array:
+      if (ref.IsUntypedVector()) {
+        DecodeArray(ref.AsVector(), value);
+      } else if (ref.IsTypedVector()) {
+        DecodeArray(ref.AsTypedVector(), value);
+      } else if (ref.IsFixedTypedVector()) {
+        DecodeArray(ref.AsFixedTypedVector(), value);
+      }
+      break;
+  }
+}
+
+template <typename TVector>
+void FMqttStructCodec::FField::DecodeArray(const TVector &vector,
+                                           uint8 *value) const {
+  FScriptArrayHelper array(ArrayProperty, value);
+  array.Resize((int32)vector.size());
+  for (int32 i = 0; i < array.Num(); ++i) {
+    Inner->Decode(vector[i], array.GetRawPtr(i));
+  }
+}
+
+const FMqttStructCodec &FMqttStructCodec::Get(const UScriptStruct *structType) {
+  check(structType != nullptr);
+
+  FScopeLock lock(&CodecsLock);
+
+  if (const TUniquePtr<FMqttStructCodec> *codec = Codecs.Find(structType)) {
+    return **codec;
+  }
+
+  MQTT_LLM_SCOPE();
+
+  // Registered before its fields are built, so structs that contain arrays
+  // of themselves find it.
+  FMqttStructCodec *codec = new FMqttStructCodec();
+  Codecs.Add(structType, TUniquePtr<FMqttStructCodec>(codec));
+
+  for (TFieldIterator<FProperty> it(structType); it; ++it) {
+    TUniquePtr<FField> field = FField::Make(*it, it->GetOffset_ForInternal());
+    if (field.IsValid()) {
+      field->Key = MakeUnique<FMqttFlexbufferKey>(it->GetName());
+      codec->Fields.Add(MoveTemp(field));
+    }
+  }
+
+  return *codec;
+}
+
+FMqttStructCodec::FMqttStructCodec() {}
+
+FMqttStructCodec::~FMqttStructCodec() {}
+
+void FMqttStructCodec::Encode(const void *value, TArray<uint8> &out) const {
+  MQTT_TRACE_SCOPE(Mqtt_EncodeStruct);
+
+  MqttEncodeFlexbuffer(out, [this, value](flexbuffers::Builder &fbb) {
+    EncodeMap(fbb, value);
+  });
+}
+
+bool FMqttStructCodec::Decode(const uint8 *data, int32 size,
+                              void *value) const {
+  MQTT_TRACE_SCOPE(Mqtt_DecodeStruct);
+
+  if (data == nullptr || size < 3) {
+    return false;
+  }
+
+  flexbuffers::Reference root = flexbuffers::GetRoot(data, size);
+  if (!root.IsMap()) {
+    return false;
+  }
+
+  DecodeMap(root.AsMap(), value);
+  return true;
+}
+
+void FMqttStructCodec::EncodeMap(flexbuffers::Builder &fbb,
+                                 const void *value) const {
+  const uint8 *base = static_cast<const uint8 *>(value);
+
+  const size_t start = fbb.StartMap();
+  for (const TUniquePtr<FField> &field : Fields) {
+    fbb.Key(field->Key->GetKey());
+    field->Encode(fbb, base + field->Offset);
+  }
+  fbb.EndMap(start);
+}
+
+void FMqttStructCodec::DecodeMap(const flexbuffers::Map &map,
+                                 void *value) const {
+  uint8 *base = static_cast<uint8 *>(value);
+
+  for (const TUniquePtr<FField> &field : Fields) {
+    flexbuffers::Reference ref = field->Key->Find(map);
+    if (!ref.IsNull()) {
+      field->Decode(ref, base + field->Offset);
+    }
+  }
+}
@@ -0,0 +1,87 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#include "FlexbuffersFunctionLibrary.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "MqttStats.h"
+#include "MqttStructCodec.h"
+
+namespace {
+
+FFingerPose MakePose() {
+  FFingerPose pose;
+  pose.hand = TEXT("right");
+  pose.Palm = FVector(0.1f, 0.2f, 0.3f);
+
+  TArray<FVector> *fingers[] = {&pose.Thumb, &pose.Index, &pose.Middle,
+                                &pose.Ring, &pose.Pinky};
+  for (int32 finger = 0; finger < 5; ++finger) {
+    for (int32 joint = 0; joint < 4; ++joint) {
+      fingers[finger]->Add(
+          FVector(finger * 0.01f, joint * 0.02f, (finger + joint) * 0.03f));
+    }
+  }
+  return pose;
+}
+
+template <typename F>
+double NanosecondsPerCall(int32 iterations, F &&call) {
+  const uint64 start = FPlatformTime::Cycles64();
+  for (int32 i = 0; i < iterations; ++i) {
+    call();
+  }
+  const uint64 cycles = FPlatformTime::Cycles64() - start;
+  return FPlatformTime::ToSeconds64(cycles) * 1e9 / iterations;
+}
+
+/**
+ * Mqtt.StructCodecBenchmark [iterations]
+ *
+ * Encodes and decodes an FFingerPose with the hand-written flexbuffer code
+ * and with the reflection-driven codec, and logs the time per call. The two
+ * use different layouts, so each decodes its own payload.
+ */
+void RunBenchmark(const TArray<FString> &args) {
+  const int32 iterations =
+      args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*args[0])) : 100000;
+
+  const FFingerPose pose = MakePose();
+  FFingerPose decoded;
+
+  TArray<uint8> handWritten;
+  UFlexbuffersFunctionLibrary::EncodeFingerPose(pose, handWritten);
+  TArray<uint8> reflected;
+  MqttEncodeStruct(pose, reflected);
+
+  // Warm the builder pool and the codec cache.
+  UFlexbuffersFunctionLibrary::DecodeFingerPose(handWritten, decoded);
+  MqttDecodeStruct(reflected, decoded);
+
+  TArray<uint8> out;
+  const double handEncode = NanosecondsPerCall(iterations, [&]() {
+    UFlexbuffersFunctionLibrary::EncodeFingerPose(pose, out);
+  });
+  const double handDecode = NanosecondsPerCall(iterations, [&]() {
+    UFlexbuffersFunctionLibrary::DecodeFingerPose(handWritten, decoded);
+  });
+  const double structEncode = NanosecondsPerCall(
+      iterations, [&]() { MqttEncodeStruct(pose, out); });
+  const double structDecode = NanosecondsPerCall(
+      iterations, [&]() { MqttDecodeStruct(reflected, decoded); });
+
+  UE_LOG(LogMqtt, Log,
+         TEXT("MQTT => FFingerPose x%d: hand-written encode %.0f ns, decode "
+              "%.0f ns, %d bytes; struct codec encode %.0f ns, decode %.0f "
+              "ns, %d bytes"),
+         iterations, handEncode, handDecode, handWritten.Num(), structEncode,
+         structDecode, reflected.Num());
+}
+
+FAutoConsoleCommand BenchmarkCommand(
+    TEXT("Mqtt.StructCodecBenchmark"),
+    TEXT("Compares the hand-written FFingerPose flexbuffer code with the "
+         "reflection-driven struct codec. Usage: Mqtt.StructCodecBenchmark "
+         "[iterations]"),
+    FConsoleCommandWithArgsDelegate::CreateStatic(&RunBenchmark));
+
+}  // namespace
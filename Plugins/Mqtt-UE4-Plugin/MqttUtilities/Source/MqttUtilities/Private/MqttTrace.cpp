@@ -0,0 +1,11 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#include "MqttTrace.h"
+
+#if MQTT_PROFILING_ENABLED && CPUPROFILERTRACE_ENABLED
+UE_TRACE_CHANNEL_DEFINE(MqttChannel)
+#endif
+
+#if MQTT_PROFILING_ENABLED && ENABLE_LOW_LEVEL_MEM_TRACKER
+DEFINE_STAT(STAT_MqttLLM);
+#endif
@@ -0,0 +1,34 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/LowLevelMemTracker.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Stats/Stats.h"
+#include "Trace/Trace.h"
+
+// Profiling hooks of the plugin; all of them compile out in shipping builds.
+//
+// MQTT_TRACE_SCOPE(Name) times the enclosing scope as an Unreal Insights CPU
+// event on the Mqtt channel ("-trace=cpu,mqtt"). MQTT_LLM_SCOPE() charges the
+// allocations of the enclosing scope to the MQTT tag of the low level memory
+// tracker ("-llm", "stat LLMFULL").
+
+#define MQTT_PROFILING_ENABLED (!UE_BUILD_SHIPPING)
+
+#if MQTT_PROFILING_ENABLED && CPUPROFILERTRACE_ENABLED
+UE_TRACE_CHANNEL_EXTERN(MqttChannel)
+#define MQTT_TRACE_SCOPE(Name) \
+  TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Name, MqttChannel)
+#else
+#define MQTT_TRACE_SCOPE(Name)
+#endif
+
+#if MQTT_PROFILING_ENABLED && ENABLE_LOW_LEVEL_MEM_TRACKER
+DECLARE_LLM_MEMORY_STAT_EXTERN(TEXT("MQTT"), STAT_MqttLLM, STATGROUP_LLMFULL, );
+#define MQTT_LLM_SCOPE() \
+  LLM_SCOPED_TAG_WITH_STAT(STAT_MqttLLM, ELLMTracker::Default)
+#else
+#define MQTT_LLM_SCOPE()
+#endif
@@ -0,0 +1,162 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#include "Async/Async.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/Guid.h"
+#include "MqttUtilitiesBPL.h"
+
+#include <atomic>
+
+namespace {
+
+const TCHAR *BenchmarkTopic = TEXT("mqtt_benchmark/latency");
+
+/**
+ * Records one-way latency on the receiving thread. The first eight bytes of
+ * every payload hold the send time in FPlatformTime cycles.
+ */
+class FLatencyRecorder : public IMqttDecodingHandler {
+ public:
+  explicit FLatencyRecorder(int32 count) : Received(0) {
+    Latencies.SetNumZeroed(count);
+  }
+
+  bool Decode(const FMqttMessage &message) override {
+    uint64 sent = 0;
+    if (message.Message.Num() < (int32)sizeof(sent)) {
+      return false;
+    }
+
+    FMemory::Memcpy(&sent, message.Message.GetData(), sizeof(sent));
+    const uint64 now = FPlatformTime::Cycles64();
+
+    const int32 index = Received.fetch_add(1);
+    if (index < Latencies.Num()) {
+      Latencies[index] = now - sent;
+    }
+    return true;
+  }
+
+  TArray<uint64> Latencies;
+  std::atomic<int32> Received;
+};
+
+void LogLatencies(const FString &host, int32 sent, int32 payloadSize,
+                  FLatencyRecorder &recorder) {
+  const int32 received = FMath::Min(recorder.Received.load(),
+                                    recorder.Latencies.Num());
+
+  TArray<uint64> latencies(recorder.Latencies.GetData(), received);
+  latencies.Sort();
+
+  auto micros = [&latencies](float percentile) {
+    if (latencies.Num() == 0) {
+      return 0.0;
+    }
+    const int32 index = FMath::Clamp(
+        FMath::FloorToInt(percentile * latencies.Num()), 0, latencies.Num() - 1);
+    return FPlatformTime::ToMilliseconds64(latencies[index]) * 1000.0;
+  };
+
+  UE_LOG(LogTemp, Log,
+         TEXT("MQTT => Benchmark %s: %d/%d messages of %d bytes, latency p50 "
+              "%.1f us, p99 %.1f us, max %.1f us"),
+         *host, received, sent, payloadSize, micros(0.5f), micros(0.99f),
+         micros(1.0f));
+}
+
+/**
+ * Mqtt.Benchmark <host url> [messages] [payload bytes]
+ *
+ * Publishes timestamped messages to a topic the same client subscribes to and
+ * logs the one-way latency, e.g. compare "Mqtt.Benchmark shm://bench" and
+ * "Mqtt.Benchmark mem://bench" with "Mqtt.Benchmark 127.0.0.1:1883" against a
+ * local broker.
+ */
+void RunBenchmark(const TArray<FString> &args) {
+  if (args.Num() < 1) {
+    UE_LOG(LogTemp, Warning,
+           TEXT("MQTT => Usage: Mqtt.Benchmark <host url> [messages] "
+                "[payload bytes]"));
+    return;
+  }
+
+  const FString host = args[0];
+  const int32 count = args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*args[1]))
+                                     : 10000;
+  const int32 payloadSize =
+      args.Num() > 2 ? FMath::Max((int32)sizeof(uint64), FCString::Atoi(*args[2]))
+                     : 256;
+
+  FMqttClientConfig config;
+  config.HostUrl = host;
+  config.Port = 1883;
+  config.Timeout = 1;
+  config.ClientId = TEXT("mqtt_benchmark_") + FGuid::NewGuid().ToString();
+
+  FString address, port;
+  if (!host.Contains(TEXT("://")) && host.Split(TEXT(":"), &address, &port)) {
+    config.HostUrl = address;
+    config.Port = FCString::Atoi(*port);
+  }
+
+  TScriptInterface<IMqttClientInterface> client =
+      UMqttUtilitiesBPL::CreateMqttClient(config);
+  if (client.GetObject() == nullptr) {
+    return;
+  }
+  client.GetObject()->AddToRoot();
+
+  TSharedPtr<FLatencyRecorder, ESPMode::ThreadSafe> recorder =
+      MakeShared<FLatencyRecorder, ESPMode::ThreadSafe>(count);
+
+  client->Connect(FMqttConnectionData());
+  client->Subscribe(BenchmarkTopic, 0, recorder);
+
+  Async(EAsyncExecution::Thread, [client, recorder, host, count,
+                                   payloadSize]() {
+    // Give the broker connection and the subscription time to settle.
+    FPlatformProcess::Sleep(1.0f);
+
+    FMqttMessage message;
+    message.Topic = BenchmarkTopic;
+    message.Qos = 0;
+    message.Retain = false;
+    message.Message.SetNumZeroed(payloadSize);
+
+    // Paced at 5 kHz, well above the hand tracker rate, so queues stay short
+    // and the numbers show transport latency rather than backlog.
+    const double interval = 0.0002;
+    double next = FPlatformTime::Seconds();
+    for (int32 i = 0; i < count; ++i) {
+      while (FPlatformTime::Seconds() < next) {
+        FPlatformProcess::YieldThread();
+      }
+      next += interval;
+
+      const uint64 now = FPlatformTime::Cycles64();
+      FMemory::Memcpy(message.Message.GetData(), &now, sizeof(now));
+      client->Publish(message);
+    }
+
+    FPlatformProcess::Sleep(1.0f);
+
+    AsyncTask(ENamedThreads::GameThread, [client, recorder, host, count,
+                                          payloadSize]() {
+      LogLatencies(host, count, payloadSize, *recorder);
+      client->Disconnect();
+      client.GetObject()->RemoveFromRoot();
+    });
+  });
+}
+
+FAutoConsoleCommand BenchmarkCommand(
+    TEXT("Mqtt.Benchmark"),
+    TEXT("Measures publish-to-receive latency. Usage: Mqtt.Benchmark <host "
+         "url> [messages] [payload bytes], e.g. shm://bench, mem://bench or "
+         "127.0.0.1:1883"),
+    FConsoleCommandWithArgsDelegate::CreateStatic(&RunBenchmark));
+
+}  // namespace
@@ -2,6 +2,13 @@
 
 #include "MqttUtilitiesBPL.h"
 
+#include "IMqttUtilitiesModule.h"
+#include "MqttStats.h"
+#include "MqttTrace.h"
+
+#include "Memory/MqttMemoryClient.h"
+#include "Shm/MqttShmClient.h"
+
 #if PLATFORM_WINDOWS
 #include "Windows/MqttClient.h"
 #endif
@@ -20,7 +27,30 @@
 
 TScriptInterface<IMqttClientInterface>
 UMqttUtilitiesBPL::CreateMqttClient(FMqttClientConfig config) {
-  UE_LOG(LogTemp, Warning, TEXT("MQTT => Creating MQTT client..."));
+  MQTT_LLM_SCOPE();
+
+  UE_LOG(LogMqtt, Verbose, TEXT("MQTT => Creating MQTT client..."));
+
+  // Same-host transport, available on every platform.
+  if (UMqttShmClient::IsShmUrl(config.HostUrl)) {
+    UMqttShmClient *ShmClient = NewObject<UMqttShmClient>();
+    ShmClient->Init(config);
+    TScriptInterface<IMqttClientInterface> ShmClientInterface;
+    ShmClientInterface.SetObject(ShmClient);
+    ShmClientInterface.SetInterface(Cast<IMqttClientInterface>(ShmClient));
+    return ShmClientInterface;
+  }
+
+  // In-process broker, for tests and offline sessions.
+  if (UMqttMemoryClient::IsMemoryUrl(config.HostUrl)) {
+    UMqttMemoryClient *MemoryClient = NewObject<UMqttMemoryClient>();
+    MemoryClient->Init(config);
+    TScriptInterface<IMqttClientInterface> MemoryClientInterface;
+    MemoryClientInterface.SetObject(MemoryClient);
+    MemoryClientInterface.SetInterface(
+        Cast<IMqttClientInterface>(MemoryClient));
+    return MemoryClientInterface;
+  }
 
 #if PLATFORM_WINDOWS || PLATFORM_MAC || PLATFORM_IOS || PLATFORM_ANDROID
 
@@ -35,3 +65,33 @@ UMqttUtilitiesBPL::CreateMqttClient(FMqttClientConfig config) {
 
   return nullptr;
 }
+
+bool UMqttUtilitiesBPL::IsMqttReady() {
+  return IMqttUtilitiesModule::IsAvailable() &&
+         IMqttUtilitiesModule::Get().IsReady();
+}
+
+float UMqttUtilitiesBPL::GetMessageLatencyMs(const FMqttMessage &message) {
+  if (message.Timestamp == 0) {
+    return -1.0f;
+  }
+
+  return (GetUnixTimeMicroseconds() - message.Timestamp) * 0.001f;
+}
+
+void UMqttUtilitiesBPL::SetLatencyTracingEnabled(bool bEnabled) {
+  FMqttLatencyTracer::SetEnabled(bEnabled);
+}
+
+TArray<FMqttLatencyStageStats> UMqttUtilitiesBPL::GetLatencyStats() {
+  TArray<FMqttLatencyStageStats> stats;
+  FMqttLatencyTracer::GetStats(stats);
+  return stats;
+}
+
+void UMqttUtilitiesBPL::ResetLatencyStats() { FMqttLatencyTracer::Reset(); }
+
+int64 UMqttUtilitiesBPL::GetUnixTimeMicroseconds() {
+  return (FDateTime::UtcNow() - FDateTime(1970, 1, 1)).GetTicks() /
+         ETimespan::TicksPerMicrosecond;
+}
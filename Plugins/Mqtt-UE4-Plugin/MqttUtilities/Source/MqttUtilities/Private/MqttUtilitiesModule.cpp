@@ -1,8 +1,19 @@
 // Copyright (c) 2019 Nineva Studios
 
+#include "Async/Async.h"
 #include "HAL/PlatformProcess.h"
 #include "IMqttUtilitiesModule.h"
 #include "Interfaces/IPluginManager.h"
+#include "Misc/Paths.h"
+#include "MqttFlexbufferBuilder.h"
+#include "MqttLatencyTracer.h"
+#include "MqttStats.h"
+
+#include <atomic>
+
+#if PLATFORM_WINDOWS
+#include "Windows/MqttReactor.h"
+#endif
 
 #define LOCTEXT_NAMESPACE "MqttUtilities"
 
@@ -10,9 +21,25 @@ class FMqttUtilitiesModule : public IMqttUtilitiesModule {
   virtual void StartupModule() override;
   virtual void ShutdownModule() override;
 
+  virtual bool IsReady() const override;
+  virtual TSharedFuture<bool> GetReadyFuture() const override;
+  virtual void WhenReady(TFunction<void(bool)> callback) override;
+
 private:
-  void *mDllHandleMosquitto;
-  void *mDllHandleMosquittopp;
+  bool LoadLibraries(const FString &pluginDir);
+  void FinishLoading(bool bLoaded);
+
+  void *mDllHandleMosquitto = nullptr;
+  void *mDllHandleMosquittopp = nullptr;
+
+  TFuture<void> LoadTask;
+  TPromise<bool> ReadyPromise;
+  TSharedFuture<bool> ReadyFuture;
+  std::atomic<bool> bReady{false};
+
+  // Game thread only.
+  bool bFinished = false;
+  TArray<TFunction<void(bool)>> ReadyCallbacks;
 };
 
 IMPLEMENT_MODULE(FMqttUtilitiesModule, MqttUtilities)
@@ -21,41 +48,112 @@ void FMqttUtilitiesModule::StartupModule() {
   // This code will execute after your module is loaded into memory; the exact
   // timing is specified in the .uplugin file per-module
 
-  // For Windows and Mac platforms dynamic libraries should be loaded manually
+  FMqttLatencyTracer::Startup();
 
 #if PLATFORM_WINDOWS
+  FMqttReactor::Startup();
+#endif
 
-  const FString PluginDir =
+  // Fresh state, the module may be started again after a shutdown.
+  ReadyPromise = TPromise<bool>();
+  ReadyFuture = ReadyPromise.GetFuture().Share();
+  ReadyCallbacks.Reset();
+  bFinished = false;
+  bReady = false;
+
+  // Loading the libraries is kept off the startup path; clients connecting
+  // before it is done wait for WhenReady.
+  const FString pluginDir =
       IPluginManager::Get().FindPlugin(TEXT("MqttUtilities"))->GetBaseDir();
-  const FString DLLPath = PluginDir / TEXT("Binaries/Win64/");
+  LoadTask = Async(EAsyncExecution::Thread, [this, pluginDir]() {
+    const bool bLoaded = LoadLibraries(pluginDir);
+    AsyncTask(ENamedThreads::GameThread, [bLoaded]() {
+      if (IMqttUtilitiesModule::IsAvailable()) {
+        static_cast<FMqttUtilitiesModule &>(IMqttUtilitiesModule::Get())
+            .FinishLoading(bLoaded);
+      }
+    });
+  });
+}
 
-  FPlatformProcess::PushDllDirectory(*DLLPath);
+bool FMqttUtilitiesModule::LoadLibraries(const FString &pluginDir) {
+  // For Windows and Mac platforms dynamic libraries should be loaded manually.
+  //
+  // This runs off the game thread, so it must not touch the DLL directory
+  // stack: it is not thread safe and other modules load libraries meanwhile.
+  // Both libraries are loaded by absolute path instead, mosquitto first so
+  // that mosquittopp binds to the copy already in the process.
+
+#if PLATFORM_WINDOWS
+
+  const FString DLLPath =
+      FPaths::ConvertRelativePathToFull(pluginDir / TEXT("Binaries/Win64/"));
 
   mDllHandleMosquitto =
       FPlatformProcess::GetDllHandle(*(DLLPath + "mosquitto.dll"));
-  mDllHandleMosquittopp =
-      FPlatformProcess::GetDllHandle(*(DLLPath + "mosquittopp.dll"));
-
-  FPlatformProcess::PopDllDirectory(*DLLPath);
+  if (mDllHandleMosquitto != nullptr) {
+    mDllHandleMosquittopp =
+        FPlatformProcess::GetDllHandle(*(DLLPath + "mosquittopp.dll"));
+  }
 
 #endif
 
 #if PLATFORM_MAC
 
-  const FString PluginDir =
-      IPluginManager::Get().FindPlugin(TEXT("MqttUtilities"))->GetBaseDir();
-  const FString DLLPath = PluginDir / TEXT("Binaries/Mac/");
-
-  FPlatformProcess::PushDllDirectory(*DLLPath);
+  const FString DLLPath =
+      FPaths::ConvertRelativePathToFull(pluginDir / TEXT("Binaries/Mac/"));
 
   mDllHandleMosquitto =
       FPlatformProcess::GetDllHandle(*(DLLPath + "mosquitto.dylib"));
-  mDllHandleMosquittopp =
-      FPlatformProcess::GetDllHandle(*(DLLPath + "mosquittopp.dylib"));
+  if (mDllHandleMosquitto != nullptr) {
+    mDllHandleMosquittopp =
+        FPlatformProcess::GetDllHandle(*(DLLPath + "mosquittopp.dylib"));
+  }
 
-  FPlatformProcess::PopDllDirectory(*DLLPath);
+#endif
 
+#if PLATFORM_WINDOWS || PLATFORM_MAC
+  if (mDllHandleMosquitto == nullptr || mDllHandleMosquittopp == nullptr) {
+    UE_LOG(LogMqtt, Error, TEXT("MQTT => Failed to load mosquitto libraries"));
+    return false;
+  }
 #endif
+
+  return true;
+}
+
+void FMqttUtilitiesModule::FinishLoading(bool bLoaded) {
+  // Shut down before loading finished.
+  if (bFinished) {
+    return;
+  }
+
+  bReady.store(bLoaded, std::memory_order_release);
+  bFinished = true;
+  ReadyPromise.SetValue(bLoaded);
+
+  TArray<TFunction<void(bool)>> callbacks = MoveTemp(ReadyCallbacks);
+  for (TFunction<void(bool)> &callback : callbacks) {
+    callback(bLoaded);
+  }
+}
+
+bool FMqttUtilitiesModule::IsReady() const {
+  return bReady.load(std::memory_order_acquire);
+}
+
+TSharedFuture<bool> FMqttUtilitiesModule::GetReadyFuture() const {
+  return ReadyFuture;
+}
+
+void FMqttUtilitiesModule::WhenReady(TFunction<void(bool)> callback) {
+  check(IsInGameThread());
+
+  if (bFinished) {
+    callback(IsReady());
+    return;
+  }
+  ReadyCallbacks.Add(MoveTemp(callback));
 }
 
 void FMqttUtilitiesModule::ShutdownModule() {
@@ -63,6 +161,27 @@ void FMqttUtilitiesModule::ShutdownModule() {
   // modules that support dynamic reloading, we call this function before
   // unloading the module.
 
+  FMqttLatencyTracer::Shutdown();
+  FMqttFlexbufferBuilderPool::Empty();
+
+  // The libraries are only released once loading is done with them.
+  if (LoadTask.IsValid()) {
+    LoadTask.Wait();
+  }
+  if (!bFinished) {
+    bFinished = true;
+    ReadyPromise.SetValue(false);
+    ReadyCallbacks.Empty();
+  }
+  bReady = false;
+
+#if PLATFORM_WINDOWS
+
+  // Close all connections while the mosquitto libraries are still loaded.
+  FMqttReactor::Shutdown();
+
+#endif
+
 #if PLATFORM_WINDOWS || PLATFORM_MAC
 
   if (mDllHandleMosquitto) {
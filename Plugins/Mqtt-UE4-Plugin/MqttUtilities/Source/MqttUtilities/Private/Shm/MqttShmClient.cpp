@@ -0,0 +1,332 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#include "MqttShmClient.h"
+
+#include "Async/Async.h"
+#include "GenericPlatform/GenericPlatformAffinity.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "MqttLatencyTracer.h"
+#include "MqttTrace.h"
+#include "MqttUtilitiesBPL.h"
+
+#include <atomic>
+
+namespace {
+
+const TCHAR *ShmScheme = TEXT("shm://");
+
+// Polls this often before yielding, and this often before sleeping. Busy
+// polling is what keeps delivery in the microsecond range.
+const int32 SpinIterations = 2000;
+const int32 YieldIterations = 20000;
+const float IdleSleepSeconds = 0.0002f;
+
+// A ring idle for this long is polled at the slower rate, so a connection
+// nobody publishes to does not keep waking a core.
+const double BackoffAfterSeconds = 1.0;
+const float BackoffSleepSeconds = 0.005f;
+
+}  // namespace
+
+/**
+ * Reader thread: follows the ring and dispatches every message like the MQTT
+ * runnable does for broker messages.
+ */
+class FMqttShmReader : public FRunnable {
+ public:
+  FMqttShmReader(UMqttShmClient *shmClient)
+      : bKeepRunning(true), Dropped(0), client(shmClient) {}
+
+  uint32 Run() override {
+    MQTT_LLM_SCOPE();
+
+    FMqttMessage message;
+    uint64 cursor = client->Ring.GetWriteSequence();
+    uint64 dropped = 0;
+    uint64 reported = 0;
+    int32 idle = 0;
+    double idleSince = 0.0;
+
+    while (bKeepRunning) {
+      switch (client->Ring.Read(cursor, message, dropped)) {
+        case FMqttShmRing::EReadResult::Message:
+          client->OnMessage(message);
+          idle = 0;
+          idleSince = 0.0;
+          break;
+        case FMqttShmRing::EReadResult::Overrun:
+          // dropped is this reader's running total; the client counter only
+          // takes what was lost since the last overrun.
+          Dropped.store(dropped, std::memory_order_relaxed);
+          client->Counters->Dropped.fetch_add((int32)(dropped - reported),
+                                              std::memory_order_relaxed);
+          reported = dropped;
+          break;
+        case FMqttShmRing::EReadResult::Empty:
+          ++idle;
+          if (idle > YieldIterations) {
+            const double now = FPlatformTime::Seconds();
+            if (idleSince == 0.0) {
+              idleSince = now;
+            }
+            FPlatformProcess::SleepNoStats(
+                now - idleSince > BackoffAfterSeconds ? BackoffSleepSeconds
+                                                      : IdleSleepSeconds);
+          } else if (idle > SpinIterations) {
+            FPlatformProcess::YieldThread();
+          }
+          break;
+      }
+    }
+
+    return 0;
+  }
+
+  void Stop() override { bKeepRunning = false; }
+
+  std::atomic<bool> bKeepRunning;
+  std::atomic<uint64> Dropped;
+
+ private:
+  UMqttShmClient *client;
+};
+
+void UMqttShmClient::BeginDestroy() {
+  UMqttClientBase::BeginDestroy();
+
+  StopReader();
+}
+
+void UMqttShmClient::Connect(FMqttConnectionData connectionData) {
+  if (Reader != nullptr) {
+    UE_LOG(LogMqtt, Warning,
+           TEXT("MQTT => Shared memory client is already connected. "
+                "Disconnect and try again"));
+    return;
+  }
+
+  // shm://<name>?slots=<n>&slot_size=<bytes>
+  FString name = ClientConfig.HostUrl.RightChop(FCString::Strlen(ShmScheme));
+  FString query;
+  name.Split(TEXT("?"), &name, &query);
+
+  int32 slots = FMqttShmRing::DefaultSlotCount;
+  int32 slotSize = FMqttShmRing::DefaultSlotSize;
+
+  TArray<FString> params;
+  query.ParseIntoArray(params, TEXT("&"));
+  for (const FString &param : params) {
+    FString key, value;
+    if (param.Split(TEXT("="), &key, &value)) {
+      if (key == TEXT("slots")) {
+        slots = FCString::Atoi(*value);
+      } else if (key == TEXT("slot_size")) {
+        slotSize = FCString::Atoi(*value);
+      }
+    }
+  }
+
+  if (name.IsEmpty() ||
+      !Ring.Open(TEXT("MqttShm_") + name, slots, slotSize)) {
+    OnErrorDelegate.ExecuteIfBound(
+        -1, FString::Printf(TEXT("Could not open shared memory ring %s"),
+                            *ClientConfig.HostUrl));
+    return;
+  }
+
+  Reader = new FMqttShmReader(this);
+  Thread = FRunnableThread::Create(
+      Reader, TEXT("MQTT Shm"), 0, EThreadPriority::TPri_AboveNormal,
+      FGenericPlatformAffinity::GetNoAffinityMask());
+
+  TWeakObjectPtr<UMqttShmClient> weakThis(this);
+  AsyncTask(ENamedThreads::GameThread, [weakThis]() {
+    if (UMqttShmClient *client = weakThis.Get()) {
+      client->OnConnectDelegate.ExecuteIfBound();
+    }
+  });
+}
+
+void UMqttShmClient::Disconnect() {
+  if (Reader == nullptr) {
+    return;
+  }
+
+  StopReader();
+
+  OnDisconnectDelegate.ExecuteIfBound();
+}
+
+void UMqttShmClient::Subscribe(FString topic, int qos,
+                               const FOnMessageHandlerDelegate &handler) {
+  {
+    FScopeLock lock(&HandlerLock);
+    if (handler.IsBound()) {
+      MsgEventHandler.Emplace(topic, handler);
+    }
+  }
+  OnSubscribed(qos);
+}
+
+void UMqttShmClient::Subscribe(FString topic, int qos,
+                               IMqttMessageHandlerInterface *handler) {
+  {
+    FScopeLock lock(&HandlerLock);
+    if (handler != nullptr) {
+      MsgFuncHandler.Emplace(topic, handler);
+    }
+  }
+  OnSubscribed(qos);
+}
+
+void UMqttShmClient::Subscribe(FString topic, int qos,
+                               IMqttDecodingHandlerPtr handler) {
+  {
+    FScopeLock lock(&HandlerLock);
+    if (handler.IsValid()) {
+      MsgDecodingHandler.Emplace(topic, handler);
+    }
+  }
+  OnSubscribed(qos);
+}
+
+void UMqttShmClient::Unsubscribe(FString topic) {
+  {
+    FScopeLock lock(&HandlerLock);
+    MsgEventHandler.Remove(topic);
+    MsgFuncHandler.Remove(topic);
+    MsgDecodingHandler.Remove(topic);
+  }
+  OnUnsubscribeDelegate.ExecuteIfBound(NextMessageId.Increment());
+}
+
+void UMqttShmClient::Publish(FMqttMessage message) {
+  if (!Ring.IsOpen()) {
+    UE_LOG(LogMqtt, Warning,
+           TEXT("MQTT => Shared memory client is not connected"));
+    return;
+  }
+
+  FTCHARToUTF8 topic(*message.Topic);
+
+  // Stamped here unless the caller passed the capture time of the data.
+  const int64 timestamp = message.Timestamp != 0
+                              ? message.Timestamp
+                              : UMqttUtilitiesBPL::GetUnixTimeMicroseconds();
+
+  bool bWritten = false;
+  {
+    FScopeLock lock(&PublishLock);
+    bWritten = Ring.Write(topic.Get(), topic.Length(),
+                          message.Message.GetData(), message.Message.Num(),
+                          timestamp);
+  }
+
+  if (!bWritten) {
+    UE_LOG(LogMqtt, Warning,
+           TEXT("MQTT => Message on %s does not fit into a shared memory "
+                "slot (%d bytes max)"),
+           *message.Topic, Ring.GetSlotCapacity());
+    return;
+  }
+
+  Counters->AddMessageOut(message.Message.Num());
+
+  if (OnPublishDelegate.IsBound()) {
+    const int mid = NextMessageId.Increment();
+    TWeakObjectPtr<UMqttShmClient> weakThis(this);
+    AsyncTask(ENamedThreads::GameThread, [weakThis, mid]() {
+      if (UMqttShmClient *client = weakThis.Get()) {
+        client->OnPublishDelegate.ExecuteIfBound(mid);
+      }
+    });
+  }
+}
+
+void UMqttShmClient::Init(FMqttClientConfig configData) {
+  ClientConfig = configData;
+  Reader = nullptr;
+  Thread = nullptr;
+}
+
+uint64 UMqttShmClient::GetDroppedCount() const {
+  return Reader != nullptr ? Reader->Dropped.load(std::memory_order_relaxed)
+                           : 0;
+}
+
+bool UMqttShmClient::IsShmUrl(const FString &url) {
+  return url.StartsWith(ShmScheme, ESearchCase::IgnoreCase);
+}
+
+void UMqttShmClient::StopReader() {
+  if (Reader != nullptr) {
+    Reader->Stop();
+    Thread->WaitForCompletion();
+
+    delete Thread;
+    delete Reader;
+    Thread = nullptr;
+    Reader = nullptr;
+  }
+
+  Ring.Close();
+}
+
+void UMqttShmClient::OnMessage(const FMqttMessage &message) {
+  MQTT_TRACE_SCOPE(Mqtt_OnMessage);
+
+  FScopeLock lock(&HandlerLock);
+
+  Counters->AddMessageIn(message.Message.Num());
+  FMqttLatencyTracer::Mark(EMqttLatencyStage::Received, message.Timestamp);
+
+  const uint64 received = FPlatformTime::Cycles64();
+
+  auto func_handler = MsgFuncHandler.Find(message.Topic);
+  if (func_handler != nullptr && (*func_handler) != nullptr) {
+    (*func_handler)->MessageHandler(message);
+  }
+
+  auto decoding_handler = MsgDecodingHandler.Find(message.Topic);
+  if (decoding_handler != nullptr) {
+    if (!(*decoding_handler)->Decode(message)) {
+      Counters->DecodeErrors.fetch_add(1, std::memory_order_relaxed);
+    }
+    Counters->AddHandler(FPlatformTime::Cycles64() - received);
+  }
+
+  FOnMessageHandlerDelegate handler;
+  if (auto event_handler = MsgEventHandler.Find(message.Topic)) {
+    handler = *event_handler;
+  }
+
+  if (handler.IsBound() || OnMessageDelegate.IsBound()) {
+    TWeakObjectPtr<UMqttShmClient> weakThis(this);
+    AsyncTask(ENamedThreads::GameThread, [weakThis, handler, message,
+                                          received]() {
+      UMqttShmClient *client = weakThis.Get();
+      if (client == nullptr) {
+        return;
+      }
+
+      const uint64 dispatched = FPlatformTime::Cycles64();
+      client->Counters->AddDispatch(dispatched - received);
+      if (handler.IsBound()) {
+        FMqttLatencyTracer::Mark(EMqttLatencyStage::Delivered,
+                                 message.Timestamp);
+      }
+
+      handler.ExecuteIfBound(message);
+      client->OnMessageDelegate.ExecuteIfBound(message);
+      client->Counters->AddHandler(FPlatformTime::Cycles64() - dispatched);
+    });
+  }
+}
+
+void UMqttShmClient::OnSubscribed(int qos) {
+  OnSubscribeDelegate.ExecuteIfBound(NextMessageId.Increment(),
+                                     TArray<int>({qos}));
+}
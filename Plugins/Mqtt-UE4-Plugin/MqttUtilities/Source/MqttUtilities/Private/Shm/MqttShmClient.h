@@ -0,0 +1,76 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MqttClientBase.h"
+#include "MqttShmRing.h"
+
+#include "MqttShmClient.generated.h"
+
+class FMqttShmReader;
+class FRunnableThread;
+
+/**
+ * Same-host transport selected by the "shm://<name>" host URL. Messages go
+ * through a shared memory ring instead of a broker; topics are matched
+ * exactly, QoS and retain flags are ignored.
+ *
+ * Optional URL parameters: shm://<name>?slots=256&slot_size=4096. Producer
+ * and consumers must use the same values.
+ */
+UCLASS()
+class UMqttShmClient : public UMqttClientBase {
+  GENERATED_BODY()
+
+  friend class FMqttShmReader;
+
+ public:
+  void BeginDestroy() override;
+
+  void Connect(FMqttConnectionData connectionData) override;
+
+  void Disconnect() override;
+
+  void Subscribe(FString topic, int qos,
+                 const FOnMessageHandlerDelegate &handler) override;
+
+  void Subscribe(FString topic, int qos,
+                 IMqttMessageHandlerInterface *handler) override;
+
+  void Subscribe(FString topic, int qos,
+                 IMqttDecodingHandlerPtr handler) override;
+
+  void Unsubscribe(FString topic) override;
+
+  void Publish(FMqttMessage message) override;
+
+ public:
+  void Init(FMqttClientConfig configData) override;
+
+  /** Number of messages this client lost because it fell behind the
+   * producer. */
+  uint64 GetDroppedCount() const;
+
+  static bool IsShmUrl(const FString &url);
+
+ private:
+  void StopReader();
+  void OnMessage(const FMqttMessage &message);
+  void OnSubscribed(int qos);
+
+  FMqttClientConfig ClientConfig;
+
+  FMqttShmRing Ring;
+  FCriticalSection PublishLock;
+
+  FMqttShmReader *Reader;
+  FRunnableThread *Thread;
+
+  FCriticalSection HandlerLock;
+  TMap<FString, IMqttMessageHandlerInterface *> MsgFuncHandler;
+  TMap<FString, FOnMessageHandlerDelegate> MsgEventHandler;
+  TMap<FString, IMqttDecodingHandlerPtr> MsgDecodingHandler;
+
+  FThreadSafeCounter NextMessageId;
+};
@@ -0,0 +1,221 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#include "MqttShmRing.h"
+
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "MqttStats.h"
+
+namespace {
+
+const uint32 RingMagic = 0x4853514d;  // "MQSH"
+const uint32 RingVersion = 2;
+
+enum ERingState : uint32 {
+  Uninitialized = 0,
+  Initializing = 1,
+  Ready = 2,
+};
+
+}  // namespace
+
+// Producer and consumer data live on separate cache lines.
+struct alignas(64) FMqttShmRing::FHeader {
+  std::atomic<uint32> State;
+  uint32 Magic;
+  uint32 Version;
+  uint32 SlotCount;
+  uint32 SlotSize;
+
+  alignas(64) std::atomic<uint64> WriteSequence;
+};
+
+struct FMqttShmRing::FSlot {
+  /** 2 * sequence + 1 while written, 2 * sequence + 2 when complete. */
+  std::atomic<uint64> Sequence;
+  uint32 TopicLength;
+  uint32 PayloadLength;
+  /** Publisher's FMqttMessage::Timestamp, for the latency tracer. */
+  int64 Timestamp;
+
+  uint8 *GetData() { return reinterpret_cast<uint8 *>(this + 1); }
+};
+
+static_assert(sizeof(std::atomic<uint64>) == sizeof(uint64) &&
+                  sizeof(std::atomic<uint32>) == sizeof(uint32),
+              "Shared memory ring needs plain lock-free atomics");
+
+FMqttShmRing::FMqttShmRing()
+    : Region(nullptr), Header(nullptr), Slots(nullptr), SlotMask(0),
+      SlotStride(0) {}
+
+FMqttShmRing::~FMqttShmRing() { Close(); }
+
+bool FMqttShmRing::Open(const FString &name, int32 slotCount,
+                        int32 slotSize) {
+  Close();
+
+  const uint32 count =
+      FMath::RoundUpToPowerOfTwo(FMath::Max(slotCount, 2));
+  const uint32 stride =
+      Align(FMath::Max<uint32>(slotSize, sizeof(FSlot) + 64), 64);
+  const SIZE_T size = sizeof(FHeader) + (SIZE_T)count * stride;
+
+  const uint32 access =
+      FPlatformMemory::ESharedMemoryAccess::Read |
+      FPlatformMemory::ESharedMemoryAccess::Write;
+
+  Region = FPlatformMemory::MapNamedSharedMemoryRegion(*name, false, access,
+                                                       size);
+  if (Region == nullptr) {
+    Region = FPlatformMemory::MapNamedSharedMemoryRegion(*name, true, access,
+                                                         size);
+  }
+  if (Region == nullptr) {
+    UE_LOG(LogMqtt, Error, TEXT("MQTT => Could not map shared memory %s"),
+           *name);
+    return false;
+  }
+
+  FHeader *header = static_cast<FHeader *>(Region->GetAddress());
+
+  // A fresh region is zero filled; whoever moves it out of Uninitialized
+  // writes the layout, everyone else waits for Ready.
+  uint32 expected = Uninitialized;
+  if (header->State.compare_exchange_strong(expected, Initializing)) {
+    header->Magic = RingMagic;
+    header->Version = RingVersion;
+    header->SlotCount = count;
+    header->SlotSize = stride;
+    header->WriteSequence.store(0, std::memory_order_relaxed);
+    header->State.store(Ready, std::memory_order_release);
+  } else {
+    const double deadline = FPlatformTime::Seconds() + 1.0;
+    while (header->State.load(std::memory_order_acquire) != Ready &&
+           FPlatformTime::Seconds() < deadline) {
+      FPlatformProcess::Yield();
+    }
+  }
+
+  if (header->State.load(std::memory_order_acquire) != Ready ||
+      header->Magic != RingMagic || header->Version != RingVersion ||
+      header->SlotCount != count || header->SlotSize != stride) {
+    UE_LOG(LogMqtt, Error,
+           TEXT("MQTT => Shared memory %s has a different layout"), *name);
+    FPlatformMemory::UnmapNamedSharedMemoryRegion(Region);
+    Region = nullptr;
+    return false;
+  }
+
+  Header = header;
+  Slots = reinterpret_cast<uint8 *>(header + 1);
+  SlotMask = count - 1;
+  SlotStride = stride;
+
+  return true;
+}
+
+void FMqttShmRing::Close() {
+  if (Region != nullptr) {
+    FPlatformMemory::UnmapNamedSharedMemoryRegion(Region);
+  }
+
+  Region = nullptr;
+  Header = nullptr;
+  Slots = nullptr;
+}
+
+bool FMqttShmRing::Write(const ANSICHAR *topic, int32 topicLength,
+                         const uint8 *payload, int32 payloadLength,
+                         int64 timestamp) {
+  if (Header == nullptr || topicLength < 0 || payloadLength < 0 ||
+      topicLength + payloadLength > GetSlotCapacity()) {
+    return false;
+  }
+
+  const uint64 sequence =
+      Header->WriteSequence.load(std::memory_order_relaxed);
+  FSlot *slot = GetSlot(sequence);
+
+  slot->Sequence.store(sequence * 2 + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  slot->TopicLength = topicLength;
+  slot->PayloadLength = payloadLength;
+  slot->Timestamp = timestamp;
+  FMemory::Memcpy(slot->GetData(), topic, topicLength);
+  FMemory::Memcpy(slot->GetData() + topicLength, payload, payloadLength);
+
+  slot->Sequence.store(sequence * 2 + 2, std::memory_order_release);
+  Header->WriteSequence.store(sequence + 1, std::memory_order_release);
+
+  return true;
+}
+
+uint64 FMqttShmRing::GetWriteSequence() const {
+  return Header != nullptr
+             ? Header->WriteSequence.load(std::memory_order_acquire)
+             : 0;
+}
+
+FMqttShmRing::EReadResult FMqttShmRing::Read(uint64 &cursor, FMqttMessage &out,
+                                             uint64 &dropped) const {
+  const uint64 write = GetWriteSequence();
+  if (cursor >= write) {
+    return EReadResult::Empty;
+  }
+
+  // The producer lapped us, skip to the oldest slot still in the ring.
+  const uint64 count = (uint64)SlotMask + 1;
+  if (write - cursor > count) {
+    dropped += write - count - cursor;
+    cursor = write - count;
+  }
+
+  FSlot *slot = GetSlot(cursor);
+  const uint64 expected = cursor * 2 + 2;
+
+  if (slot->Sequence.load(std::memory_order_acquire) != expected) {
+    ++dropped;
+    ++cursor;
+    return EReadResult::Overrun;
+  }
+
+  const uint32 topicLength = slot->TopicLength;
+  const uint32 payloadLength = slot->PayloadLength;
+  const int64 timestamp = slot->Timestamp;
+  const bool bSane =
+      (uint64)topicLength + payloadLength <= (uint64)GetSlotCapacity();
+
+  if (bSane) {
+    FUTF8ToTCHAR topic((const ANSICHAR *)slot->GetData(), topicLength);
+    out.Topic = FString(topic.Length(), topic.Get());
+    out.Message.SetNumUninitialized(payloadLength, false);
+    FMemory::Memcpy(out.Message.GetData(), slot->GetData() + topicLength,
+                    payloadLength);
+  }
+
+  // Anything copied while the producer reused the slot is discarded.
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (!bSane ||
+      slot->Sequence.load(std::memory_order_relaxed) != expected) {
+    ++dropped;
+    ++cursor;
+    return EReadResult::Overrun;
+  }
+
+  out.Qos = 0;
+  out.Retain = false;
+  out.Timestamp = timestamp;
+  ++cursor;
+  return EReadResult::Message;
+}
+
+int32 FMqttShmRing::GetSlotCapacity() const {
+  return (int32)(SlotStride - sizeof(FSlot));
+}
+
+FMqttShmRing::FSlot *FMqttShmRing::GetSlot(uint64 sequence) const {
+  return reinterpret_cast<FSlot *>(Slots +
+                                   (sequence & SlotMask) * SlotStride);
+}
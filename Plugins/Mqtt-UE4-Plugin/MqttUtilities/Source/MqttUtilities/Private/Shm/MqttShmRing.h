@@ -0,0 +1,80 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Entities/MqttMessage.h"
+#include "HAL/PlatformMemory.h"
+
+#include <atomic>
+
+/**
+ * Single-producer / multi-consumer message ring in a named shared memory
+ * region (POSIX shm on Linux and Mac, a file mapping on Windows).
+ *
+ * The producer never waits: every slot carries a sequence number that is odd
+ * while the slot is written and even once it is complete, and readers validate
+ * it before and after copying. A reader that falls more than a ring behind
+ * loses the oldest messages and continues from the newest ones.
+ */
+class FMqttShmRing {
+ public:
+  enum class EReadResult {
+    Empty,
+    Message,
+    Overrun,
+  };
+
+  static const int32 DefaultSlotCount = 256;
+  static const int32 DefaultSlotSize = 4096;
+
+  FMqttShmRing();
+  ~FMqttShmRing();
+
+  /**
+   * Map (or create) the named region
+   * @param name - region name, the same for producer and consumers
+   * @param slotCount - number of slots, rounded up to a power of two
+   * @param slotSize - bytes per slot including topic, payload and slot header
+   */
+  bool Open(const FString &name, int32 slotCount, int32 slotSize);
+
+  void Close();
+
+  bool IsOpen() const { return Header != nullptr; }
+
+  /**
+   * Append a message. Only one thread in one process may publish to a region
+   * at a time. Returns false if the message does not fit into a slot.
+   * @param timestamp - FMqttMessage::Timestamp, handed to the readers
+   */
+  bool Write(const ANSICHAR *topic, int32 topicLength, const uint8 *payload,
+             int32 payloadLength, int64 timestamp);
+
+  /** Sequence number of the next message to be written. New readers start
+   * here. */
+  uint64 GetWriteSequence() const;
+
+  /**
+   * Read the message at cursor and advance it
+   * @param cursor - reader position, starts at GetWriteSequence()
+   * @param out - receives topic, payload and timestamp
+   * @param dropped - incremented by the number of messages the reader lost
+   */
+  EReadResult Read(uint64 &cursor, FMqttMessage &out, uint64 &dropped) const;
+
+  /** Largest topic + payload size a slot can hold. */
+  int32 GetSlotCapacity() const;
+
+ private:
+  struct FHeader;
+  struct FSlot;
+
+  FSlot *GetSlot(uint64 sequence) const;
+
+  FPlatformMemory::FSharedMemoryRegion *Region;
+  FHeader *Header;
+  uint8 *Slots;
+  uint32 SlotMask;
+  uint32 SlotStride;
+};
@@ -0,0 +1,155 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#include "CoreMinimal.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+#include "MqttHandPoseCodec.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace {
+
+const int32 NumLandmarks = FMqttHandPoseEncoder::NumLandmarks;
+
+struct FPose {
+  FVector Landmarks[NumLandmarks];
+};
+
+// A hand drifting a little every frame, like a tracked one.
+TArray<FPose> MakePoses(int32 numFrames) {
+  FRandomStream random(1234);
+  FPose pose;
+  for (FVector &landmark : pose.Landmarks) {
+    landmark = random.GetUnitVector() * random.FRandRange(0.05f, 0.2f);
+  }
+
+  TArray<FPose> poses;
+  for (int32 frame = 0; frame < numFrames; ++frame) {
+    for (FVector &landmark : pose.Landmarks) {
+      landmark += random.GetUnitVector() * 0.002f;
+    }
+    poses.Add(pose);
+  }
+  return poses;
+}
+
+bool IsKeyframe(const TArray<uint8> &frame) {
+  return frame.Num() > 0 && (frame[0] & 1) != 0;
+}
+
+float MaxError(const FPose &sent, const FVector *decoded) {
+  float error = 0.0f;
+  for (int32 i = 0; i < NumLandmarks; ++i) {
+    const FVector difference = (sent.Landmarks[i] - decoded[i]).GetAbs();
+    error = FMath::Max(error, difference.GetMax());
+  }
+  return error;
+}
+
+}  // namespace
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMqttHandPoseCodecRoundTripTest,
+                                 "Mqtt.HandPoseCodec.RoundTrip",
+                                 EAutomationTestFlags::ApplicationContextMask |
+                                     EAutomationTestFlags::EngineFilter)
+
+bool FMqttHandPoseCodecRoundTripTest::RunTest(const FString &Parameters) {
+  const TArray<FPose> poses = MakePoses(40);
+
+  for (float errorBound : {0.0001f, 0.0005f, 0.005f}) {
+    FMqttHandPoseCodecSettings settings;
+    settings.ErrorBound = errorBound;
+    settings.KeyframeInterval = 16;
+
+    FMqttHandPoseEncoder encoder(settings);
+    FMqttHandPoseDecoder decoder;
+
+    int32 numKeyframes = 0;
+    float maxError = 0.0f;
+    bool bDecoded = true;
+
+    TArray<uint8> frame;
+    for (const FPose &pose : poses) {
+      encoder.Encode(pose.Landmarks, true, frame);
+      numKeyframes += IsKeyframe(frame) ? 1 : 0;
+
+      FVector decoded[NumLandmarks];
+      bool bRightHand = false;
+      bDecoded &=
+          decoder.Decode(frame.GetData(), frame.Num(), decoded, bRightHand) &&
+          bRightHand;
+      maxError = FMath::Max(maxError, MaxError(pose, decoded));
+    }
+
+    const FString bound = FString::Printf(TEXT("ErrorBound %g"), errorBound);
+    TestTrue(bound + TEXT(": every frame decoded"), bDecoded);
+    TestEqual(bound + TEXT(": keyframes"), numKeyframes, 3);
+    TestTrue(FString::Printf(TEXT("%s: max error %g within bound"), *bound,
+                             maxError),
+             maxError <= errorBound * 1.001f);
+  }
+  return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMqttHandPoseCodecMissingReferenceTest,
+                                 "Mqtt.HandPoseCodec.MissingReference",
+                                 EAutomationTestFlags::ApplicationContextMask |
+                                     EAutomationTestFlags::EngineFilter)
+
+bool FMqttHandPoseCodecMissingReferenceTest::RunTest(
+    const FString &Parameters) {
+  const TArray<FPose> poses = MakePoses(6);
+
+  FMqttHandPoseEncoder encoder;
+  TArray<TArray<uint8>> frames;
+  for (const FPose &pose : poses) {
+    encoder.Encode(pose.Landmarks, true, frames.AddDefaulted_GetRef());
+  }
+  if (!TestTrue(TEXT("Keyframe first"), IsKeyframe(frames[0])) ||
+      !TestFalse(TEXT("Delta after it"), IsKeyframe(frames[1]))) {
+    return false;
+  }
+
+  FVector decoded[NumLandmarks];
+  bool bRightHand = false;
+
+  // A delta of one hand does not apply to the other hand's keyframe.
+  {
+    FMqttHandPoseEncoder leftEncoder;
+    TArray<uint8> leftKeyframe;
+    leftEncoder.Encode(poses[0].Landmarks, false, leftKeyframe);
+
+    FMqttHandPoseDecoder decoder;
+    TestTrue(TEXT("Left keyframe decoded"),
+             decoder.Decode(leftKeyframe.GetData(), leftKeyframe.Num(), decoded,
+                            bRightHand));
+    TestFalse(TEXT("Right delta without right keyframe"),
+              decoder.Decode(frames[1].GetData(), frames[1].Num(), decoded,
+                             bRightHand));
+  }
+
+  // A lost delta invalidates the following ones until the next keyframe.
+  FMqttHandPoseDecoder decoder;
+  TestTrue(TEXT("Keyframe decoded"),
+           decoder.Decode(frames[0].GetData(), frames[0].Num(), decoded,
+                          bRightHand));
+  TestFalse(TEXT("Delta after a lost one"),
+            decoder.Decode(frames[2].GetData(), frames[2].Num(), decoded,
+                           bRightHand));
+  TestFalse(TEXT("Later delta still rejected"),
+            decoder.Decode(frames[3].GetData(), frames[3].Num(), decoded,
+                           bRightHand));
+
+  encoder.ForceKeyframe();
+  TArray<uint8> keyframe;
+  encoder.Encode(poses[5].Landmarks, true, keyframe);
+  TestTrue(TEXT("Stream resumes at the next keyframe"),
+           decoder.Decode(keyframe.GetData(), keyframe.Num(), decoded,
+                          bRightHand));
+  TestTrue(TEXT("Resumed pose within bound"),
+           MaxError(poses[5], decoded) <=
+               FMqttHandPoseCodecSettings().ErrorBound * 1.001f);
+  return true;
+}
+
+#endif  // WITH_DEV_AUTOMATION_TESTS
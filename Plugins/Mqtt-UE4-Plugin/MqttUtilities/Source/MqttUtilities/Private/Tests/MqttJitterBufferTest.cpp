@@ -0,0 +1,99 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#include "CoreMinimal.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/AutomationTest.h"
+#include "MqttFlexbufferBuilder.h"
+#include "MqttJitterBuffer.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace {
+
+typedef TMqttJitterBuffer<int32> FTestJitterBuffer;
+
+FMqttMessage MakeFrame(int64 sequence, int64 timestampMs) {
+  FMqttMessage message;
+  message.Topic = TEXT("test/frames");
+  MqttEncodeFlexbuffer(message.Message, [&](flexbuffers::Builder &fbb) {
+    fbb.Map([&]() {
+      fbb.Int("seq", sequence);
+      fbb.Int("ts", timestampMs);
+    });
+  });
+  return message;
+}
+
+// The value of a frame is its sequence number, so the handler records the
+// playout order.
+bool DecodeSequence(const TArray<uint8> &payload, int32 &out) {
+  int64 sequence = 0;
+  double captureTime = 0.0;
+  if (!MqttReadFrameHeader(payload, FMqttJitterBufferSettings(), sequence,
+                           captureTime)) {
+    return false;
+  }
+  out = (int32)sequence;
+  return true;
+}
+
+void Feed(FTestJitterBuffer &buffer, int64 first, int32 count) {
+  for (int32 i = 0; i < count; ++i) {
+    buffer.Decode(MakeFrame(first + i, i * 10));
+  }
+}
+
+// Far enough ahead that every queued frame is due.
+double Later() { return FPlatformTime::Seconds() + 10.0; }
+
+}  // namespace
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMqttJitterBufferRestartTest,
+                                 "Mqtt.JitterBuffer.Restart",
+                                 EAutomationTestFlags::ApplicationContextMask |
+                                     EAutomationTestFlags::EngineFilter)
+
+bool FMqttJitterBufferRestartTest::RunTest(const FString &Parameters) {
+  FMqttJitterBufferSettings settings;
+  settings.Capacity = 8;
+
+  // Not started, so only the test drives playout.
+  TArray<int32> played;
+  TSharedRef<FTestJitterBuffer, ESPMode::ThreadSafe> buffer =
+      MakeShared<FTestJitterBuffer, ESPMode::ThreadSafe>(
+          settings, &DecodeSequence,
+          [&played](const int32 &value) { played.Add(value); });
+
+  Feed(*buffer, 1000, 5);
+  buffer->Update(Later());
+  TestTrue(TEXT("First stream played in order"),
+           played == TArray<int32>({1000, 1001, 1002, 1003, 1004}));
+
+  // A frame a little older than the last played one is a late arrival.
+  Feed(*buffer, 1002, 1);
+  buffer->Update(Later());
+  TestEqual(TEXT("Late frame dropped"), buffer->GetStats().LateDrops, 1);
+
+  // The sender restarts its sequence and its capture clock.
+  played.Reset();
+  Feed(*buffer, 1, 3);
+  buffer->Update(Later());
+  TestTrue(TEXT("Restarted stream played in order"),
+           played == TArray<int32>({1, 2, 3}));
+
+  FMqttJitterBufferStats stats = buffer->GetStats();
+  TestEqual(TEXT("Resets"), stats.Resets, 1);
+  TestEqual(TEXT("Late drops"), stats.LateDrops, 1);
+  TestEqual(TEXT("Played"), stats.Played, 8);
+  TestEqual(TEXT("Lost"), stats.Lost, 0);
+
+  // The restarted stream is anchored: its own late frames are dropped again.
+  Feed(*buffer, 2, 1);
+  buffer->Update(Later());
+  stats = buffer->GetStats();
+  TestEqual(TEXT("Late drops after restart"), stats.LateDrops, 2);
+  TestEqual(TEXT("No further reset"), stats.Resets, 1);
+  return true;
+}
+
+#endif  // WITH_DEV_AUTOMATION_TESTS
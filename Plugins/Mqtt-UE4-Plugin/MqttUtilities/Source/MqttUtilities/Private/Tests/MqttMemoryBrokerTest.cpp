@@ -0,0 +1,173 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#include "CoreMinimal.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "Memory/MqttMemoryBroker.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/ScopeLock.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace {
+
+// Records what the broker thread delivers to one session.
+class FTestSession : public IMqttMemorySession {
+ public:
+  void OnBrokerMessage(const FMqttMessage &message) override {
+    FScopeLock lock(&Lock);
+    Messages.Add(message);
+  }
+  void OnBrokerPublished(int mid) override {
+    FScopeLock lock(&Lock);
+    Published.Add(mid);
+  }
+  void OnBrokerSubscribed(int mid, int grantedQos) override {
+    FScopeLock lock(&Lock);
+    Subscribed.Add(mid, grantedQos);
+  }
+  void OnBrokerUnsubscribed(int mid) override {}
+
+  int32 NumMessages() {
+    FScopeLock lock(&Lock);
+    return Messages.Num();
+  }
+
+  FCriticalSection Lock;
+  TArray<FMqttMessage> Messages;
+  TArray<int> Published;
+  TMap<int, int> Subscribed;
+};
+
+FMqttMessage MakeMessage(const FString &topic, int qos, bool bRetain = false) {
+  FMqttMessage message;
+  message.Topic = topic;
+  message.Qos = qos;
+  message.Retain = bRetain;
+  message.Message.Add(42);
+  return message;
+}
+
+// The broker runs commands in order, so once a marker published last has
+// arrived, everything before it has been handled.
+bool Flush(FMqttMemoryBroker &broker, FTestSession &session) {
+  const FString marker = TEXT("test/flush");
+  broker.Subscribe(&session, marker, 0, 0);
+  const int32 expected = session.NumMessages() + 1;
+  broker.Publish(&session, MakeMessage(marker, 0), 0);
+
+  const double deadline = FPlatformTime::Seconds() + 5.0;
+  while (session.NumMessages() < expected) {
+    if (FPlatformTime::Seconds() > deadline) {
+      return false;
+    }
+    FPlatformProcess::Sleep(0.001f);
+  }
+
+  FScopeLock lock(&session.Lock);
+  session.Messages.Pop();
+  return true;
+}
+
+}  // namespace
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMqttMemoryBrokerTopicMatchesTest,
+                                 "Mqtt.MemoryBroker.TopicMatches",
+                                 EAutomationTestFlags::ApplicationContextMask |
+                                     EAutomationTestFlags::EngineFilter)
+
+bool FMqttMemoryBrokerTopicMatchesTest::RunTest(const FString &Parameters) {
+  struct FCase {
+    const TCHAR *Filter;
+    const TCHAR *Topic;
+    bool bMatches;
+  };
+
+  const FCase cases[] = {
+      {TEXT("hand/left"), TEXT("hand/left"), true},
+      {TEXT("hand/left"), TEXT("hand/right"), false},
+      {TEXT("hand/left"), TEXT("hand/left/pose"), false},
+      {TEXT("hand/+"), TEXT("hand/left"), true},
+      {TEXT("hand/+"), TEXT("hand/left/pose"), false},
+      {TEXT("+/+/pose"), TEXT("hand/left/pose"), true},
+      {TEXT("hand/+/pose"), TEXT("hand//pose"), true},
+      {TEXT("hand/#"), TEXT("hand"), true},
+      {TEXT("hand/#"), TEXT("hand/left/pose"), true},
+      {TEXT("hand/#"), TEXT("hands/left"), false},
+      {TEXT("#"), TEXT("hand/left"), true},
+      {TEXT("#"), TEXT("$SYS/broker"), false},
+      {TEXT("+/broker"), TEXT("$SYS/broker"), false},
+      {TEXT("$SYS/#"), TEXT("$SYS/broker"), true},
+  };
+
+  for (const FCase &test : cases) {
+    TestEqual(FString::Printf(TEXT("%s matches %s"), test.Filter, test.Topic),
+              FMqttMemoryBroker::TopicMatches(test.Filter, test.Topic),
+              test.bMatches);
+  }
+  return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMqttMemoryBrokerPublishSubscribeTest,
+                                 "Mqtt.MemoryBroker.PublishSubscribe",
+                                 EAutomationTestFlags::ApplicationContextMask |
+                                     EAutomationTestFlags::EngineFilter)
+
+bool FMqttMemoryBrokerPublishSubscribeTest::RunTest(const FString &Parameters) {
+  TSharedRef<FMqttMemoryBroker, ESPMode::ThreadSafe> broker =
+      FMqttMemoryBroker::Get(FGuid::NewGuid().ToString());
+
+  FTestSession left, all, late;
+  broker->Attach(&left);
+  broker->Attach(&all);
+  broker->Attach(&late);
+
+  broker->Subscribe(&left, TEXT("hand/left/+"), 1, 1);
+  broker->Subscribe(&all, TEXT("hand/#"), 0, 2);
+  broker->Subscribe(&all, TEXT("hand/+/pose"), 2, 3);
+
+  broker->Publish(&left, MakeMessage(TEXT("hand/left/pose"), 1), 10);
+  broker->Publish(&left, MakeMessage(TEXT("hand/right/gesture"), 1), 11);
+  broker->Publish(&left, MakeMessage(TEXT("hand/state"), 1, true), 12);
+  broker->Publish(&left, MakeMessage(TEXT("head/pose"), 1), 13);
+
+  if (TestTrue(TEXT("Broker flushed"), Flush(*broker, left))) {
+    FScopeLock leftLock(&left.Lock);
+    FScopeLock allLock(&all.Lock);
+
+    TestEqual(TEXT("QoS 2 granted as 1"), all.Subscribed.FindRef(3), 1);
+    TestTrue(TEXT("Publishes acknowledged in order"),
+             left.Published == TArray<int>({10, 11, 12, 13, 0}));
+
+    if (TestEqual(TEXT("Left messages"), left.Messages.Num(), 1)) {
+      TestEqual(TEXT("Left topic"), left.Messages[0].Topic,
+                FString(TEXT("hand/left/pose")));
+      TestEqual(TEXT("Left QoS"), left.Messages[0].Qos, 1);
+    }
+
+    // Overlapping filters deliver one copy at the highest granted QoS.
+    if (TestEqual(TEXT("All messages"), all.Messages.Num(), 3)) {
+      TestEqual(TEXT("Pose QoS"), all.Messages[0].Qos, 1);
+      TestEqual(TEXT("Gesture QoS"), all.Messages[1].Qos, 0);
+      TestFalse(TEXT("Live message not retained"), all.Messages[2].Retain);
+    }
+  }
+
+  // A later subscription receives the retained message with the flag set.
+  broker->Subscribe(&late, TEXT("hand/+"), 1, 20);
+  if (TestTrue(TEXT("Broker flushed"), Flush(*broker, late))) {
+    FScopeLock lock(&late.Lock);
+    if (TestEqual(TEXT("Retained messages"), late.Messages.Num(), 1)) {
+      TestEqual(TEXT("Retained topic"), late.Messages[0].Topic,
+                FString(TEXT("hand/state")));
+      TestTrue(TEXT("Retained flag"), late.Messages[0].Retain);
+    }
+  }
+
+  broker->Detach(&left);
+  broker->Detach(&all);
+  broker->Detach(&late);
+  return true;
+}
+
+#endif  // WITH_DEV_AUTOMATION_TESTS
@@ -1,68 +1,114 @@
 // Copyright (c) 2019 Nineva Studios
 
 #include "MqttClient.h"
-#include "GenericPlatform/GenericPlatformAffinity.h"
-#include "HAL/RunnableThread.h"
+#include "IMqttUtilitiesModule.h"
+#include "MqttReactor.h"
 #include "MqttRunnable.h"
 #include "MqttTask.h"
+#include "MqttTrace.h"
+#include "MqttUtilitiesBPL.h"
 #include "Utils/StringUtils.h"
 
 void UMqttClient::BeginDestroy() {
   UMqttClientBase::BeginDestroy();
 
-  if (Task != nullptr) {
+  if (Task.IsValid()) {
     Task->StopRunning();
   }
 }
 
 void UMqttClient::Connect(FMqttConnectionData connectionData) {
-  if (Task != nullptr && Task->IsAlive()) {
+  if (Task.IsValid() && Task->IsAlive()) {
     UE_LOG(
-        LogTemp, Warning,
+        LogMqtt, Warning,
         TEXT("MQTT => MQTT task is already running. Disconnect and try again"));
     return;
   }
 
   if (ClientConfig.ClientId.IsEmpty()) {
-    UE_LOG(LogTemp, Warning,
+    UE_LOG(LogMqtt, Warning,
            TEXT("MQTT => Client ID is not set. Connection cancelled."));
     return;
   }
 
+  // mosquitto is loaded in the background and cannot be called before; the
+  // connection is made once it is, unless Disconnect comes first.
+  IMqttUtilitiesModule &module = IMqttUtilitiesModule::Get();
+  if (!module.IsReady()) {
+    const bool bAlreadyPending = bConnectPending;
+    bConnectPending = true;
+    if (bAlreadyPending) {
+      return;
+    }
+
+    UE_LOG(LogMqtt, Log,
+           TEXT("MQTT => Libraries are still loading, connection deferred"));
+    TWeakObjectPtr<UMqttClient> weakThis(this);
+    module.WhenReady([weakThis, connectionData](bool bLoaded) {
+      UMqttClient *client = weakThis.Get();
+      if (client == nullptr || !client->bConnectPending) {
+        return;
+      }
+      client->bConnectPending = false;
+
+      if (bLoaded) {
+        client->Connect(connectionData);
+      } else {
+        client->OnErrorDelegate.ExecuteIfBound(
+            -1, TEXT("MQTT libraries failed to load"));
+      }
+    });
+    return;
+  }
+
   /**
-   * All communication between client and broker should be done in a separate
+   * All communication between client and broker is done on the shared reactor
    * thread. Runnable task stores thread-safe queue for output messages
-   * (subscribe, unsubscribe, publish) and receives broker responsen that are
+   * (subscribe, unsubscribe, publish) and receives broker responses that are
    * redirected to client.
    */
 
-  Task = new FMqttRunnable(this);
+  Task = MakeShared<FMqttRunnable, ESPMode::ThreadSafe>(this);
 
   Task->Host = std::string(TCHAR_TO_ANSI(*ClientConfig.HostUrl));
   Task->ClientId = std::string(TCHAR_TO_ANSI(*ClientConfig.ClientId));
   Task->Port = ClientConfig.Port;
+  Task->bProtocolV5 = ClientConfig.ProtocolVersion == EMqttProtocolVersion::V5;
   Task->Timeout = ClientConfig.Timeout > 1000 ? 1000 : ClientConfig.Timeout;
 
+  Task->ReconnectMinDelay =
+      FMath::Max(ClientConfig.ReconnectMinDelayMs, 1) * 0.001;
+  Task->ReconnectMaxDelay = ClientConfig.ReconnectMaxDelayMs * 0.001;
+  Task->OfflineBufferSize = ClientConfig.OfflineBufferSize;
+  Task->OfflinePolicy = ClientConfig.OfflinePolicy;
+
+  Task->MaxInflight = ClientConfig.MaxInflight;
+  Task->MaxPublishRate = ClientConfig.MaxPublishRate;
+  Task->ControlQueueSize = ClientConfig.ControlQueueSize;
+  Task->TelemetryQueueSize = ClientConfig.TelemetryQueueSize;
+  Task->LatestOnlyTopics.Append(ClientConfig.LatestOnlyTopics);
+
   Task->Username = std::string(TCHAR_TO_ANSI(*connectionData.Login));
   Task->Password = std::string(TCHAR_TO_ANSI(*connectionData.Password));
 
-  Thread = FRunnableThread::Create(
-      Task, TEXT("MQTT"), 0, EThreadPriority::TPri_Normal,
-      FGenericPlatformAffinity::GetNoAffinityMask());
+  FMqttReactor::Add(Task);
 }
 
 void UMqttClient::Disconnect() {
-  if (Task != nullptr) {
+  bConnectPending = false;
+
+  // The reactor only exists once a connection was made.
+  if (Task.IsValid()) {
     Task->StopRunning();
+    Task.Reset();
+    FMqttReactor::Wake();
   }
-
-  Task = nullptr;
 }
 
 void UMqttClient::Subscribe(FString topic, int qos,
                             const FOnMessageHandlerDelegate &handler) {
-  if (Task == nullptr || !Task->IsAlive()) {
-    UE_LOG(LogTemp, Warning, TEXT("MQTT => There is no running MQTT task"));
+  if (!Task.IsValid() || !Task->IsAlive()) {
+    UE_LOG(LogMqtt, Warning, TEXT("MQTT => There is no running MQTT task"));
     return;
   }
 
@@ -82,8 +128,8 @@ void UMqttClient::Subscribe(FString topic, int qos,
 
 void UMqttClient::Subscribe(FString topic, int qos,
                             IMqttMessageHandlerInterface *handler) {
-  if (Task == nullptr || !Task->IsAlive()) {
-    UE_LOG(LogTemp, Warning, TEXT("MQTT => There is no running MQTT task"));
+  if (!Task.IsValid() || !Task->IsAlive()) {
+    UE_LOG(LogMqtt, Warning, TEXT("MQTT => There is no running MQTT task"));
     return;
   }
 
@@ -100,9 +146,29 @@ void UMqttClient::Subscribe(FString topic, int qos,
   Task->PushTask(taskSubscribe);
 }
 
+void UMqttClient::Subscribe(FString topic, int qos,
+                            IMqttDecodingHandlerPtr handler) {
+  if (!Task.IsValid() || !Task->IsAlive()) {
+    UE_LOG(LogMqtt, Warning, TEXT("MQTT => There is no running MQTT task"));
+    return;
+  }
+
+  char *sub = StringUtils::CopyString(topic);
+
+  FMqttSubscribeDecodingTaskPtr taskSubscribe =
+      MakeShared<FMqttSubscribeDecodingTask>();
+  taskSubscribe->type = MqttTaskType::Subscribe;
+  taskSubscribe->qos = qos;
+  taskSubscribe->sub = sub;
+  taskSubscribe->handler_type = HandlerType::Decoding;
+  taskSubscribe->handler = handler;
+
+  Task->PushTask(taskSubscribe);
+}
+
 void UMqttClient::Unsubscribe(FString topic) {
-  if (Task == nullptr || !Task->IsAlive()) {
-    UE_LOG(LogTemp, Warning, TEXT("MQTT => There is no running MQTT task"));
+  if (!Task.IsValid() || !Task->IsAlive()) {
+    UE_LOG(LogMqtt, Warning, TEXT("MQTT => There is no running MQTT task"));
     return;
   }
 
@@ -116,26 +182,27 @@ void UMqttClient::Unsubscribe(FString topic) {
 }
 
 void UMqttClient::Publish(FMqttMessage message) {
-  if (Task == nullptr || !Task->IsAlive()) {
-    UE_LOG(LogTemp, Warning, TEXT("MQTT => There is no running MQTT task"));
+  MQTT_LLM_SCOPE();
+
+  if (!Task.IsValid() || !Task->IsAlive()) {
+    UE_LOG(LogMqtt, Warning, TEXT("MQTT => There is no running MQTT task"));
     return;
   }
 
-  int message_size = message.Message.Num();
   char *sub = StringUtils::CopyString(message.Topic);
-  void *buffer = (uint8_t *)malloc(message_size);
-
-  if (buffer != NULL) {
-    memcpy(buffer, message.Message.GetData(), message_size);
-  }
 
   FMqttPublishTaskPtr taskPublish = MakeShared<FMqttPublishTask>();
   taskPublish->type = MqttTaskType::Publish;
   taskPublish->topic = sub;
-  taskPublish->payloadlen = message_size;
-  taskPublish->payload = buffer;
+  taskPublish->payload = MoveTemp(message.Message);
   taskPublish->qos = message.Qos;
   taskPublish->retain = message.Retain;
+  taskPublish->lane = message.Lane;
+
+  // Stamped here unless the caller passed the capture time of the data.
+  taskPublish->timestamp = message.Timestamp != 0
+                               ? message.Timestamp
+                               : UMqttUtilitiesBPL::GetUnixTimeMicroseconds();
 
   Task->PushTask(taskPublish);
 }
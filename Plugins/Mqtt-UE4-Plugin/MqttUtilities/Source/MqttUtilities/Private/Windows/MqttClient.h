@@ -9,6 +9,12 @@
 
 class FMqttRunnable;
 
+typedef TSharedPtr<FMqttRunnable, ESPMode::ThreadSafe> FMqttRunnablePtr;
+
+/**
+ * Handle to a broker connection. The connection itself lives on the shared
+ * FMqttReactor thread; the client only queues tasks for it.
+ */
 UCLASS()
 class UMqttClient : public UMqttClientBase {
   GENERATED_BODY()
@@ -28,6 +34,9 @@ public:
   void Subscribe(FString topic, int qos,
                  IMqttMessageHandlerInterface *handler) override;
 
+  void Subscribe(FString topic, int qos,
+                 IMqttDecodingHandlerPtr handler) override;
+
   void Unsubscribe(FString topic) override;
 
   void Publish(FMqttMessage message) override;
@@ -36,7 +45,9 @@ public:
   void Init(FMqttClientConfig configData) override;
 
 private:
-  FMqttRunnable *Task;
-  FRunnableThread *Thread;
+  FMqttRunnablePtr Task;
   FMqttClientConfig ClientConfig;
+
+  /** Connect called before the mosquitto libraries finished loading. */
+  bool bConnectPending = false;
 };
\ No newline at end of file
@@ -2,17 +2,182 @@
 
 #include "MqttClientImpl.h"
 #include "MqttRunnable.h"
+#include "MqttStats.h"
+#include "MqttTrace.h"
 
-MqttClientImpl::MqttClientImpl(const char *id) : mosqpp::mosquittopp(id) {}
+#include <mqtt_protocol.h>
 
-MqttClientImpl::~MqttClientImpl() {}
+namespace {
 
-void MqttClientImpl::on_connect(int rc) {
+// QoS 0 publishes to a topic before it gets an alias.
+const int32 HotTopicPublishes = 8;
+
+const char *TimestampProperty = "ts";
+
+MqttClientImpl *Self(void *obj) { return static_cast<MqttClientImpl *>(obj); }
+
+void OnConnectCallback(struct mosquitto *, void *obj, int rc, int,
+                       const mosquitto_property *props) {
+  Self(obj)->on_connect(rc, props);
+}
+
+void OnDisconnectCallback(struct mosquitto *, void *obj, int rc,
+                          const mosquitto_property *) {
+  Self(obj)->on_disconnect(rc);
+}
+
+void OnPublishCallback(struct mosquitto *, void *obj, int mid, int,
+                       const mosquitto_property *) {
+  Self(obj)->on_publish(mid);
+}
+
+void OnMessageCallback(struct mosquitto *, void *obj,
+                       const struct mosquitto_message *message,
+                       const mosquitto_property *props) {
+  Self(obj)->on_message(message, props);
+}
+
+void OnSubscribeCallback(struct mosquitto *, void *obj, int mid, int qos_count,
+                         const int *granted_qos, const mosquitto_property *) {
+  Self(obj)->on_subscribe(mid, qos_count, granted_qos);
+}
+
+void OnUnsubscribeCallback(struct mosquitto *, void *obj, int mid,
+                           const mosquitto_property *) {
+  Self(obj)->on_unsubscribe(mid);
+}
+
+}  // namespace
+
+MqttClientImpl::MqttClientImpl(const char *id, bool bProtocolV5)
+    : Task(nullptr),
+      Mosq(mosquitto_new(id, true, this)),
+      bProtocolV5(bProtocolV5),
+      TopicAliasMaximum(0),
+      NextTopicAlias(1) {
+  if (bProtocolV5) {
+    mosquitto_int_option(Mosq, MOSQ_OPT_PROTOCOL_VERSION, MQTT_PROTOCOL_V5);
+  }
+
+  mosquitto_connect_v5_callback_set(Mosq, &OnConnectCallback);
+  mosquitto_disconnect_v5_callback_set(Mosq, &OnDisconnectCallback);
+  mosquitto_publish_v5_callback_set(Mosq, &OnPublishCallback);
+  mosquitto_message_v5_callback_set(Mosq, &OnMessageCallback);
+  mosquitto_subscribe_v5_callback_set(Mosq, &OnSubscribeCallback);
+  mosquitto_unsubscribe_v5_callback_set(Mosq, &OnUnsubscribeCallback);
+}
+
+MqttClientImpl::~MqttClientImpl() { mosquitto_destroy(Mosq); }
+
+int MqttClientImpl::socket() { return mosquitto_socket(Mosq); }
+
+bool MqttClientImpl::want_write() { return mosquitto_want_write(Mosq); }
+
+int MqttClientImpl::username_pw_set(const char *username,
+                                    const char *password) {
+  return mosquitto_username_pw_set(Mosq, username, password);
+}
+
+int MqttClientImpl::max_inflight_messages_set(
+    unsigned int max_inflight_messages) {
+  return mosquitto_max_inflight_messages_set(Mosq, max_inflight_messages);
+}
+
+int MqttClientImpl::connect_async(const char *host, int port, int keepalive) {
+  return mosquitto_connect_async(Mosq, host, port, keepalive);
+}
+
+int MqttClientImpl::reconnect_async() {
+  return mosquitto_reconnect_async(Mosq);
+}
+
+int MqttClientImpl::disconnect() { return mosquitto_disconnect(Mosq); }
+
+int MqttClientImpl::publish(int *mid, const char *topic, int payloadlen,
+                            const void *payload, int qos, bool retain,
+                            int64 timestamp) {
+  MQTT_TRACE_SCOPE(Mqtt_publish);
+
+  if (!bProtocolV5) {
+    return mosquitto_publish(Mosq, mid, topic, payloadlen, payload, qos,
+                             retain);
+  }
+
+  mosquitto_property *props = nullptr;
+
+  if (timestamp != 0) {
+    char value[24];
+    FCStringAnsi::Snprintf(value, sizeof(value), "%lld",
+                           (long long)timestamp);
+    mosquitto_property_add_string_pair(&props, MQTT_PROP_USER_PROPERTY,
+                                       TimestampProperty, value);
+  }
+
+  // Only QoS 0 messages use aliases; retried QoS 1/2 packets would have to
+  // carry the topic again after a reconnect.
+  FTopicAlias *alias = nullptr;
+  if (qos == 0 && TopicAliasMaximum > 0) {
+    alias = &TopicAliases[topic];
+
+    if (alias->Alias == 0 && ++alias->Publishes >= HotTopicPublishes &&
+        NextTopicAlias <= TopicAliasMaximum) {
+      alias->Alias = NextTopicAlias++;
+    }
+
+    if (alias->Alias != 0) {
+      mosquitto_property_add_int16(&props, MQTT_PROP_TOPIC_ALIAS, alias->Alias);
+    }
+  }
+
+  // The first packet binds the alias, later ones leave the topic empty.
+  const bool bAliasOnly =
+      alias != nullptr && alias->Alias != 0 && alias->bAnnounced;
+
+  int returnCode =
+      mosquitto_publish_v5(Mosq, mid, bAliasOnly ? nullptr : topic,
+                           payloadlen, payload, qos, retain, props);
+  mosquitto_property_free_all(&props);
+
+  if (returnCode == MOSQ_ERR_SUCCESS && alias != nullptr) {
+    alias->bAnnounced = alias->Alias != 0;
+  }
+
+  return returnCode;
+}
+
+int MqttClientImpl::subscribe(int *mid, const char *sub, int qos) {
+  return mosquitto_subscribe(Mosq, mid, sub, qos);
+}
+
+int MqttClientImpl::unsubscribe(int *mid, const char *sub) {
+  return mosquitto_unsubscribe(Mosq, mid, sub);
+}
+
+int MqttClientImpl::loop_misc() { return mosquitto_loop_misc(Mosq); }
+
+int MqttClientImpl::loop_read(int max_packets) {
+  return mosquitto_loop_read(Mosq, max_packets);
+}
+
+int MqttClientImpl::loop_write(int max_packets) {
+  return mosquitto_loop_write(Mosq, max_packets);
+}
+
+void MqttClientImpl::on_connect(int rc, const mosquitto_property *props) {
   if (rc != 0) {
     return;
   }
 
-  UE_LOG(LogTemp, Warning, TEXT("MQTT => Impl: Connected"));
+  // Aliases are per connection; the broker states how many it accepts.
+  TopicAliases.clear();
+  NextTopicAlias = 1;
+  TopicAliasMaximum = 0;
+  if (bProtocolV5) {
+    mosquitto_property_read_int16(props, MQTT_PROP_TOPIC_ALIAS_MAXIMUM,
+                                  &TopicAliasMaximum, false);
+  }
+
+  UE_LOG(LogMqtt, Log, TEXT("MQTT => Impl: Connected"));
 
   Task->OnConnect();
 }
@@ -22,27 +187,30 @@ void MqttClientImpl::on_disconnect(int rc) {
     return;
   }
 
-  UE_LOG(LogTemp, Warning, TEXT("MQTT => Impl: Disconnected"));
+  UE_LOG(LogMqtt, Log, TEXT("MQTT => Impl: Disconnected"));
 
   Task->OnDisconnect();
 }
 
 void MqttClientImpl::on_publish(int mid) {
-  UE_LOG(LogTemp, Warning, TEXT("MQTT => Impl: Mesage published"));
+  UE_LOG(LogMqtt, Verbose, TEXT("MQTT => Impl: Message published"));
 
   Task->OnPublished(mid);
 }
 
-void MqttClientImpl::on_message(const mosquitto_message *src) {
+void MqttClientImpl::on_message(const mosquitto_message *src,
+                                const mosquitto_property *props) {
+  MQTT_TRACE_SCOPE(Mqtt_on_message);
+
   if (!src->topic) {
-    UE_LOG(LogTemp, Warning, TEXT("MQTT => Impl: Topic is NULL"));
+    UE_LOG(LogMqtt, Warning, TEXT("MQTT => Impl: Topic is NULL"));
     return;
   }
   if (!src->payload) {
-    UE_LOG(LogTemp, Warning, TEXT("MQTT => Impl: Payload is NULL"));
+    UE_LOG(LogMqtt, Warning, TEXT("MQTT => Impl: Payload is NULL"));
     return;
   }
-  //UE_LOG(LogTemp, Warning, TEXT("MQTT => Impl: Message received"));
+  UE_LOG(LogMqtt, VeryVerbose, TEXT("MQTT => Impl: Message received"));
 
   FMqttMessage msg;
 
@@ -51,17 +219,29 @@ void MqttClientImpl::on_message(const mosquitto_message *src) {
   msg.Retain = src->retain;
   int PayloadLength = src->payloadlen;
 
-  std::vector<uint8_t> buf(PayloadLength);
-  memcpy(buf.data(), src->payload, PayloadLength);
+  msg.Message.Append(static_cast<const uint8 *>(src->payload), PayloadLength);
 
-  msg.Message.Append(&buf[0], PayloadLength);
+  // Capture time set by the sender, if it is a v5 client of this plugin.
+  bool bSkipFirst = false;
+  char *name = nullptr;
+  char *value = nullptr;
+  while ((props = mosquitto_property_read_string_pair(
+              props, MQTT_PROP_USER_PROPERTY, &name, &value, bSkipFirst)) !=
+         nullptr) {
+    if (FCStringAnsi::Strcmp(name, TimestampProperty) == 0) {
+      msg.Timestamp = FCStringAnsi::Atoi64(value);
+    }
+    free(name);
+    free(value);
+    bSkipFirst = true;
+  }
 
   Task->OnMessage(msg);
 }
 
 void MqttClientImpl::on_subscribe(int mid, int qos_count,
                                   const int *granted_qos) {
-  UE_LOG(LogTemp, Warning, TEXT("MQTT => Impl: Subscribed"));
+  UE_LOG(LogMqtt, Verbose, TEXT("MQTT => Impl: Subscribed"));
 
   TArray<int> qos;
 
@@ -73,7 +253,7 @@ void MqttClientImpl::on_subscribe(int mid, int qos_count,
 }
 
 void MqttClientImpl::on_unsubscribe(int mid) {
-  UE_LOG(LogTemp, Warning, TEXT("MQTT => Impl: Unsubscribed"));
+  UE_LOG(LogMqtt, Verbose, TEXT("MQTT => Impl: Unsubscribed"));
 
   Task->OnUnsubscribe(mid);
-}
\ No newline at end of file
+}
@@ -2,21 +2,70 @@
 
 #pragma once
 
-#include <mosquittopp.h>
+#include "CoreMinimal.h"
+
+#include <mosquitto.h>
+
+#include <string>
+#include <unordered_map>
 
 class FMqttRunnable;
 
-class MqttClientImpl : public mosqpp::mosquittopp {
+/**
+ * Broker connection on the libmosquitto C API.
+ *
+ * Keeps the method names of the mosquittopp wrapper it replaces; the C API is
+ * needed for MQTT v5 properties. In v5 mode frequently published QoS 0 topics
+ * get topic aliases once the broker allows them, and every publish carries
+ * its capture time as a "ts" user property.
+ */
+class MqttClientImpl {
 public:
-  MqttClientImpl(const char *id);
+  MqttClientImpl(const char *id, bool bProtocolV5);
   ~MqttClientImpl();
 
-  void on_connect(int rc) override;
-  void on_disconnect(int rc) override;
-  void on_publish(int mid) override;
-  void on_message(const struct mosquitto_message *message) override;
-  void on_subscribe(int mid, int qos_count, const int *granted_qos) override;
-  void on_unsubscribe(int mid) override;
+  int socket();
+  bool want_write();
+
+  int username_pw_set(const char *username, const char *password);
+  int max_inflight_messages_set(unsigned int max_inflight_messages);
+
+  int connect_async(const char *host, int port, int keepalive);
+  int reconnect_async();
+  int disconnect();
+
+  /** timestamp is the capture time in microseconds since the Unix epoch. */
+  int publish(int *mid, const char *topic, int payloadlen, const void *payload,
+              int qos, bool retain, int64 timestamp = 0);
+  int subscribe(int *mid, const char *sub, int qos);
+  int unsubscribe(int *mid, const char *sub);
+
+  int loop_misc();
+  int loop_read(int max_packets = 1);
+  int loop_write(int max_packets = 1);
+
+  void on_connect(int rc, const mosquitto_property *props);
+  void on_disconnect(int rc);
+  void on_publish(int mid);
+  void on_message(const struct mosquitto_message *message,
+                  const mosquitto_property *props);
+  void on_subscribe(int mid, int qos_count, const int *granted_qos);
+  void on_unsubscribe(int mid);
 
   FMqttRunnable *Task;
-};
\ No newline at end of file
+
+private:
+  struct FTopicAlias {
+    int32 Publishes = 0;
+    uint16 Alias = 0;
+    bool bAnnounced = false;
+  };
+
+  struct mosquitto *Mosq;
+  bool bProtocolV5;
+
+  // Topic aliases of this connection; the broker forgets them on disconnect.
+  std::unordered_map<std::string, FTopicAlias> TopicAliases;
+  uint16 TopicAliasMaximum;
+  uint16 NextTopicAlias;
+};
@@ -0,0 +1,276 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#include "MqttReactor.h"
+
+#include "GenericPlatform/GenericPlatformAffinity.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/ScopeLock.h"
+#include "MqttRunnable.h"
+#include "MqttStats.h"
+#include "MqttTrace.h"
+
+#include "Windows/AllowWindowsPlatformTypes.h"
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include "Windows/HideWindowsPlatformTypes.h"
+
+#include <mosquitto.h>
+
+namespace {
+
+TUniquePtr<FMqttReactor> Instance;
+bool bShutDown = false;
+FCriticalSection InstanceLock;
+
+}  // namespace
+
+void FMqttReactor::Startup() {
+  FScopeLock lock(&InstanceLock);
+  bShutDown = false;
+}
+
+void FMqttReactor::Shutdown() {
+  TUniquePtr<FMqttReactor> reactor;
+  {
+    FScopeLock lock(&InstanceLock);
+    bShutDown = true;
+    reactor = MoveTemp(Instance);
+  }
+
+  // Destroyed outside the lock: connections finishing on the reactor thread
+  // may still wake it, which is a no-op by now.
+  reactor.Reset();
+}
+
+void FMqttReactor::Add(const FMqttRunnablePtr &connection) {
+  FScopeLock lock(&InstanceLock);
+
+  if (bShutDown) {
+    UE_LOG(LogMqtt, Warning,
+           TEXT("MQTT => Connection added after shutdown, ignored"));
+    return;
+  }
+
+  if (!Instance.IsValid()) {
+    Instance = TUniquePtr<FMqttReactor>(new FMqttReactor());
+  }
+
+  Instance->AddConnection(connection);
+}
+
+void FMqttReactor::Wake() {
+  FScopeLock lock(&InstanceLock);
+
+  if (Instance.IsValid()) {
+    Instance->WakePoll();
+  }
+}
+
+int32 FMqttReactor::GetNumConnections() {
+  FScopeLock lock(&InstanceLock);
+
+  if (!Instance.IsValid()) {
+    return 0;
+  }
+
+  FScopeLock connectionsLock(&Instance->ConnectionsLock);
+  return Instance->NumConnections;
+}
+
+FMqttReactor::FMqttReactor()
+    : bKeepRunning(true),
+      bWakePending(false),
+      WakeSocket(INVALID_SOCKET),
+      NumConnections(0),
+      Thread(nullptr) {
+  mosquitto_lib_init();
+
+  if (!CreateWakeSocket()) {
+    UE_LOG(LogMqtt, Warning,
+           TEXT("MQTT => Reactor has no wake socket, tasks run on poll "
+                "timeouts only"));
+  }
+
+  Thread = FRunnableThread::Create(
+      this, TEXT("MQTT"), 0, EThreadPriority::TPri_Normal,
+      FGenericPlatformAffinity::GetNoAffinityMask());
+}
+
+FMqttReactor::~FMqttReactor() {
+  if (Thread != nullptr) {
+    Thread->Kill(true);
+    delete Thread;
+    Thread = nullptr;
+  }
+
+  if (WakeSocket != INVALID_SOCKET) {
+    closesocket((SOCKET)WakeSocket);
+    WakeSocket = INVALID_SOCKET;
+  }
+
+  mosquitto_lib_cleanup();
+}
+
+bool FMqttReactor::CreateWakeSocket() {
+  // Needed before any socket call; mosquitto does the same in lib_init.
+  WSADATA wsaData;
+  WSAStartup(MAKEWORD(2, 2), &wsaData);
+
+  SOCKET sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (sock == INVALID_SOCKET) {
+    return false;
+  }
+
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = 0;
+  int addressSize = sizeof(address);
+
+  u_long nonBlocking = 1;
+  if (bind(sock, (sockaddr *)&address, sizeof(address)) != 0 ||
+      getsockname(sock, (sockaddr *)&address, &addressSize) != 0 ||
+      connect(sock, (sockaddr *)&address, sizeof(address)) != 0 ||
+      ioctlsocket(sock, FIONBIO, &nonBlocking) != 0) {
+    closesocket(sock);
+    return false;
+  }
+
+  WakeSocket = (uint64)sock;
+  return true;
+}
+
+void FMqttReactor::DrainWakeSocket() {
+  char buffer[16];
+  while (recv((SOCKET)WakeSocket, buffer, sizeof(buffer), 0) > 0) {
+  }
+
+  // Cleared after draining so a wake racing with this sends a new datagram;
+  // tasks queued before it run on the next pass anyway.
+  bWakePending = false;
+}
+
+void FMqttReactor::AddConnection(const FMqttRunnablePtr &connection) {
+  {
+    FScopeLock lock(&ConnectionsLock);
+    Added.Add(connection);
+    ++NumConnections;
+  }
+
+  WakePoll();
+}
+
+void FMqttReactor::WakePoll() {
+  // Many publishes between two polls need only one datagram.
+  if (WakeSocket == INVALID_SOCKET || bWakePending.AtomicSet(true)) {
+    return;
+  }
+
+  const char byte = 0;
+  send((SOCKET)WakeSocket, &byte, 1, 0);
+}
+
+void FMqttReactor::Stop() {
+  bKeepRunning = false;
+  WakePoll();
+}
+
+uint32 FMqttReactor::Run() {
+  MQTT_LLM_SCOPE();
+
+  TArray<WSAPOLLFD> fds;
+  TArray<FMqttRunnable *> polled;
+
+  while (bKeepRunning) {
+    MQTT_TRACE_SCOPE(Mqtt_ReactorIteration);
+
+    {
+      FScopeLock lock(&ConnectionsLock);
+      for (const FMqttRunnablePtr &connection : Added) {
+        if (connection->IsAlive()) {
+          connection->Start();
+        }
+        Connections.Add(connection);
+      }
+      Added.Reset();
+    }
+
+    const double now = FPlatformTime::Seconds();
+    int32 timeout = 1000;
+
+    fds.Reset();
+    polled.Reset();
+
+    for (int32 i = Connections.Num() - 1; i >= 0; --i) {
+      FMqttRunnable *connection = Connections[i].Get();
+
+      if (!connection->IsAlive()) {
+        connection->Finish();
+        Connections.RemoveAtSwap(i);
+
+        FScopeLock lock(&ConnectionsLock);
+        --NumConnections;
+        continue;
+      }
+
+      connection->ProcessTasks();
+      connection->Tick(now);
+      timeout = FMath::Min(timeout, connection->GetPollTimeout());
+
+      const int sock = connection->GetSocket();
+      if (sock == -1) {
+        continue;
+      }
+
+      WSAPOLLFD fd = {};
+      fd.fd = (SOCKET)sock;
+      fd.events = POLLRDNORM | (connection->WantWrite() ? POLLWRNORM : 0);
+      fds.Add(fd);
+      polled.Add(connection);
+    }
+
+    if (WakeSocket != INVALID_SOCKET) {
+      WSAPOLLFD fd = {};
+      fd.fd = (SOCKET)WakeSocket;
+      fd.events = POLLRDNORM;
+      fds.Add(fd);
+    }
+
+    if (fds.Num() == 0) {
+      FPlatformProcess::Sleep(timeout * 0.001f);
+      continue;
+    }
+
+    {
+      // Idle wait, kept out of the iteration's own time.
+      MQTT_TRACE_SCOPE(Mqtt_ReactorPoll);
+      if (WSAPoll(fds.GetData(), fds.Num(), timeout) <= 0) {
+        continue;
+      }
+    }
+
+    const double ready = FPlatformTime::Seconds();
+
+    for (int32 i = 0; i < polled.Num(); ++i) {
+      const SHORT revents = fds[i].revents;
+      if (revents & (POLLRDNORM | POLLHUP | POLLERR)) {
+        polled[i]->OnReadable(ready);
+      }
+      if (revents & POLLWRNORM) {
+        polled[i]->OnWritable(ready);
+      }
+    }
+
+    if (WakeSocket != INVALID_SOCKET && fds.Last().revents != 0) {
+      DrainWakeSocket();
+    }
+  }
+
+  for (const FMqttRunnablePtr &connection : Connections) {
+    connection->Finish();
+  }
+  Connections.Reset();
+
+  return 0;
+}
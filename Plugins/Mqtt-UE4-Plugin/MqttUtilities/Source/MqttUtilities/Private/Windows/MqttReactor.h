@@ -0,0 +1,69 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+
+class FMqttRunnable;
+
+typedef TSharedPtr<FMqttRunnable, ESPMode::ThreadSafe> FMqttRunnablePtr;
+
+/**
+ * Single network thread shared by all MQTT clients.
+ *
+ * The reactor owns the broker connections of every UMqttClient and waits for
+ * all of their sockets with one poll. Clients only queue tasks and wake the
+ * reactor; connection callbacks and typed decoders of every client run on this
+ * thread.
+ *
+ * The reactor is created by the first connection and destroyed by Shutdown;
+ * calls made after that, e.g. by clients torn down late, are ignored instead
+ * of starting a new thread.
+ */
+class FMqttReactor : public FRunnable {
+ public:
+  /** Allow the reactor to be created again. Called on module startup. */
+  static void Startup();
+
+  /** Stop the thread and close all connections. Called on module shutdown. */
+  static void Shutdown();
+
+  /** Start connecting and stepping a connection. Any thread. */
+  static void Add(const FMqttRunnablePtr &connection);
+
+  /** Interrupt the current poll so queued tasks run at once. Any thread. */
+  static void Wake();
+
+  static int32 GetNumConnections();
+
+  virtual ~FMqttReactor();
+
+  uint32 Run() override;
+  void Stop() override;
+
+ private:
+  FMqttReactor();
+
+  void AddConnection(const FMqttRunnablePtr &connection);
+  void WakePoll();
+
+  bool CreateWakeSocket();
+  void DrainWakeSocket();
+
+  FThreadSafeBool bKeepRunning;
+  FThreadSafeBool bWakePending;
+
+  // Loopback UDP socket connected to itself; a datagram ends the poll.
+  uint64 WakeSocket;
+
+  mutable FCriticalSection ConnectionsLock;
+  TArray<FMqttRunnablePtr> Added;
+  int32 NumConnections;
+
+  // Reactor thread only.
+  TArray<FMqttRunnablePtr> Connections;
+
+  FRunnableThread *Thread;
+};
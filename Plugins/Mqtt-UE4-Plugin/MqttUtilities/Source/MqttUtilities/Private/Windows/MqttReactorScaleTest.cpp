@@ -0,0 +1,136 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#include "Async/Async.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/Guid.h"
+#include "MqttReactor.h"
+#include "MqttStats.h"
+#include "MqttUtilitiesBPL.h"
+
+#include <atomic>
+
+namespace {
+
+/** Counts the messages of all clients; called on the reactor thread. */
+class FReceiveCounter : public IMqttDecodingHandler {
+ public:
+  FReceiveCounter() : Received(0) {}
+
+  bool Decode(const FMqttMessage &message) override {
+    Received.fetch_add(1);
+    return true;
+  }
+
+  std::atomic<int32> Received;
+};
+
+/**
+ * Mqtt.ReactorScale <host[:port]> [clients] [messages per client]
+ *
+ * Connects many clients to a broker, each subscribed to its own topic, and
+ * has every client publish to itself. Logs the delivered messages and the
+ * time taken; all connections share the single reactor thread.
+ */
+void RunScaleTest(const TArray<FString> &args) {
+  if (args.Num() < 1) {
+    UE_LOG(LogMqtt, Warning,
+           TEXT("MQTT => Usage: Mqtt.ReactorScale <host[:port]> [clients] "
+                "[messages per client]"));
+    return;
+  }
+
+  const int32 numClients =
+      args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*args[1])) : 100;
+  const int32 numMessages =
+      args.Num() > 2 ? FMath::Max(1, FCString::Atoi(*args[2])) : 100;
+
+  FMqttClientConfig config;
+  config.HostUrl = args[0];
+  config.Port = 1883;
+  config.Timeout = 100;
+
+  FString address, port;
+  if (args[0].Split(TEXT(":"), &address, &port)) {
+    config.HostUrl = address;
+    config.Port = FCString::Atoi(*port);
+  }
+
+  TSharedPtr<FReceiveCounter, ESPMode::ThreadSafe> counter =
+      MakeShared<FReceiveCounter, ESPMode::ThreadSafe>();
+
+  const FString prefix =
+      TEXT("mqtt_reactor_scale/") + FGuid::NewGuid().ToString();
+  TArray<TScriptInterface<IMqttClientInterface>> clients;
+
+  for (int32 i = 0; i < numClients; ++i) {
+    config.ClientId =
+        FString::Printf(TEXT("mqtt_reactor_scale_%d_%s"), i,
+                        *FGuid::NewGuid().ToString());
+
+    TScriptInterface<IMqttClientInterface> client =
+        UMqttUtilitiesBPL::CreateMqttClient(config);
+    if (client.GetObject() == nullptr) {
+      continue;
+    }
+    client.GetObject()->AddToRoot();
+
+    client->Connect(FMqttConnectionData());
+    client->Subscribe(FString::Printf(TEXT("%s/%d"), *prefix, i), 0, counter);
+    clients.Add(client);
+  }
+
+  UE_LOG(LogMqtt, Log, TEXT("MQTT => Reactor scale: %d connections"),
+         FMqttReactor::GetNumConnections());
+
+  Async(EAsyncExecution::Thread, [clients, counter, prefix, numMessages]() {
+    // Give the connections and subscriptions time to settle.
+    FPlatformProcess::Sleep(2.0f);
+
+    const double start = FPlatformTime::Seconds();
+
+    FMqttMessage message;
+    message.Qos = 0;
+    message.Retain = false;
+    message.Message.SetNumZeroed(64);
+
+    for (int32 m = 0; m < numMessages; ++m) {
+      for (int32 i = 0; i < clients.Num(); ++i) {
+        message.Topic = FString::Printf(TEXT("%s/%d"), *prefix, i);
+        clients[i]->Publish(message);
+      }
+    }
+
+    const int32 expected = clients.Num() * numMessages;
+    const double deadline = start + 10.0;
+    while (counter->Received.load() < expected &&
+           FPlatformTime::Seconds() < deadline) {
+      FPlatformProcess::Sleep(0.01f);
+    }
+
+    const double elapsed = FPlatformTime::Seconds() - start;
+
+    AsyncTask(ENamedThreads::GameThread, [clients, counter, expected,
+                                          elapsed]() {
+      UE_LOG(LogMqtt, Log,
+             TEXT("MQTT => Reactor scale: %d clients, %d/%d messages in "
+                  "%.1f ms on one network thread"),
+             clients.Num(), counter->Received.load(), expected,
+             elapsed * 1000.0);
+
+      for (const TScriptInterface<IMqttClientInterface> &client : clients) {
+        client->Disconnect();
+        client.GetObject()->RemoveFromRoot();
+      }
+    });
+  });
+}
+
+FAutoConsoleCommand ScaleTestCommand(
+    TEXT("Mqtt.ReactorScale"),
+    TEXT("Connects many clients through the shared reactor thread. Usage: "
+         "Mqtt.ReactorScale <host[:port]> [clients] [messages per client]"),
+    FConsoleCommandWithArgsDelegate::CreateStatic(&RunScaleTest));
+
+}  // namespace
@@ -4,14 +4,37 @@
 
 #include "MqttClient.h"
 #include "MqttClientImpl.h"
+#include "MqttLatencyTracer.h"
+#include "MqttReactor.h"
+#include "MqttTrace.h"
 
 #include "Async/Async.h"
 
 FMqttRunnable::FMqttRunnable(UMqttClient *mqttClient)
-    : FRunnable(),
+    : bKeepRunning(true),
       TaskQueue(new std::queue<FMqttTaskPtr>()),
       TaskQueueLock(new FCriticalSection()),
-      client(mqttClient) {}
+      client(mqttClient),
+      Counters(mqttClient->Counters),
+      bConnected(false),
+      bWasConnected(false),
+      bResubscribe(false),
+      bReconnect(false),
+      ReconnectTime(0.0),
+      ReconnectAttempts(0),
+      OfflineDropped(0),
+      TelemetryDropped(0),
+      Tokens(0.0),
+      TokenTime(0.0),
+      ReconnectMinDelay(0.5),
+      ReconnectMaxDelay(30.0),
+      OfflineBufferSize(256),
+      OfflinePolicy(EMqttOfflinePolicy::DropOldest),
+      bProtocolV5(false),
+      MaxInflight(20),
+      MaxPublishRate(0.0),
+      ControlQueueSize(1024),
+      TelemetryQueueSize(256) {}
 
 FMqttRunnable::~FMqttRunnable() {
   if (TaskQueueLock != nullptr) {
@@ -25,139 +48,403 @@ FMqttRunnable::~FMqttRunnable() {
   }
 }
 
-bool FMqttRunnable::Init() {
-  bKeepRunning = true;
-  return true;
-}
-
-void FMqttRunnable::Stop() { StopRunning(); }
-
-uint32 FMqttRunnable::Run() {
-  mosqpp::lib_init();
-
-  MqttClientImpl connection(ClientId.c_str());
+bool FMqttRunnable::Start() {
+  Connection = MakeUnique<MqttClientImpl>(ClientId.c_str(), bProtocolV5);
 
-  connection.max_inflight_messages_set(0);
-  connection.Task = this;
-
-  int returnCode = 0;
+  // The in-flight window is enforced in SendQueued, so mosquitto never has
+  // to queue messages on its own.
+  Connection->max_inflight_messages_set(0);
+  Connection->Task = this;
 
   if (!Username.empty()) {
-    connection.username_pw_set(Username.c_str(), Password.c_str());
+    Connection->username_pw_set(Username.c_str(), Password.c_str());
   }
 
-  returnCode = connection.connect(Host.c_str(), Port, 10);
+  Random.Initialize((int32)(FPlatformTime::Cycles() ^
+                            GetTypeHash(FString(ClientId.c_str()))));
+  OfflineBuffer.SetCapacity(OfflineBufferSize);
+  ControlLane.SetCapacity(ControlQueueSize);
+  TelemetryLane.SetCapacity(TelemetryQueueSize);
+
+  int returnCode = Connection->connect_async(Host.c_str(), Port, 10);
 
   if (returnCode != 0) {
-    UE_LOG(LogTemp, Error, TEXT("MQTT => Connection error: %s"),
+    UE_LOG(LogMqtt, Error, TEXT("MQTT => Connection error: %s"),
            ANSI_TO_TCHAR(mosquitto_strerror(returnCode)));
     OnError(returnCode, FString(ANSI_TO_TCHAR(mosquitto_strerror(returnCode))));
-    bKeepRunning = false;
+
+    // Only invalid settings are fatal; an unreachable broker is retried.
+    if (returnCode == MOSQ_ERR_INVAL) {
+      bKeepRunning = false;
+      return false;
+    }
+
+    bReconnect = true;
+    ScheduleReconnect(FPlatformTime::Seconds());
   }
 
-  while (bKeepRunning) {
-    TaskQueueLock->Lock();
+  return true;
+}
 
-    while (TaskQueue != nullptr) {
-      if (TaskQueue->empty()) {
-        break;
+void FMqttRunnable::ProcessTasks() {
+  MQTT_TRACE_SCOPE(Mqtt_ProcessTasks);
+
+  // Mosquitto drops packets queued before a (re)connect, so subscriptions and
+  // offline publishes are replayed once the broker accepted the connection.
+  if (bConnected && bResubscribe) {
+    bResubscribe = false;
+
+    for (const TPair<FString, int32> &subscription : Subscriptions) {
+      int returnCode = Connection->subscribe(
+          NULL, TCHAR_TO_ANSI(*subscription.Key), subscription.Value);
+      if (returnCode != 0) {
+        UE_LOG(LogMqtt, Error, TEXT("MQTT => Resubscribe error: %s"),
+               ANSI_TO_TCHAR(mosquitto_strerror(returnCode)));
       }
+    }
 
-      FMqttTaskPtr task = TaskQueue->front();
-      TaskQueue->pop();
+    FlushOffline();
+  }
+
+  int returnCode = 0;
+  MqttClientImpl &connection = *Connection;
+
+  TaskQueueLock->Lock();
+
+  while (TaskQueue != nullptr) {
+    if (TaskQueue->empty()) {
+      break;
+    }
+
+    FMqttTaskPtr task = TaskQueue->front();
+    TaskQueue->pop();
+
+    returnCode = 0;
+
+    switch (task->type) {
+      case MqttTaskType::Subscribe: {
+        auto taskSubscribe = StaticCastSharedPtr<FMqttSubscribeTask>(task);
+        FString topic(ANSI_TO_TCHAR(taskSubscribe->sub));
 
-      switch (task->type) {
-        case MqttTaskType::Subscribe: {
-          auto taskSubscribe = StaticCastSharedPtr<FMqttSubscribeTask>(task);
+        // Stored first so the subscription is made again after a reconnect.
+        Subscriptions.Emplace(topic, taskSubscribe->qos);
+        if (bConnected) {
           returnCode = connection.subscribe(NULL, taskSubscribe->sub,
                                             taskSubscribe->qos);
-          if (returnCode == 0) {
-            FString topic(ANSI_TO_TCHAR(taskSubscribe->sub));
-            switch (taskSubscribe->handler_type) {
-              case HandlerType::EventDelegate: {
-                auto taskEventHandler =
-                    StaticCastSharedPtr<FMqttSubscribeEventDelegateTask>(
-                        taskSubscribe);
-                if (taskEventHandler->handler.IsBound() == true) {
-                  m_MsgEventHandler.Emplace(topic, taskEventHandler->handler);
-                }
-                break;
-              }
-              case HandlerType::InterfaceFunction: {
-                auto taskFuncHandler =
-                    StaticCastSharedPtr<FMqttSubscribeInterfaceFuncTask>(
-                        taskSubscribe);
-                if (taskFuncHandler->handler != nullptr) {
-                  m_MsgFuncHandler.Emplace(topic, taskFuncHandler->handler);
-                }
-                break;
-              }
+        }
+
+        switch (taskSubscribe->handler_type) {
+          case HandlerType::EventDelegate: {
+            auto taskEventHandler =
+                StaticCastSharedPtr<FMqttSubscribeEventDelegateTask>(
+                    taskSubscribe);
+            if (taskEventHandler->handler.IsBound() == true) {
+              m_MsgEventHandler.Emplace(topic, taskEventHandler->handler);
             }
+            break;
+          }
+          case HandlerType::InterfaceFunction: {
+            auto taskFuncHandler =
+                StaticCastSharedPtr<FMqttSubscribeInterfaceFuncTask>(
+                    taskSubscribe);
+            if (taskFuncHandler->handler != nullptr) {
+              m_MsgFuncHandler.Emplace(topic, taskFuncHandler->handler);
+            }
+            break;
+          }
+          case HandlerType::Decoding: {
+            auto taskDecodingHandler =
+                StaticCastSharedPtr<FMqttSubscribeDecodingTask>(
+                    taskSubscribe);
+            if (taskDecodingHandler->handler.IsValid()) {
+              m_MsgDecodingHandler.Emplace(topic,
+                                           taskDecodingHandler->handler);
+            }
+            break;
           }
-          break;
         }
-        case MqttTaskType::Unsubscribe: {
-          auto taskUnsubscribe =
-              StaticCastSharedPtr<FMqttUnsubscribeTask>(task);
+        break;
+      }
+      case MqttTaskType::Unsubscribe: {
+        auto taskUnsubscribe = StaticCastSharedPtr<FMqttUnsubscribeTask>(task);
+        if (bConnected) {
           returnCode = connection.unsubscribe(NULL, taskUnsubscribe->sub);
-          FString topic(ANSI_TO_TCHAR(taskUnsubscribe->sub));
-          m_MsgEventHandler.Remove(topic);
-          m_MsgFuncHandler.Remove(topic);
-          break;
         }
-        case MqttTaskType::Publish: {
-          auto taskPublish = StaticCastSharedPtr<FMqttPublishTask>(task);
-          returnCode = connection.publish(
-              NULL, taskPublish->topic, taskPublish->payloadlen,
-              taskPublish->payload, taskPublish->qos, taskPublish->retain);
-          break;
+        FString topic(ANSI_TO_TCHAR(taskUnsubscribe->sub));
+        Subscriptions.Remove(topic);
+        m_MsgEventHandler.Remove(topic);
+        m_MsgFuncHandler.Remove(topic);
+        m_MsgDecodingHandler.Remove(topic);
+        break;
+      }
+      case MqttTaskType::Publish: {
+        // Sent from the lanes below as the in-flight window and the rate
+        // limit allow.
+        auto taskPublish = StaticCastSharedPtr<FMqttPublishTask>(task);
+        if (bConnected) {
+          EnqueuePublish(taskPublish);
+        } else {
+          BufferOffline(taskPublish);
         }
+        break;
       }
+    }
 
-      if (returnCode != 0) {
-        UE_LOG(LogTemp, Error, TEXT("MQTT => Output error: %s"),
-               ANSI_TO_TCHAR(mosquitto_strerror(returnCode)));
-        OnError(returnCode,
-                FString(ANSI_TO_TCHAR(mosquitto_strerror(returnCode))));
-      }
+    if (returnCode != 0) {
+      UE_LOG(LogMqtt, Error, TEXT("MQTT => Output error: %s"),
+             ANSI_TO_TCHAR(mosquitto_strerror(returnCode)));
+      OnError(returnCode,
+              FString(ANSI_TO_TCHAR(mosquitto_strerror(returnCode))));
     }
+  }
+
+  TaskQueueLock->Unlock();
+
+  SendQueued(FPlatformTime::Seconds());
+}
+
+void FMqttRunnable::BufferOffline(const FMqttPublishTaskPtr &task) {
+  const bool bDropNewest = OfflinePolicy == EMqttOfflinePolicy::DropNewest;
+  if (OfflineBuffer.Push(task, bDropNewest).IsValid()) {
+    ++OfflineDropped;
+    Counters->Dropped.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void FMqttRunnable::FlushOffline() {
+  if (OfflineDropped > 0) {
+    UE_LOG(LogMqtt, Warning,
+           TEXT("MQTT => %d messages dropped while disconnected"),
+           OfflineDropped);
+    OfflineDropped = 0;
+  }
 
-    TaskQueueLock->Unlock();
+  while (OfflineBuffer.Num() > 0) {
+    EnqueuePublish(OfflineBuffer.Pop());
+  }
+}
 
-    returnCode = connection.loop(Timeout);
+void FMqttRunnable::EnqueuePublish(const FMqttPublishTaskPtr &task) {
+  if (task->lane == EMqttPublishLane::Control) {
+    // Control messages are never replaced; a full lane rejects new ones.
+    if (ControlLane.Push(task, true).IsValid()) {
+      Counters->Dropped.fetch_add(1, std::memory_order_relaxed);
+      UE_LOG(LogMqtt, Warning, TEXT("MQTT => Control queue full, dropped %s"),
+             ANSI_TO_TCHAR(task->topic));
+    }
+    return;
+  }
+
+  const FString topic(ANSI_TO_TCHAR(task->topic));
+  if (LatestOnlyTopics.Contains(topic)) {
+    // A sample of this topic is still queued: send the new message in its
+    // place instead of queueing both, with its own capture time for the
+    // latency tracer.
+    FMqttPublishTaskPtr *pending = LatestOnly.Find(topic);
+    if (pending != nullptr) {
+      Swap((*pending)->payload, task->payload);
+      (*pending)->qos = task->qos;
+      (*pending)->retain = task->retain;
+      (*pending)->timestamp = task->timestamp;
+      (*pending)->lane = task->lane;
+      return;
+    }
+
+    task->latest_only = true;
+    LatestOnly.Add(topic, task);
+  }
+
+  FMqttPublishTaskPtr dropped = TelemetryLane.Push(task, false);
+  if (dropped.IsValid()) {
+    ++TelemetryDropped;
+    Counters->Dropped.fetch_add(1, std::memory_order_relaxed);
+    if (dropped->latest_only) {
+      LatestOnly.Remove(FString(ANSI_TO_TCHAR(dropped->topic)));
+    }
+  }
+}
+
+void FMqttRunnable::SendQueued(double now) {
+  if (MaxPublishRate > 0.0) {
+    // Token bucket holding at most 100 ms worth of messages.
+    const double burst = FMath::Max(MaxPublishRate * 0.1, 1.0);
+    Tokens = FMath::Min(Tokens + (now - TokenTime) * MaxPublishRate, burst);
+    TokenTime = now;
+  }
+
+  while (bConnected) {
+    const bool bControl = ControlLane.Num() > 0;
+    FMqttPublishRing &lane = bControl ? ControlLane : TelemetryLane;
+    if (lane.Num() == 0) {
+      break;
+    }
+
+    const FMqttPublishTaskPtr &next = lane.Peek();
+
+    // QoS 1/2 messages wait for acknowledgements once the window is full.
+    if (next->qos > 0 && MaxInflight > 0 && InFlight.Num() >= MaxInflight) {
+      break;
+    }
+
+    // Telemetry waits while the socket still has unsent bytes, so a stalled
+    // broker cannot grow mosquitto's own packet queue.
+    if (!bControl && Connection->want_write()) {
+      break;
+    }
+
+    if (MaxPublishRate > 0.0 && Tokens < 1.0) {
+      break;
+    }
+
+    FMqttPublishTaskPtr taskPublish = lane.Pop();
+    if (taskPublish->latest_only) {
+      LatestOnly.Remove(FString(ANSI_TO_TCHAR(taskPublish->topic)));
+      taskPublish->latest_only = false;
+    }
+
+    int mid = 0;
+    int returnCode = Connection->publish(
+        &mid, taskPublish->topic, taskPublish->payload.Num(),
+        taskPublish->payload.GetData(), taskPublish->qos, taskPublish->retain,
+        taskPublish->timestamp);
+
+    // The connection dropped before the reactor noticed.
+    if (returnCode == MOSQ_ERR_NO_CONN || returnCode == MOSQ_ERR_CONN_LOST) {
+      BufferOffline(taskPublish);
+      break;
+    }
 
     if (returnCode != 0) {
-      UE_LOG(LogTemp, Error, TEXT("MQTT => Connection error: %s"),
+      UE_LOG(LogMqtt, Error, TEXT("MQTT => Output error: %s"),
              ANSI_TO_TCHAR(mosquitto_strerror(returnCode)));
+      OnError(returnCode,
+              FString(ANSI_TO_TCHAR(mosquitto_strerror(returnCode))));
+      continue;
+    }
 
-      if (returnCode == MOSQ_ERR_CONN_REFUSED) {
-        OnError(returnCode,
-                FString(ANSI_TO_TCHAR(mosquitto_strerror(returnCode))));
-        bKeepRunning = false;
-      } else {
-        if (returnCode == MOSQ_ERR_CONN_LOST) {
-          OnError(returnCode,
-                  FString(ANSI_TO_TCHAR(mosquitto_strerror(returnCode))));
-        }
-        connection.reconnect();
-      }
+    if (MaxPublishRate > 0.0) {
+      Tokens -= 1.0;
     }
+    if (taskPublish->qos > 0) {
+      InFlight.Add(mid);
+    }
+    Counters->AddMessageOut(taskPublish->payload.Num());
   }
 
-  returnCode = connection.disconnect();
+  UpdateQueueDepth();
+}
+
+void FMqttRunnable::UpdateQueueDepth() {
+  Counters->QueueDepth.store(
+      ControlLane.Num() + TelemetryLane.Num() + OfflineBuffer.Num(),
+      std::memory_order_relaxed);
+}
+
+void FMqttRunnable::Tick(double now) {
+  MQTT_TRACE_SCOPE(Mqtt_Tick);
 
+  if (bReconnect || GetSocket() == -1) {
+    bConnected = false;
+
+    // Dropped connections are retried without blocking the other clients.
+    if (now >= ReconnectTime) {
+      // Scheduled as if this attempt fails too; CONNACK resets the backoff.
+      ScheduleReconnect(now);
+      bReconnect = Connection->reconnect_async() != 0;
+    }
+    return;
+  }
+
+  int returnCode = Connection->loop_misc();
   if (returnCode != 0) {
-    UE_LOG(LogTemp, Error, TEXT("MQTT => %s"),
+    HandleLoopError(returnCode, now);
+  }
+}
+
+void FMqttRunnable::ScheduleReconnect(double now) {
+  // Exponential backoff with jitter, so clients that lost the same broker do
+  // not come back in lockstep.
+  const double backoff = (double)(1 << FMath::Min(ReconnectAttempts, 20));
+  const double delay =
+      FMath::Min(ReconnectMinDelay * backoff,
+                 FMath::Max(ReconnectMaxDelay, ReconnectMinDelay));
+  ReconnectTime = now + delay * Random.FRandRange(0.5f, 1.0f);
+  ++ReconnectAttempts;
+}
+
+int FMqttRunnable::GetSocket() const { return Connection->socket(); }
+
+bool FMqttRunnable::WantWrite() const { return Connection->want_write(); }
+
+int32 FMqttRunnable::GetPollTimeout() const {
+  int32 timeout = Timeout < 0 ? 1000 : Timeout;
+
+  // Wake up when the rate limiter has a token for the next queued message.
+  if (bConnected && MaxPublishRate > 0.0 && Tokens < 1.0 &&
+      ControlLane.Num() + TelemetryLane.Num() > 0) {
+    const double wait = (1.0 - Tokens) / MaxPublishRate;
+    timeout = FMath::Min(timeout, FMath::CeilToInt(wait * 1000.0));
+  }
+
+  return timeout;
+}
+
+void FMqttRunnable::OnReadable(double now) {
+  MQTT_TRACE_SCOPE(Mqtt_OnReadable);
+
+  int returnCode = Connection->loop_read();
+  if (returnCode != 0) {
+    HandleLoopError(returnCode, now);
+  }
+}
+
+void FMqttRunnable::OnWritable(double now) {
+  MQTT_TRACE_SCOPE(Mqtt_OnWritable);
+
+  int returnCode = Connection->loop_write();
+  if (returnCode != 0) {
+    HandleLoopError(returnCode, now);
+  }
+}
+
+void FMqttRunnable::HandleLoopError(int returnCode, double now) {
+  // Failed reconnect attempts are expected while the broker is down.
+  if (ReconnectAttempts == 0) {
+    UE_LOG(LogMqtt, Error, TEXT("MQTT => Connection error: %s"),
            ANSI_TO_TCHAR(mosquitto_strerror(returnCode)));
+  } else {
+    UE_LOG(LogMqtt, Verbose, TEXT("MQTT => Reconnect attempt %d failed: %s"),
+           ReconnectAttempts, ANSI_TO_TCHAR(mosquitto_strerror(returnCode)));
+  }
+
+  bConnected = false;
+
+  if (returnCode == MOSQ_ERR_CONN_REFUSED) {
+    OnError(returnCode, FString(ANSI_TO_TCHAR(mosquitto_strerror(returnCode))));
+    bKeepRunning = false;
+  } else {
+    if (returnCode == MOSQ_ERR_CONN_LOST) {
+      OnError(returnCode,
+              FString(ANSI_TO_TCHAR(mosquitto_strerror(returnCode))));
+    }
+    bReconnect = true;
+    ScheduleReconnect(now);
   }
+}
 
-  delete TaskQueue;
-  delete TaskQueueLock;
+void FMqttRunnable::Finish() {
+  if (!Connection.IsValid()) {
+    return;
+  }
 
-  TaskQueue = nullptr;
-  TaskQueueLock = nullptr;
+  int returnCode = Connection->disconnect();
 
-  return 0;
+  if (returnCode != 0 && returnCode != MOSQ_ERR_NO_CONN) {
+    UE_LOG(LogMqtt, Error, TEXT("MQTT => %s"),
+           ANSI_TO_TCHAR(mosquitto_strerror(returnCode)));
+  }
+
+  Connection.Reset();
 }
 
 void FMqttRunnable::StopRunning() { bKeepRunning = false; }
@@ -172,51 +459,116 @@ void FMqttRunnable::PushTask(FMqttTaskPtr task) {
   }
 
   TaskQueueLock->Unlock();
+
+  FMqttReactor::Wake();
 }
 
 void FMqttRunnable::OnConnect() {
-  AsyncTask(ENamedThreads::GameThread,
-            [=]() { client->OnConnectDelegate.ExecuteIfBound(); });
+  if (bWasConnected) {
+    Counters->Reconnects.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  bConnected = true;
+  bWasConnected = true;
+  bReconnect = false;
+  bResubscribe = true;
+  ReconnectAttempts = 0;
+
+  // The session is clean, so nothing sent earlier will be acknowledged.
+  InFlight.Reset();
+
+  RunOnGameThread([](UMqttClient *mqttClient) {
+    mqttClient->OnConnectDelegate.ExecuteIfBound();
+  });
 }
 
 void FMqttRunnable::OnDisconnect() {
-  AsyncTask(ENamedThreads::GameThread,
-            [=]() { client->OnDisconnectDelegate.ExecuteIfBound(); });
+  bConnected = false;
+
+  RunOnGameThread([](UMqttClient *mqttClient) {
+    mqttClient->OnDisconnectDelegate.ExecuteIfBound();
+  });
 }
 
 void FMqttRunnable::OnPublished(int mid) {
-  AsyncTask(ENamedThreads::GameThread,
-            [=]() { client->OnPublishDelegate.ExecuteIfBound(mid); });
+  InFlight.Remove(mid);
+
+  RunOnGameThread([mid](UMqttClient *mqttClient) {
+    mqttClient->OnPublishDelegate.ExecuteIfBound(mid);
+  });
 }
 
 void FMqttRunnable::OnMessage(FMqttMessage message) {
+  MQTT_TRACE_SCOPE(Mqtt_OnMessage);
+  MQTT_LLM_SCOPE();
+
+  FMqttClientCounters &counters = *Counters;
+  counters.AddMessageIn(message.Message.Num());
+  FMqttLatencyTracer::Mark(EMqttLatencyStage::Received, message.Timestamp);
+
+  const uint64 received = FPlatformTime::Cycles64();
+
   auto func_handler = m_MsgFuncHandler.Find(message.Topic);
   if (func_handler != nullptr && (*func_handler) != nullptr) {
     (*func_handler)->MessageHandler(message);
   }
 
-  auto event_handler = m_MsgEventHandler.Find(message.Topic);
-  if (event_handler != nullptr) {
-    AsyncTask(ENamedThreads::GameThread,
-              [=]() { event_handler->ExecuteIfBound(message); });
+  // Typed handlers decode here and only pass the decoded value on to the game
+  // thread. Failures are counted rather than logged for every message.
+  auto decoding_handler = m_MsgDecodingHandler.Find(message.Topic);
+  if (decoding_handler != nullptr) {
+    if (!(*decoding_handler)->Decode(message)) {
+      counters.DecodeErrors.fetch_add(1, std::memory_order_relaxed);
+    }
+    counters.AddHandler(FPlatformTime::Cycles64() - received);
+  }
+
+  // The delegate is copied: the handler map may change before the game
+  // thread runs the task.
+  FOnMessageHandlerDelegate eventHandler;
+  if (auto event_handler = m_MsgEventHandler.Find(message.Topic)) {
+    eventHandler = *event_handler;
   }
 
-  AsyncTask(ENamedThreads::GameThread,
-            [=]() { client->OnMessageDelegate.ExecuteIfBound(message); });
+  RunOnGameThread([eventHandler, message, received](UMqttClient *mqttClient) {
+    MQTT_TRACE_SCOPE(Mqtt_DispatchMessage);
+    FMqttClientCounters &counters = *mqttClient->Counters;
+    const uint64 dispatched = FPlatformTime::Cycles64();
+    counters.AddDispatch(dispatched - received);
+    if (eventHandler.IsBound()) {
+      FMqttLatencyTracer::Mark(EMqttLatencyStage::Delivered,
+                               message.Timestamp);
+    }
+
+    eventHandler.ExecuteIfBound(message);
+    mqttClient->OnMessageDelegate.ExecuteIfBound(message);
+    counters.AddHandler(FPlatformTime::Cycles64() - dispatched);
+  });
 }
 
 void FMqttRunnable::OnSubscribe(int mid, const TArray<int> qos) {
-  AsyncTask(ENamedThreads::GameThread,
-            [=]() { client->OnSubscribeDelegate.ExecuteIfBound(mid, qos); });
+  RunOnGameThread([mid, qos](UMqttClient *mqttClient) {
+    mqttClient->OnSubscribeDelegate.ExecuteIfBound(mid, qos);
+  });
 }
 
 void FMqttRunnable::OnUnsubscribe(int mid) {
-  AsyncTask(ENamedThreads::GameThread,
-            [=]() { client->OnUnsubscribeDelegate.ExecuteIfBound(mid); });
+  RunOnGameThread([mid](UMqttClient *mqttClient) {
+    mqttClient->OnUnsubscribeDelegate.ExecuteIfBound(mid);
+  });
 }
 
 void FMqttRunnable::OnError(int errCode, FString message) {
-  AsyncTask(ENamedThreads::GameThread, [=]() {
-    client->OnErrorDelegate.ExecuteIfBound(errCode, message);
+  RunOnGameThread([errCode, message](UMqttClient *mqttClient) {
+    mqttClient->OnErrorDelegate.ExecuteIfBound(errCode, message);
+  });
+}
+
+void FMqttRunnable::RunOnGameThread(TFunction<void(UMqttClient *)> callback) {
+  TWeakObjectPtr<UMqttClient> weakClient = client;
+  AsyncTask(ENamedThreads::GameThread, [weakClient, callback]() {
+    if (UMqttClient *mqttClient = weakClient.Get()) {
+      callback(mqttClient);
+    }
   });
 }
@@ -3,44 +3,124 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
 
+#include "Entities/MqttClientConfig.h"
 #include "Entities/MqttMessage.h"
+#include "Math/RandomStream.h"
+#include "MqttStats.h"
 #include "MqttTask.h"
 
 #include <queue>
 #include <string>
 
 class UMqttClient;
+class MqttClientImpl;
 
 typedef void (IMqttMessageHandlerInterface::*MessageHandlerFunc)(FMqttMessage);
 
-class FMqttRunnable : public FRunnable {
+/**
+ * One broker connection. It has no thread of its own: the shared FMqttReactor
+ * starts it, runs its queued tasks and does its socket I/O, while the client
+ * only pushes tasks from the game thread.
+ */
+class FMqttRunnable {
  public:
   FMqttRunnable(UMqttClient *mqttClient);
   virtual ~FMqttRunnable();
 
-  bool Init() override;
-  uint32 Run() override;
-  void Stop() override;
-
   void PushTask(FMqttTaskPtr task);
 
   void StopRunning();
 
   bool IsAlive() const;
 
+  // Called by the reactor thread only.
+
+  /** Create the connection and start connecting without blocking. */
+  bool Start();
+
+  /** Run the queued subscribe, unsubscribe and publish tasks. */
+  void ProcessTasks();
+
+  /** Keepalive and reconnect handling; call at least every poll timeout. */
+  void Tick(double now);
+
+  /** Socket to poll, or -1 while not connected. */
+  int GetSocket() const;
+
+  bool WantWrite() const;
+
+  /** Poll timeout in milliseconds requested by the client config. */
+  int32 GetPollTimeout() const;
+
+  void OnReadable(double now);
+  void OnWritable(double now);
+
+  /** Disconnect cleanly once the client stopped the connection. */
+  void Finish();
+
  private:
-  bool bKeepRunning;
+  void HandleLoopError(int returnCode, double now);
+  void ScheduleReconnect(double now);
+
+  void BufferOffline(const FMqttPublishTaskPtr &task);
+  void FlushOffline();
+
+  void EnqueuePublish(const FMqttPublishTaskPtr &task);
+  void SendQueued(double now);
+  void UpdateQueueDepth();
+
+  /** Run callback on the game thread if the client is still alive then. */
+  void RunOnGameThread(TFunction<void(UMqttClient *)> callback);
+
+  FThreadSafeBool bKeepRunning;
 
   std::queue<FMqttTaskPtr> *TaskQueue;
 
   FCriticalSection *TaskQueueLock;
 
-  UMqttClient *client;
+  // The client may be destroyed while the reactor still holds this
+  // connection: the counters are shared and the client is only reached
+  // from the game thread.
+  TWeakObjectPtr<UMqttClient> client;
+  FMqttClientCountersRef Counters;
+
+  TUniquePtr<MqttClientImpl> Connection;
+  bool bConnected;
+  bool bWasConnected;
+  bool bResubscribe;
+
+  // Set after a socket error; the next attempt is made at ReconnectTime.
+  bool bReconnect;
+  double ReconnectTime;
+  int32 ReconnectAttempts;
+  FRandomStream Random;
+
+  // Topics and QoS subscribed to, replayed after every (re)connect.
+  TMap<FString, int32> Subscriptions;
+
+  // Messages published while disconnected.
+  FMqttPublishRing OfflineBuffer;
+  int32 OfflineDropped;
+
+  // Messages waiting for the in-flight window and the rate limiter.
+  FMqttPublishRing ControlLane;
+  FMqttPublishRing TelemetryLane;
+  int32 TelemetryDropped;
+
+  // Queued telemetry of LatestOnlyTopics, replaced by newer samples.
+  TMap<FString, FMqttPublishTaskPtr> LatestOnly;
+
+  // Message ids of QoS 1/2 publishes not acknowledged yet.
+  TSet<int> InFlight;
+
+  double Tokens;
+  double TokenTime;
 
   TMap<FString, IMqttMessageHandlerInterface *> m_MsgFuncHandler;
   TMap<FString, FOnMessageHandlerDelegate> m_MsgEventHandler;
+  TMap<FString, IMqttDecodingHandlerPtr> m_MsgDecodingHandler;
 
  public:
   std::string Host;
@@ -50,6 +130,18 @@ class FMqttRunnable : public FRunnable {
 
   int32 Port;
   int32 Timeout;
+  bool bProtocolV5;
+
+  double ReconnectMinDelay;
+  double ReconnectMaxDelay;
+  int32 OfflineBufferSize;
+  EMqttOfflinePolicy OfflinePolicy;
+
+  int32 MaxInflight;
+  double MaxPublishRate;
+  int32 ControlQueueSize;
+  int32 TelemetryQueueSize;
+  TSet<FString> LatestOnlyTopics;
 
   void OnConnect();
   void OnDisconnect();
@@ -58,4 +150,4 @@ class FMqttRunnable : public FRunnable {
   void OnSubscribe(int mid, const TArray<int> qos);
   void OnUnsubscribe(int mid);
   void OnError(int errCode, FString message);
-};
\ No newline at end of file
+};
@@ -16,6 +16,11 @@ FMqttSubscribeInterfaceFuncTask::FMqttSubscribeInterfaceFuncTask()
 
 FMqttSubscribeInterfaceFuncTask::~FMqttSubscribeInterfaceFuncTask() {}
 
+FMqttSubscribeDecodingTask::FMqttSubscribeDecodingTask()
+    : FMqttSubscribeTask() {}
+
+FMqttSubscribeDecodingTask::~FMqttSubscribeDecodingTask() {}
+
 FMqttUnsubscribeTask::FMqttUnsubscribeTask() : FMqttTask(), sub(nullptr) {}
 
 FMqttUnsubscribeTask::~FMqttUnsubscribeTask() {
@@ -26,17 +31,68 @@ FMqttUnsubscribeTask::~FMqttUnsubscribeTask() {
 }
 
 FMqttPublishTask::FMqttPublishTask()
-    : FMqttTask(), topic(nullptr), payloadlen(0), payload(nullptr), qos(0),
-      retain(false) {}
+    : FMqttTask(),
+      topic(nullptr),
+      qos(0),
+      retain(false),
+      timestamp(0),
+      lane(EMqttPublishLane::Control),
+      latest_only(false) {}
 
 FMqttPublishTask::~FMqttPublishTask() {
   if (topic != nullptr) {
     free(topic);
     topic = nullptr;
   }
+}
+
+FMqttPublishRing::FMqttPublishRing() : Head(0), Count(0) {}
 
-  if (payload != nullptr) {
-    free(payload);
-    payload = nullptr;
+void FMqttPublishRing::SetCapacity(int32 capacity) {
+  TArray<FMqttPublishTaskPtr> tasks;
+  tasks.SetNum(FMath::Max(capacity, 0));
+
+  while (Count > 0 && Count > tasks.Num()) {
+    Pop();
+  }
+  for (int32 i = 0; i < Count; ++i) {
+    tasks[i] = MoveTemp(Tasks[(Head + i) % Tasks.Num()]);
   }
-}
\ No newline at end of file
+
+  Tasks = MoveTemp(tasks);
+  Head = 0;
+}
+
+FMqttPublishTaskPtr FMqttPublishRing::Push(const FMqttPublishTaskPtr &task,
+                                           bool bDropNewest) {
+  const int32 capacity = Tasks.Num();
+
+  if (Count == capacity) {
+    if (capacity == 0 || bDropNewest) {
+      return task;
+    }
+
+    // The new task takes the place of the oldest one.
+    FMqttPublishTaskPtr dropped = MoveTemp(Tasks[Head]);
+    Tasks[Head] = task;
+    Head = (Head + 1) % capacity;
+    return dropped;
+  }
+
+  Tasks[(Head + Count) % capacity] = task;
+  ++Count;
+  return nullptr;
+}
+
+const FMqttPublishTaskPtr &FMqttPublishRing::Peek() const {
+  check(Count > 0);
+  return Tasks[Head];
+}
+
+FMqttPublishTaskPtr FMqttPublishRing::Pop() {
+  check(Count > 0);
+  FMqttPublishTaskPtr task = MoveTemp(Tasks[Head]);
+  Head = (Head + 1) % Tasks.Num();
+  --Count;
+  return task;
+}
@@ -2,6 +2,8 @@
 
 #pragma once
 
+#include "Entities/MqttMessage.h"
+#include "Interface/MqttDecodingHandler.h"
 #include "Interface/MqttMessageHandlerInterface.h"
 
 enum class MqttTaskType {
@@ -13,6 +15,7 @@ enum class MqttTaskType {
 enum class HandlerType {
   EventDelegate,
   InterfaceFunction,
+  Decoding,
 };
 
 struct FMqttTask {
@@ -42,6 +45,13 @@ struct FMqttSubscribeInterfaceFuncTask : public FMqttSubscribeTask {
   IMqttMessageHandlerInterface *handler;
 };
 
+struct FMqttSubscribeDecodingTask : public FMqttSubscribeTask {
+  FMqttSubscribeDecodingTask();
+  virtual ~FMqttSubscribeDecodingTask();
+
+  IMqttDecodingHandlerPtr handler;
+};
+
 struct FMqttUnsubscribeTask : public FMqttTask {
   FMqttUnsubscribeTask();
   ~FMqttUnsubscribeTask();
@@ -54,10 +64,16 @@ struct FMqttPublishTask : public FMqttTask {
   ~FMqttPublishTask();
 
   char *topic;
-  int payloadlen;
-  void *payload;
+
+  // Moved from the published FMqttMessage, so the payload is not copied.
+  TArray<uint8> payload;
   int qos;
   bool retain;
+  int64 timestamp;
+  EMqttPublishLane lane;
+
+  // Queued under its topic in the latest-only map of the runnable.
+  bool latest_only;
 };
 
 typedef TSharedPtr<FMqttSubscribeTask> FMqttSubscribeTaskPtr;
@@ -65,6 +81,31 @@ typedef TSharedPtr<FMqttSubscribeEventDelegateTask>
     FMqttSubscribeEventDelegateTaskPtr;
 typedef TSharedPtr<FMqttSubscribeInterfaceFuncTask>
     FMqttSubscribeInterfaceFuncTaskPtr;
+typedef TSharedPtr<FMqttSubscribeDecodingTask> FMqttSubscribeDecodingTaskPtr;
 typedef TSharedPtr<FMqttUnsubscribeTask> FMqttUnsubscribeTaskPtr;
 typedef TSharedPtr<FMqttPublishTask> FMqttPublishTaskPtr;
-typedef TSharedPtr<FMqttTask> FMqttTaskPtr;
\ No newline at end of file
+typedef TSharedPtr<FMqttTask> FMqttTaskPtr;
+
+/** Bounded FIFO of publish tasks. */
+class FMqttPublishRing {
+ public:
+  FMqttPublishRing();
+
+  void SetCapacity(int32 capacity);
+
+  /**
+   * Append a task. When the ring is full either the oldest task or the new one
+   * is dropped; the dropped task is returned.
+   */
+  FMqttPublishTaskPtr Push(const FMqttPublishTaskPtr &task, bool bDropNewest);
+
+  const FMqttPublishTaskPtr &Peek() const;
+  FMqttPublishTaskPtr Pop();
+
+  int32 Num() const { return Count; }
+
+ private:
+  TArray<FMqttPublishTaskPtr> Tasks;
+  int32 Head;
+  int32 Count;
+};
\ No newline at end of file
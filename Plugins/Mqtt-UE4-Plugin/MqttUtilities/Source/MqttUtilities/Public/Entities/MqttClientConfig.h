@@ -4,6 +4,19 @@
 
 #include "MqttClientConfig.generated.h"
 
+UENUM(BlueprintType)
+enum class EMqttProtocolVersion : uint8 {
+  V311 UMETA(DisplayName = "3.1.1"),
+  V5 UMETA(DisplayName = "5"),
+};
+
+/** What to drop when the offline buffer is full. */
+UENUM(BlueprintType)
+enum class EMqttOfflinePolicy : uint8 {
+  DropOldest,
+  DropNewest,
+};
+
 USTRUCT(BlueprintType)
 struct MQTTUTILITIES_API FMqttClientConfig {
   GENERATED_BODY()
@@ -24,4 +37,49 @@ struct MQTTUTILITIES_API FMqttClientConfig {
   UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MQTT",
             Meta = (DisplayName = "Timeout (0 ~ 1000ms, < 0: 1000ms)"))
   int Timeout;
+
+  /**
+   * MQTT protocol version. Version 5 adds topic aliases for frequently
+   * published topics and capture timestamps on every message.
+   */
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MQTT")
+  EMqttProtocolVersion ProtocolVersion = EMqttProtocolVersion::V311;
+
+  /** Delay before the first reconnect attempt; doubles per failed attempt. */
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MQTT")
+  int ReconnectMinDelayMs = 500;
+
+  /** Upper bound of the reconnect delay. */
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MQTT")
+  int ReconnectMaxDelayMs = 30000;
+
+  /** Messages published while disconnected that are sent on reconnect. */
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MQTT")
+  int OfflineBufferSize = 256;
+
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MQTT")
+  EMqttOfflinePolicy OfflinePolicy = EMqttOfflinePolicy::DropOldest;
+
+  /** QoS 1/2 messages sent but not acknowledged at most (0: unlimited). */
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MQTT")
+  int MaxInflight = 20;
+
+  /** Messages sent per second at most (0: unlimited). */
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MQTT")
+  float MaxPublishRate = 0.0f;
+
+  /** Control messages waiting to be sent; new ones are rejected beyond it. */
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MQTT")
+  int ControlQueueSize = 1024;
+
+  /** Telemetry messages waiting to be sent; the oldest is dropped beyond it. */
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MQTT")
+  int TelemetryQueueSize = 256;
+
+  /**
+   * Telemetry topics of which only the newest message is kept while waiting,
+   * e.g. hand poses.
+   */
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MQTT")
+  TArray<FString> LatestOnlyTopics;
 };
\ No newline at end of file
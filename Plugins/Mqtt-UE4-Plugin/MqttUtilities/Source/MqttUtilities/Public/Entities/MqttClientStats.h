@@ -0,0 +1,58 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#pragma once
+
+#include "MqttClientStats.generated.h"
+
+/** Activity of one MQTT client, sampled once per second. */
+USTRUCT(BlueprintType)
+struct MQTTUTILITIES_API FMqttClientStats {
+  GENERATED_BODY()
+
+  UPROPERTY(BlueprintReadOnly, Category = "MQTT")
+  float MessagesInPerSecond = 0.0f;
+
+  UPROPERTY(BlueprintReadOnly, Category = "MQTT")
+  float MessagesOutPerSecond = 0.0f;
+
+  UPROPERTY(BlueprintReadOnly, Category = "MQTT")
+  float BytesInPerSecond = 0.0f;
+
+  UPROPERTY(BlueprintReadOnly, Category = "MQTT")
+  float BytesOutPerSecond = 0.0f;
+
+  UPROPERTY(BlueprintReadOnly, Category = "MQTT")
+  int64 MessagesIn = 0;
+
+  UPROPERTY(BlueprintReadOnly, Category = "MQTT")
+  int64 MessagesOut = 0;
+
+  UPROPERTY(BlueprintReadOnly, Category = "MQTT")
+  int64 BytesIn = 0;
+
+  UPROPERTY(BlueprintReadOnly, Category = "MQTT")
+  int64 BytesOut = 0;
+
+  /** Outgoing messages waiting for the broker connection or flow control. */
+  UPROPERTY(BlueprintReadOnly, Category = "MQTT")
+  int32 QueueDepth = 0;
+
+  /** Average time from receiving a message to running its game thread
+   * handlers. */
+  UPROPERTY(BlueprintReadOnly, Category = "MQTT")
+  float DispatchLatencyMs = 0.0f;
+
+  /** Average time spent in handlers and decoders per message. */
+  UPROPERTY(BlueprintReadOnly, Category = "MQTT")
+  float HandlerTimeMs = 0.0f;
+
+  UPROPERTY(BlueprintReadOnly, Category = "MQTT")
+  int32 Reconnects = 0;
+
+  UPROPERTY(BlueprintReadOnly, Category = "MQTT")
+  int32 DecodeErrors = 0;
+
+  /** Outgoing messages dropped by full queues. */
+  UPROPERTY(BlueprintReadOnly, Category = "MQTT")
+  int32 DroppedMessages = 0;
+};
@@ -0,0 +1,96 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#pragma once
+
+#include "MqttJitterBufferSettings.generated.h"
+
+USTRUCT(BlueprintType)
+struct MQTTUTILITIES_API FMqttJitterBufferSettings {
+  GENERATED_BODY()
+
+  /** Lowest playout delay added on top of the fastest observed transit. */
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MQTT")
+  float MinDelayMs = 10.0f;
+
+  /** Highest playout delay; frames are never held longer than this. */
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MQTT")
+  float MaxDelayMs = 120.0f;
+
+  /** Target delay is MinDelayMs + JitterFactor * measured jitter. */
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MQTT")
+  float JitterFactor = 3.0f;
+
+  /** How fast the delay follows its target (0..1 per received frame). */
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MQTT")
+  float AdaptRate = 0.05f;
+
+  /** Frames held at most; the oldest is dropped beyond this. */
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MQTT")
+  int32 Capacity = 32;
+
+  /**
+   * A frame arriving this long after the last playout starts a new stream:
+   * the clock is re-anchored and lower sequence numbers are accepted again.
+   * 0 disables the timeout.
+   */
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MQTT")
+  float ResetTimeoutMs = 1000.0f;
+
+  /** Payload key of the frame sequence number. */
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MQTT")
+  FString SequenceKey = TEXT("seq");
+
+  /** Payload key of the capture timestamp. */
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MQTT")
+  FString TimestampKey = TEXT("ts");
+
+  /** Seconds per timestamp unit (0.001 for milliseconds). */
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MQTT")
+  float TimestampUnit = 0.001f;
+};
+
+USTRUCT(BlueprintType)
+struct MQTTUTILITIES_API FMqttJitterBufferStats {
+  GENERATED_BODY()
+
+  /** Frames currently waiting for playout. */
+  UPROPERTY(BlueprintReadOnly, Category = "MQTT")
+  int32 Depth = 0;
+
+  /** Current playout delay. */
+  UPROPERTY(BlueprintReadOnly, Category = "MQTT")
+  float DelayMs = 0.0f;
+
+  /** Smoothed transit jitter. */
+  UPROPERTY(BlueprintReadOnly, Category = "MQTT")
+  float JitterMs = 0.0f;
+
+  UPROPERTY(BlueprintReadOnly, Category = "MQTT")
+  int32 Received = 0;
+
+  UPROPERTY(BlueprintReadOnly, Category = "MQTT")
+  int32 Played = 0;
+
+  /** Frames that arrived after a newer frame was already played. */
+  UPROPERTY(BlueprintReadOnly, Category = "MQTT")
+  int32 LateDrops = 0;
+
+  UPROPERTY(BlueprintReadOnly, Category = "MQTT")
+  int32 Duplicates = 0;
+
+  /** Frames dropped because the buffer was full. */
+  UPROPERTY(BlueprintReadOnly, Category = "MQTT")
+  int32 Overflows = 0;
+
+  /** Sequence numbers skipped at playout. */
+  UPROPERTY(BlueprintReadOnly, Category = "MQTT")
+  int32 Lost = 0;
+
+  /** Times the buffer ran dry while frames were expected. */
+  UPROPERTY(BlueprintReadOnly, Category = "MQTT")
+  int32 Underruns = 0;
+
+  /** Sender restarts, sequence wraps and silences the buffer restarted on. */
+  UPROPERTY(BlueprintReadOnly, Category = "MQTT")
+  int32 Resets = 0;
+};
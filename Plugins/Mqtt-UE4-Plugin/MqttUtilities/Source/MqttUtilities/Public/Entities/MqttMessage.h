@@ -4,6 +4,16 @@
 
 #include "MqttMessage.generated.h"
 
+/**
+ * Outgoing queue of a published message. Control messages are always sent
+ * before telemetry; telemetry is dropped first when the broker falls behind.
+ */
+UENUM(BlueprintType)
+enum class EMqttPublishLane : uint8 {
+  Control,
+  Telemetry,
+};
+
 USTRUCT(BlueprintType)
 struct MQTTUTILITIES_API FMqttMessage {
   GENERATED_BODY()
@@ -23,4 +33,15 @@ struct MQTTUTILITIES_API FMqttMessage {
   /** Quality of signal. */
   UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MQTT")
   int Qos;
+
+  /**
+   * Capture time in microseconds since the Unix epoch (UTC). Set on publish
+   * unless already set; filled on receive when the sender used MQTT 5.
+   */
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MQTT")
+  int64 Timestamp = 0;
+
+  /** Outgoing queue, ignored for received messages. */
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MQTT")
+  EMqttPublishLane Lane = EMqttPublishLane::Control;
 };
@@ -2,7 +2,9 @@
 
 #pragma once
 
+#include "Async/Future.h"
 #include "Modules/ModuleManager.h"
+#include "Templates/Function.h"
 
 class IMqttUtilitiesModule : public IModuleInterface {
 public:
@@ -14,4 +16,19 @@ public:
   static inline bool IsAvailable() {
     return FModuleManager::Get().IsModuleLoaded("MqttUtilities");
   }
+
+  /**
+   * Whether the native MQTT libraries finished loading. They are loaded in
+   * the background after startup; connections made earlier are deferred.
+   */
+  virtual bool IsReady() const = 0;
+
+  /** Resolves once loading finished, with whether it succeeded. */
+  virtual TSharedFuture<bool> GetReadyFuture() const = 0;
+
+  /**
+   * Run callback on the game thread once loading finished, immediately if it
+   * already has. Game thread only.
+   */
+  virtual void WhenReady(TFunction<void(bool)> callback) = 0;
 };
@@ -5,8 +5,10 @@
 #include "UObject/Interface.h"
 
 #include "Entities/MqttClientConfig.h"
+#include "Entities/MqttClientStats.h"
 #include "Entities/MqttConnectionData.h"
 #include "Entities/MqttMessage.h"
+#include "MqttDecodingHandler.h"
 #include "MqttMessageHandlerInterface.h"
 
 #include "MqttClientInterface.generated.h"
@@ -73,6 +75,31 @@ public:
   virtual void Subscribe(FString topic, int qos,
                          IMqttMessageHandlerInterface *handler) = 0;
 
+  /**
+   * Subscribe to topic with a typed handler (used in cpp)
+   * @param topic - name of the topic
+   * @param qos - level of quality of service
+   * @param handler - handler decoding messages on the MQTT thread and passing
+   * decoded values to the game thread, see MakeMqttDecodingHandler
+   *
+   * Not supported by the Android, IOS and Mac clients, which report it
+   * through the error delegate.
+   */
+  virtual void Subscribe(FString topic, int qos,
+                         IMqttDecodingHandlerPtr handler) = 0;
+
+  /**
+   * Get number of messages typed subscriptions failed to decode
+   */
+  UFUNCTION(BlueprintCallable, Category = "MQTT")
+  virtual int GetDecodeErrorCount() = 0;
+
+  /**
+   * Get traffic, queue and latency statistics, sampled once per second
+   */
+  UFUNCTION(BlueprintCallable, Category = "MQTT")
+  virtual FMqttClientStats GetStats() = 0;
+
   /**
    * Unsubscribe from topic
    * @param topic - name of the topic
@@ -0,0 +1,122 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Async.h"
+#include "Entities/MqttMessage.h"
+#include "Misc/ScopeLock.h"
+#include "MqttLatencyTracer.h"
+#include "Templates/Function.h"
+
+/**
+ * Handler for typed subscriptions. Decode is called on the MQTT thread for
+ * every message of the subscribed topic.
+ */
+class IMqttDecodingHandler {
+ public:
+  virtual ~IMqttDecodingHandler() {}
+
+  /**
+   * Decode message payload and schedule delivery of the result
+   * @param message - received message
+   * @return false if the payload could not be decoded
+   */
+  virtual bool Decode(const FMqttMessage &message) = 0;
+};
+
+typedef TSharedPtr<IMqttDecodingHandler, ESPMode::ThreadSafe>
+    IMqttDecodingHandlerPtr;
+
+/**
+ * Called with every decoded value and the capture time of its message, so
+ * types that carry it on to later pipeline stages can overload it.
+ */
+template <typename T>
+inline void MqttSetCaptureTime(T &value, int64 captureUs) {}
+
+/**
+ * Small free list of decoded values. Values are handed back after the game
+ * thread handler ran, so arrays inside them keep their allocations.
+ */
+template <typename T>
+class TMqttValuePool {
+ public:
+  typedef TSharedPtr<T, ESPMode::ThreadSafe> FValuePtr;
+
+  explicit TMqttValuePool(int32 maxFree = 8) : MaxFree(maxFree) {}
+
+  FValuePtr Acquire() {
+    FScopeLock lock(&Lock);
+    return Free.Num() > 0 ? Free.Pop(false) : MakeShared<T, ESPMode::ThreadSafe>();
+  }
+
+  void Release(const FValuePtr &value) {
+    FScopeLock lock(&Lock);
+    if (Free.Num() < MaxFree) {
+      Free.Add(value);
+    }
+  }
+
+ private:
+  FCriticalSection Lock;
+  TArray<FValuePtr> Free;
+  int32 MaxFree;
+};
+
+/**
+ * Decodes payloads into T on the MQTT thread and calls the handler with the
+ * ready value on the game thread.
+ */
+template <typename T>
+class TMqttDecodingHandler
+    : public IMqttDecodingHandler,
+      public TSharedFromThis<TMqttDecodingHandler<T>, ESPMode::ThreadSafe> {
+ public:
+  typedef TFunction<bool(const TArray<uint8> &, T &)> FDecoder;
+  typedef TFunction<void(const T &)> FHandler;
+
+  TMqttDecodingHandler(FDecoder decoder, FHandler handler)
+      : Decoder(MoveTemp(decoder)), Handler(MoveTemp(handler)) {}
+
+  bool Decode(const FMqttMessage &message) override {
+    typename TMqttValuePool<T>::FValuePtr value = Pool.Acquire();
+
+    if (!Decoder(message.Message, *value)) {
+      Pool.Release(value);
+      return false;
+    }
+
+    const int64 capture = message.Timestamp;
+    MqttSetCaptureTime(*value, capture);
+    FMqttLatencyTracer::Mark(EMqttLatencyStage::Decoded, capture);
+
+    auto self = this->AsShared();
+    AsyncTask(ENamedThreads::GameThread, [self, value, capture]() {
+      FMqttLatencyTracer::Mark(EMqttLatencyStage::Delivered, capture);
+      self->Handler(*value);
+      self->Pool.Release(value);
+    });
+
+    return true;
+  }
+
+ private:
+  FDecoder Decoder;
+  FHandler Handler;
+  TMqttValuePool<T> Pool;
+};
+
+/**
+ * Make a typed subscription handler
+ * @param decoder - function filling T from the payload, called on the MQTT
+ * thread
+ * @param handler - function receiving the decoded value on the game thread
+ */
+template <typename T>
+IMqttDecodingHandlerPtr MakeMqttDecodingHandler(
+    typename TMqttDecodingHandler<T>::FDecoder decoder,
+    typename TMqttDecodingHandler<T>::FHandler handler) {
+  return MakeShared<TMqttDecodingHandler<T>, ESPMode::ThreadSafe>(
+      MoveTemp(decoder), MoveTemp(handler));
+}
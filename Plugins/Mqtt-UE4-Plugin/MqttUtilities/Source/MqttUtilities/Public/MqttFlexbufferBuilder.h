@@ -0,0 +1,68 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include <flatbuffers/flexbuffers.h>
+
+/**
+ * Lock-free pool of flexbuffers builders shared by all threads. A builder
+ * keeps its buffer and key pools between messages, so encoding a message of a
+ * known size does not allocate.
+ *
+ * The pool is global rather than per thread: encoders run on the game thread
+ * and on task graph workers, and per-thread pools would keep builders on
+ * every worker that ever encoded and could not be emptied before the module
+ * unloads.
+ */
+class MQTTUTILITIES_API FMqttFlexbufferBuilderPool {
+ public:
+  /** Cleared builder, returned to the pool when destroyed. */
+  class MQTTUTILITIES_API FScopedBuilder {
+   public:
+    FScopedBuilder(FScopedBuilder &&other) : Builder(other.Builder) {
+      other.Builder = nullptr;
+    }
+    ~FScopedBuilder();
+
+    FScopedBuilder(const FScopedBuilder &) = delete;
+    FScopedBuilder &operator=(const FScopedBuilder &) = delete;
+
+    flexbuffers::Builder &operator*() const { return *Builder; }
+    flexbuffers::Builder *operator->() const { return Builder; }
+
+   private:
+    friend class FMqttFlexbufferBuilderPool;
+    explicit FScopedBuilder(flexbuffers::Builder *builder)
+        : Builder(builder) {}
+
+    flexbuffers::Builder *Builder;
+  };
+
+  /** Take a builder from the pool. Any thread; nested calls are fine. */
+  static FScopedBuilder Acquire();
+
+  /** Delete the pooled builders. Builders in use return to the pool later. */
+  static void Empty();
+};
+
+/**
+ * Encode a flexbuffer with a pooled builder into out, reusing out's
+ * allocation. build receives the builder and adds the root value, e.g.
+ *
+ *   MqttEncodeFlexbuffer(message.Message, [&](flexbuffers::Builder &fbb) {
+ *     fbb.Map([&]() { fbb.Int("seq", seq); });
+ *   });
+ */
+template <typename F>
+void MqttEncodeFlexbuffer(TArray<uint8> &out, F &&build) {
+  FMqttFlexbufferBuilderPool::FScopedBuilder builder =
+      FMqttFlexbufferBuilderPool::Acquire();
+  build(*builder);
+  builder->Finish();
+
+  const std::vector<uint8_t> &buffer = builder->GetBuffer();
+  out.SetNumUninitialized((int32)buffer.size(), false);
+  FMemory::Memcpy(out.GetData(), buffer.data(), buffer.size());
+}
@@ -0,0 +1,71 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include <flatbuffers/flexbuffers.h>
+
+#include <atomic>
+#include <cstring>
+
+/**
+ * Map key whose position in the sorted key vector is remembered between
+ * messages. Producers send the same keys every time, so after the first
+ * message a lookup is one comparison at the cached index instead of a binary
+ * search; other layouts fall back to the search and update the cache.
+ *
+ * Keep instances static per decoder or as members of a handler; lookups are
+ * safe from any thread.
+ */
+class FMqttFlexbufferKey {
+ public:
+  /** Key with static storage, e.g. a string literal. */
+  explicit FMqttFlexbufferKey(const char *key) : Key(key), Index(-1) {}
+
+  /** Key from settings; converted to UTF-8 once and kept by the object. */
+  explicit FMqttFlexbufferKey(const FString &key) : Index(-1) {
+    FTCHARToUTF8 utf8(*key);
+    Storage.Append(utf8.Get(), utf8.Length() + 1);
+    Key = Storage.GetData();
+  }
+
+  FMqttFlexbufferKey(const FMqttFlexbufferKey &) = delete;
+  FMqttFlexbufferKey &operator=(const FMqttFlexbufferKey &) = delete;
+
+  const char *GetKey() const { return Key; }
+
+  flexbuffers::Reference Find(const flexbuffers::Map &map) const {
+    const flexbuffers::TypedVector keys = map.Keys();
+    const int32 num = (int32)keys.size();
+
+    const int32 cached = Index.load(std::memory_order_relaxed);
+    if (cached >= 0 && cached < num &&
+        std::strcmp(keys[cached].AsKey(), Key) == 0) {
+      return map.Values()[cached];
+    }
+
+    int32 low = 0;
+    int32 high = num - 1;
+    while (low <= high) {
+      const int32 middle = (low + high) / 2;
+      const int order = std::strcmp(keys[middle].AsKey(), Key);
+      if (order == 0) {
+        Index.store(middle, std::memory_order_relaxed);
+        return map.Values()[middle];
+      }
+      if (order < 0) {
+        low = middle + 1;
+      } else {
+        high = middle - 1;
+      }
+    }
+
+    return flexbuffers::Reference();
+  }
+
+ private:
+  TArray<ANSICHAR> Storage;
+  const char *Key;
+  mutable std::atomic<int32> Index;
+};
@@ -0,0 +1,128 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/ScopeRWLock.h"
+
+#include <flatbuffers/flexbuffers.h>
+
+#include "MqttGestureRegistry.generated.h"
+
+UENUM(BlueprintType)
+enum class EMqttGestureParamType : uint8 {
+  String,
+  Float,
+  Int,
+  /** One of the names of the schema's enum; the value is stored in Int. */
+  Enum,
+};
+
+USTRUCT(BlueprintType)
+struct MQTTUTILITIES_API FMqttGestureParamSchema {
+  GENERATED_BODY()
+
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MQTT")
+  EMqttGestureParamType Type = EMqttGestureParamType::String;
+
+  /** Enum whose names the parameter holds, for Enum parameters. */
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MQTT")
+  UEnum *Enum = nullptr;
+};
+
+USTRUCT(BlueprintType)
+struct MQTTUTILITIES_API FMqttGestureParam {
+  GENERATED_BODY()
+
+  UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "MQTT")
+  EMqttGestureParamType Type = EMqttGestureParamType::String;
+
+  UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "MQTT")
+  float Float = 0.0f;
+
+  /** Int and Enum parameters; INDEX_NONE for an unknown enum name. */
+  UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "MQTT")
+  int32 Int = 0;
+
+  /** String parameters, and any parameter of an unregistered gesture. */
+  UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "MQTT")
+  FString String;
+};
+
+/**
+ * Gesture resolved against FMqttGestureRegistry. Id is what game code
+ * switches on; INDEX_NONE means the name was not registered.
+ */
+USTRUCT(BlueprintType)
+struct MQTTUTILITIES_API FMqttGesture {
+  GENERATED_BODY()
+
+  UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "MQTT")
+  int32 Id = INDEX_NONE;
+
+  UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "MQTT")
+  FName Name;
+
+  UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "MQTT")
+  TArray<FMqttGestureParam> Params;
+};
+
+/**
+ * Table of known gesture names, interned to integer ids with an optional
+ * schema for their parameters.
+ *
+ * Decoding looks the UTF-8 name of a message up by hash without converting
+ * it, and parses parameters straight from the payload into typed values.
+ * Names compare case-insensitively, like FName. Register on startup; lookups
+ * are safe from any thread.
+ */
+class MQTTUTILITIES_API FMqttGestureRegistry {
+ public:
+  static FMqttGestureRegistry &Get();
+
+  /** Add or replace a gesture. Names and ids should be unique. */
+  void Register(FName name, int32 id,
+                const TArray<FMqttGestureParamSchema> &params =
+                    TArray<FMqttGestureParamSchema>());
+
+  /**
+   * Register every enumerator of gestures, named without the enum prefix,
+   * with its value as id, so that Id casts back to the enum.
+   */
+  void RegisterEnum(const UEnum *gestures,
+                    const TArray<FMqttGestureParamSchema> &params =
+                        TArray<FMqttGestureParamSchema>());
+
+  /**
+   * Resolve name and parse params into out. Parameter arrays of out are
+   * reused, so repeated decodes into the same value do not allocate.
+   */
+  void Resolve(const flexbuffers::Reference &name,
+               const flexbuffers::Reference *params, int32 numParams,
+               FMqttGesture &out) const;
+
+ private:
+  struct FNamedValue {
+    TArray<ANSICHAR> Name;
+    int32 Value;
+  };
+
+  struct FParam {
+    EMqttGestureParamType Type;
+    TArray<FNamedValue> EnumValues;
+  };
+
+  struct FEntry {
+    TArray<ANSICHAR> Name;
+    FName DisplayName;
+    int32 Id;
+    TArray<FParam> Params;
+  };
+
+  static void ParseParam(const flexbuffers::Reference &value,
+                         const FParam *schema, FMqttGestureParam &out);
+
+  mutable FRWLock Lock;
+  TArray<TUniquePtr<FEntry>> Entries;
+  TMultiMap<uint32, const FEntry *> EntriesByHash;
+};
@@ -0,0 +1,114 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FlexbuffersFunctionLibrary.h"
+#include "UObject/Object.h"
+
+#include "MqttHandPoseCodec.generated.h"
+
+USTRUCT(BlueprintType)
+struct MQTTUTILITIES_API FMqttHandPoseCodecSettings {
+  GENERATED_BODY()
+
+  /**
+   * Largest per-coordinate difference between sent and decoded landmarks, in
+   * landmark units. Coordinates further than 32767 * 2 * ErrorBound from the
+   * palm are clamped.
+   */
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MQTT")
+  float ErrorBound = 0.0005f;
+
+  /** A full frame is sent every this many frames so receivers can join or
+   * recover from loss. */
+  UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MQTT")
+  int32 KeyframeInterval = 30;
+};
+
+/**
+ * Compact wire format for 21-landmark hand poses (landmark 0 is the palm).
+ *
+ * Landmarks are quantized to 16-bit fixed point relative to the palm. A
+ * keyframe carries the quantized values, a delta frame the zigzag encoded
+ * differences to the previous frame, bit-packed at the width of the largest
+ * one. Both sides keep separate state for the left and right hand.
+ *
+ *   header   : uint8 version << 4 | right << 1 | keyframe, uint16 sequence
+ *   keyframe : float step, float palm[3], int16 landmarks[20 * 3]
+ *   delta    : float palm[3], uint8 width, packed residuals[20 * 3]
+ */
+class MQTTUTILITIES_API FMqttHandPoseEncoder {
+ public:
+  static const int32 NumLandmarks = 21;
+
+  explicit FMqttHandPoseEncoder(
+      const FMqttHandPoseCodecSettings &settings = FMqttHandPoseCodecSettings());
+
+  /** Encode NumLandmarks landmarks, replacing the contents of out. */
+  void Encode(const FVector *landmarks, bool bRightHand, TArray<uint8> &out);
+
+  /** Send the next frame of both hands as a keyframe. */
+  void ForceKeyframe();
+
+ private:
+  struct FHandState {
+    int16 Quantized[(NumLandmarks - 1) * 3] = {};
+    uint16 Sequence = 0;
+    int32 FramesSinceKeyframe = -1;
+  };
+
+  FMqttHandPoseCodecSettings Settings;
+  float Step;
+  FHandState Hands[2];
+};
+
+class MQTTUTILITIES_API FMqttHandPoseDecoder {
+ public:
+  static const int32 NumLandmarks = FMqttHandPoseEncoder::NumLandmarks;
+
+  /**
+   * Decode one frame into NumLandmarks landmarks. Returns false for malformed
+   * frames and for delta frames whose reference frame was not received; the
+   * stream resumes with the next keyframe.
+   */
+  bool Decode(const uint8 *data, int32 size, FVector *outLandmarks,
+              bool &bRightHand);
+
+ private:
+  struct FHandState {
+    int16 Quantized[(NumLandmarks - 1) * 3] = {};
+    uint16 Sequence = 0;
+    float Step = 0.0f;
+    bool bValid = false;
+  };
+
+  FHandState Hands[2];
+};
+
+/** Blueprint access to a codec pair; keep one object per stream. */
+UCLASS(BlueprintType)
+class MQTTUTILITIES_API UMqttHandPoseCodec : public UObject {
+  GENERATED_BODY()
+
+ public:
+  UFUNCTION(BlueprintCallable, Category = "MQTT")
+  static UMqttHandPoseCodec *
+  CreateHandPoseCodec(const FMqttHandPoseCodecSettings &settings);
+
+  /** Encode a pose; the hand field must be "right" or "left". */
+  UFUNCTION(BlueprintCallable, Category = "MQTT")
+  TArray<uint8> EncodeFingerPose(const FFingerPose &pose);
+
+  UFUNCTION(BlueprintCallable, Category = "MQTT")
+  bool DecodeFingerPose(const TArray<uint8> &data, FFingerPose &pose);
+
+  /** Pose <-> landmark conversion shared with the typed subscriptions. */
+  static void PoseToLandmarks(const FFingerPose &pose, FVector *landmarks);
+  static void LandmarksToPose(const FVector *landmarks, bool bRightHand,
+                              FFingerPose &pose);
+
+ private:
+  TUniquePtr<FMqttHandPoseEncoder> Encoder;
+  TUniquePtr<FMqttHandPoseDecoder> Decoder;
+};
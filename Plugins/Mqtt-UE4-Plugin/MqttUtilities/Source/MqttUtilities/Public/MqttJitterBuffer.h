@@ -0,0 +1,320 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Algo/BinarySearch.h"
+#include "Containers/Ticker.h"
+#include "Entities/MqttJitterBufferSettings.h"
+#include "HAL/PlatformTime.h"
+#include "Interface/MqttDecodingHandler.h"
+#include "MqttFlexbufferKey.h"
+
+/**
+ * Maps sender capture times onto local playout times.
+ *
+ * The clock offset is the smallest transit time (arrival - capture) seen over
+ * the last frames, so it absorbs both the clock difference and the base
+ * network latency. The remaining transit variation is the jitter; the playout
+ * delay follows MinDelay + JitterFactor * jitter and grows on underruns.
+ */
+class MQTTUTILITIES_API FMqttPlayoutClock {
+ public:
+  explicit FMqttPlayoutClock(const FMqttJitterBufferSettings &settings);
+
+  /** Feed the capture and arrival time (both in seconds) of a frame. */
+  void AddSample(double captureTime, double arrivalTime);
+
+  /** Local time at which a frame captured at captureTime should be played. */
+  double GetPlayoutTime(double captureTime) const {
+    return captureTime + Offset + Delay;
+  }
+
+  void OnUnderrun();
+
+  /**
+   * Forget the offset so the next sample anchors it again. Jitter and delay
+   * describe the network rather than the sender and are kept.
+   */
+  void Reset();
+
+  double GetDelay() const { return Delay; }
+  double GetJitter() const { return Jitter; }
+
+ private:
+  static const int32 OffsetWindow = 64;
+
+  FMqttJitterBufferSettings Settings;
+
+  double Transit[OffsetWindow];
+  int32 TransitCount;
+  int32 TransitIndex;
+
+  double Offset;
+  double Jitter;
+  double Delay;
+};
+
+/** Reads the sequence number and capture time (seconds) of a flexbuffer map
+ * payload. */
+MQTTUTILITIES_API bool
+MqttReadFrameHeader(const TArray<uint8> &payload,
+                    const FMqttJitterBufferSettings &settings, int64 &sequence,
+                    double &captureTime);
+
+/** Same, with the keys resolved once by the caller. */
+MQTTUTILITIES_API bool
+MqttReadFrameHeader(const uint8 *data, int32 size,
+                    const FMqttFlexbufferKey &sequenceKey,
+                    const FMqttFlexbufferKey &timestampKey,
+                    double timestampUnit, int64 &sequence,
+                    double &captureTime);
+
+/** Stats access shared by all jitter buffer types. */
+class MQTTUTILITIES_API IMqttJitterBuffer {
+ public:
+  virtual ~IMqttJitterBuffer() {}
+
+  /** Game thread only. */
+  virtual FMqttJitterBufferStats GetStats() const = 0;
+
+  /** Make the buffer's stats available under its topic. */
+  static void Register(const FString &topic,
+                       const TSharedRef<IMqttJitterBuffer, ESPMode::ThreadSafe>
+                           &buffer);
+
+  static bool FindStats(const FString &topic, FMqttJitterBufferStats &out);
+};
+
+/**
+ * Per-topic jitter buffer. Messages are decoded on the MQTT thread like any
+ * typed subscription; instead of being delivered at once they are reordered by
+ * sequence number and released on the core ticker at their playout time.
+ * Frames older than the last played one are dropped, unless they are so much
+ * older, or arrive after so long a silence, that the sender must have
+ * restarted; the buffer then starts over with the new stream.
+ */
+template <typename T>
+class TMqttJitterBuffer
+    : public IMqttDecodingHandler,
+      public IMqttJitterBuffer,
+      public TSharedFromThis<TMqttJitterBuffer<T>, ESPMode::ThreadSafe> {
+ public:
+  typedef typename TMqttDecodingHandler<T>::FDecoder FDecoder;
+  typedef typename TMqttDecodingHandler<T>::FHandler FHandler;
+
+  TMqttJitterBuffer(const FMqttJitterBufferSettings &settings,
+                    FDecoder decoder, FHandler handler)
+      : Settings(settings), Clock(settings),
+        SequenceKey(settings.SequenceKey), TimestampKey(settings.TimestampKey),
+        Decoder(MoveTemp(decoder)),
+        Handler(MoveTemp(handler)), Pool(FMath::Max(settings.Capacity, 1)),
+        ImplicitSequence(0), bPlayed(false), bUnderrun(false),
+        LastPlayedSequence(0), LastPlayedCapture(0.0), LastPlayoutTime(0.0),
+        FrameInterval(0.0) {}
+
+  /** Start playout. Called by MakeMqttJitterBuffer. */
+  void Start() {
+    FTicker::GetCoreTicker().AddTicker(
+        FTickerDelegate::CreateThreadSafeSP(this, &TMqttJitterBuffer::Tick));
+  }
+
+  bool Decode(const FMqttMessage &message) override {
+    FFrame frame;
+    frame.ArrivalTime = FPlatformTime::Seconds();
+
+    // Without a header the buffer still smooths arrival bursts.
+    if (!MqttReadFrameHeader(message.Message.GetData(), message.Message.Num(),
+                             SequenceKey, TimestampKey, Settings.TimestampUnit,
+                             frame.Sequence, frame.CaptureTime)) {
+      frame.Sequence = ++ImplicitSequence;
+      frame.CaptureTime = frame.ArrivalTime;
+    }
+
+    frame.Value = Pool.Acquire();
+    if (!Decoder(message.Message, *frame.Value)) {
+      Pool.Release(frame.Value);
+      return false;
+    }
+
+    frame.CaptureUs = message.Timestamp;
+    MqttSetCaptureTime(*frame.Value, frame.CaptureUs);
+    FMqttLatencyTracer::Mark(EMqttLatencyStage::Decoded, frame.CaptureUs);
+
+    FScopeLock lock(&IncomingLock);
+    Incoming.Add(MoveTemp(frame));
+    return true;
+  }
+
+  /**
+   * Insert the frames decoded since the last call and play those due at now.
+   * Runs on the core ticker; game thread only.
+   */
+  void Update(double now) {
+    TArray<FFrame> arrived;
+    {
+      FScopeLock lock(&IncomingLock);
+      Swap(arrived, Incoming);
+    }
+
+    for (FFrame &frame : arrived) {
+      Insert(frame);
+    }
+
+    bool bPlayedNow = false;
+
+    while (Frames.Num() > 0 &&
+           Clock.GetPlayoutTime(Frames[0].CaptureTime) <= now) {
+      FFrame frame = MoveTemp(Frames[0]);
+      Frames.RemoveAt(0, 1, false);
+
+      if (bPlayed) {
+        const int64 step = frame.Sequence - LastPlayedSequence;
+        Stats.Lost += (int32)FMath::Max<int64>(step - 1, 0);
+
+        const double interval = (frame.CaptureTime - LastPlayedCapture) /
+                                 FMath::Max<int64>(step, 1);
+        FrameInterval = FrameInterval > 0.0
+                            ? FrameInterval + (interval - FrameInterval) * 0.1
+                            : interval;
+      }
+
+      bPlayed = true;
+      LastPlayedSequence = frame.Sequence;
+      LastPlayedCapture = frame.CaptureTime;
+      LastPlayoutTime = Clock.GetPlayoutTime(frame.CaptureTime);
+      ++Stats.Played;
+      bPlayedNow = true;
+
+      FMqttLatencyTracer::Mark(EMqttLatencyStage::Delivered, frame.CaptureUs);
+      Handler(*frame.Value);
+      Pool.Release(frame.Value);
+    }
+
+    // Nothing to play although the next frame is overdue by half an interval.
+    if (bPlayedNow) {
+      bUnderrun = false;
+    } else if (bPlayed && !bUnderrun && FrameInterval > 0.0 &&
+               now > LastPlayoutTime + FrameInterval * 1.5) {
+      bUnderrun = true;
+      ++Stats.Underruns;
+      Clock.OnUnderrun();
+    }
+  }
+
+  FMqttJitterBufferStats GetStats() const override {
+    FMqttJitterBufferStats stats = Stats;
+    stats.Depth = Frames.Num();
+    stats.DelayMs = Clock.GetDelay() * 1000.0;
+    stats.JitterMs = Clock.GetJitter() * 1000.0;
+    return stats;
+  }
+
+ private:
+  struct FFrame {
+    int64 Sequence;
+    double CaptureTime;
+    double ArrivalTime;
+    /** FMqttMessage::Timestamp, for the latency tracer. */
+    int64 CaptureUs;
+    typename TMqttValuePool<T>::FValuePtr Value;
+  };
+
+  bool Tick(float deltaTime) {
+    Update(FPlatformTime::Seconds());
+    return true;
+  }
+
+  void Insert(FFrame &frame) {
+    ++Stats.Received;
+
+    // Reordering never moves a frame back by more than the buffer holds, and
+    // a silent sender may come back with a new sequence and capture clock.
+    if (bPlayed) {
+      const int64 maxReorder = FMath::Max(Settings.Capacity, 1);
+      const double timeout = Settings.ResetTimeoutMs * 0.001;
+      const bool bRestarted = frame.Sequence < LastPlayedSequence - maxReorder;
+      const bool bSilent =
+          timeout > 0.0 && frame.ArrivalTime > LastPlayoutTime + timeout;
+      if (bRestarted || bSilent) {
+        Reset();
+      }
+    }
+
+    if (bPlayed && frame.Sequence <= LastPlayedSequence) {
+      ++Stats.LateDrops;
+      Pool.Release(frame.Value);
+      return;
+    }
+
+    const int32 index = Algo::LowerBoundBy(
+        Frames, frame.Sequence, [](const FFrame &f) { return f.Sequence; });
+    if (Frames.IsValidIndex(index) &&
+        Frames[index].Sequence == frame.Sequence) {
+      ++Stats.Duplicates;
+      Pool.Release(frame.Value);
+      return;
+    }
+
+    Clock.AddSample(frame.CaptureTime, frame.ArrivalTime);
+    Frames.Insert(MoveTemp(frame), index);
+
+    if (Frames.Num() > FMath::Max(Settings.Capacity, 1)) {
+      ++Stats.Overflows;
+      Pool.Release(Frames[0].Value);
+      Frames.RemoveAt(0, 1, false);
+    }
+  }
+
+  void Reset() {
+    ++Stats.Resets;
+    for (FFrame &queued : Frames) {
+      Pool.Release(queued.Value);
+    }
+    Frames.Reset();
+    Clock.Reset();
+    bPlayed = false;
+    bUnderrun = false;
+    FrameInterval = 0.0;
+  }
+
+  FMqttJitterBufferSettings Settings;
+  FMqttPlayoutClock Clock;
+  FMqttFlexbufferKey SequenceKey;
+  FMqttFlexbufferKey TimestampKey;
+
+  FDecoder Decoder;
+  FHandler Handler;
+  TMqttValuePool<T> Pool;
+
+  FCriticalSection IncomingLock;
+  TArray<FFrame> Incoming;
+  int64 ImplicitSequence;
+
+  // Game thread only.
+  TArray<FFrame> Frames;
+  FMqttJitterBufferStats Stats;
+  bool bPlayed;
+  bool bUnderrun;
+  int64 LastPlayedSequence;
+  double LastPlayedCapture;
+  double LastPlayoutTime;
+  double FrameInterval;
+};
+
+/**
+ * Make a jitter buffer for a typed subscription and register its stats under
+ * topic. Pass the result to IMqttClientInterface::Subscribe.
+ */
+template <typename T>
+IMqttDecodingHandlerPtr MakeMqttJitterBuffer(
+    const FString &topic, const FMqttJitterBufferSettings &settings,
+    typename TMqttJitterBuffer<T>::FDecoder decoder,
+    typename TMqttJitterBuffer<T>::FHandler handler) {
+  TSharedRef<TMqttJitterBuffer<T>, ESPMode::ThreadSafe> buffer =
+      MakeShared<TMqttJitterBuffer<T>, ESPMode::ThreadSafe>(
+          settings, MoveTemp(decoder), MoveTemp(handler));
+  buffer->Start();
+  IMqttJitterBuffer::Register(topic, buffer);
+  return buffer;
+}
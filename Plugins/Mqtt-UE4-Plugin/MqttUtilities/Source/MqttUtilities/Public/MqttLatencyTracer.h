@@ -0,0 +1,105 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "MqttLatencyTracer.generated.h"
+
+/**
+ * Stages of the hand pipeline after capture. Every stage is measured from the
+ * capture time the sender stamped on the message (FMqttMessage::Timestamp).
+ */
+UENUM(BlueprintType)
+enum class EMqttLatencyStage : uint8 {
+  /** Message handed to the client by the transport (on_message). */
+  Received,
+  /** Typed handler finished decoding on the network thread. */
+  Decoded,
+  /** Message or decoded value reached its game thread handler. */
+  Delivered,
+  /** Pose read by the animation graph. */
+  Applied,
+  /** Render thread finished the frame showing the pose. */
+  Presented,
+};
+
+USTRUCT(BlueprintType)
+struct MQTTUTILITIES_API FMqttLatencyStageStats {
+  GENERATED_BODY()
+
+  UPROPERTY(BlueprintReadOnly, Category = "MQTT")
+  EMqttLatencyStage Stage = EMqttLatencyStage::Received;
+
+  UPROPERTY(BlueprintReadOnly, Category = "MQTT")
+  int32 Count = 0;
+
+  /** Samples stamped before their capture time, i.e. clock skew. */
+  UPROPERTY(BlueprintReadOnly, Category = "MQTT")
+  int32 Negative = 0;
+
+  /** Time since capture, in milliseconds. */
+  UPROPERTY(BlueprintReadOnly, Category = "MQTT")
+  float MeanMs = 0.0f;
+
+  UPROPERTY(BlueprintReadOnly, Category = "MQTT")
+  float P50Ms = 0.0f;
+
+  UPROPERTY(BlueprintReadOnly, Category = "MQTT")
+  float P90Ms = 0.0f;
+
+  UPROPERTY(BlueprintReadOnly, Category = "MQTT")
+  float P99Ms = 0.0f;
+
+  UPROPERTY(BlueprintReadOnly, Category = "MQTT")
+  float MaxMs = 0.0f;
+};
+
+/**
+ * Motion-to-photon latency tracer, enabled with mqtt.LatencyTrace 1.
+ *
+ * Markers are stamped into a lock-free ring of the calling thread and drained
+ * on the game thread, which emits each sample as an Unreal Insights event on
+ * the MqttLatency channel and adds it to a per-stage histogram. The report is
+ * logged by Mqtt.LatencyReport.
+ *
+ * Stages after delivery are stamped with the capture time carried by the
+ * decoded value (see MqttSetCaptureTime). They are read every frame, so
+ * MarkOnce records a capture once per stage and source; sources keep
+ * independent streams, such as the two hands, from resetting each other.
+ */
+class MQTTUTILITIES_API FMqttLatencyTracer {
+ public:
+  static void Startup();
+  static void Shutdown();
+
+  static bool IsEnabled();
+  static void SetEnabled(bool bEnabled);
+
+  static const int32 MaxSources = 8;
+
+  /** Stamp a stage of the message captured at captureUs. Any thread. */
+  static void Mark(EMqttLatencyStage stage, int64 captureUs);
+
+  /**
+   * Stamp a stage of the capture unless it was already stamped last for this
+   * stage and source. Any thread.
+   */
+  static void MarkOnce(EMqttLatencyStage stage, int64 captureUs,
+                       int32 source = 0);
+
+  /**
+   * For every source, stamp a stage for the capture last stamped by MarkOnce
+   * for the previous stage.
+   */
+  static void MarkLatest(EMqttLatencyStage stage);
+
+  /** Histogram summaries, one per stage. Game thread. */
+  static void GetStats(TArray<FMqttLatencyStageStats> &out);
+
+  static void Reset();
+
+ private:
+  static bool Tick(float deltaTime);
+  static void Drain();
+};
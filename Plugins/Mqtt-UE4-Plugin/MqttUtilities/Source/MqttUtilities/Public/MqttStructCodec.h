@@ -0,0 +1,70 @@
+// Copyright 2021 Samsung Electronics. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MqttFlexbufferKey.h"
+#include "UObject/Class.h"
+
+class FArrayProperty;
+class FProperty;
+
+/**
+ * Flexbuffer codec for any native USTRUCT, driven by reflection.
+ *
+ * The property list of a struct is walked once, on first use, into a plan of
+ * (key, offset, converter) fields; encoding and decoding then only follow the
+ * plan. A struct becomes a map keyed by property name. Supported properties
+ * are bool, integers, float, double, enums, FString, FName, nested structs
+ * and arrays of these. FVector, FVector2D, FVector4, FRotator, FQuat and
+ * FLinearColor are written as fixed float vectors; other property types are
+ * skipped.
+ *
+ * Missing keys leave the field untouched, so a decode into a reused value
+ * only overwrites what the payload carries.
+ */
+class MQTTUTILITIES_API FMqttStructCodec {
+ public:
+  /** Codec of the struct, built on first use. Any thread. */
+  static const FMqttStructCodec &Get(const UScriptStruct *structType);
+
+  ~FMqttStructCodec();
+
+  /** Encode the struct at value, replacing the contents of out. */
+  void Encode(const void *value, TArray<uint8> &out) const;
+
+  /**
+   * Decode into the struct at value. Returns false if the payload is not a
+   * flexbuffer map.
+   */
+  bool Decode(const uint8 *data, int32 size, void *value) const;
+
+  struct FField;
+
+ private:
+  FMqttStructCodec();
+
+  void EncodeMap(flexbuffers::Builder &fbb, const void *value) const;
+  void DecodeMap(const flexbuffers::Map &map, void *value) const;
+
+  friend struct FField;
+
+  TArray<TUniquePtr<FField>> Fields;
+};
+
+/** Encode a USTRUCT value with its cached codec. */
+template <typename T>
+void MqttEncodeStruct(const T &value, TArray<uint8> &out) {
+  FMqttStructCodec::Get(T::StaticStruct()).Encode(&value, out);
+}
+
+/** Decode a USTRUCT value with its cached codec. */
+template <typename T>
+bool MqttDecodeStruct(const uint8 *data, int32 size, T &out) {
+  return FMqttStructCodec::Get(T::StaticStruct()).Decode(data, size, &out);
+}
+
+template <typename T>
+bool MqttDecodeStruct(const TArray<uint8> &data, T &out) {
+  return MqttDecodeStruct(data.GetData(), data.Num(), out);
+}
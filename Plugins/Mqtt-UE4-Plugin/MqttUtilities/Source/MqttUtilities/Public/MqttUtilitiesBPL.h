@@ -3,7 +3,9 @@
 #pragma once
 
 #include "Entities/MqttClientConfig.h"
+#include "Entities/MqttMessage.h"
 #include "Interface/MqttClientInterface.h"
+#include "MqttLatencyTracer.h"
 
 #include "Kismet/BlueprintFunctionLibrary.h"
 
@@ -21,4 +23,38 @@ class MQTTUTILITIES_API UMqttUtilitiesBPL : public UBlueprintFunctionLibrary {
   UFUNCTION(BlueprintCallable, Category = "MQTT")
   static TScriptInterface<IMqttClientInterface>
   CreateMqttClient(FMqttClientConfig config);
+
+  /**
+   * Whether the native MQTT libraries finished loading in the background.
+   * Clients may be created and connected before; their connections start once
+   * loading is done.
+   */
+  UFUNCTION(BlueprintPure, Category = "MQTT")
+  static bool IsMqttReady();
+
+  /**
+   * Time since a received message was captured, from the timestamp an MQTT 5
+   * sender attached. Requires synchronized clocks on both hosts.
+   *
+   * @return - latency in milliseconds, or -1 if the message has no timestamp
+   */
+  UFUNCTION(BlueprintPure, Category = "MQTT")
+  static float GetMessageLatencyMs(const FMqttMessage &message);
+
+  /**
+   * Stamp latency markers for timestamped messages as they pass each stage
+   * of the hand pipeline. Same as the mqtt.LatencyTrace console variable.
+   */
+  UFUNCTION(BlueprintCallable, Category = "MQTT")
+  static void SetLatencyTracingEnabled(bool bEnabled);
+
+  /** Latency since capture per pipeline stage, over all traced messages. */
+  UFUNCTION(BlueprintCallable, Category = "MQTT")
+  static TArray<FMqttLatencyStageStats> GetLatencyStats();
+
+  UFUNCTION(BlueprintCallable, Category = "MQTT")
+  static void ResetLatencyStats();
+
+  /** Current UTC time in the unit of FMqttMessage::Timestamp. */
+  static int64 GetUnixTimeMicroseconds();
 };
\ No newline at end of file
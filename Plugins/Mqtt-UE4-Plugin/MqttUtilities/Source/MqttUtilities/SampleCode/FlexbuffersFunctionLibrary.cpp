@@ -2,8 +2,64 @@
 
 #include "FlexbuffersFunctionLibrary.h"
 
+#include "HandCoreText.h"
+#include "MqttFlexbufferBuilder.h"
+#include "MqttFlexbufferKey.h"
+#include "MqttHandPoseCodec.h"
+#include "MqttJitterBuffer.h"
+#include "MqttTrace.h"
+
 #include <flatbuffers/flexbuffers.h>
 
+namespace {
+
+const int32 LandmarkCount = HandCore::NumLandmarks;
+
+const FMqttFlexbufferKey HandKey("hand");
+const FMqttFlexbufferKey LandmarkKey("landmark");
+const FMqttFlexbufferKey GestureKey("gesture");
+const FMqttFlexbufferKey Param1Key("param1");
+const FMqttFlexbufferKey Param2Key("param2");
+const FMqttFlexbufferKey Param3Key("param3");
+const FMqttFlexbufferKey TypeKey("type");
+const FMqttFlexbufferKey ScreenSizeKey("screensize");
+
+FString ToFString(const flexbuffers::Reference &value) {
+  flexbuffers::String str = value.AsString();
+  FUTF8ToTCHAR converted(str.c_str(), str.length());
+  return FString(converted.Length(), converted.Get());
+}
+
+// flexbuffers 1.12 has no verifier, so at least make sure the root is a map
+// before any key lookup.
+bool GetRootMap(const uint8 *data, int32 size, flexbuffers::Map &out) {
+  if (data == nullptr || size < 3) {
+    return false;
+  }
+
+  flexbuffers::Reference root = flexbuffers::GetRoot(data, size);
+  if (!root.IsMap()) {
+    return false;
+  }
+
+  out = root.AsMap();
+  return true;
+}
+
+void WriteString(flexbuffers::Builder &fbb, const char *key,
+                 const FTCHARToUTF8 &value) {
+  fbb.Key(key);
+  fbb.String(value.Get(), value.Length());
+}
+
+// Appends "x,y,z," to a comma separated list, the format ParseFloatList reads.
+int32 WriteFloatList(const FVector &value, char *out, int32 size) {
+  const float values[] = {value.X, value.Y, value.Z};
+  return HandCore::FormatFloatList(values, 3, out, size);
+}
+
+}  // namespace
+
 SampleHandler::SampleHandler() { count = 0; }
 
 SampleHandler &SampleHandler::Instance() {
@@ -29,115 +85,424 @@ int UFlexbuffersFunctionLibrary::GetCount() {
   return SampleHandler::Instance().GetCount();
 }
 
-TArray<uint8> UFlexbuffersFunctionLibrary::FlexbufferDataFromFString(FString data) {
+TArray<uint8>
+UFlexbuffersFunctionLibrary::FlexbufferDataFromFString(const FString &data) {
   TArray<uint8> ret;
+  FTCHARToUTF8 pose(*data);
+
+  MqttEncodeFlexbuffer(ret, [&pose](flexbuffers::Builder &fbb) {
+    fbb.Map([&]() { WriteString(fbb, "pose", pose); });
+  });
+
+  return ret;
+}
+
+FString UFlexbuffersFunctionLibrary::FStringFromFlexbufferData(
+    const TArray<uint8> &data) {
+  static const FMqttFlexbufferKey PoseKey("pose");
+
+  flexbuffers::Map map = flexbuffers::Map::EmptyMap();
+  if (!GetRootMap(data.GetData(), data.Num(), map)) {
+    return FString();
+  }
 
-  flexbuffers::Builder fbb;
-  fbb.Clear();
-  fbb.Map([&]() { fbb.String("pose", std::string(TCHAR_TO_ANSI(*data))); });
-  fbb.Finish();
+  flexbuffers::Reference pose = PoseKey.Find(map);
+  return pose.IsString() ? ToFString(pose) : FString();
+}
 
-  std::vector<uint8_t> flex_buf;
-  flex_buf = fbb.GetBuffer();
+FInputInfo UFlexbuffersFunctionLibrary::InputInfoFromFexbufferData(
+    const TArray<uint8> &data) {
+  FInputInfo ret;
+  DecodeInputInfo(data, ret);
+  return ret;
+}
 
-  ret.Append(&flex_buf[0], flex_buf.size());
+FFingerPose UFlexbuffersFunctionLibrary::FingersFromFexbufferData(
+    const TArray<uint8> &data) {
+  FFingerPose ret;
+  DecodeFingerPose(data, ret);
+  return ret;
+}
 
+FFingerGesture UFlexbuffersFunctionLibrary::GestureFromFexbufferData(
+    const TArray<uint8> &data) {
+  FFingerGesture ret;
+  DecodeGesture(data, ret);
   return ret;
 }
 
-FString UFlexbuffersFunctionLibrary::FStringFromFlexbufferData(TArray<uint8> data) {
-  FString ret;
+FMqttGesture UFlexbuffersFunctionLibrary::TypedGestureFromFlexbufferData(
+    const TArray<uint8> &data) {
+  FMqttGesture ret;
+  DecodeGesture(data, ret);
+  return ret;
+}
 
-  std::vector<uint8_t> buf(data.Num());
-  memcpy(&buf[0], data.GetData(), data.Num());
+TArray<uint8> UFlexbuffersFunctionLibrary::FlexbufferDataFromFingerPose(
+    const FFingerPose &pose) {
+  TArray<uint8> ret;
+  EncodeFingerPose(pose, ret);
+  return ret;
+}
 
-  auto map = flexbuffers::GetRoot(buf).AsMap();
-  ret = FString(UTF8_TO_TCHAR(map["pose"].AsString().c_str()));
+TArray<uint8> UFlexbuffersFunctionLibrary::FlexbufferDataFromGesture(
+    const FFingerGesture &gesture) {
+  TArray<uint8> ret;
+  EncodeGesture(gesture, ret);
+  return ret;
+}
 
+TArray<uint8> UFlexbuffersFunctionLibrary::FlexbufferDataFromInputInfo(
+    const FInputInfo &info) {
+  TArray<uint8> ret;
+  EncodeInputInfo(info, ret);
   return ret;
 }
 
-FInputInfo UFlexbuffersFunctionLibrary::InputInfoFromFexbufferData(TArray<uint8> data) {
-	std::vector<uint8_t> buf(data.Num());
-	memcpy(&buf[0], data.GetData(), data.Num());
-	auto map = flexbuffers::GetRoot(buf).AsMap();
-
-	FInputInfo ret;
-	ret.type = FString(UTF8_TO_TCHAR(map["type"].AsString().c_str()));
-	FString screensize = FString(UTF8_TO_TCHAR(map["screensize"].AsString().c_str()));
-
-	TArray<FString> array = {};
-	screensize.ParseIntoArray(array, TEXT(","));
-	if (array.Num() >= 2) {
-		ret.screensize.X = FCString::Atof(*array[0].TrimQuotes());
-		ret.screensize.Y = FCString::Atof(*array[1].TrimQuotes());
-	}
-	else {
-		ret.screensize = FVector2D(0, 0);
-	}
-
-	return ret;
-}
-
-FVector StringToFingerVector(FString arr,int index) {
-    TArray<FString> array = {};
-    arr.ParseIntoArray(array, TEXT(","));
-	if (array.Num() >= 3) {
-		float x = FCString::Atof(*array[index * 3 + 0].TrimQuotes());
-		float y = FCString::Atof(*array[index * 3 + 1].TrimQuotes());
-		float z = FCString::Atof(*array[index * 3 + 2].TrimQuotes());
-		return FVector(x, y, z);
-	}
-	return FVector(0,0,0);
-}
-
-FFingerPose UFlexbuffersFunctionLibrary::FingersFromFexbufferData(TArray<uint8> data) {
-    
-    std::vector<uint8_t> buf(data.Num());
-    memcpy(&buf[0], data.GetData(), data.Num());
-    auto map = flexbuffers::GetRoot(buf).AsMap();
-
-	FFingerPose ret;
-    ret.hand = FString(UTF8_TO_TCHAR(map["hand"].AsString().c_str()));
-
-    FString position = FString(UTF8_TO_TCHAR(map["landmark"].AsString().c_str()));
-    ret.Palm = StringToFingerVector(position, 0);
-	ret.Thumb.Add(StringToFingerVector(position, 1));
-	ret.Thumb.Add(StringToFingerVector(position, 2));
-	ret.Thumb.Add(StringToFingerVector(position, 3));
-	ret.Thumb.Add(StringToFingerVector(position, 4));
-    ret.Index.Add(StringToFingerVector(position, 5));
-	ret.Index.Add(StringToFingerVector(position, 6));
-	ret.Index.Add(StringToFingerVector(position, 7));
-	ret.Index.Add(StringToFingerVector(position, 8));
-	ret.Middle.Add(StringToFingerVector(position, 9));
-	ret.Middle.Add(StringToFingerVector(position, 10));
-	ret.Middle.Add(StringToFingerVector(position, 11));
-	ret.Middle.Add(StringToFingerVector(position, 12));
-	ret.Ring.Add(StringToFingerVector(position, 13));
-	ret.Ring.Add(StringToFingerVector(position, 14));
-	ret.Ring.Add(StringToFingerVector(position, 15));
-	ret.Ring.Add(StringToFingerVector(position, 16));
-	ret.Pinky.Add(StringToFingerVector(position, 17));
-	ret.Pinky.Add(StringToFingerVector(position, 18));
-	ret.Pinky.Add(StringToFingerVector(position, 19));
-	ret.Pinky.Add(StringToFingerVector(position, 20));
-
-    return ret;
-}
-
-FFingerGesture UFlexbuffersFunctionLibrary::GestureFromFexbufferData(TArray<uint8> data) {
-	
-	std::vector<uint8_t> buf(data.Num());
-	memcpy(&buf[0], data.GetData(), data.Num());
-	auto map = flexbuffers::GetRoot(buf).AsMap();
-
-	FFingerGesture ret;
-	ret.gesture = FString(UTF8_TO_TCHAR(map["gesture"].AsString().c_str()));
-	ret.param.Add(FString(UTF8_TO_TCHAR(map["param1"].AsString().c_str())));
-	ret.param.Add(FString(UTF8_TO_TCHAR(map["param2"].AsString().c_str())));
-	ret.param.Add(FString(UTF8_TO_TCHAR(map["param3"].AsString().c_str())));
-
-	return ret;
+void UFlexbuffersFunctionLibrary::PublishFingerPose(
+    const TScriptInterface<IMqttClientInterface> &client, FString topic,
+    int qos, const FFingerPose &pose, EMqttPublishLane lane) {
+  if (client.GetInterface() == nullptr) {
+    return;
+  }
+
+  FMqttMessage message;
+  message.Topic = MoveTemp(topic);
+  message.Qos = qos;
+  message.Retain = false;
+  message.Lane = lane;
+  EncodeFingerPose(pose, message.Message);
+
+  client->Publish(MoveTemp(message));
+}
+
+void UFlexbuffersFunctionLibrary::SubscribeHandPose(
+    const TScriptInterface<IMqttClientInterface> &client, FString topic,
+    int qos, const FOnHandPoseDelegate &handler) {
+  if (client.GetInterface() == nullptr) {
+    return;
+  }
+
+  client->Subscribe(
+      topic, qos,
+      MakeMqttDecodingHandler<FFingerPose>(
+          [](const TArray<uint8> &data, FFingerPose &out) {
+            return DecodeFingerPose(data, out);
+          },
+          [handler](const FFingerPose &pose) { handler.ExecuteIfBound(pose); }));
+}
+
+void UFlexbuffersFunctionLibrary::SubscribeHandPoseQuantized(
+    const TScriptInterface<IMqttClientInterface> &client, FString topic,
+    int qos, const FOnHandPoseDelegate &handler) {
+  if (client.GetInterface() == nullptr) {
+    return;
+  }
+
+  // Decoders run one message at a time on the MQTT thread, so the stream
+  // state needs no lock.
+  TSharedRef<FMqttHandPoseDecoder, ESPMode::ThreadSafe> decoder =
+      MakeShared<FMqttHandPoseDecoder, ESPMode::ThreadSafe>();
+
+  client->Subscribe(
+      topic, qos,
+      MakeMqttDecodingHandler<FFingerPose>(
+          [decoder](const TArray<uint8> &data, FFingerPose &out) {
+            FVector landmarks[FMqttHandPoseDecoder::NumLandmarks];
+            bool bRightHand = false;
+            if (!decoder->Decode(data.GetData(), data.Num(), landmarks,
+                                 bRightHand)) {
+              return false;
+            }
+            UMqttHandPoseCodec::LandmarksToPose(landmarks, bRightHand, out);
+            return true;
+          },
+          [handler](const FFingerPose &pose) { handler.ExecuteIfBound(pose); }));
+}
+
+void UFlexbuffersFunctionLibrary::SubscribeGesture(
+    const TScriptInterface<IMqttClientInterface> &client, FString topic,
+    int qos, const FOnGestureDelegate &handler) {
+  if (client.GetInterface() == nullptr) {
+    return;
+  }
+
+  client->Subscribe(topic, qos,
+                    MakeMqttDecodingHandler<FFingerGesture>(
+                        [](const TArray<uint8> &data, FFingerGesture &out) {
+                          return DecodeGesture(data, out);
+                        },
+                        [handler](const FFingerGesture &gesture) {
+                          handler.ExecuteIfBound(gesture);
+                        }));
+}
+
+void UFlexbuffersFunctionLibrary::RegisterGesture(
+    FName name, int32 id, const TArray<FMqttGestureParamSchema> &params) {
+  FMqttGestureRegistry::Get().Register(name, id, params);
 }
 
+void UFlexbuffersFunctionLibrary::RegisterGestureEnum(
+    UEnum *gestures, const TArray<FMqttGestureParamSchema> &params) {
+  FMqttGestureRegistry::Get().RegisterEnum(gestures, params);
+}
+
+void UFlexbuffersFunctionLibrary::SubscribeTypedGesture(
+    const TScriptInterface<IMqttClientInterface> &client, FString topic,
+    int qos, const FOnTypedGestureDelegate &handler) {
+  if (client.GetInterface() == nullptr) {
+    return;
+  }
+
+  client->Subscribe(topic, qos,
+                    MakeMqttDecodingHandler<FMqttGesture>(
+                        [](const TArray<uint8> &data, FMqttGesture &out) {
+                          return DecodeGesture(data, out);
+                        },
+                        [handler](const FMqttGesture &gesture) {
+                          handler.ExecuteIfBound(gesture);
+                        }));
+}
+
+void UFlexbuffersFunctionLibrary::SubscribeInputInfo(
+    const TScriptInterface<IMqttClientInterface> &client, FString topic,
+    int qos, const FOnInputInfoDelegate &handler) {
+  if (client.GetInterface() == nullptr) {
+    return;
+  }
+
+  client->Subscribe(topic, qos,
+                    MakeMqttDecodingHandler<FInputInfo>(
+                        [](const TArray<uint8> &data, FInputInfo &out) {
+                          return DecodeInputInfo(data, out);
+                        },
+                        [handler](const FInputInfo &info) {
+                          handler.ExecuteIfBound(info);
+                        }));
+}
+
+void UFlexbuffersFunctionLibrary::SubscribeHandPoseBuffered(
+    const TScriptInterface<IMqttClientInterface> &client, FString topic,
+    int qos, const FMqttJitterBufferSettings &settings,
+    const FOnHandPoseDelegate &handler) {
+  if (client.GetInterface() == nullptr) {
+    return;
+  }
+
+  client->Subscribe(topic, qos,
+                    MakeMqttJitterBuffer<FFingerPose>(
+                        topic, settings,
+                        [](const TArray<uint8> &data, FFingerPose &out) {
+                          return DecodeFingerPose(data, out);
+                        },
+                        [handler](const FFingerPose &pose) {
+                          handler.ExecuteIfBound(pose);
+                        }));
+}
+
+void UFlexbuffersFunctionLibrary::SubscribeBuffered(
+    const TScriptInterface<IMqttClientInterface> &client, FString topic,
+    int qos, const FMqttJitterBufferSettings &settings,
+    const FOnMessageHandlerDelegate &handler) {
+  if (client.GetInterface() == nullptr) {
+    return;
+  }
+
+  client->Subscribe(
+      topic, qos,
+      MakeMqttJitterBuffer<FMqttMessage>(
+          topic, settings,
+          [topic, qos](const TArray<uint8> &data, FMqttMessage &out) {
+            out.Topic = topic;
+            out.Qos = qos;
+            out.Retain = false;
+            out.Message = data;
+            return true;
+          },
+          [handler](const FMqttMessage &message) {
+            handler.ExecuteIfBound(message);
+          }));
+}
+
+bool UFlexbuffersFunctionLibrary::GetJitterBufferStats(
+    FString topic, FMqttJitterBufferStats &stats) {
+  return IMqttJitterBuffer::FindStats(topic, stats);
+}
+
+bool UFlexbuffersFunctionLibrary::DecodeFingerPose(const uint8 *data,
+                                                   int32 size,
+                                                   FFingerPose &out) {
+  MQTT_TRACE_SCOPE(Mqtt_DecodeFingerPose);
+
+  flexbuffers::Map map = flexbuffers::Map::EmptyMap();
+  if (!GetRootMap(data, size, map)) {
+    return false;
+  }
+
+  flexbuffers::Reference hand = HandKey.Find(map);
+  flexbuffers::Reference landmark = LandmarkKey.Find(map);
+  if (!hand.IsString() || !landmark.IsString()) {
+    return false;
+  }
+
+  float values[LandmarkCount * 3];
+  flexbuffers::String position = landmark.AsString();
+  if (HandCore::ParseFloatList(position.c_str(), position.length(), values,
+                               LandmarkCount * 3) < LandmarkCount * 3) {
+    return false;
+  }
+
+  out.hand = ToFString(hand);
+  out.Palm = FVector(values[0], values[1], values[2]);
+
+  // Landmarks 1..20 are four per finger, thumb to pinky.
+  TArray<FVector> *fingers[] = {&out.Thumb, &out.Index, &out.Middle, &out.Ring,
+                                &out.Pinky};
+  for (int32 finger = 0; finger < 5; ++finger) {
+    fingers[finger]->Reset(4);
+    for (int32 joint = 0; joint < 4; ++joint) {
+      const float *v = &values[(1 + finger * 4 + joint) * 3];
+      fingers[finger]->Add(FVector(v[0], v[1], v[2]));
+    }
+  }
+
+  return true;
+}
+
+bool UFlexbuffersFunctionLibrary::DecodeGesture(const uint8 *data, int32 size,
+                                                FFingerGesture &out) {
+  MQTT_TRACE_SCOPE(Mqtt_DecodeGesture);
+
+  flexbuffers::Map map = flexbuffers::Map::EmptyMap();
+  if (!GetRootMap(data, size, map)) {
+    return false;
+  }
+
+  flexbuffers::Reference gesture = GestureKey.Find(map);
+  if (!gesture.IsString()) {
+    return false;
+  }
+
+  out.gesture = ToFString(gesture);
+  out.param.Reset(3);
+  out.param.Add(ToFString(Param1Key.Find(map)));
+  out.param.Add(ToFString(Param2Key.Find(map)));
+  out.param.Add(ToFString(Param3Key.Find(map)));
+
+  return true;
+}
+
+bool UFlexbuffersFunctionLibrary::DecodeGesture(const uint8 *data, int32 size,
+                                                FMqttGesture &out) {
+  MQTT_TRACE_SCOPE(Mqtt_DecodeTypedGesture);
+
+  flexbuffers::Map map = flexbuffers::Map::EmptyMap();
+  if (!GetRootMap(data, size, map)) {
+    return false;
+  }
+
+  flexbuffers::Reference gesture = GestureKey.Find(map);
+  if (!gesture.IsString()) {
+    return false;
+  }
+
+  const flexbuffers::Reference params[] = {
+      Param1Key.Find(map), Param2Key.Find(map), Param3Key.Find(map)};
+  FMqttGestureRegistry::Get().Resolve(gesture, params, 3, out);
+
+  return true;
+}
+
+bool UFlexbuffersFunctionLibrary::DecodeInputInfo(const uint8 *data,
+                                                  int32 size, FInputInfo &out) {
+  MQTT_TRACE_SCOPE(Mqtt_DecodeInputInfo);
+
+  flexbuffers::Map map = flexbuffers::Map::EmptyMap();
+  if (!GetRootMap(data, size, map)) {
+    return false;
+  }
+
+  flexbuffers::Reference type = TypeKey.Find(map);
+  if (!type.IsString()) {
+    return false;
+  }
+
+  out.type = ToFString(type);
+
+  float screen[2];
+  flexbuffers::String screensize = ScreenSizeKey.Find(map).AsString();
+  if (HandCore::ParseFloatList(screensize.c_str(), screensize.length(),
+                               screen, 2) == 2) {
+    out.screensize = FVector2D(screen[0], screen[1]);
+  } else {
+    out.screensize = FVector2D(0, 0);
+  }
+
+  return true;
+}
+
+void UFlexbuffersFunctionLibrary::EncodeFingerPose(const FFingerPose &pose,
+                                                   TArray<uint8> &out) {
+  MQTT_TRACE_SCOPE(Mqtt_EncodeFingerPose);
+
+  // 21 landmarks of up to three 14 character numbers each.
+  char landmark[LandmarkCount * 3 * 16];
+  const int32 capacity = (int32)sizeof(landmark);
+  int32 length = WriteFloatList(pose.Palm, landmark, capacity);
+
+  const TArray<FVector> *fingers[] = {&pose.Thumb, &pose.Index, &pose.Middle,
+                                      &pose.Ring, &pose.Pinky};
+  for (const TArray<FVector> *finger : fingers) {
+    for (int32 joint = 0; joint < 4; ++joint) {
+      const FVector &value =
+          finger->IsValidIndex(joint) ? (*finger)[joint] : pose.Palm;
+      length += WriteFloatList(value, landmark + length, capacity - length);
+    }
+  }
+
+  FTCHARToUTF8 hand(*pose.hand);
+  MqttEncodeFlexbuffer(out, [&](flexbuffers::Builder &fbb) {
+    fbb.Map([&]() {
+      WriteString(fbb, "hand", hand);
+      fbb.Key("landmark");
+      fbb.String(landmark, FMath::Max(length - 1, 0));
+    });
+  });
+}
+
+void UFlexbuffersFunctionLibrary::EncodeGesture(const FFingerGesture &gesture,
+                                                TArray<uint8> &out) {
+  MQTT_TRACE_SCOPE(Mqtt_EncodeGesture);
+
+  static const char *ParamNames[] = {"param1", "param2", "param3"};
+
+  MqttEncodeFlexbuffer(out, [&gesture](flexbuffers::Builder &fbb) {
+    fbb.Map([&]() {
+      WriteString(fbb, "gesture", FTCHARToUTF8(*gesture.gesture));
+      for (int32 i = 0; i < 3; ++i) {
+        const TCHAR *param =
+            gesture.param.IsValidIndex(i) ? *gesture.param[i] : TEXT("");
+        WriteString(fbb, ParamNames[i], FTCHARToUTF8(param));
+      }
+    });
+  });
+}
+
+void UFlexbuffersFunctionLibrary::EncodeInputInfo(const FInputInfo &info,
+                                                  TArray<uint8> &out) {
+  MQTT_TRACE_SCOPE(Mqtt_EncodeInputInfo);
+
+  char screensize[64];
+  const int32 length = FMath::Clamp(
+      FCStringAnsi::Snprintf(screensize, sizeof(screensize), "%.6g,%.6g",
+                             info.screensize.X, info.screensize.Y),
+      0, (int32)sizeof(screensize) - 1);
+
+  MqttEncodeFlexbuffer(out, [&](flexbuffers::Builder &fbb) {
+    fbb.Map([&]() {
+      WriteString(fbb, "type", FTCHARToUTF8(*info.type));
+      fbb.Key("screensize");
+      fbb.String(screensize, length);
+    });
+  });
+}
@@ -5,7 +5,9 @@
 #include "CoreMinimal.h"
 #include "Kismet/BlueprintFunctionLibrary.h"
 
+#include "Entities/MqttJitterBufferSettings.h"
 #include "Interface/MqttClientInterface.h"
+#include "MqttGestureRegistry.h"
 
 #include "FlexbuffersFunctionLibrary.generated.h"
 
@@ -21,7 +23,7 @@ public:
 };
 
 USTRUCT(BlueprintType)
-struct FInputInfo {
+struct MQTTUTILITIES_API FInputInfo {
 	GENERATED_BODY()
 public:
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "MQTT")
@@ -31,7 +33,7 @@ public:
 };
 
 USTRUCT(BlueprintType)
-struct FFingerPose {
+struct MQTTUTILITIES_API FFingerPose {
   GENERATED_BODY()
 public:
   UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "MQTT")
@@ -48,10 +50,21 @@ public:
   TArray<FVector> Ring;
   UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "MQTT")
   TArray<FVector> Pinky;
+  /**
+   * Capture time of the message the pose was decoded from (see
+   * FMqttMessage::Timestamp), 0 if unknown. Set on receive; the hand pose
+   * encoders do not write it.
+   */
+  UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "MQTT")
+  int64 CaptureUs = 0;
 };
 
+inline void MqttSetCaptureTime(FFingerPose &pose, int64 captureUs) {
+  pose.CaptureUs = captureUs;
+}
+
 USTRUCT(BlueprintType)
-struct FFingerGesture {
+struct MQTTUTILITIES_API FFingerGesture {
 	GENERATED_BODY()
 public:
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "MQTT")
@@ -60,6 +73,15 @@ public:
 		TArray<FString> param;
 };
 
+DECLARE_DYNAMIC_DELEGATE_OneParam(FOnHandPoseDelegate, const FFingerPose &,
+                                  pose);
+DECLARE_DYNAMIC_DELEGATE_OneParam(FOnGestureDelegate, const FFingerGesture &,
+                                  gesture);
+DECLARE_DYNAMIC_DELEGATE_OneParam(FOnTypedGestureDelegate,
+                                  const FMqttGesture &, gesture);
+DECLARE_DYNAMIC_DELEGATE_OneParam(FOnInputInfoDelegate, const FInputInfo &,
+                                  info);
+
 /**
  *
  */
@@ -77,18 +99,158 @@ class MQTTUTILITIES_API UFlexbuffersFunctionLibrary
   static int GetCount();
 
   UFUNCTION(BlueprintCallable, Category = "MQTT")
-  static TArray<uint8> FlexbufferDataFromFString(FString data);
+  static TArray<uint8> FlexbufferDataFromFString(const FString &data);
+
+  UFUNCTION(BlueprintCallable, Category = "MQTT")
+  static FString FStringFromFlexbufferData(const TArray<uint8> &data);
+
+  UFUNCTION(BlueprintCallable, Category = "MQTT")
+  static FFingerPose FingersFromFexbufferData(const TArray<uint8> &data);
+
+  UFUNCTION(BlueprintCallable, Category = "MQTT")
+  static FFingerGesture
+  GestureFromFexbufferData(const TArray<uint8> &data);
+
+  /** Gesture resolved against the registered gesture names. */
+  UFUNCTION(BlueprintCallable, Category = "MQTT")
+  static FMqttGesture
+  TypedGestureFromFlexbufferData(const TArray<uint8> &data);
 
   UFUNCTION(BlueprintCallable, Category = "MQTT")
-  static FString FStringFromFlexbufferData(TArray<uint8> data);
+  static FInputInfo InputInfoFromFexbufferData(const TArray<uint8> &data);
 
   UFUNCTION(BlueprintCallable, Category = "MQTT")
-  static FFingerPose FingersFromFexbufferData(TArray<uint8> data);
+  static TArray<uint8> FlexbufferDataFromFingerPose(const FFingerPose &pose);
 
   UFUNCTION(BlueprintCallable, Category = "MQTT")
-  static FFingerGesture GestureFromFexbufferData(TArray<uint8> data);
+  static TArray<uint8>
+  FlexbufferDataFromGesture(const FFingerGesture &gesture);
 
   UFUNCTION(BlueprintCallable, Category = "MQTT")
-  static FInputInfo InputInfoFromFexbufferData(TArray<uint8> data);
+  static TArray<uint8> FlexbufferDataFromInputInfo(const FInputInfo &info);
+
+  /**
+   * Encode a pose and publish it. The payload is built with a pooled builder
+   * and moved into the outgoing message without further copies.
+   */
+  UFUNCTION(BlueprintCallable, Category = "MQTT")
+  static void
+  PublishFingerPose(const TScriptInterface<IMqttClientInterface> &client,
+                    FString topic, int qos, const FFingerPose &pose,
+                    EMqttPublishLane lane = EMqttPublishLane::Telemetry);
+
+  /**
+   * Subscribe to hand pose messages. Payloads are decoded on the MQTT thread
+   * and the handler receives the ready pose on the game thread.
+   */
+  UFUNCTION(BlueprintCallable, Category = "MQTT")
+  static void
+  SubscribeHandPose(const TScriptInterface<IMqttClientInterface> &client,
+                    FString topic, int qos, const FOnHandPoseDelegate &handler);
+
+  /**
+   * Subscribe to hand poses sent in the quantized format of
+   * UMqttHandPoseCodec, decoded on the MQTT thread.
+   */
+  UFUNCTION(BlueprintCallable, Category = "MQTT")
+  static void SubscribeHandPoseQuantized(
+      const TScriptInterface<IMqttClientInterface> &client, FString topic,
+      int qos, const FOnHandPoseDelegate &handler);
+
+  /** Subscribe to gesture messages, decoded on the MQTT thread. */
+  UFUNCTION(BlueprintCallable, Category = "MQTT")
+  static void
+  SubscribeGesture(const TScriptInterface<IMqttClientInterface> &client,
+                   FString topic, int qos, const FOnGestureDelegate &handler);
+
+  /**
+   * Register a gesture name for typed gesture decoding. Parameters are
+   * parsed by the given schema; extra parameters stay strings.
+   */
+  UFUNCTION(BlueprintCallable, Category = "MQTT")
+  static void RegisterGesture(FName name, int32 id,
+                              const TArray<FMqttGestureParamSchema> &params);
+
+  /** Register all names of an enum as gestures, with their values as ids. */
+  UFUNCTION(BlueprintCallable, Category = "MQTT")
+  static void
+  RegisterGestureEnum(UEnum *gestures,
+                      const TArray<FMqttGestureParamSchema> &params);
+
+  /**
+   * Subscribe to gesture messages resolved to registered ids on the MQTT
+   * thread, so handlers can switch on the id instead of comparing strings.
+   */
+  UFUNCTION(BlueprintCallable, Category = "MQTT")
+  static void
+  SubscribeTypedGesture(const TScriptInterface<IMqttClientInterface> &client,
+                        FString topic, int qos,
+                        const FOnTypedGestureDelegate &handler);
+
+  /** Subscribe to input info messages, decoded on the MQTT thread. */
+  UFUNCTION(BlueprintCallable, Category = "MQTT")
+  static void
+  SubscribeInputInfo(const TScriptInterface<IMqttClientInterface> &client,
+                     FString topic, int qos,
+                     const FOnInputInfoDelegate &handler);
+
+  /**
+   * Subscribe to hand pose messages through a jitter buffer. Frames are
+   * reordered by their sequence number and played out at an adaptive delay
+   * after their capture time (see FMqttJitterBufferSettings for the payload
+   * keys).
+   */
+  UFUNCTION(BlueprintCallable, Category = "MQTT")
+  static void SubscribeHandPoseBuffered(
+      const TScriptInterface<IMqttClientInterface> &client, FString topic,
+      int qos, const FMqttJitterBufferSettings &settings,
+      const FOnHandPoseDelegate &handler);
+
+  /** Subscribe to raw messages through a jitter buffer. */
+  UFUNCTION(BlueprintCallable, Category = "MQTT")
+  static void
+  SubscribeBuffered(const TScriptInterface<IMqttClientInterface> &client,
+                    FString topic, int qos,
+                    const FMqttJitterBufferSettings &settings,
+                    const FOnMessageHandlerDelegate &handler);
+
+  /** Depth, delay and drop counters of the jitter buffer on topic. */
+  UFUNCTION(BlueprintCallable, Category = "MQTT")
+  static bool GetJitterBufferStats(FString topic,
+                                   FMqttJitterBufferStats &stats);
+
+public:
+  /**
+   * Decoders used by the typed subscriptions. They read the payload in place,
+   * are safe to call from any thread and return false instead of reading past
+   * malformed payloads. Arrays in the output are reused.
+   */
+  static bool DecodeFingerPose(const uint8 *data, int32 size,
+                               FFingerPose &out);
+  static bool DecodeGesture(const uint8 *data, int32 size,
+                            FFingerGesture &out);
+  static bool DecodeGesture(const uint8 *data, int32 size, FMqttGesture &out);
+  static bool DecodeInputInfo(const uint8 *data, int32 size, FInputInfo &out);
+
+  static bool DecodeFingerPose(const TArray<uint8> &data, FFingerPose &out) {
+    return DecodeFingerPose(data.GetData(), data.Num(), out);
+  }
+  static bool DecodeGesture(const TArray<uint8> &data, FFingerGesture &out) {
+    return DecodeGesture(data.GetData(), data.Num(), out);
+  }
+  static bool DecodeGesture(const TArray<uint8> &data, FMqttGesture &out) {
+    return DecodeGesture(data.GetData(), data.Num(), out);
+  }
+  static bool DecodeInputInfo(const TArray<uint8> &data, FInputInfo &out) {
+    return DecodeInputInfo(data.GetData(), data.Num(), out);
+  }
 
+  /**
+   * Encoders producing the payloads the decoders read, replacing the contents
+   * of out. Builders come from FMqttFlexbufferBuilderPool.
+   */
+  static void EncodeFingerPose(const FFingerPose &pose, TArray<uint8> &out);
+  static void EncodeGesture(const FFingerGesture &gesture,
+                            TArray<uint8> &out);
+  static void EncodeInputInfo(const FInputInfo &info, TArray<uint8> &out);
 };
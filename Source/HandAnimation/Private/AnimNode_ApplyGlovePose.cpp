@@ -0,0 +1,162 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "AnimNode_ApplyGlovePose.h"
+
+#include "Animation/AnimInstanceProxy.h"
+#include "HandPoseBuffer.h"
+#include "MollisenHAND.h"
+#include "MqttLatencyTracer.h"
+
+namespace
+{
+	constexpr int32 GloveJointCount = 15;
+	constexpr int32 GloveThumbJointCount = 3;
+
+	FTS::DeviceType ToGloveDevice(EDeviceType Type)
+	{
+		switch (Type)
+		{
+		case EDeviceType::HandL: return FTS::DeviceType::HandL;
+		case EDeviceType::HandR: return FTS::DeviceType::HandR;
+		default:
+			return FTS::DeviceType::None;
+		}
+	}
+}
+
+FAnimNode_ApplyGlovePose::FAnimNode_ApplyGlovePose()
+	: Hand(EDeviceType::HandR)
+	, PoseSource(EHandPoseSource::Glove)
+	, FlexAxis(1.0f, 0.0f, 0.0f)
+	, ThumbFlexAxis(0.0f, 0.0f, 1.0f)
+	, DegreeScale(1.0f)
+	, WristRotationOffset(ForceInitToZero)
+	, Alpha(1.0f)
+	, GloveModule(nullptr)
+	, CachedWristIndex(INDEX_NONE)
+	, ActualAlpha(0.0f)
+{
+	JointBones.SetNum(GloveJointCount);
+}
+
+void FAnimNode_ApplyGlovePose::Initialize_AnyThread(const FAnimationInitializeContext& Context)
+{
+	FAnimNode_Base::Initialize_AnyThread(Context);
+	Source.Initialize(Context);
+
+	GloveModule = FModuleManager::GetModulePtr<FMollisenHANDModule>("MollisenHAND");
+	JointDegrees.Reserve(GloveJointCount);
+}
+
+void FAnimNode_ApplyGlovePose::CacheBones_AnyThread(const FAnimationCacheBonesContext& Context)
+{
+	Source.CacheBones(Context);
+
+	const FBoneContainer& RequiredBones = Context.AnimInstanceProxy->GetRequiredBones();
+	const FVector Axis = FlexAxis.GetSafeNormal(SMALL_NUMBER, FVector(1.0f, 0.0f, 0.0f));
+	const FVector ThumbAxis = ThumbFlexAxis.GetSafeNormal(SMALL_NUMBER, FVector(0.0f, 0.0f, 1.0f));
+
+	CachedJointIndices.Reset(JointBones.Num());
+	CachedAxes.Reset(JointBones.Num());
+	for (int32 Joint = 0; Joint < JointBones.Num(); ++Joint)
+	{
+		FBoneReference& Bone = JointBones[Joint];
+		Bone.Initialize(RequiredBones);
+
+		CachedJointIndices.Add(Bone.IsValidToEvaluate(RequiredBones) ? Bone.GetCompactPoseIndex(RequiredBones) : FCompactPoseBoneIndex(INDEX_NONE));
+		CachedAxes.Add(Joint < GloveThumbJointCount ? ThumbAxis : Axis);
+	}
+
+	WristBone.Initialize(RequiredBones);
+	CachedWristIndex = WristBone.IsValidToEvaluate(RequiredBones) ? WristBone.GetCompactPoseIndex(RequiredBones) : FCompactPoseBoneIndex(INDEX_NONE);
+}
+
+void FAnimNode_ApplyGlovePose::Update_AnyThread(const FAnimationUpdateContext& Context)
+{
+	GetEvaluateGraphExposedInputs().Execute(Context);
+	Source.Update(Context);
+
+	ActualAlpha = FMath::Clamp(Alpha, 0.0f, 1.0f);
+}
+
+void FAnimNode_ApplyGlovePose::Evaluate_AnyThread(FPoseContext& Output)
+{
+	Source.Evaluate(Output);
+
+	if (!FAnimWeight::IsRelevant(ActualAlpha))
+	{
+		return;
+	}
+
+	if (PoseSource == EHandPoseSource::Glove)
+	{
+		ApplyWristRotation(Output);
+	}
+
+	bool bHasPose = false;
+	int64 CaptureUs = 0;
+	const int32 HandIndex = FHandPoseBuffer::HandIndex(Hand == EDeviceType::HandR);
+	switch (PoseSource)
+	{
+	case EHandPoseSource::Glove:
+		bHasPose = GloveModule != nullptr && GloveModule->GetJointDegrees(ToGloveDevice(Hand), JointDegrees);
+		break;
+	case EHandPoseSource::Landmarks:
+		bHasPose = Hand != EDeviceType::None && FHandPoseBuffer::GetLatestJointDegrees(HandIndex, JointDegrees, CaptureUs);
+		break;
+	}
+
+	if (!bHasPose)
+	{
+		return;
+	}
+
+	// One latency source per hand, so each hand's pose is credited to its own capture.
+	FMqttLatencyTracer::MarkOnce(EMqttLatencyStage::Applied, CaptureUs, HandIndex);
+
+	const float Scale = DegreeScale * ActualAlpha;
+	const int32 NumJoints = FMath::Min(CachedJointIndices.Num(), JointDegrees.Num());
+	for (int32 Joint = 0; Joint < NumJoints; ++Joint)
+	{
+		const FCompactPoseBoneIndex BoneIndex = CachedJointIndices[Joint];
+		if (BoneIndex == INDEX_NONE)
+		{
+			continue;
+		}
+
+		// Bend in the bone's own frame, on top of whatever the source pose provides.
+		FTransform& BoneTransform = Output.Pose[BoneIndex];
+		const FQuat Flex(CachedAxes[Joint], FMath::DegreesToRadians(JointDegrees[Joint] * Scale));
+		BoneTransform.SetRotation(BoneTransform.GetRotation() * Flex);
+	}
+}
+
+void FAnimNode_ApplyGlovePose::ApplyWristRotation(FPoseContext& Output) const
+{
+	FQuat Orientation;
+	double Timestamp;
+	if (CachedWristIndex == INDEX_NONE || GloveModule == nullptr || !GloveModule->GetWristOrientation(ToGloveDevice(Hand), Orientation, Timestamp))
+	{
+		return;
+	}
+
+	// Component space rotation of the wrist's parent, to express the orientation relative to it.
+	FQuat ParentRotation = FQuat::Identity;
+	for (FCompactPoseBoneIndex Parent = Output.Pose.GetParentBoneIndex(CachedWristIndex); Parent != INDEX_NONE; Parent = Output.Pose.GetParentBoneIndex(Parent))
+	{
+		ParentRotation = Output.Pose[Parent].GetRotation() * ParentRotation;
+	}
+
+	FTransform& WristTransform = Output.Pose[CachedWristIndex];
+	const FQuat Target = ParentRotation.Inverse() * Orientation * WristRotationOffset.Quaternion();
+	WristTransform.SetRotation(FQuat::Slerp(WristTransform.GetRotation(), Target, ActualAlpha).GetNormalized());
+}
+
+void FAnimNode_ApplyGlovePose::GatherDebugData(FNodeDebugData& DebugData)
+{
+	FString DebugLine = DebugData.GetNodeName(this);
+	DebugLine += FString::Printf(TEXT("(Hand: %d, Alpha: %.1f%%)"), (int32)Hand, ActualAlpha * 100.0f);
+	DebugData.AddDebugItem(DebugLine);
+
+	Source.GatherDebugData(DebugData);
+}
@@ -0,0 +1,218 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HandLandmarkRetargeter.h"
+
+#include "HAL/PlatformTime.h"
+
+namespace
+{
+	constexpr int32 L = FHandLandmarkInput::NumLandmarks;
+	constexpr int32 H = FHandLandmarkInput::MaxHands;
+	constexpr int32 NumFingers = 5;
+	constexpr int32 BonesPerFinger = 4;
+	constexpr int32 NumBones = NumFingers * BonesPerFinger;
+
+	constexpr int32 Wrist = 0;
+	constexpr int32 IndexMCP = 5;
+	constexpr int32 MiddleMCP = 9;
+	constexpr int32 PinkyMCP = 17;
+
+	/** Landmark at position Point (0 = wrist, 1..4 = finger joints) of a finger chain. */
+	FORCEINLINE int32 ChainLandmark(int32 Finger, int32 Point)
+	{
+		return Point == 0 ? Wrist : 1 + Finger * BonesPerFinger + (Point - 1);
+	}
+
+	/** Quaternion rotating unit vector A onto unit vector B, as (x, y, z, w). */
+	FORCEINLINE void RotationBetween(const float A[3], const float B[3], float Q[4])
+	{
+		const float W = 1.0f + A[0] * B[0] + A[1] * B[1] + A[2] * B[2];
+		if (W < KINDA_SMALL_NUMBER)
+		{
+			// Opposite directions: any perpendicular axis works, the palm normal keeps the result in the flex plane.
+			Q[0] = 0.0f; Q[1] = 0.0f; Q[2] = 1.0f; Q[3] = 0.0f;
+			return;
+		}
+
+		Q[0] = A[1] * B[2] - A[2] * B[1];
+		Q[1] = A[2] * B[0] - A[0] * B[2];
+		Q[2] = A[0] * B[1] - A[1] * B[0];
+		Q[3] = W;
+
+		const float InvLength = FMath::InvSqrt(Q[0] * Q[0] + Q[1] * Q[1] + Q[2] * Q[2] + Q[3] * Q[3]);
+		Q[0] *= InvLength; Q[1] *= InvLength; Q[2] *= InvLength; Q[3] *= InvLength;
+	}
+
+	/**
+	 * Swing-twist split of Q about a palm-frame basis axis (0 = forward, 1 = side, 2 = normal).
+	 * Returns the twist angle, and the angle of the remaining swing around the palm normal in OutSpread.
+	 */
+	FORCEINLINE float SwingTwist(const float Q[4], int32 TwistAxis, float& OutSpread)
+	{
+		const float TwistV = Q[TwistAxis];
+		const float TwistW = Q[3];
+		const float TwistLength = FMath::Sqrt(TwistV * TwistV + TwistW * TwistW);
+		if (TwistLength < KINDA_SMALL_NUMBER)
+		{
+			OutSpread = 0.0f;
+			return 0.0f;
+		}
+
+		const float TwistAngle = 2.0f * FMath::Atan2(TwistV, TwistW);
+
+		// Swing = Q * conjugate(Twist); only its component about the palm normal is needed.
+		const float V = TwistV / TwistLength;
+		const FQuat Twist(TwistAxis == 0 ? V : 0.0f, TwistAxis == 1 ? V : 0.0f, TwistAxis == 2 ? V : 0.0f, TwistW / TwistLength);
+		const FQuat Swing = FQuat(Q[0], Q[1], Q[2], Q[3]) * Twist.Inverse();
+		OutSpread = TwistAxis == 2 ? 0.0f : 2.0f * FMath::Atan2(Swing.Z, Swing.W);
+
+		return TwistAngle;
+	}
+}
+
+FHandLandmarkInput::FHandLandmarkInput()
+{
+	FMemory::Memzero(X);
+	FMemory::Memzero(Y);
+	FMemory::Memzero(Z);
+
+	for (int32 Hand = 0; Hand < MaxHands; ++Hand)
+	{
+		bPresent[Hand] = false;
+		Timestamp[Hand] = 0.0;
+	}
+}
+
+void FHandLandmarkInput::SetHand(int32 Hand, const FVector* Landmarks, int32 NumPoints, double InTimestamp)
+{
+	if (Hand < 0 || Hand >= MaxHands || Landmarks == nullptr || NumPoints < NumLandmarks)
+	{
+		return;
+	}
+
+	for (int32 Landmark = 0; Landmark < NumLandmarks; ++Landmark)
+	{
+		X[Landmark * MaxHands + Hand] = Landmarks[Landmark].X;
+		Y[Landmark * MaxHands + Hand] = Landmarks[Landmark].Y;
+		Z[Landmark * MaxHands + Hand] = Landmarks[Landmark].Z;
+	}
+
+	bPresent[Hand] = true;
+	Timestamp[Hand] = InTimestamp;
+}
+
+void FHandLandmarkRetargeter::Solve(const FHandLandmarkInput& Input, const FHandLandmarkRetargetSettings& Settings, FHandPoseBuffer& OutPose)
+{
+	// Palm frame per hand: forward, side and normal axes plus the inverse palm length used to normalize bone lengths.
+	float Fx[H], Fy[H], Fz[H];
+	float Sx[H], Sy[H], Sz[H];
+	float Nx[H], Ny[H], Nz[H];
+	float InvPalm[H];
+	bool bSolvable[H];
+
+	for (int32 Hand = 0; Hand < H; ++Hand)
+	{
+		const int32 W = Wrist * H + Hand;
+		const int32 M = MiddleMCP * H + Hand;
+		const int32 I = IndexMCP * H + Hand;
+		const int32 P = PinkyMCP * H + Hand;
+
+		const FVector Forward(Input.X[M] - Input.X[W], Input.Y[M] - Input.Y[W], Input.Z[M] - Input.Z[W]);
+		const float PalmLength = Forward.Size();
+
+		bSolvable[Hand] = Input.bPresent[Hand] && PalmLength > Settings.MinPalmLength;
+		InvPalm[Hand] = bSolvable[Hand] ? 1.0f / PalmLength : 0.0f;
+
+		const FVector F = bSolvable[Hand] ? Forward * InvPalm[Hand] : FVector::ForwardVector;
+		const FVector Across(Input.X[I] - Input.X[P], Input.Y[I] - Input.Y[P], Input.Z[I] - Input.Z[P]);
+		const FVector S = (Across - (Across | F) * F).GetSafeNormal(SMALL_NUMBER, FVector::RightVector);
+		const FVector N = F ^ S;
+
+		Fx[Hand] = F.X; Fy[Hand] = F.Y; Fz[Hand] = F.Z;
+		Sx[Hand] = S.X; Sy[Hand] = S.Y; Sz[Hand] = S.Z;
+		Nx[Hand] = N.X; Ny[Hand] = N.Y; Nz[Hand] = N.Z;
+
+		OutPose.bValid[Hand] = bSolvable[Hand];
+		OutPose.Timestamp[Hand] = Input.Timestamp[Hand] > 0.0 ? Input.Timestamp[Hand] : FPlatformTime::Seconds();
+		OutPose.WristPosition[Hand] = FVector(Input.X[W], Input.Y[W], Input.Z[W]);
+		OutPose.PalmRotation[Hand] = FMatrix(F, S, N, FVector::ZeroVector).ToQuat();
+	}
+
+	// Landmarks relative to the wrist, expressed in the palm frame and scaled to unit palm length.
+	float Px[L * H], Py[L * H], Pz[L * H];
+	for (int32 Landmark = 0; Landmark < L; ++Landmark)
+	{
+		for (int32 Hand = 0; Hand < H; ++Hand)
+		{
+			const int32 Index = Landmark * H + Hand;
+			const int32 W = Wrist * H + Hand;
+			const float Dx = Input.X[Index] - Input.X[W];
+			const float Dy = Input.Y[Index] - Input.Y[W];
+			const float Dz = Input.Z[Index] - Input.Z[W];
+
+			Px[Index] = (Dx * Fx[Hand] + Dy * Fy[Hand] + Dz * Fz[Hand]) * InvPalm[Hand];
+			Py[Index] = (Dx * Sx[Hand] + Dy * Sy[Hand] + Dz * Sz[Hand]) * InvPalm[Hand];
+			Pz[Index] = (Dx * Nx[Hand] + Dy * Ny[Hand] + Dz * Nz[Hand]) * InvPalm[Hand];
+		}
+	}
+
+	// Unit bone directions: wrist to first landmark, then along each finger.
+	float Bx[NumBones * H], By[NumBones * H], Bz[NumBones * H];
+	for (int32 Finger = 0; Finger < NumFingers; ++Finger)
+	{
+		for (int32 Bone = 0; Bone < BonesPerFinger; ++Bone)
+		{
+			const int32 From = ChainLandmark(Finger, Bone) * H;
+			const int32 To = ChainLandmark(Finger, Bone + 1) * H;
+			const int32 Out = (Finger * BonesPerFinger + Bone) * H;
+
+			for (int32 Hand = 0; Hand < H; ++Hand)
+			{
+				const float Dx = Px[To + Hand] - Px[From + Hand];
+				const float Dy = Py[To + Hand] - Py[From + Hand];
+				const float Dz = Pz[To + Hand] - Pz[From + Hand];
+				const float InvLength = FMath::InvSqrt(FMath::Max(Dx * Dx + Dy * Dy + Dz * Dz, SMALL_NUMBER));
+
+				Bx[Out + Hand] = Dx * InvLength;
+				By[Out + Hand] = Dy * InvLength;
+				Bz[Out + Hand] = Dz * InvLength;
+			}
+		}
+	}
+
+	// Joint rotations between consecutive bones, split into flexion and spread.
+	for (int32 Hand = 0; Hand < H; ++Hand)
+	{
+		if (!bSolvable[Hand])
+		{
+			continue;
+		}
+
+		const float Sign = Hand == FHandPoseBuffer::HandIndex(true) ? Settings.FlexSign : -Settings.FlexSign;
+
+		for (int32 Finger = 0; Finger < NumFingers; ++Finger)
+		{
+			// Fingers curl about the palm side axis, the thumb about the palm forward axis.
+			const int32 TwistAxis = Finger == 0 ? 0 : 1;
+
+			for (int32 Joint = 0; Joint < 3; ++Joint)
+			{
+				const int32 Parent = (Finger * BonesPerFinger + Joint) * H + Hand;
+				const int32 Child = Parent + H;
+
+				const float A[3] = { Bx[Parent], By[Parent], Bz[Parent] };
+				const float B[3] = { Bx[Child], By[Child], Bz[Child] };
+
+				float Q[4];
+				RotationBetween(A, B, Q);
+
+				float Spread = 0.0f;
+				const float Flex = SwingTwist(Q, TwistAxis, Spread);
+
+				const int32 JointIndex = Finger * 3 + Joint;
+				OutPose.JointDegrees[Hand][JointIndex] = FMath::RadiansToDegrees(Flex) * Sign;
+				OutPose.JointSpread[Hand][JointIndex] = FMath::RadiansToDegrees(Spread) * Sign;
+			}
+		}
+	}
+}
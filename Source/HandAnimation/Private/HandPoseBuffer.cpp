@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HandPoseBuffer.h"
+
+#include "Misc/ScopeLock.h"
+
+namespace
+{
+	FCriticalSection LatestPoseLock;
+	FHandPoseBuffer LatestPose;
+}
+
+FHandPoseBuffer::FHandPoseBuffer()
+{
+	FMemory::Memzero(JointDegrees);
+	FMemory::Memzero(JointSpread);
+
+	for (int32 Hand = 0; Hand < MaxHands; ++Hand)
+	{
+		PalmRotation[Hand] = FQuat::Identity;
+		WristPosition[Hand] = FVector::ZeroVector;
+		Timestamp[Hand] = 0.0;
+		CaptureUs[Hand] = 0;
+		bValid[Hand] = false;
+	}
+}
+
+void FHandPoseBuffer::Publish(const FHandPoseBuffer& Pose)
+{
+	FScopeLock Lock(&LatestPoseLock);
+
+	for (int32 Hand = 0; Hand < MaxHands; ++Hand)
+	{
+		if (!Pose.bValid[Hand])
+		{
+			continue;
+		}
+
+		FMemory::Memcpy(LatestPose.JointDegrees[Hand], Pose.JointDegrees[Hand], sizeof(Pose.JointDegrees[Hand]));
+		FMemory::Memcpy(LatestPose.JointSpread[Hand], Pose.JointSpread[Hand], sizeof(Pose.JointSpread[Hand]));
+		LatestPose.PalmRotation[Hand] = Pose.PalmRotation[Hand];
+		LatestPose.WristPosition[Hand] = Pose.WristPosition[Hand];
+		LatestPose.Timestamp[Hand] = Pose.Timestamp[Hand];
+		LatestPose.CaptureUs[Hand] = Pose.CaptureUs[Hand];
+		LatestPose.bValid[Hand] = true;
+	}
+}
+
+bool FHandPoseBuffer::GetLatestJointDegrees(int32 Hand, TArray<float>& OutDegrees)
+{
+	int64 CaptureUs;
+	return GetLatestJointDegrees(Hand, OutDegrees, CaptureUs);
+}
+
+bool FHandPoseBuffer::GetLatestJointDegrees(int32 Hand, TArray<float>& OutDegrees, int64& OutCaptureUs)
+{
+	if (Hand < 0 || Hand >= MaxHands)
+	{
+		return false;
+	}
+
+	FScopeLock Lock(&LatestPoseLock);
+
+	if (!LatestPose.bValid[Hand])
+	{
+		return false;
+	}
+
+	OutDegrees.SetNumUninitialized(NumJoints, false);
+	FMemory::Memcpy(OutDegrees.GetData(), LatestPose.JointDegrees[Hand], sizeof(LatestPose.JointDegrees[Hand]));
+	OutCaptureUs = LatestPose.CaptureUs[Hand];
+	return true;
+}
+
+void FHandPoseBuffer::GetLatest(FHandPoseBuffer& OutPose)
+{
+	FScopeLock Lock(&LatestPoseLock);
+	OutPose = LatestPose;
+}
@@ -0,0 +1,54 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HandPoseFunctionLibrary.h"
+
+#include "HandLandmarkRetargeter.h"
+
+int32 UHandPoseFunctionLibrary::SubmitFingerPoses(const TArray<FFingerPose>& Poses)
+{
+	FHandLandmarkInput Input;
+	const double Now = FPlatformTime::Seconds();
+	int64 CaptureUs[FHandPoseBuffer::MaxHands] = {};
+
+	for (const FFingerPose& Pose : Poses)
+	{
+		const TArray<FVector>* Fingers[] = { &Pose.Thumb, &Pose.Index, &Pose.Middle, &Pose.Ring, &Pose.Pinky };
+
+		FVector Landmarks[FHandLandmarkInput::NumLandmarks];
+		Landmarks[0] = Pose.Palm;
+
+		bool bComplete = true;
+		for (int32 Finger = 0; Finger < UE_ARRAY_COUNT(Fingers) && bComplete; ++Finger)
+		{
+			bComplete = Fingers[Finger]->Num() >= 4;
+			for (int32 Point = 0; Point < 4 && bComplete; ++Point)
+			{
+				Landmarks[1 + Finger * 4 + Point] = (*Fingers[Finger])[Point];
+			}
+		}
+
+		if (bComplete)
+		{
+			const bool bRightHand = Pose.hand.Equals(TEXT("Right"), ESearchCase::IgnoreCase);
+			Input.SetHand(FHandPoseBuffer::HandIndex(bRightHand), Landmarks, UE_ARRAY_COUNT(Landmarks), Now);
+			CaptureUs[FHandPoseBuffer::HandIndex(bRightHand)] = Pose.CaptureUs;
+		}
+	}
+
+	FHandPoseBuffer Output;
+	FHandLandmarkRetargeter::Solve(Input, FHandLandmarkRetargetSettings(), Output);
+	FMemory::Memcpy(Output.CaptureUs, CaptureUs, sizeof(CaptureUs));
+	FHandPoseBuffer::Publish(Output);
+
+	int32 NumSolved = 0;
+	for (int32 Hand = 0; Hand < FHandPoseBuffer::MaxHands; ++Hand)
+	{
+		NumSolved += Output.bValid[Hand] ? 1 : 0;
+	}
+	return NumSolved;
+}
+
+bool UHandPoseFunctionLibrary::GetLandmarkJointDegrees(bool bRightHand, TArray<float>& JointDegrees)
+{
+	return FHandPoseBuffer::GetLatestJointDegrees(FHandPoseBuffer::HandIndex(bRightHand), JointDegrees);
+}
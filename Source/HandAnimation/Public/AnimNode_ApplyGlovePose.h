@@ -0,0 +1,98 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Animation/AnimNodeBase.h"
+#include "BoneContainer.h"
+#include "MollisenHANDBPLibrary.h"
+#include "AnimNode_ApplyGlovePose.generated.h"
+
+class FMollisenHANDModule;
+
+/** Where the Apply Glove Pose node takes its joint degrees from. */
+UENUM(BlueprintType)
+enum class EHandPoseSource : uint8
+{
+	/** MollisenHAND glove joints. */
+	Glove,
+	/** Camera landmarks retargeted by FHandLandmarkRetargeter. */
+	Landmarks,
+};
+
+/**
+ * Applies the latest glove joint degrees to the finger bones in one pass.
+ * The joint snapshot is read on the animation worker thread, so hand posing no longer needs per-bone blueprint nodes.
+ * With the glove source the wrist bone can also follow the orientation fused from the glove IMU.
+ */
+USTRUCT(BlueprintInternalUseOnly)
+struct HANDANIMATION_API FAnimNode_ApplyGlovePose : public FAnimNode_Base
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Links)
+	FPoseLink Source;
+
+	/** Hand to read the joints from. */
+	UPROPERTY(EditAnywhere, Category = "Glove")
+	EDeviceType Hand;
+
+	UPROPERTY(EditAnywhere, Category = "Glove")
+	EHandPoseSource PoseSource;
+
+	/** Finger bones in EJointType order (ThumbCMC .. PinkyDIP). Leave a bone empty to skip that joint. */
+	UPROPERTY(EditAnywhere, EditFixedSize, Category = "Glove")
+	TArray<FBoneReference> JointBones;
+
+	/** Bone-local axis the fingers curl around. */
+	UPROPERTY(EditAnywhere, Category = "Glove")
+	FVector FlexAxis;
+
+	/** Bone-local axis the thumb curls around. */
+	UPROPERTY(EditAnywhere, Category = "Glove")
+	FVector ThumbFlexAxis;
+
+	/** Multiplier applied to every degree value, use -1 to mirror the bend direction. */
+	UPROPERTY(EditAnywhere, Category = "Glove")
+	float DegreeScale;
+
+	/** Bone rotated to the glove's wrist orientation in component space. Leave empty to keep the source pose's wrist. */
+	UPROPERTY(EditAnywhere, Category = "Glove")
+	FBoneReference WristBone;
+
+	/** Rotation from the glove's sensor axes to the wrist bone's axes. */
+	UPROPERTY(EditAnywhere, Category = "Glove")
+	FRotator WristRotationOffset;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings, meta = (PinShownByDefault))
+	float Alpha;
+
+	FAnimNode_ApplyGlovePose();
+
+	// FAnimNode_Base interface
+	virtual void Initialize_AnyThread(const FAnimationInitializeContext& Context) override;
+	virtual void CacheBones_AnyThread(const FAnimationCacheBonesContext& Context) override;
+	virtual void Update_AnyThread(const FAnimationUpdateContext& Context) override;
+	virtual void Evaluate_AnyThread(FPoseContext& Output) override;
+	virtual void GatherDebugData(FNodeDebugData& DebugData) override;
+	// End of FAnimNode_Base interface
+
+private:
+	void ApplyWristRotation(FPoseContext& Output) const;
+
+	FMollisenHANDModule* GloveModule;
+
+	/** Compact pose index of WristBone, INDEX_NONE when unset or not required by the current LOD. */
+	FCompactPoseBoneIndex CachedWristIndex;
+
+	/** Compact pose index per entry of JointBones, INDEX_NONE when the bone is not required by the current LOD. */
+	TArray<FCompactPoseBoneIndex> CachedJointIndices;
+
+	/** Normalized bend axis per entry of JointBones. */
+	TArray<FVector> CachedAxes;
+
+	/** Scratch buffer reused every evaluation. */
+	TArray<float> JointDegrees;
+
+	float ActualAlpha;
+};
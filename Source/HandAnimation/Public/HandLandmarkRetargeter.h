@@ -0,0 +1,54 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HandPoseBuffer.h"
+
+/**
+ * Landmarks of up to two hands in MediaPipe order (wrist, then 4 points per finger from thumb to pinky).
+ * Stored as structure-of-arrays with the hand as the fastest index, X[Landmark * MaxHands + Hand],
+ * so every per-landmark step of the solver runs over both hands at once.
+ */
+struct HANDANIMATION_API FHandLandmarkInput
+{
+	static constexpr int32 NumLandmarks = 21;
+	static constexpr int32 MaxHands = FHandPoseBuffer::MaxHands;
+
+	float X[NumLandmarks * MaxHands];
+	float Y[NumLandmarks * MaxHands];
+	float Z[NumLandmarks * MaxHands];
+
+	bool bPresent[MaxHands];
+
+	/** Platform seconds the landmarks were captured at, copied into the pose buffer. */
+	double Timestamp[MaxHands];
+
+	FHandLandmarkInput();
+
+	/** Stores 21 landmarks for a hand slot (see FHandPoseBuffer::HandIndex). */
+	void SetHand(int32 Hand, const FVector* Landmarks, int32 NumPoints, double InTimestamp);
+};
+
+struct HANDANIMATION_API FHandLandmarkRetargetSettings
+{
+	/** Sign applied to flexion of the right hand; the left hand gets the opposite sign because its palm frame is mirrored. */
+	float FlexSign = 1.0f;
+
+	/** Hands whose wrist-to-middle-MCP distance is below this (in tracker units) are treated as lost. */
+	float MinPalmLength = KINDA_SMALL_NUMBER;
+};
+
+/**
+ * Computes per-joint flexion and spread from tracked hand landmarks.
+ *
+ * Landmarks are moved into a palm frame (forward: wrist to middle MCP, side: pinky MCP to index MCP) and scaled by the
+ * palm length, so the result does not depend on the hand size or distance to the camera. Each joint rotation is the
+ * swing between consecutive bone directions, split with a swing-twist decomposition into flexion (twist about the
+ * finger's bend axis) and spread (the remaining swing about the palm normal).
+ */
+class HANDANIMATION_API FHandLandmarkRetargeter
+{
+public:
+	static void Solve(const FHandLandmarkInput& Input, const FHandLandmarkRetargetSettings& Settings, FHandPoseBuffer& OutPose);
+};
@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Per-hand joint pose produced by the landmark retargeter and consumed by the Apply Glove Pose node.
+ * Joint arrays follow EJointType order (ThumbCMC .. PinkyDIP) so the AnimGraph treats both sources the same.
+ */
+struct HANDANIMATION_API FHandPoseBuffer
+{
+	static constexpr int32 MaxHands = 2;
+	static constexpr int32 NumJoints = 15;
+
+	/** Flexion per joint in degrees. */
+	float JointDegrees[MaxHands][NumJoints];
+
+	/** Abduction (side swing) per joint in degrees. */
+	float JointSpread[MaxHands][NumJoints];
+
+	/** Palm orientation in tracker space. */
+	FQuat PalmRotation[MaxHands];
+
+	/** Wrist position in tracker space. */
+	FVector WristPosition[MaxHands];
+
+	/** Platform seconds at which the pose was solved. */
+	double Timestamp[MaxHands];
+
+	/** Capture time of the landmarks' MQTT message (FMqttMessage::Timestamp), 0 if unknown. For the latency tracer. */
+	int64 CaptureUs[MaxHands];
+
+	bool bValid[MaxHands];
+
+	FHandPoseBuffer();
+
+	/** Hand slot for bRightHand: 0 for the left hand, 1 for the right, always in [0, MaxHands). */
+	static int32 HandIndex(bool bRightHand) { return bRightHand ? 1 : 0; }
+
+	/** Publishes the valid hands of Pose as the latest pose. Safe to call from any thread. */
+	static void Publish(const FHandPoseBuffer& Pose);
+
+	/** Copies the latest joint degrees of one hand. Safe to call from animation worker threads. */
+	static bool GetLatestJointDegrees(int32 Hand, TArray<float>& OutDegrees);
+
+	/** Same, with the capture time of the pose. */
+	static bool GetLatestJointDegrees(int32 Hand, TArray<float>& OutDegrees, int64& OutCaptureUs);
+
+	/** Copies the latest pose of both hands. */
+	static void GetLatest(FHandPoseBuffer& OutPose);
+};
@@ -0,0 +1,26 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Kismet/BlueprintFunctionLibrary.h"
+#include "FlexbuffersFunctionLibrary.h"
+#include "HandPoseFunctionLibrary.generated.h"
+
+UCLASS()
+class HANDANIMATION_API UHandPoseFunctionLibrary : public UBlueprintFunctionLibrary
+{
+	GENERATED_BODY()
+
+public:
+	/**
+	 * Retargets the landmarks of up to one left and one right hand in a single batch and publishes the result
+	 * for Apply Glove Pose nodes set to the Landmarks source. Returns the number of hands solved.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Hand")
+	static int32 SubmitFingerPoses(const TArray<FFingerPose>& Poses);
+
+	/** Latest retargeted flexion per joint (EJointType order) for one hand. */
+	UFUNCTION(BlueprintPure, Category = "Hand")
+	static bool GetLandmarkJointDegrees(bool bRightHand, TArray<float>& JointDegrees);
+};
@@ -0,0 +1,15 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+using UnrealBuildTool;
+
+public class HandAnimationEditor : ModuleRules
+{
+	public HandAnimationEditor(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "AnimGraph", "HandAnimation" });
+
+		PrivateDependencyModuleNames.AddRange(new string[] { "BlueprintGraph", "UnrealEd", "UE4IKTest", "MqttUtilities", "HandCore", "Json" });
+	}
+}
@@ -0,0 +1,27 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "AnimGraphNode_ApplyGlovePose.h"
+
+#define LOCTEXT_NAMESPACE "HandAnimationEditor"
+
+FText UAnimGraphNode_ApplyGlovePose::GetNodeTitle(ENodeTitleType::Type TitleType) const
+{
+	return LOCTEXT("ApplyGlovePose_Title", "Apply Glove Pose");
+}
+
+FText UAnimGraphNode_ApplyGlovePose::GetTooltipText() const
+{
+	return LOCTEXT("ApplyGlovePose_Tooltip", "Rotates the finger bones from the latest MollisenHAND glove joint degrees.");
+}
+
+FLinearColor UAnimGraphNode_ApplyGlovePose::GetNodeTitleColor() const
+{
+	return FLinearColor(0.7f, 0.7f, 0.1f);
+}
+
+FString UAnimGraphNode_ApplyGlovePose::GetNodeCategory() const
+{
+	return TEXT("Hand");
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,16 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Modules/ModuleManager.h"
+#include "HandBenchMalloc.h"
+
+class FHandAnimationEditorModule : public FDefaultModuleImpl
+{
+public:
+	virtual void StartupModule() override
+	{
+		// Allocation counting for -run=HandPipelineBench has to be in place before the commandlet runs.
+		FHandBenchMalloc::InstallIfRequested();
+	}
+};
+
+IMPLEMENT_MODULE(FHandAnimationEditorModule, HandAnimationEditor);
@@ -0,0 +1,96 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HandBenchMalloc.h"
+
+#include "HAL/PlatformMisc.h"
+#include "HAL/PlatformTLS.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+
+namespace
+{
+	FHandBenchMalloc* Instance = nullptr;
+}
+
+FHandBenchMalloc::FHandBenchMalloc(FMalloc* InInner)
+	: Inner(InInner)
+	, CountedThreadId(0)
+	, Allocations(0)
+{
+}
+
+void FHandBenchMalloc::InstallIfRequested()
+{
+	check(IsInGameThread());
+
+	if (Instance != nullptr || GMalloc == nullptr || !FParse::Param(FCommandLine::Get(), TEXT("BenchAllocs")))
+	{
+		return;
+	}
+
+	// Leaked on purpose, see the class comment. Built with the inner allocator so the proxy does not count itself.
+	Instance = new (GMalloc->Malloc(sizeof(FHandBenchMalloc), alignof(FHandBenchMalloc))) FHandBenchMalloc(GMalloc);
+	FPlatformMisc::MemoryBarrier();
+	GMalloc = Instance;
+
+	UE_LOG(LogMemory, Display, TEXT("Counting allocations for the hand pipeline bench (-BenchAllocs)."));
+}
+
+bool FHandBenchMalloc::IsInstalled()
+{
+	return Instance != nullptr;
+}
+
+void FHandBenchMalloc::BeginCounting()
+{
+	if (Instance != nullptr)
+	{
+		Instance->Allocations = 0;
+		Instance->CountedThreadId.store(FPlatformTLS::GetCurrentThreadId(), std::memory_order_release);
+	}
+}
+
+void FHandBenchMalloc::EndCounting()
+{
+	if (Instance != nullptr)
+	{
+		Instance->CountedThreadId.store(0, std::memory_order_release);
+	}
+}
+
+int64 FHandBenchMalloc::GetAllocations()
+{
+	return Instance != nullptr ? Instance->Allocations : 0;
+}
+
+void* FHandBenchMalloc::Malloc(SIZE_T Count, uint32 Alignment)
+{
+	Counted();
+	return Inner->Malloc(Count, Alignment);
+}
+
+void* FHandBenchMalloc::TryMalloc(SIZE_T Count, uint32 Alignment)
+{
+	Counted();
+	return Inner->TryMalloc(Count, Alignment);
+}
+
+void* FHandBenchMalloc::Realloc(void* Original, SIZE_T Count, uint32 Alignment)
+{
+	Counted();
+	return Inner->Realloc(Original, Count, Alignment);
+}
+
+void* FHandBenchMalloc::TryRealloc(void* Original, SIZE_T Count, uint32 Alignment)
+{
+	Counted();
+	return Inner->TryRealloc(Original, Count, Alignment);
+}
+
+void FHandBenchMalloc::Counted()
+{
+	if (CountedThreadId.load(std::memory_order_relaxed) == FPlatformTLS::GetCurrentThreadId())
+	{
+		++Allocations;
+	}
+}
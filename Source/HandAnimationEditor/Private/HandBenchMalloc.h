@@ -0,0 +1,69 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/MemoryBase.h"
+
+#include <atomic>
+
+/**
+ * Forwards to the engine allocator and counts the allocations made by one thread, so the pipeline bench can report
+ * allocations per frame without a memory profiler attached.
+ *
+ * Installed over GMalloc once, at module startup and only with -BenchAllocs on the command line. It is never removed
+ * or destroyed: other threads may have read GMalloc at any time, so both the proxy and the allocator it wraps must
+ * stay valid for the rest of the process.
+ */
+class FHandBenchMalloc final : public FMalloc
+{
+public:
+	/** Installs the proxy if -BenchAllocs was passed. Call once, during startup. */
+	static void InstallIfRequested();
+
+	/** Whether allocations can be counted in this process. */
+	static bool IsInstalled();
+
+	/** Counts allocations of the calling thread from now on; any previous count is discarded. */
+	static void BeginCounting();
+
+	/** Stops counting. */
+	static void EndCounting();
+
+	/** Allocations counted since BeginCounting. Only meaningful on the thread that called it. */
+	static int64 GetAllocations();
+
+	// FMalloc interface
+	virtual void* Malloc(SIZE_T Count, uint32 Alignment) override;
+	virtual void* TryMalloc(SIZE_T Count, uint32 Alignment) override;
+	virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override;
+	virtual void* TryRealloc(void* Original, SIZE_T Count, uint32 Alignment) override;
+	virtual void Free(void* Original) override { Inner->Free(Original); }
+	virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return Inner->QuantizeSize(Count, Alignment); }
+	virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return Inner->GetAllocationSize(Original, SizeOut); }
+	virtual void Trim(bool bTrimThreadCaches) override { Inner->Trim(bTrimThreadCaches); }
+	virtual void SetupTLSCachesOnCurrentThread() override { Inner->SetupTLSCachesOnCurrentThread(); }
+	virtual void ClearAndDisableTLSCachesOnCurrentThread() override { Inner->ClearAndDisableTLSCachesOnCurrentThread(); }
+	virtual void InitializeStatsMetadata() override { Inner->InitializeStatsMetadata(); }
+	virtual void UpdateStats() override { Inner->UpdateStats(); }
+	virtual void GetAllocatorStats(FGenericMemoryStats& OutStats) override { Inner->GetAllocatorStats(OutStats); }
+	virtual void DumpAllocatorStats(FOutputDevice& Ar) override { Inner->DumpAllocatorStats(Ar); }
+	virtual bool IsInternallyThreadSafe() const override { return Inner->IsInternallyThreadSafe(); }
+	virtual bool ValidateHeap() override { return Inner->ValidateHeap(); }
+	virtual const TCHAR* GetDescriptiveName() override { return Inner->GetDescriptiveName(); }
+	virtual bool Exec(UWorld* InWorld, const TCHAR* Cmd, FOutputDevice& Ar) override { return Inner->Exec(InWorld, Cmd, Ar); }
+	// End of FMalloc interface
+
+private:
+	explicit FHandBenchMalloc(FMalloc* InInner);
+
+	void Counted();
+
+	FMalloc* Inner;
+
+	/** Thread being counted, 0 when counting is off. */
+	std::atomic<uint32> CountedThreadId;
+
+	/** Written by the counted thread only. */
+	int64 Allocations;
+};
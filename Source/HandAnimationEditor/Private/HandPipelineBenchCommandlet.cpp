@@ -0,0 +1,487 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HandPipelineBenchCommandlet.h"
+
+#include "Dom/JsonObject.h"
+#include "FlexbuffersFunctionLibrary.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "HandBenchMalloc.h"
+#include "HandCoreJoints.h"
+#include "HandCoreText.h"
+#include "HandFKSolver.h"
+#include "HandPoseBuffer.h"
+#include "HandPoseFunctionLibrary.h"
+#include "Math/RandomStream.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/JsonSerializer.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogHandPipelineBench, Log, All);
+
+namespace
+{
+	enum EBenchStage
+	{
+		Stage_Glove,
+		Stage_Filter,
+		Stage_Decode,
+		Stage_Retarget,
+		Stage_FK,
+		Stage_Total,
+		NumBenchStages
+	};
+
+	const TCHAR* StageNames[NumBenchStages] = { TEXT("Glove"), TEXT("Filter"), TEXT("Decode"), TEXT("Retarget"), TEXT("FK"), TEXT("Total") };
+
+	constexpr int32 MaxHands = FHandPoseBuffer::MaxHands;
+	constexpr int32 NumSyntheticFrames = 240;
+	constexpr int32 NumWarmupFrames = 200;
+
+	/** Calibration and filter settings FTSDevice and FMollisenHANDModule start with. */
+	const float CalibrationMin[HandCore::NumJointSensors] = { 1814, 1638, 1123, 1017, 955, 872, 1232, 1041, 1369, 1003 };
+	const float CalibrationMax[HandCore::NumJointSensors] = { 2200, 1946, 1237, 1227, 1191, 1076, 1457, 1335, 1539, 1259 };
+	const float Sensitivity = 0.04f;
+	const float MaxJointDegree = 90.0f;
+
+	/** One recorded or synthetic frame; it drives both hands. */
+	struct FBenchFrame
+	{
+		float Raw[HandCore::NumJointSensors];
+		TArray<uint8> Payload[MaxHands];
+	};
+
+	/** 21 landmarks of a hand with every finger curled by Curl (0..1), MediaPipe order. */
+	void MakeLandmarks(bool bRightHand, const float Curl[5], FFingerPose& OutPose)
+	{
+		const float Side = bRightHand ? 1.0f : -1.0f;
+		TArray<FVector>* Fingers[] = { &OutPose.Thumb, &OutPose.Index, &OutPose.Middle, &OutPose.Ring, &OutPose.Pinky };
+
+		OutPose.hand = bRightHand ? TEXT("Right") : TEXT("Left");
+		OutPose.Palm = FVector::ZeroVector;
+
+		for (int32 Finger = 0; Finger < UE_ARRAY_COUNT(Fingers); ++Finger)
+		{
+			// The thumb starts at its CMC beside the palm, the fingers at their MCP across the top of it.
+			FVector Point = Finger == 0 ? FVector(0.3f, -0.35f * Side, 0.0f) : FVector(0.9f, (Finger - 2.5f) * 0.2f * Side, 0.0f);
+			const float Length = Finger == 0 ? 0.25f : 0.3f;
+
+			Fingers[Finger]->Reset(4);
+			Fingers[Finger]->Add(Point);
+			for (int32 Bone = 1; Bone < 4; ++Bone)
+			{
+				const float Angle = Curl[Finger] * Bone * HALF_PI / 3.0f;
+				Point += FVector(FMath::Cos(Angle), Finger == 0 ? -0.3f * Side : 0.0f, -FMath::Sin(Angle)).GetSafeNormal() * Length;
+				Fingers[Finger]->Add(Point);
+			}
+		}
+	}
+
+	void MakeSyntheticFrames(int32 Seed, TArray<FBenchFrame>& OutFrames)
+	{
+		FRandomStream Random(Seed);
+		OutFrames.SetNum(NumSyntheticFrames);
+
+		float Phase[HandCore::NumJointSensors];
+		for (float& Value : Phase)
+		{
+			Value = Random.FRandRange(0.0f, 2.0f * PI);
+		}
+
+		for (int32 Frame = 0; Frame < NumSyntheticFrames; ++Frame)
+		{
+			const float Time = Frame * 2.0f * PI / NumSyntheticFrames;
+			FBenchFrame& Out = OutFrames[Frame];
+
+			// Slow open/close cycles with a little sensor noise on top.
+			for (int32 Sensor = 0; Sensor < HandCore::NumJointSensors; ++Sensor)
+			{
+				const float Bend = 0.5f + 0.5f * FMath::Sin(Time * 3.0f + Phase[Sensor]);
+				Out.Raw[Sensor] = FMath::Lerp(CalibrationMin[Sensor], CalibrationMax[Sensor], Bend) + Random.FRandRange(-2.0f, 2.0f);
+			}
+
+			float Curl[5];
+			for (int32 Finger = 0; Finger < 5; ++Finger)
+			{
+				Curl[Finger] = 0.5f + 0.5f * FMath::Sin(Time * 2.0f + Phase[Finger * 2]) + Random.FRandRange(-0.01f, 0.01f);
+			}
+
+			FFingerPose Pose;
+			for (int32 Hand = 0; Hand < MaxHands; ++Hand)
+			{
+				MakeLandmarks(Hand == 1, Curl, Pose);
+				UFlexbuffersFunctionLibrary::EncodeFingerPose(Pose, Out.Payload[Hand]);
+			}
+		}
+	}
+
+	/** Replaces synthetic frames with the recorded halves found in File. */
+	bool LoadRecordedFrames(const FString& File, TArray<FBenchFrame>& InOutFrames)
+	{
+		TArray<FString> Lines;
+		if (!FFileHelper::LoadFileToStringArray(Lines, *File))
+		{
+			UE_LOG(LogHandPipelineBench, Error, TEXT("Could not read %s."), *File);
+			return false;
+		}
+
+		TArray<FBenchFrame> Synthetic = MoveTemp(InOutFrames);
+		InOutFrames.Reset(Lines.Num());
+
+		FFingerPose Pose;
+		for (const FString& Line : Lines)
+		{
+			FString Glove;
+			FString Landmarks;
+			if (!Line.Split(TEXT(";"), &Glove, &Landmarks))
+			{
+				continue;
+			}
+
+			FBenchFrame& Out = InOutFrames.Add_GetRef(Synthetic[InOutFrames.Num() % Synthetic.Num()]);
+
+			const FTCHARToUTF8 GloveUtf8(*Glove);
+			float Raw[HandCore::NumJointSensors];
+			if (HandCore::ParseFloatList(GloveUtf8.Get(), GloveUtf8.Length(), Raw, HandCore::NumJointSensors) == HandCore::NumJointSensors)
+			{
+				FMemory::Memcpy(Out.Raw, Raw, sizeof(Raw));
+			}
+
+			const FTCHARToUTF8 LandmarksUtf8(*Landmarks);
+			float Points[HandCore::NumLandmarks * 3];
+			if (HandCore::ParseFloatList(LandmarksUtf8.Get(), LandmarksUtf8.Length(), Points, UE_ARRAY_COUNT(Points)) == UE_ARRAY_COUNT(Points))
+			{
+				TArray<FVector>* Fingers[] = { &Pose.Thumb, &Pose.Index, &Pose.Middle, &Pose.Ring, &Pose.Pinky };
+				Pose.Palm = FVector(Points[0], Points[1], Points[2]);
+				for (int32 Finger = 0; Finger < UE_ARRAY_COUNT(Fingers); ++Finger)
+				{
+					Fingers[Finger]->Reset(4);
+					for (int32 Point = 0; Point < 4; ++Point)
+					{
+						const float* XYZ = &Points[(1 + Finger * 4 + Point) * 3];
+						Fingers[Finger]->Add(FVector(XYZ[0], XYZ[1], XYZ[2]));
+					}
+				}
+
+				for (int32 Hand = 0; Hand < MaxHands; ++Hand)
+				{
+					Pose.hand = Hand == 1 ? TEXT("Right") : TEXT("Left");
+					UFlexbuffersFunctionLibrary::EncodeFingerPose(Pose, Out.Payload[Hand]);
+				}
+			}
+		}
+
+		if (InOutFrames.Num() == 0)
+		{
+			UE_LOG(LogHandPipelineBench, Error, TEXT("%s has no frames."), *File);
+			return false;
+		}
+		return true;
+	}
+
+	/** Three-bone chains per finger with the bind pose of a generic hand, parent-first like FHandFKSolver::BuildRig. */
+	FHandFKRig MakeRig(bool bRightHand)
+	{
+		const float Side = bRightHand ? 1.0f : -1.0f;
+
+		FHandFKRig Rig;
+		for (int32 Finger = 0; Finger < 5; ++Finger)
+		{
+			for (int32 Bone = 0; Bone < 3; ++Bone)
+			{
+				const int32 Slot = Finger * 3 + Bone;
+				Rig.BoneIndices.Add(Slot);
+				Rig.ParentSlots.Add(Bone == 0 ? INDEX_NONE : Slot - 1);
+				Rig.JointIndices.Add(Slot);
+				Rig.BindLocal.Add(FTransform(FVector(0.0f, Bone == 0 ? 0.0f : 3.5f, 0.0f)));
+				Rig.ParentOffset.Add(Bone == 0 ? FTransform(FVector((Finger - 2) * 2.0f * Side, 9.0f, 0.0f)) : FTransform::Identity);
+				Rig.FlexAxes.Add(Finger == 0 ? FVector(0.0f, 0.0f, 1.0f) : FVector(1.0f, 0.0f, 0.0f));
+				Rig.BoneNames.Add(NAME_None);
+			}
+		}
+		Rig.DegreeScale = Side;
+		return Rig;
+	}
+
+	struct FRunSettings
+	{
+		int32 NumFrames = 20000;
+		float Rate = 0.0f;
+	};
+
+	/** Runs the pipeline over Frames and returns the JSON summary of the run. */
+	TSharedRef<FJsonObject> RunPipeline(const TArray<FBenchFrame>& Frames, const FRunSettings& Settings, const TMap<FString, double>& Budgets, bool& bOutPassed)
+	{
+		const FHandFKRig Rigs[MaxHands] = { MakeRig(false), MakeRig(true) };
+
+		float Values[MaxHands][HandCore::NumJointSensors];
+		float Previous[MaxHands][HandCore::NumJointSensors] = {};
+		float Degrees[MaxHands][HandCore::NumJointRatios];
+		TArray<FFingerPose> Poses;
+		Poses.SetNum(MaxHands);
+		FHandPoseBuffer LandmarkPose;
+		TArray<FTransform> Component;
+		Component.Reserve(FHandFKSolver::NumJoints);
+
+		// Every sample slot exists before counting starts, so recording does not show up as an allocation.
+		TArray<float> Samples[NumBenchStages];
+		for (TArray<float>& Stage : Samples)
+		{
+			Stage.SetNumUninitialized(Settings.NumFrames);
+		}
+		TArray<int32> FrameAllocations;
+		FrameAllocations.SetNumUninitialized(Settings.NumFrames);
+
+		int32 NumLate = 0;
+		const double FramePeriod = Settings.Rate > 0.0f ? 1.0 / Settings.Rate : 0.0;
+		const double MicrosecondsPerCycle = FPlatformTime::GetSecondsPerCycle64() * 1e6;
+
+		auto RunFrame = [&](int32 Index, uint64* OutCycles)
+		{
+			const FBenchFrame& Frame = Frames[Index % Frames.Num()];
+			uint64 Cycles = FPlatformTime::Cycles64();
+			auto Lap = [&](int32 Stage)
+			{
+				const uint64 Now = FPlatformTime::Cycles64();
+				if (OutCycles != nullptr)
+				{
+					OutCycles[Stage] = Now - Cycles;
+				}
+				Cycles = Now;
+			};
+
+			// What FTSDevice::GetData does with the SDK buffer.
+			for (int32 Hand = 0; Hand < MaxHands; ++Hand)
+			{
+				HandCore::Calibrate(Frame.Raw, CalibrationMin, CalibrationMax, HandCore::NumJointSensors, Values[Hand]);
+			}
+			Lap(Stage_Glove);
+
+			// FTSDevice::GetJointRatios and the degree range of FMollisenHANDModule::GetJointDegrees.
+			for (int32 Hand = 0; Hand < MaxHands; ++Hand)
+			{
+				HandCore::ApplyHysteresis(Values[Hand], Previous[Hand], HandCore::NumJointSensors, Sensitivity);
+				HandCore::ExpandJointRatios(Values[Hand], HandCore::NumJointSensors, Degrees[Hand], HandCore::NumJointRatios);
+				for (float& Degree : Degrees[Hand])
+				{
+					Degree *= MaxJointDegree;
+				}
+			}
+			Lap(Stage_Filter);
+
+			for (int32 Hand = 0; Hand < MaxHands; ++Hand)
+			{
+				UFlexbuffersFunctionLibrary::DecodeFingerPose(Frame.Payload[Hand], Poses[Hand]);
+			}
+			Lap(Stage_Decode);
+
+			UHandPoseFunctionLibrary::SubmitFingerPoses(Poses);
+			Lap(Stage_Retarget);
+
+			// Both sources of the Apply Glove Pose node, solved like the native FK path does.
+			FHandPoseBuffer::GetLatest(LandmarkPose);
+			for (int32 Hand = 0; Hand < MaxHands; ++Hand)
+			{
+				FHandFKSolver::Solve(Rigs[Hand], Degrees[Hand], HandCore::NumJointRatios, Component);
+				FHandFKSolver::Solve(Rigs[Hand], LandmarkPose.JointDegrees[Hand], FHandPoseBuffer::NumJoints, Component);
+			}
+			Lap(Stage_FK);
+		};
+
+		// Warm up caches, builder pools and array capacities outside the measurement.
+		for (int32 Index = 0; Index < NumWarmupFrames; ++Index)
+		{
+			RunFrame(Index, nullptr);
+		}
+
+		uint64 StageCycles[NumBenchStages];
+		const double StartTime = FPlatformTime::Seconds();
+		{
+			FHandBenchMalloc::BeginCounting();
+
+			for (int32 Index = 0; Index < Settings.NumFrames; ++Index)
+			{
+				if (FramePeriod > 0.0)
+				{
+					// Pacing happens before the frame starts and is not part of any stage.
+					const double Deadline = StartTime + Index * FramePeriod;
+					const double Wait = Deadline - FPlatformTime::Seconds();
+					if (Wait > 0.0)
+					{
+						FPlatformProcess::SleepNoStats((float)Wait);
+					}
+				}
+
+				const int64 AllocationsBefore = FHandBenchMalloc::GetAllocations();
+				RunFrame(Index, StageCycles);
+				FrameAllocations[Index] = (int32)(FHandBenchMalloc::GetAllocations() - AllocationsBefore);
+
+				uint64 TotalCycles = 0;
+				for (int32 Stage = 0; Stage < Stage_Total; ++Stage)
+				{
+					Samples[Stage][Index] = (float)(StageCycles[Stage] * MicrosecondsPerCycle);
+					TotalCycles += StageCycles[Stage];
+				}
+				Samples[Stage_Total][Index] = (float)(TotalCycles * MicrosecondsPerCycle);
+
+				if (FramePeriod > 0.0 && Samples[Stage_Total][Index] > FramePeriod * 1e6)
+				{
+					++NumLate;
+				}
+			}
+
+			FHandBenchMalloc::EndCounting();
+		}
+		const double Seconds = FPlatformTime::Seconds() - StartTime;
+
+		TSharedRef<FJsonObject> Run = MakeShared<FJsonObject>();
+		Run->SetNumberField(TEXT("rate"), Settings.Rate);
+		Run->SetNumberField(TEXT("frames"), Settings.NumFrames);
+		Run->SetNumberField(TEXT("seconds"), Seconds);
+		Run->SetNumberField(TEXT("framesPerSecond"), Seconds > 0.0 ? Settings.NumFrames / Seconds : 0.0);
+		Run->SetNumberField(TEXT("lateFrames"), NumLate);
+
+		// Left out rather than reported as zero when the process was started without -BenchAllocs.
+		if (FHandBenchMalloc::IsInstalled())
+		{
+			int64 TotalAllocations = 0;
+			int32 MaxAllocations = 0;
+			for (int32 Allocations : FrameAllocations)
+			{
+				TotalAllocations += Allocations;
+				MaxAllocations = FMath::Max(MaxAllocations, Allocations);
+			}
+			Run->SetNumberField(TEXT("allocationsPerFrame"), Settings.NumFrames > 0 ? (double)TotalAllocations / Settings.NumFrames : 0.0);
+			Run->SetNumberField(TEXT("maxAllocationsPerFrame"), MaxAllocations);
+		}
+
+		TSharedRef<FJsonObject> Stages = MakeShared<FJsonObject>();
+		TArray<TSharedPtr<FJsonValue>> OverBudget;
+		for (int32 Stage = 0; Stage < NumBenchStages; ++Stage)
+		{
+			TArray<float>& Sorted = Samples[Stage];
+			Sorted.Sort();
+			auto Percentile = [&Sorted](double P) { return Sorted.Num() > 0 ? Sorted[(int32)(P * (Sorted.Num() - 1))] : 0.0f; };
+
+			TSharedRef<FJsonObject> Summary = MakeShared<FJsonObject>();
+			Summary->SetNumberField(TEXT("p50Us"), Percentile(0.50));
+			Summary->SetNumberField(TEXT("p99Us"), Percentile(0.99));
+			Summary->SetNumberField(TEXT("maxUs"), Sorted.Num() > 0 ? Sorted.Last() : 0.0f);
+			Stages->SetObjectField(StageNames[Stage], Summary);
+
+			const double* Budget = Budgets.Find(StageNames[Stage]);
+			if (Budget != nullptr && Percentile(0.99) > *Budget)
+			{
+				OverBudget.Add(MakeShared<FJsonValueString>(StageNames[Stage]));
+				UE_LOG(LogHandPipelineBench, Error, TEXT("%s p99 %.1f us is over its %.1f us budget at rate %g."), StageNames[Stage], Percentile(0.99), *Budget, Settings.Rate);
+			}
+		}
+		Run->SetObjectField(TEXT("stages"), Stages);
+		Run->SetArrayField(TEXT("overBudget"), OverBudget);
+
+		bOutPassed = OverBudget.Num() == 0;
+		return Run;
+	}
+}
+
+UHandPipelineBenchCommandlet::UHandPipelineBenchCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UHandPipelineBenchCommandlet::Main(const FString& Params)
+{
+	const TCHAR* Cmd = *Params;
+
+	int32 NumFrames = 20000;
+	FParse::Value(Cmd, TEXT("frames="), NumFrames);
+	NumFrames = FMath::Max(NumFrames, 1);
+
+	int32 Seed = 1234;
+	FParse::Value(Cmd, TEXT("seed="), Seed);
+
+	TArray<float> Rates;
+	FString RatesList = TEXT("0,90");
+	FParse::Value(Cmd, TEXT("rates="), RatesList, false);
+	TArray<FString> RateStrings;
+	RatesList.ParseIntoArray(RateStrings, TEXT(","));
+	for (const FString& Rate : RateStrings)
+	{
+		Rates.Add(FMath::Max(FCString::Atof(*Rate), 0.0f));
+	}
+
+	TMap<FString, double> Budgets;
+	FString BudgetList;
+	if (FParse::Value(Cmd, TEXT("budget="), BudgetList, false))
+	{
+		TArray<FString> Entries;
+		BudgetList.ParseIntoArray(Entries, TEXT(","));
+		for (const FString& Entry : Entries)
+		{
+			FString Stage;
+			FString Microseconds;
+			if (Entry.Split(TEXT(":"), &Stage, &Microseconds))
+			{
+				Budgets.Add(Stage, FCString::Atod(*Microseconds));
+			}
+		}
+	}
+
+	TArray<FBenchFrame> Frames;
+	MakeSyntheticFrames(Seed, Frames);
+
+	FString InputFile;
+	if (FParse::Value(Cmd, TEXT("input="), InputFile) && !LoadRecordedFrames(InputFile, Frames))
+	{
+		return 1;
+	}
+
+	if (!FHandBenchMalloc::IsInstalled())
+	{
+		UE_LOG(LogHandPipelineBench, Display, TEXT("Allocations are not counted; pass -BenchAllocs to count them."));
+	}
+
+	TSharedRef<FJsonObject> Report = MakeShared<FJsonObject>();
+	Report->SetStringField(TEXT("source"), InputFile.IsEmpty() ? TEXT("synthetic") : *InputFile);
+	Report->SetNumberField(TEXT("sourceFrames"), Frames.Num());
+
+	bool bPassed = true;
+	TArray<TSharedPtr<FJsonValue>> Runs;
+	for (float Rate : Rates)
+	{
+		FRunSettings Settings;
+		Settings.NumFrames = NumFrames;
+		Settings.Rate = Rate;
+
+		UE_LOG(LogHandPipelineBench, Display, TEXT("Running %d frames at %s."), NumFrames, Rate > 0.0f ? *FString::Printf(TEXT("%g Hz"), Rate) : TEXT("max speed"));
+
+		bool bRunPassed = true;
+		Runs.Add(MakeShared<FJsonValueObject>(RunPipeline(Frames, Settings, Budgets, bRunPassed)));
+		bPassed &= bRunPassed;
+	}
+	Report->SetArrayField(TEXT("runs"), Runs);
+	Report->SetBoolField(TEXT("passed"), bPassed);
+
+	FString Json;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+	FJsonSerializer::Serialize(Report, Writer);
+
+	FString OutputFile;
+	if (FParse::Value(Cmd, TEXT("output="), OutputFile))
+	{
+		if (!FFileHelper::SaveStringToFile(Json, *OutputFile))
+		{
+			UE_LOG(LogHandPipelineBench, Error, TEXT("Could not write %s."), *OutputFile);
+			return 1;
+		}
+		UE_LOG(LogHandPipelineBench, Display, TEXT("Report written to %s."), *OutputFile);
+	}
+	else
+	{
+		UE_LOG(LogHandPipelineBench, Display, TEXT("%s"), *Json);
+	}
+
+	return bPassed ? 0 : 1;
+}
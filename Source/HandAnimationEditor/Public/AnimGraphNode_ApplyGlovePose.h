@@ -0,0 +1,28 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AnimGraphNode_Base.h"
+#include "AnimNode_ApplyGlovePose.h"
+#include "AnimGraphNode_ApplyGlovePose.generated.h"
+
+UCLASS()
+class HANDANIMATIONEDITOR_API UAnimGraphNode_ApplyGlovePose : public UAnimGraphNode_Base
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, Category = Settings)
+	FAnimNode_ApplyGlovePose Node;
+
+public:
+	// UEdGraphNode interface
+	virtual FText GetNodeTitle(ENodeTitleType::Type TitleType) const override;
+	virtual FText GetTooltipText() const override;
+	virtual FLinearColor GetNodeTitleColor() const override;
+	// End of UEdGraphNode interface
+
+	// UAnimGraphNode_Base interface
+	virtual FString GetNodeCategory() const override;
+	// End of UAnimGraphNode_Base interface
+};
@@ -0,0 +1,37 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "HandPipelineBenchCommandlet.generated.h"
+
+/**
+ * Drives the glove and MQTT landmark pipelines frame by frame without rendering and reports throughput,
+ * per-stage p50/p99 latency and allocations per frame as JSON.
+ *
+ * UE4Editor-Cmd UE4IKTest -run=HandPipelineBench -nullrhi [options]
+ *
+ *   -frames=N        Frames per run (default 20000).
+ *   -rates=0,60,120  Frame rates to run at; 0 runs at max speed (default 0,90).
+ *   -input=File      Recorded frames, one per line: "10 raw glove sensor values;63 landmark coordinates" in the
+ *                    comma separated format of the hand messages. Either half may be empty. Synthetic data otherwise.
+ *   -seed=N          Seed of the synthetic data (default 1234).
+ *   -output=File     Writes the report there instead of the log.
+ *   -budget=Stage:Us,...
+ *                    p99 budgets in microseconds, e.g. "Total:500,FK:80". Any run over budget fails the commandlet.
+ *   -BenchAllocs     Counts allocations per frame. Installs a counting allocator when the editor module starts, so it
+ *                    must be on the process command line; without it the report has no allocation fields.
+ */
+UCLASS()
+class HANDANIMATIONEDITOR_API UHandPipelineBenchCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UHandPipelineBenchCommandlet();
+
+	// UCommandlet interface
+	virtual int32 Main(const FString& Params) override;
+	// End of UCommandlet interface
+};
@@ -9,6 +9,6 @@ public class UE4IKTestTarget : TargetRules
 	{
 		Type = TargetType.Game;
 
-		ExtraModuleNames.AddRange( new string[] { "UE4IKTest" } );
+		ExtraModuleNames.AddRange( new string[] { "UE4IKTest", "HandAnimation" } );
 	}
 }
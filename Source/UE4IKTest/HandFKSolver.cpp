@@ -0,0 +1,158 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HandFKSolver.h"
+
+#include "Components/SkinnedMeshComponent.h"
+#include "Engine/SkeletalMesh.h"
+
+FHandFKRigDesc FHandFKSolver::GetDefaultRigDesc(EHandFKSkeleton Skeleton, bool bRightHand)
+{
+	static const TCHAR* Fingers[] = { TEXT("thumb"), TEXT("index"), TEXT("middle"), TEXT("ring"), TEXT("pinky") };
+	static const TCHAR* RealFingers[] = { TEXT("Thumb"), TEXT("Index"), TEXT("Middle"), TEXT("Ring"), TEXT("Pinky") };
+
+	FHandFKRigDesc Desc;
+	Desc.BoneNames.Reserve(NumJoints);
+
+	switch (Skeleton)
+	{
+	case EHandFKSkeleton::RiggedHand:
+	{
+		const TCHAR* Side = bRightHand ? TEXT("R") : TEXT("L");
+		for (int32 Finger = 0; Finger < UE_ARRAY_COUNT(Fingers); ++Finger)
+		{
+			for (int32 Joint = 1; Joint <= 3; ++Joint)
+			{
+				Desc.BoneNames.Add(Finger == 0
+					? FName(*FString::Printf(TEXT("thumb_%02d_%s"), Joint, Side))
+					: FName(*FString::Printf(TEXT("finger_%s_%02d_%s"), Fingers[Finger], Joint, Side)));
+			}
+		}
+		Desc.FlexAxis = FVector(1.0f, 0.0f, 0.0f);
+		Desc.ThumbFlexAxis = FVector(0.0f, 0.0f, 1.0f);
+		break;
+	}
+	case EHandFKSkeleton::RealHand:
+	{
+		for (int32 Finger = 0; Finger < UE_ARRAY_COUNT(RealFingers); ++Finger)
+		{
+			for (int32 Joint = 1; Joint <= 3; ++Joint)
+			{
+				Desc.BoneNames.Add(FName(*FString::Printf(TEXT("Bone_Finger_%s_%02d"), RealFingers[Finger], Joint)));
+			}
+		}
+		Desc.FlexAxis = FVector(0.0f, 0.0f, 1.0f);
+		Desc.ThumbFlexAxis = FVector(0.0f, 1.0f, 0.0f);
+		Desc.DegreeScale = bRightHand ? 1.0f : -1.0f;
+		break;
+	}
+	}
+
+	return Desc;
+}
+
+bool FHandFKSolver::BuildRig(const USkinnedMeshComponent* Mesh, const FHandFKRigDesc& Desc, FHandFKRig& OutRig)
+{
+	OutRig = FHandFKRig();
+
+	if (Mesh == nullptr || Mesh->SkeletalMesh == nullptr)
+	{
+		return false;
+	}
+
+	const FReferenceSkeleton& RefSkeleton = Mesh->SkeletalMesh->GetRefSkeleton();
+	const TArray<FTransform>& RefPose = RefSkeleton.GetRefBonePose();
+
+	// The reference skeleton is stored parent-first, so one pass gives the component-space bind pose.
+	TArray<FTransform> ComponentBind;
+	ComponentBind.SetNum(RefPose.Num());
+	for (int32 BoneIndex = 0; BoneIndex < RefPose.Num(); ++BoneIndex)
+	{
+		const int32 ParentIndex = RefSkeleton.GetParentIndex(BoneIndex);
+		ComponentBind[BoneIndex] = ParentIndex == INDEX_NONE ? RefPose[BoneIndex] : RefPose[BoneIndex] * ComponentBind[ParentIndex];
+	}
+
+	// Collect the driven bones and sort them by bone index, which keeps parents ahead of children.
+	TArray<TPair<int32, int32>> Driven;
+	for (int32 Joint = 0; Joint < Desc.BoneNames.Num() && Joint < NumJoints; ++Joint)
+	{
+		const int32 BoneIndex = RefSkeleton.FindBoneIndex(Desc.BoneNames[Joint]);
+		if (BoneIndex != INDEX_NONE)
+		{
+			Driven.Emplace(BoneIndex, Joint);
+		}
+		else
+		{
+			UE_LOG(LogTemp, Verbose, TEXT("[HandFK] Bone %s not found in %s."), *Desc.BoneNames[Joint].ToString(), *Mesh->SkeletalMesh->GetName());
+		}
+	}
+	Driven.Sort([](const TPair<int32, int32>& A, const TPair<int32, int32>& B) { return A.Key < B.Key; });
+
+	const FVector FlexAxis = Desc.FlexAxis.GetSafeNormal(SMALL_NUMBER, FVector(1.0f, 0.0f, 0.0f));
+	const FVector ThumbFlexAxis = Desc.ThumbFlexAxis.GetSafeNormal(SMALL_NUMBER, FVector(0.0f, 0.0f, 1.0f));
+
+	for (const TPair<int32, int32>& Entry : Driven)
+	{
+		const int32 BoneIndex = Entry.Key;
+		const int32 Joint = Entry.Value;
+
+		// Find the closest driven ancestor; anything in between is folded into ParentOffset.
+		int32 ParentSlot = INDEX_NONE;
+		const int32 ParentBone = RefSkeleton.GetParentIndex(BoneIndex);
+		for (int32 Ancestor = ParentBone; Ancestor != INDEX_NONE && ParentSlot == INDEX_NONE; Ancestor = RefSkeleton.GetParentIndex(Ancestor))
+		{
+			ParentSlot = OutRig.BoneIndices.IndexOfByKey(Ancestor);
+		}
+
+		FTransform ParentOffset = FTransform::Identity;
+		if (ParentBone != INDEX_NONE)
+		{
+			ParentOffset = ParentSlot == INDEX_NONE
+				? ComponentBind[ParentBone]
+				: ComponentBind[ParentBone].GetRelativeTransform(ComponentBind[OutRig.BoneIndices[ParentSlot]]);
+		}
+
+		OutRig.BoneIndices.Add(BoneIndex);
+		OutRig.ParentSlots.Add(ParentSlot);
+		OutRig.JointIndices.Add(Joint);
+		OutRig.BindLocal.Add(RefPose[BoneIndex]);
+		OutRig.ParentOffset.Add(ParentOffset);
+		OutRig.FlexAxes.Add(Joint < 3 ? ThumbFlexAxis : FlexAxis);
+		OutRig.BoneNames.Add(Desc.BoneNames[Joint]);
+	}
+
+	OutRig.DegreeScale = Desc.DegreeScale;
+
+	return OutRig.IsValid();
+}
+
+void FHandFKSolver::Solve(const FHandFKRig& Rig, const float* JointDegrees, int32 NumDegrees, TArray<FTransform>& OutComponent, TArray<FTransform>* OutLocal)
+{
+	const int32 NumSlots = Rig.Num();
+
+	OutComponent.SetNumUninitialized(NumSlots, false);
+	if (OutLocal != nullptr)
+	{
+		OutLocal->SetNumUninitialized(NumSlots, false);
+	}
+
+	for (int32 Slot = 0; Slot < NumSlots; ++Slot)
+	{
+		const int32 Joint = Rig.JointIndices[Slot];
+		const float Degree = Joint < NumDegrees ? JointDegrees[Joint] * Rig.DegreeScale : 0.0f;
+
+		// Bend in the bone's own frame: the flex rotation is applied before the bind rotation.
+		const FTransform& Bind = Rig.BindLocal[Slot];
+		const FQuat Flex(Rig.FlexAxes[Slot], FMath::DegreesToRadians(Degree));
+		const FTransform Local(Bind.GetRotation() * Flex, Bind.GetTranslation(), Bind.GetScale3D());
+
+		const int32 ParentSlot = Rig.ParentSlots[Slot];
+		OutComponent[Slot] = ParentSlot == INDEX_NONE
+			? Local * Rig.ParentOffset[Slot]
+			: Local * Rig.ParentOffset[Slot] * OutComponent[ParentSlot];
+
+		if (OutLocal != nullptr)
+		{
+			(*OutLocal)[Slot] = Local;
+		}
+	}
+}
@@ -0,0 +1,110 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HandFKSolver.generated.h"
+
+class USkinnedMeshComponent;
+
+/** Hand skeletons shipped with the project. */
+UENUM(BlueprintType)
+enum class EHandFKSkeleton : uint8
+{
+	RiggedHand	UMETA(DisplayName = "Rigged_Hand"),
+	RealHand	UMETA(DisplayName = "Real_Hand"),
+};
+
+/**
+ * Bone names and bend axes describing how the 15 glove joints map onto a skeleton.
+ * BoneNames is ordered like EJointType (ThumbCMC .. PinkyDIP).
+ */
+USTRUCT(BlueprintType)
+struct UE4IKTEST_API FHandFKRigDesc
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "HandFK")
+	TArray<FName> BoneNames;
+
+	/** Bone-local axis the fingers curl around. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "HandFK")
+	FVector FlexAxis = FVector(1.0f, 0.0f, 0.0f);
+
+	/** Bone-local axis the thumb curls around (the thumb is rotated against the palm). */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "HandFK")
+	FVector ThumbFlexAxis = FVector(0.0f, 0.0f, 1.0f);
+
+	/** Multiplier applied to every degree value, use -1 to mirror the bend direction. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "HandFK")
+	float DegreeScale = 1.0f;
+};
+
+/**
+ * Precomputed bind-pose data for one hand, built once per mesh by UMyBlueprintFunctionLibrary::MakeHandFKRig.
+ * Slots are stored parent-first so the solver can compose component-space transforms in a single forward pass.
+ */
+USTRUCT(BlueprintType)
+struct UE4IKTEST_API FHandFKRig
+{
+	GENERATED_BODY()
+
+	/** Reference-skeleton bone index per slot. */
+	UPROPERTY()
+	TArray<int32> BoneIndices;
+
+	/** Slot index of the parent bone, or INDEX_NONE when the parent is not driven by the solver. */
+	UPROPERTY()
+	TArray<int32> ParentSlots;
+
+	/** Joint (EJointType) index driving each slot. */
+	UPROPERTY()
+	TArray<int32> JointIndices;
+
+	/** Local bind pose of every slot. */
+	UPROPERTY()
+	TArray<FTransform> BindLocal;
+
+	/**
+	 * Bind transform of the real parent bone relative to the parent slot, or in component space for root slots.
+	 * Identity when the parent bone is itself a slot; folds in bones the solver does not drive.
+	 */
+	UPROPERTY()
+	TArray<FTransform> ParentOffset;
+
+	/** Normalized bend axis per slot, in bone space. */
+	UPROPERTY()
+	TArray<FVector> FlexAxes;
+
+	/** Bone names per slot, kept for components that address bones by name. */
+	UPROPERTY()
+	TArray<FName> BoneNames;
+
+	UPROPERTY()
+	float DegreeScale = 1.0f;
+
+	int32 Num() const { return BoneIndices.Num(); }
+	bool IsValid() const { return BoneIndices.Num() > 0; }
+};
+
+/**
+ * Forward kinematics for the glove driven finger chains.
+ */
+class UE4IKTEST_API FHandFKSolver
+{
+public:
+	/** Number of finger joints driven by the glove (matches EJointType in MollisenHAND). */
+	static constexpr int32 NumJoints = 15;
+
+	/** Default joint-to-bone mapping for one of the project skeletons. */
+	static FHandFKRigDesc GetDefaultRigDesc(EHandFKSkeleton Skeleton, bool bRightHand);
+
+	/** Resolves bone indices and caches the bind pose of Mesh for Desc. Joints whose bone is missing are skipped. */
+	static bool BuildRig(const USkinnedMeshComponent* Mesh, const FHandFKRigDesc& Desc, FHandFKRig& OutRig);
+
+	/**
+	 * Converts joint degrees (EJointType order) into component-space transforms, one per rig slot.
+	 * OutComponent is resized to Rig.Num(); OutLocal is optional and receives the posed local transforms.
+	 */
+	static void Solve(const FHandFKRig& Rig, const float* JointDegrees, int32 NumDegrees, TArray<FTransform>& OutComponent, TArray<FTransform>* OutLocal = nullptr);
+};
@@ -0,0 +1,428 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "IKBatchSubsystem.h"
+
+#include "Async/ParallelFor.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "HAL/IConsoleManager.h"
+#include "Stats/Stats.h"
+
+DECLARE_CYCLE_STAT(TEXT("IK Batch Solve"), STAT_IKBatchSolve, STATGROUP_Anim);
+
+static TAutoConsoleVariable<int32> CVarIKBatchParallel(
+	TEXT("IK.Batch.Parallel"),
+	1,
+	TEXT("Solve IK batches with ParallelFor (1) or on the game thread (0)."));
+
+static TAutoConsoleVariable<int32> CVarIKBatchGroupsPerTask(
+	TEXT("IK.Batch.GroupsPerTask"),
+	8,
+	TEXT("SIMD groups of four chains handed to each ParallelFor task. Larger runs keep a task on contiguous memory."));
+
+/** Batch shapes a world is expected to use; readers index Batches during the tick, so it must not reallocate then. */
+static constexpr int32 IKBatchReservedShapes = 16;
+
+void FIKBatchSolveTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Subsystem != nullptr && Subsystem->GetNumChains() > 0)
+	{
+		Subsystem->SolveAll();
+	}
+}
+
+FString FIKBatchSolveTickFunction::DiagnosticMessage()
+{
+	return TEXT("FIKBatchSolveTickFunction");
+}
+
+void UIKBatchSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Batches.Reserve(IKBatchReservedShapes);
+
+	SolveTickFunction.TickGroup = TG_PrePhysics;
+	SolveTickFunction.bCanEverTick = true;
+	SolveTickFunction.bStartWithTickEnabled = true;
+	SolveTickFunction.bRunOnAnyThread = false;
+	SolveTickFunction.Subsystem = this;
+	RegisterSolveTick();
+
+	PreActorTickHandle = FWorldDelegates::OnWorldPreActorTick.AddUObject(this, &UIKBatchSubsystem::OnWorldPreActorTick);
+}
+
+void UIKBatchSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldPreActorTick.Remove(PreActorTickHandle);
+
+	// Components outliving the subsystem must not keep a prerequisite on a tick function that is going away.
+	for (const TWeakObjectPtr<UActorComponent>& AnimComponent : AnimComponents)
+	{
+		if (AnimComponent.IsValid())
+		{
+			AnimComponent->PrimaryComponentTick.RemovePrerequisite(this, SolveTickFunction);
+		}
+	}
+	AnimComponents.Empty();
+
+	if (SolveTickFunction.IsTickFunctionRegistered())
+	{
+		SolveTickFunction.UnRegisterTickFunction();
+	}
+	SolveTickFunction.Subsystem = nullptr;
+
+	Batches.Empty();
+	NumChains = 0;
+
+	Super::Deinitialize();
+}
+
+FIKChainHandle UIKBatchSubsystem::RegisterChain(const TArray<FVector>& RestPose, float MaxBendDegrees)
+{
+	check(IsInGameThread());
+
+	FIKChainHandle Handle;
+	if (RestPose.Num() < 2)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("IKBatch] A chain needs at least two joints."));
+		return Handle;
+	}
+
+	RegisterSolveTick();
+
+	Handle.Batch = FindOrAddBatch(RestPose.Num(), MaxBendDegrees);
+	FIKChainBatch& Batch = *Batches[Handle.Batch];
+
+	if (!IsWorldTicking())
+	{
+		AddPendingChains(Batch);
+	}
+
+	if (Batch.FreeSlots.Num() == 0)
+	{
+		if (IsWorldTicking())
+		{
+			// Solver arrays may be read by other threads until the frame ends; take the slot past the last pending one.
+			Handle.Slot = Batch.Used.Num();
+			while (Batch.PendingSlots.Contains(Handle.Slot))
+			{
+				++Handle.Slot;
+			}
+			Batch.PendingSlots.Add(Handle.Slot);
+			Batch.PendingRestPoses.Append(RestPose);
+
+			++NumChains;
+			return Handle;
+		}
+
+		GrowBatch(Batch, Batch.Used.Num() + 1);
+	}
+
+	Handle.Slot = Batch.FreeSlots.Pop(false);
+	Batch.Used[Handle.Slot] = true;
+	FMemory::Memcpy(&Batch.RestPoses[Handle.Slot * Batch.NumJoints], RestPose.GetData(), Batch.NumJoints * sizeof(FVector));
+	Batch.Solver.SetChain(Handle.Slot, RestPose.GetData());
+
+	++NumChains;
+	return Handle;
+}
+
+void UIKBatchSubsystem::UnregisterChain(FIKChainHandle& Handle)
+{
+	check(IsInGameThread());
+
+	if (IsLive(Handle))
+	{
+		FIKChainBatch& Batch = *Batches[Handle.Batch];
+		Batch.Used[Handle.Slot] = false;
+		Batch.FreeSlots.Add(Handle.Slot);
+		ParkSlot(Batch, Handle.Slot);
+		--NumChains;
+	}
+	else if (Batches.IsValidIndex(Handle.Batch))
+	{
+		FIKChainBatch& Batch = *Batches[Handle.Batch];
+		const int32 Pending = Batch.PendingSlots.Find(Handle.Slot);
+		if (Pending != INDEX_NONE)
+		{
+			Batch.PendingSlots.RemoveAt(Pending, 1, false);
+			Batch.PendingRestPoses.RemoveAt(Pending * Batch.NumJoints, Batch.NumJoints, false);
+			--NumChains;
+		}
+	}
+
+	Handle = FIKChainHandle();
+}
+
+void UIKBatchSubsystem::ReserveChains(int32 NumJoints, int32 Count, float MaxBendDegrees)
+{
+	check(IsInGameThread());
+
+	if (NumJoints < 2 || Count <= 0)
+	{
+		return;
+	}
+
+	FIKChainBatch& Batch = *Batches[FindOrAddBatch(NumJoints, MaxBendDegrees)];
+	const int32 Capacity = Batch.Used.Num() - Batch.FreeSlots.Num() + Batch.PendingSlots.Num() + Count;
+
+	if (IsWorldTicking())
+	{
+		Batch.PendingCapacity = FMath::Max(Batch.PendingCapacity, Capacity);
+		return;
+	}
+
+	AddPendingChains(Batch);
+	if (Capacity > Batch.Used.Num())
+	{
+		GrowBatch(Batch, Capacity);
+	}
+}
+
+void UIKBatchSubsystem::AddAnimComponent(UActorComponent* AnimComponent)
+{
+	check(IsInGameThread());
+
+	if (AnimComponent == nullptr || AnimComponents.Contains(AnimComponent))
+	{
+		return;
+	}
+
+	RegisterSolveTick();
+
+	if (AActor* Owner = AnimComponent->GetOwner())
+	{
+		SolveTickFunction.AddPrerequisite(Owner, Owner->PrimaryActorTick);
+	}
+	AnimComponent->PrimaryComponentTick.AddPrerequisite(this, SolveTickFunction);
+	AnimComponents.Add(AnimComponent);
+}
+
+void UIKBatchSubsystem::RemoveAnimComponent(UActorComponent* AnimComponent)
+{
+	check(IsInGameThread());
+
+	if (AnimComponent == nullptr || AnimComponents.Remove(AnimComponent) == 0)
+	{
+		return;
+	}
+
+	AnimComponent->PrimaryComponentTick.RemovePrerequisite(this, SolveTickFunction);
+
+	// Other components of the same actor still need the solve to wait for it.
+	AActor* Owner = AnimComponent->GetOwner();
+	const bool bOwnerStillUsed = AnimComponents.ContainsByPredicate([Owner](const TWeakObjectPtr<UActorComponent>& Other)
+	{
+		return Other.IsValid() && Other->GetOwner() == Owner;
+	});
+	if (Owner != nullptr && !bOwnerStillUsed)
+	{
+		SolveTickFunction.RemovePrerequisite(Owner, Owner->PrimaryActorTick);
+	}
+}
+
+void UIKBatchSubsystem::SetChainTarget(const FIKChainHandle& Handle, const FVector& Root, const FVector& Target)
+{
+	if (IsLive(Handle))
+	{
+		FMultiChainIKSolver& Solver = Batches[Handle.Batch]->Solver;
+		Solver.SetRoot(Handle.Slot, Root);
+		Solver.SetTarget(Handle.Slot, Target);
+	}
+}
+
+bool UIKBatchSubsystem::GetChainResult(const FIKChainHandle& Handle, TArray<FVector>& Joints) const
+{
+	if (!IsLive(Handle))
+	{
+		return false;
+	}
+
+	const FIKChainBatch& Batch = *Batches[Handle.Batch];
+	Joints.SetNumUninitialized(Batch.NumJoints, false);
+	Batch.Solver.GetChain(Handle.Slot, Joints.GetData());
+	return true;
+}
+
+void UIKBatchSubsystem::SolveAll()
+{
+	SCOPE_CYCLE_COUNTER(STAT_IKBatchSolve);
+
+	struct FWorkItem
+	{
+		FMultiChainIKSolver* Solver;
+		int32 FirstGroup;
+		int32 NumGroups;
+		FIKSolveStats Stats;
+	};
+
+	// Cut every batch into runs of consecutive groups, so each task walks one contiguous block of lanes.
+	const int32 GroupsPerTask = FMath::Max(1, CVarIKBatchGroupsPerTask.GetValueOnGameThread());
+	TArray<FWorkItem, TInlineAllocator<32>> Items;
+	for (const TUniquePtr<FIKChainBatch>& Batch : Batches)
+	{
+		const int32 NumGroups = Batch->Solver.GetNumGroups();
+		for (int32 FirstGroup = 0; FirstGroup < NumGroups; FirstGroup += GroupsPerTask)
+		{
+			Items.Add({ &Batch->Solver, FirstGroup, FMath::Min(GroupsPerTask, NumGroups - FirstGroup), FIKSolveStats() });
+		}
+	}
+
+	const FIKSolveSettings SolveSettings = Settings;
+	ParallelFor(Items.Num(), [&Items, &SolveSettings](int32 Index)
+	{
+		FWorkItem& Item = Items[Index];
+		Item.Stats = Item.Solver->SolveGroups(Item.FirstGroup, Item.NumGroups, SolveSettings);
+	}, CVarIKBatchParallel.GetValueOnGameThread() == 0);
+
+	// Mean error is weighted by chain count; parked slots have zero error and are included, like in the solver stats.
+	LastStats = FIKSolveStats();
+	int32 NumLanes = 0;
+	for (const FWorkItem& Item : Items)
+	{
+		const int32 ItemLanes = FMath::Min(Item.NumGroups * FMultiChainIKSolver::LaneCount, Item.Solver->GetNumChains() - Item.FirstGroup * FMultiChainIKSolver::LaneCount);
+		LastStats.Iterations += Item.Stats.Iterations;
+		LastStats.MeanError += Item.Stats.MeanError * ItemLanes;
+		LastStats.MaxError = FMath::Max(LastStats.MaxError, Item.Stats.MaxError);
+		NumLanes += ItemLanes;
+	}
+	LastStats.MeanError = NumLanes > 0 ? LastStats.MeanError / NumLanes : 0.0f;
+}
+
+void UIKBatchSubsystem::OnWorldPreActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds)
+{
+	if (InWorld != GetWorld())
+	{
+		return;
+	}
+
+	RegisterSolveTick();
+
+	// No tick function has run yet this frame, so nothing reads the solvers while they grow.
+	for (const TUniquePtr<FIKChainBatch>& Batch : Batches)
+	{
+		AddPendingChains(*Batch);
+	}
+}
+
+void UIKBatchSubsystem::RegisterSolveTick()
+{
+	UWorld* World = GetWorld();
+	if (!SolveTickFunction.IsTickFunctionRegistered() && World != nullptr && World->PersistentLevel != nullptr)
+	{
+		SolveTickFunction.RegisterTickFunction(World->PersistentLevel);
+	}
+}
+
+bool UIKBatchSubsystem::IsWorldTicking() const
+{
+	const UWorld* World = GetWorld();
+	return World != nullptr && World->bInTick;
+}
+
+bool UIKBatchSubsystem::IsLive(const FIKChainHandle& Handle) const
+{
+	return Batches.IsValidIndex(Handle.Batch) && Batches[Handle.Batch]->Used.IsValidIndex(Handle.Slot) && Batches[Handle.Batch]->Used[Handle.Slot];
+}
+
+int32 UIKBatchSubsystem::FindOrAddBatch(int32 NumJoints, float MaxBendDegrees)
+{
+	MaxBendDegrees = MaxBendDegrees < 0.0f ? -1.0f : MaxBendDegrees;
+
+	const int32 Existing = Batches.IndexOfByPredicate([NumJoints, MaxBendDegrees](const TUniquePtr<FIKChainBatch>& Batch)
+	{
+		return Batch->NumJoints == NumJoints && FMath::IsNearlyEqual(Batch->MaxBendDegrees, MaxBendDegrees);
+	});
+	if (Existing != INDEX_NONE)
+	{
+		return Existing;
+	}
+
+	ensureMsgf(!IsWorldTicking() || Batches.Num() < Batches.Max(), TEXT("IK batch shape added during the tick reallocates the batch list; register it before the world ticks."));
+
+	TUniquePtr<FIKChainBatch> Batch = MakeUnique<FIKChainBatch>();
+	Batch->NumJoints = NumJoints;
+	Batch->MaxBendDegrees = MaxBendDegrees;
+	return Batches.Add(MoveTemp(Batch));
+}
+
+void UIKBatchSubsystem::GrowBatch(FIKChainBatch& Batch, int32 MinCapacity)
+{
+	check(IsInGameThread());
+
+	const int32 OldCapacity = Batch.Used.Num();
+	int32 NewCapacity = FMath::Max(OldCapacity * 2, FMultiChainIKSolver::LaneCount * 4);
+	while (NewCapacity < MinCapacity)
+	{
+		NewCapacity *= 2;
+	}
+
+	// Resize keeps every chain mid-solve where it is; only a new batch starts from Init.
+	if (OldCapacity == 0)
+	{
+		Batch.Solver.Init(NewCapacity, Batch.NumJoints);
+		for (int32 Joint = 1; Joint < Batch.NumJoints - 1; ++Joint)
+		{
+			Batch.Solver.SetJointLimit(Joint, Batch.MaxBendDegrees);
+		}
+	}
+	else
+	{
+		Batch.Solver.Resize(NewCapacity);
+	}
+
+	Batch.RestPoses.SetNumZeroed(NewCapacity * Batch.NumJoints);
+	Batch.Used.SetNumZeroed(NewCapacity);
+
+	// Hand out low slots first so live chains stay packed at the front of the batch.
+	TArray<int32> FreeSlots;
+	FreeSlots.Reserve(NewCapacity - OldCapacity + Batch.FreeSlots.Num());
+	for (int32 Slot = NewCapacity - 1; Slot >= OldCapacity; --Slot)
+	{
+		ParkSlot(Batch, Slot);
+		FreeSlots.Add(Slot);
+	}
+	FreeSlots.Append(Batch.FreeSlots);
+	Batch.FreeSlots = MoveTemp(FreeSlots);
+}
+
+void UIKBatchSubsystem::AddPendingChains(FIKChainBatch& Batch)
+{
+	int32 MinCapacity = Batch.PendingCapacity;
+	for (int32 Slot : Batch.PendingSlots)
+	{
+		MinCapacity = FMath::Max(MinCapacity, Slot + 1);
+	}
+	Batch.PendingCapacity = 0;
+
+	if (MinCapacity > Batch.Used.Num())
+	{
+		GrowBatch(Batch, MinCapacity);
+	}
+
+	for (int32 Index = 0; Index < Batch.PendingSlots.Num(); ++Index)
+	{
+		const int32 Slot = Batch.PendingSlots[Index];
+		const FVector* RestPose = &Batch.PendingRestPoses[Index * Batch.NumJoints];
+
+		Batch.FreeSlots.RemoveSingle(Slot);
+		Batch.Used[Slot] = true;
+		FMemory::Memcpy(&Batch.RestPoses[Slot * Batch.NumJoints], RestPose, Batch.NumJoints * sizeof(FVector));
+		Batch.Solver.SetChain(Slot, RestPose);
+	}
+
+	Batch.PendingSlots.Reset();
+	Batch.PendingRestPoses.Reset();
+}
+
+void UIKBatchSubsystem::ParkSlot(FIKChainBatch& Batch, int32 Slot)
+{
+	TArray<FVector, TInlineAllocator<16>> Straight;
+	for (int32 Joint = 0; Joint < Batch.NumJoints; ++Joint)
+	{
+		Straight.Add(FVector(Joint, 0.0f, 0.0f));
+	}
+	Batch.Solver.SetChain(Slot, Straight.GetData());
+}
@@ -0,0 +1,165 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Components/ActorComponent.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "MultiChainIKSolver.h"
+#include "IKBatchSubsystem.generated.h"
+
+/** Identifies a chain registered with UIKBatchSubsystem. */
+USTRUCT(BlueprintType)
+struct UE4IKTEST_API FIKChainHandle
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	int32 Batch = INDEX_NONE;
+
+	UPROPERTY()
+	int32 Slot = INDEX_NONE;
+
+	bool IsValid() const { return Batch != INDEX_NONE && Slot != INDEX_NONE; }
+};
+
+/** All chains sharing a joint count and bend limit, solved together by one FMultiChainIKSolver. */
+struct FIKChainBatch
+{
+	int32 NumJoints = 0;
+	float MaxBendDegrees = -1.0f;
+
+	FMultiChainIKSolver Solver;
+
+	/** Rest pose per slot, NumJoints entries each. */
+	TArray<FVector> RestPoses;
+	TArray<bool> Used;
+	TArray<int32> FreeSlots;
+
+	/** Chains registered while the world ticked and the batch was full; they get their slots at the next frame start. */
+	TArray<int32> PendingSlots;
+	TArray<FVector> PendingRestPoses;
+
+	/** Capacity asked for by ReserveChains while the world ticked. */
+	int32 PendingCapacity = 0;
+};
+
+class UIKBatchSubsystem;
+
+/** Solves every batch of a UIKBatchSubsystem once per frame, ordered by the prerequisites AddAnimComponent sets up. */
+USTRUCT()
+struct FIKBatchSolveTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	UIKBatchSubsystem* Subsystem = nullptr;
+
+	// FTickFunction interface
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+	// End of FTickFunction interface
+};
+
+template<>
+struct TStructOpsTypeTraits<FIKBatchSolveTickFunction> : public TStructOpsTypeTraitsBase2<FIKBatchSolveTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
+/**
+ * Collects the IK chains of every character in the world and solves them together once per frame.
+ *
+ * Chains with the same joint count and limit share a batch, batches are cut into runs of SIMD groups and the runs are
+ * solved with ParallelFor by a TG_PrePhysics tick function. AddAnimComponent orders that solve after the tick of the
+ * component's owner, which sets the targets, and before the component's own tick, which evaluates the pose; targets
+ * set during frame N are then solved and read during frame N. Chains whose components were not added are solved in
+ * the same tick group without that guarantee.
+ *
+ * Register and unregister chains from the game thread. Targets can be set and results read from any thread during the
+ * tick, as long as each chain is only touched by its owner. Batches never reallocate while the world ticks: a chain
+ * registered then into a full batch joins it at the start of the next frame, and until then its targets are ignored
+ * and it has no result.
+ */
+UCLASS()
+class UE4IKTEST_API UIKBatchSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/** Adds a chain with the given rest pose (root first). Bends at inner joints are limited to MaxBendDegrees, negative disables the limit. */
+	UFUNCTION(BlueprintCallable, Category = "IK")
+	FIKChainHandle RegisterChain(const TArray<FVector>& RestPose, float MaxBendDegrees = -1.0f);
+
+	/** Makes room for Count more chains of this shape, so registering them during the tick never has to wait a frame. */
+	UFUNCTION(BlueprintCallable, Category = "IK")
+	void ReserveChains(int32 NumJoints, int32 Count, float MaxBendDegrees = -1.0f);
+
+	/** Solves after the tick of AnimComponent's owner and before AnimComponent ticks and evaluates its pose. */
+	UFUNCTION(BlueprintCallable, Category = "IK")
+	void AddAnimComponent(UActorComponent* AnimComponent);
+
+	UFUNCTION(BlueprintCallable, Category = "IK")
+	void RemoveAnimComponent(UActorComponent* AnimComponent);
+
+	UFUNCTION(BlueprintCallable, Category = "IK")
+	void UnregisterChain(UPARAM(ref) FIKChainHandle& Handle);
+
+	/** Root and end effector target for the next solve, in the same space as the rest pose. */
+	UFUNCTION(BlueprintCallable, Category = "IK")
+	void SetChainTarget(const FIKChainHandle& Handle, const FVector& Root, const FVector& Target);
+
+	/** Joint positions from the last solve. Returns false for invalid handles and for chains still waiting for a slot. */
+	UFUNCTION(BlueprintCallable, Category = "IK")
+	bool GetChainResult(const FIKChainHandle& Handle, TArray<FVector>& Joints) const;
+
+	UFUNCTION(BlueprintCallable, Category = "IK")
+	void SetSolveSettings(const FIKSolveSettings& InSettings) { Settings = InSettings; }
+
+	UFUNCTION(BlueprintPure, Category = "IK")
+	int32 GetNumChains() const { return NumChains; }
+
+	/** Solves every batch now. Called automatically every frame by the solve tick function. */
+	void SolveAll();
+
+	const FIKSolveStats& GetLastStats() const { return LastStats; }
+
+private:
+	void OnWorldPreActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds);
+
+	void RegisterSolveTick();
+	bool IsWorldTicking() const;
+
+	bool IsLive(const FIKChainHandle& Handle) const;
+	int32 FindOrAddBatch(int32 NumJoints, float MaxBendDegrees);
+
+	/** Grows to at least MinCapacity slots, keeping every chain's joints. Game thread, outside the world tick. */
+	void GrowBatch(FIKChainBatch& Batch, int32 MinCapacity);
+
+	/** Gives pending chains their slots. Game thread, outside the world tick. */
+	void AddPendingChains(FIKChainBatch& Batch);
+
+	/** Fills an unused slot with a straight chain already at its target, so it converges without iterating. */
+	static void ParkSlot(FIKChainBatch& Batch, int32 Slot);
+
+	UPROPERTY()
+	FIKSolveSettings Settings;
+
+	TArray<TUniquePtr<FIKChainBatch>> Batches;
+	int32 NumChains = 0;
+
+	FIKSolveStats LastStats;
+
+	FIKBatchSolveTickFunction SolveTickFunction;
+
+	/** Components whose tick waits on SolveTickFunction. */
+	TArray<TWeakObjectPtr<UActorComponent>> AnimComponents;
+
+	FDelegateHandle PreActorTickHandle;
+};
@@ -0,0 +1,217 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "MultiChainIKSolver.h"
+#include "IKBatchSubsystem.h"
+
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+
+namespace
+{
+	/**
+	 * Solves NumChains arm-like chains against targets that drift a little every frame and logs
+	 * mean/max error, iterations per chain and time per frame for FABRIK and CCD, cold and warm started.
+	 */
+	void RunIKBenchmark(int32 NumChains, int32 NumJoints, int32 NumFrames)
+	{
+		const float BoneLength = 10.0f;
+		const float ChainLength = BoneLength * (NumJoints - 1);
+
+		TArray<FVector> RestPose;
+		for (int32 Joint = 0; Joint < NumJoints; ++Joint)
+		{
+			RestPose.Add(FVector(Joint * BoneLength, 0.0f, 0.0f));
+		}
+
+		for (EIKSolverType Solver : { EIKSolverType::FABRIK, EIKSolverType::CCD })
+		{
+			for (bool bWarmStart : { false, true })
+			{
+				FRandomStream Random(1234);
+
+				FMultiChainIKSolver IK;
+				IK.Init(NumChains, NumJoints);
+				for (int32 Chain = 0; Chain < NumChains; ++Chain)
+				{
+					IK.SetChain(Chain, RestPose.GetData());
+					for (int32 Joint = 1; Joint < NumJoints - 1; ++Joint)
+					{
+						IK.SetJointLimit(Joint, 120.0f);
+					}
+				}
+
+				TArray<FVector> Targets;
+				for (int32 Chain = 0; Chain < NumChains; ++Chain)
+				{
+					Targets.Add(Random.GetUnitVector() * Random.FRandRange(0.3f, 0.9f) * ChainLength);
+				}
+
+				FIKSolveSettings Settings;
+				Settings.Solver = Solver;
+				Settings.bWarmStart = bWarmStart;
+				Settings.MaxIterations = 20;
+				Settings.Tolerance = 0.01f;
+
+				double TotalSeconds = 0.0;
+				int64 TotalIterations = 0;
+				float MeanError = 0.0f;
+				float MaxError = 0.0f;
+
+				for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+				{
+					for (int32 Chain = 0; Chain < NumChains; ++Chain)
+					{
+						Targets[Chain] = (Targets[Chain] + Random.GetUnitVector() * 0.5f).GetClampedToMaxSize(0.95f * ChainLength);
+						IK.SetTarget(Chain, Targets[Chain]);
+					}
+
+					const double StartTime = FPlatformTime::Seconds();
+					const FIKSolveStats Stats = IK.Solve(Settings);
+					TotalSeconds += FPlatformTime::Seconds() - StartTime;
+
+					TotalIterations += Stats.Iterations;
+					MeanError += Stats.MeanError / NumFrames;
+					MaxError = FMath::Max(MaxError, Stats.MaxError);
+				}
+
+				const int32 NumGroups = FMath::DivideAndRoundUp(NumChains, FMultiChainIKSolver::LaneCount);
+				UE_LOG(LogTemp, Log, TEXT("IK Benchmark] %-6s %-4s chains: %5d  iterations/group: %5.2f  error mean: %.4f max: %.4f  time/frame: %8.3f us  time/chain: %6.3f us"),
+					Solver == EIKSolverType::FABRIK ? TEXT("FABRIK") : TEXT("CCD"),
+					bWarmStart ? TEXT("warm") : TEXT("cold"),
+					NumChains,
+					(double)TotalIterations / ((double)NumFrames * NumGroups),
+					MeanError,
+					MaxError,
+					TotalSeconds * 1e6 / NumFrames,
+					TotalSeconds * 1e6 / ((double)NumFrames * NumChains));
+			}
+		}
+	}
+
+	/**
+	 * Solves the five finger chains of NumHands hands per frame through the UIKBatchSubsystem of a temporary world and, for
+	 * comparison, with one solver per hand run one after the other, and logs the time per frame of both.
+	 */
+	void RunIKBatchBenchmark(int32 NumHands, int32 NumFrames)
+	{
+		const int32 NumFingers = 5;
+		const int32 NumJoints = 4;
+		const int32 NumChains = NumHands * NumFingers;
+		const float BoneLength = 3.0f;
+		const float ChainLength = BoneLength * (NumJoints - 1);
+
+		TArray<FVector> RestPose;
+		for (int32 Joint = 0; Joint < NumJoints; ++Joint)
+		{
+			RestPose.Add(FVector(Joint * BoneLength, 0.0f, 0.0f));
+		}
+
+		FIKSolveSettings Settings;
+		Settings.MaxIterations = 10;
+		Settings.Tolerance = 0.01f;
+
+		FRandomStream Random(1234);
+		TArray<FVector> Targets;
+		for (int32 Chain = 0; Chain < NumChains; ++Chain)
+		{
+			Targets.Add(Random.GetUnitVector() * Random.FRandRange(0.3f, 0.9f) * ChainLength);
+		}
+
+		// World subsystems need their world; a private one keeps the bench from touching the editor or game world.
+		UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("IKBatchBenchmark"));
+		UIKBatchSubsystem* Batch = World->GetSubsystem<UIKBatchSubsystem>();
+		if (Batch == nullptr)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("IK Benchmark] Could not create the IK batch subsystem."));
+			World->DestroyWorld(false);
+			return;
+		}
+		Batch->SetSolveSettings(Settings);
+		TArray<FIKChainHandle> Handles;
+		for (int32 Chain = 0; Chain < NumChains; ++Chain)
+		{
+			Handles.Add(Batch->RegisterChain(RestPose, 90.0f));
+		}
+
+		TArray<FMultiChainIKSolver> Hands;
+		Hands.SetNum(NumHands);
+		for (FMultiChainIKSolver& Hand : Hands)
+		{
+			Hand.Init(NumFingers, NumJoints);
+			for (int32 Finger = 0; Finger < NumFingers; ++Finger)
+			{
+				Hand.SetChain(Finger, RestPose.GetData());
+			}
+			for (int32 Joint = 1; Joint < NumJoints - 1; ++Joint)
+			{
+				Hand.SetJointLimit(Joint, 90.0f);
+			}
+		}
+
+		double BatchedSeconds = 0.0;
+		double SerialSeconds = 0.0;
+
+		for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+		{
+			for (int32 Chain = 0; Chain < NumChains; ++Chain)
+			{
+				Targets[Chain] = (Targets[Chain] + Random.GetUnitVector() * 0.2f).GetClampedToMaxSize(0.95f * ChainLength);
+				Batch->SetChainTarget(Handles[Chain], FVector::ZeroVector, Targets[Chain]);
+				Hands[Chain / NumFingers].SetTarget(Chain % NumFingers, Targets[Chain]);
+			}
+
+			// Same work as FIKBatchSolveTickFunction::ExecuteTick.
+			double StartTime = FPlatformTime::Seconds();
+			if (Batch->GetNumChains() > 0)
+			{
+				Batch->SolveAll();
+			}
+			BatchedSeconds += FPlatformTime::Seconds() - StartTime;
+
+			StartTime = FPlatformTime::Seconds();
+			for (FMultiChainIKSolver& Hand : Hands)
+			{
+				Hand.Solve(Settings);
+			}
+			SerialSeconds += FPlatformTime::Seconds() - StartTime;
+		}
+
+		World->DestroyWorld(false);
+
+		UE_LOG(LogTemp, Log, TEXT("IK Benchmark] hands: %3d  chains: %4d  batched: %8.3f us/frame  per hand: %8.3f us/frame  speedup: %5.2fx"),
+			NumHands,
+			NumChains,
+			BatchedSeconds * 1e6 / NumFrames,
+			SerialSeconds * 1e6 / NumFrames,
+			BatchedSeconds > 0.0 ? SerialSeconds / BatchedSeconds : 0.0);
+	}
+
+	FAutoConsoleCommand IKBenchmarkCommand(
+		TEXT("IK.Benchmark"),
+		TEXT("Benchmarks the multi-chain IK solver. Usage: IK.Benchmark [Joints=4] [Frames=200]"),
+		FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+		{
+			const int32 NumJoints = Args.Num() > 0 ? FMath::Max(2, FCString::Atoi(*Args[0])) : 4;
+			const int32 NumFrames = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 200;
+
+			for (int32 NumChains : { 2, 8, 32, 128, 512, 2048 })
+			{
+				RunIKBenchmark(NumChains, NumJoints, NumFrames);
+			}
+		}));
+
+	FAutoConsoleCommand IKBatchBenchmarkCommand(
+		TEXT("IK.BatchBenchmark"),
+		TEXT("Benchmarks UIKBatchSubsystem from 2 to 64 hands of five 4-joint fingers against one solver per hand. Usage: IK.BatchBenchmark [Frames=200]"),
+		FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+		{
+			const int32 NumFrames = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 200;
+
+			for (int32 NumHands : { 2, 4, 8, 16, 32, 64 })
+			{
+				RunIKBatchBenchmark(NumHands, NumFrames);
+			}
+		}));
+}
@@ -0,0 +1,423 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "MultiChainIKSolver.h"
+
+#include "Math/VectorRegister.h"
+
+namespace
+{
+	/** One joint of the four chains of a group. */
+	struct FLaneVector
+	{
+		VectorRegister X;
+		VectorRegister Y;
+		VectorRegister Z;
+	};
+
+	FORCEINLINE FLaneVector LoadLanes(const float* X, const float* Y, const float* Z, int32 Offset)
+	{
+		return { VectorLoadAligned(X + Offset), VectorLoadAligned(Y + Offset), VectorLoadAligned(Z + Offset) };
+	}
+
+	FORCEINLINE void StoreLanes(const FLaneVector& V, float* X, float* Y, float* Z, int32 Offset)
+	{
+		VectorStoreAligned(V.X, X + Offset);
+		VectorStoreAligned(V.Y, Y + Offset);
+		VectorStoreAligned(V.Z, Z + Offset);
+	}
+
+	FORCEINLINE FLaneVector Add(const FLaneVector& A, const FLaneVector& B)
+	{
+		return { VectorAdd(A.X, B.X), VectorAdd(A.Y, B.Y), VectorAdd(A.Z, B.Z) };
+	}
+
+	FORCEINLINE FLaneVector Sub(const FLaneVector& A, const FLaneVector& B)
+	{
+		return { VectorSubtract(A.X, B.X), VectorSubtract(A.Y, B.Y), VectorSubtract(A.Z, B.Z) };
+	}
+
+	FORCEINLINE FLaneVector Scale(const FLaneVector& A, const VectorRegister& S)
+	{
+		return { VectorMultiply(A.X, S), VectorMultiply(A.Y, S), VectorMultiply(A.Z, S) };
+	}
+
+	/** A + B * S */
+	FORCEINLINE FLaneVector MulAdd(const FLaneVector& A, const FLaneVector& B, const VectorRegister& S)
+	{
+		return { VectorMultiplyAdd(B.X, S, A.X), VectorMultiplyAdd(B.Y, S, A.Y), VectorMultiplyAdd(B.Z, S, A.Z) };
+	}
+
+	FORCEINLINE VectorRegister Dot(const FLaneVector& A, const FLaneVector& B)
+	{
+		return VectorMultiplyAdd(A.Z, B.Z, VectorMultiplyAdd(A.Y, B.Y, VectorMultiply(A.X, B.X)));
+	}
+
+	FORCEINLINE FLaneVector Cross(const FLaneVector& A, const FLaneVector& B)
+	{
+		return {
+			VectorSubtract(VectorMultiply(A.Y, B.Z), VectorMultiply(A.Z, B.Y)),
+			VectorSubtract(VectorMultiply(A.Z, B.X), VectorMultiply(A.X, B.Z)),
+			VectorSubtract(VectorMultiply(A.X, B.Y), VectorMultiply(A.Y, B.X))
+		};
+	}
+
+	FORCEINLINE FLaneVector Select(const VectorRegister& Mask, const FLaneVector& A, const FLaneVector& B)
+	{
+		return { VectorSelect(Mask, A.X, B.X), VectorSelect(Mask, A.Y, B.Y), VectorSelect(Mask, A.Z, B.Z) };
+	}
+
+	FORCEINLINE VectorRegister InvLength(const FLaneVector& V)
+	{
+		return VectorReciprocalSqrtAccurate(VectorMax(Dot(V, V), VectorSetFloat1(SMALL_NUMBER)));
+	}
+
+	/** Clamps unit direction Dir to a cone of the given cosine/sine around unit direction Parent. */
+	FORCEINLINE FLaneVector ClampToCone(const FLaneVector& Dir, const FLaneVector& Parent, const VectorRegister& Cos, const VectorRegister& Sin)
+	{
+		const VectorRegister CosAngle = Dot(Dir, Parent);
+		const VectorRegister OutsideMask = VectorCompareGT(Cos, CosAngle);
+
+		FLaneVector Perp = MulAdd(Dir, Parent, VectorNegate(CosAngle));
+		Perp = Scale(Perp, InvLength(Perp));
+
+		const FLaneVector Clamped = Add(Scale(Parent, Cos), Scale(Perp, Sin));
+		return Select(OutsideMask, Clamped, Dir);
+	}
+
+	/** Bitmask of lanes whose end effector is further than the tolerance from the target. */
+	FORCEINLINE int32 UnsolvedLanes(const FLaneVector& End, const FLaneVector& Target, const VectorRegister& ToleranceSquared, int32 ActiveLanes)
+	{
+		const FLaneVector Delta = Sub(Target, End);
+		return VectorMaskBits(VectorCompareGT(Dot(Delta, Delta), ToleranceSquared)) & ActiveLanes;
+	}
+}
+
+FMultiChainIKSolver::FMultiChainIKSolver()
+	: NumChains(0)
+	, NumJoints(0)
+	, NumGroups(0)
+	, bHasLimits(false)
+{
+}
+
+void FMultiChainIKSolver::Init(int32 InNumChains, int32 InNumJoints)
+{
+	check(InNumJoints >= 2);
+
+	NumChains = InNumChains;
+	NumJoints = InNumJoints;
+	NumGroups = FMath::DivideAndRoundUp(InNumChains, LaneCount);
+	bHasLimits = false;
+
+	const int32 JointLanes = NumGroups * NumJoints * LaneCount;
+	const int32 BoneLanes = NumGroups * (NumJoints - 1) * LaneCount;
+	const int32 GroupLanes = NumGroups * LaneCount;
+
+	for (FLaneArray* Array : { &X, &Y, &Z, &RestX, &RestY, &RestZ })
+	{
+		Array->SetNumZeroed(JointLanes);
+	}
+	Lengths.SetNumZeroed(BoneLanes);
+	for (FLaneArray* Array : { &RootX, &RootY, &RootZ, &TargetX, &TargetY, &TargetZ })
+	{
+		Array->SetNumZeroed(GroupLanes);
+	}
+
+	LimitCos.Init(-1.0f, NumJoints);
+	LimitSin.Init(0.0f, NumJoints);
+}
+
+void FMultiChainIKSolver::Resize(int32 InNumChains)
+{
+	check(NumJoints >= 2);
+
+	NumChains = InNumChains;
+	NumGroups = FMath::DivideAndRoundUp(InNumChains, LaneCount);
+
+	const int32 JointLanes = NumGroups * NumJoints * LaneCount;
+	const int32 BoneLanes = NumGroups * (NumJoints - 1) * LaneCount;
+	const int32 GroupLanes = NumGroups * LaneCount;
+
+	for (FLaneArray* Array : { &X, &Y, &Z, &RestX, &RestY, &RestZ })
+	{
+		Array->SetNumZeroed(JointLanes);
+	}
+	Lengths.SetNumZeroed(BoneLanes);
+	for (FLaneArray* Array : { &RootX, &RootY, &RootZ, &TargetX, &TargetY, &TargetZ })
+	{
+		Array->SetNumZeroed(GroupLanes);
+	}
+}
+
+void FMultiChainIKSolver::SetChain(int32 Chain, const FVector* Joints)
+{
+	check(Chain >= 0 && Chain < NumChains);
+
+	for (int32 Joint = 0; Joint < NumJoints; ++Joint)
+	{
+		const int32 Index = JointIndex(Chain, Joint);
+		X[Index] = RestX[Index] = Joints[Joint].X;
+		Y[Index] = RestY[Index] = Joints[Joint].Y;
+		Z[Index] = RestZ[Index] = Joints[Joint].Z;
+
+		if (Joint > 0)
+		{
+			Lengths[BoneIndex(Chain, Joint - 1)] = FVector::Dist(Joints[Joint - 1], Joints[Joint]);
+		}
+	}
+
+	SetRoot(Chain, Joints[0]);
+	SetTarget(Chain, Joints[NumJoints - 1]);
+}
+
+void FMultiChainIKSolver::SetRoot(int32 Chain, const FVector& Root)
+{
+	RootX[Chain] = Root.X;
+	RootY[Chain] = Root.Y;
+	RootZ[Chain] = Root.Z;
+}
+
+void FMultiChainIKSolver::SetTarget(int32 Chain, const FVector& Target)
+{
+	TargetX[Chain] = Target.X;
+	TargetY[Chain] = Target.Y;
+	TargetZ[Chain] = Target.Z;
+}
+
+void FMultiChainIKSolver::SetJointLimit(int32 Joint, float MaxBendDegrees)
+{
+	if (!LimitCos.IsValidIndex(Joint))
+	{
+		return;
+	}
+
+	const float Radians = FMath::DegreesToRadians(FMath::Clamp(MaxBendDegrees, 0.0f, 180.0f));
+	LimitCos[Joint] = MaxBendDegrees < 0.0f ? -1.0f : FMath::Cos(Radians);
+	LimitSin[Joint] = MaxBendDegrees < 0.0f ? 0.0f : FMath::Sin(Radians);
+
+	bHasLimits = false;
+	for (int32 Index = 1; Index < NumJoints - 1; ++Index)
+	{
+		bHasLimits |= LimitCos[Index] > -1.0f;
+	}
+}
+
+void FMultiChainIKSolver::ResetToRestPose()
+{
+	ResetChainsToRestPose(0, NumChains);
+}
+
+void FMultiChainIKSolver::ResetChainsToRestPose(int32 FirstChain, int32 EndChain)
+{
+	for (int32 Chain = FirstChain; Chain < EndChain; ++Chain)
+	{
+		const int32 RootIndex = JointIndex(Chain, 0);
+		const FVector Offset(RootX[Chain] - RestX[RootIndex], RootY[Chain] - RestY[RootIndex], RootZ[Chain] - RestZ[RootIndex]);
+
+		for (int32 Joint = 0; Joint < NumJoints; ++Joint)
+		{
+			const int32 Index = JointIndex(Chain, Joint);
+			X[Index] = RestX[Index] + Offset.X;
+			Y[Index] = RestY[Index] + Offset.Y;
+			Z[Index] = RestZ[Index] + Offset.Z;
+		}
+	}
+}
+
+FIKSolveStats FMultiChainIKSolver::Solve(const FIKSolveSettings& Settings)
+{
+	return SolveGroups(0, NumGroups, Settings);
+}
+
+FIKSolveStats FMultiChainIKSolver::SolveGroups(int32 FirstGroup, int32 Count, const FIKSolveSettings& Settings)
+{
+	FIKSolveStats Stats;
+
+	const int32 EndGroup = FMath::Min(FirstGroup + Count, NumGroups);
+	const int32 FirstChain = FirstGroup * LaneCount;
+	const int32 EndChain = FMath::Min(EndGroup * LaneCount, NumChains);
+
+	if (!Settings.bWarmStart)
+	{
+		ResetChainsToRestPose(FirstChain, EndChain);
+	}
+
+	for (int32 Group = FirstGroup; Group < EndGroup; ++Group)
+	{
+		switch (Settings.Solver)
+		{
+		case EIKSolverType::FABRIK: SolveGroupFABRIK(Group, Settings, Stats); break;
+		case EIKSolverType::CCD: SolveGroupCCD(Group, Settings, Stats); break;
+		}
+	}
+
+	for (int32 Chain = FirstChain; Chain < EndChain; ++Chain)
+	{
+		const float Error = FVector::Dist(GetEndEffector(Chain), FVector(TargetX[Chain], TargetY[Chain], TargetZ[Chain]));
+		Stats.MeanError += Error;
+		Stats.MaxError = FMath::Max(Stats.MaxError, Error);
+	}
+	Stats.MeanError = EndChain > FirstChain ? Stats.MeanError / (EndChain - FirstChain) : 0.0f;
+
+	return Stats;
+}
+
+void FMultiChainIKSolver::GetChain(int32 Chain, FVector* OutJoints) const
+{
+	for (int32 Joint = 0; Joint < NumJoints; ++Joint)
+	{
+		const int32 Index = JointIndex(Chain, Joint);
+		OutJoints[Joint] = FVector(X[Index], Y[Index], Z[Index]);
+	}
+}
+
+FVector FMultiChainIKSolver::GetEndEffector(int32 Chain) const
+{
+	const int32 Index = JointIndex(Chain, NumJoints - 1);
+	return FVector(X[Index], Y[Index], Z[Index]);
+}
+
+void FMultiChainIKSolver::SolveGroupFABRIK(int32 Group, const FIKSolveSettings& Settings, FIKSolveStats& Stats)
+{
+	const int32 ActiveLanes = (1 << FMath::Min(LaneCount, NumChains - Group * LaneCount)) - 1;
+	const int32 JointBase = Group * NumJoints * LaneCount;
+	const int32 BoneBase = Group * (NumJoints - 1) * LaneCount;
+	const int32 GroupBase = Group * LaneCount;
+	const int32 EndOffset = JointBase + (NumJoints - 1) * LaneCount;
+
+	const VectorRegister ToleranceSquared = VectorSetFloat1(Settings.Tolerance * Settings.Tolerance);
+	const FLaneVector Root = LoadLanes(RootX.GetData(), RootY.GetData(), RootZ.GetData(), GroupBase);
+	const FLaneVector Target = LoadLanes(TargetX.GetData(), TargetY.GetData(), TargetZ.GetData(), GroupBase);
+
+	float* PX = X.GetData();
+	float* PY = Y.GetData();
+	float* PZ = Z.GetData();
+
+	for (int32 Iteration = 0; Iteration < Settings.MaxIterations; ++Iteration)
+	{
+		if (UnsolvedLanes(LoadLanes(PX, PY, PZ, EndOffset), Target, ToleranceSquared, ActiveLanes) == 0)
+		{
+			break;
+		}
+		++Stats.Iterations;
+
+		// Backward: pin the tip to the target and pull every joint towards its child.
+		FLaneVector Child = Target;
+		StoreLanes(Child, PX, PY, PZ, EndOffset);
+		for (int32 Joint = NumJoints - 2; Joint >= 0; --Joint)
+		{
+			const int32 Offset = JointBase + Joint * LaneCount;
+			const VectorRegister Length = VectorLoadAligned(Lengths.GetData() + BoneBase + Joint * LaneCount);
+
+			const FLaneVector Delta = Sub(LoadLanes(PX, PY, PZ, Offset), Child);
+			Child = MulAdd(Child, Delta, VectorMultiply(Length, InvLength(Delta)));
+			StoreLanes(Child, PX, PY, PZ, Offset);
+		}
+
+		// Forward: pin the root and push every joint away from its parent, clamping bends to the limits.
+		StoreLanes(Root, PX, PY, PZ, JointBase);
+		ApplyLimitsForward(Group);
+	}
+}
+
+void FMultiChainIKSolver::SolveGroupCCD(int32 Group, const FIKSolveSettings& Settings, FIKSolveStats& Stats)
+{
+	const int32 ActiveLanes = (1 << FMath::Min(LaneCount, NumChains - Group * LaneCount)) - 1;
+	const int32 JointBase = Group * NumJoints * LaneCount;
+	const int32 GroupBase = Group * LaneCount;
+	const int32 EndOffset = JointBase + (NumJoints - 1) * LaneCount;
+
+	const VectorRegister ToleranceSquared = VectorSetFloat1(Settings.Tolerance * Settings.Tolerance);
+	const VectorRegister Two = VectorSetFloat1(2.0f);
+	const FLaneVector Target = LoadLanes(TargetX.GetData(), TargetY.GetData(), TargetZ.GetData(), GroupBase);
+
+	float* PX = X.GetData();
+	float* PY = Y.GetData();
+	float* PZ = Z.GetData();
+
+	// The root may have moved since the last solve; translate the whole chain with it.
+	{
+		const FLaneVector Root = LoadLanes(RootX.GetData(), RootY.GetData(), RootZ.GetData(), GroupBase);
+		const FLaneVector Shift = Sub(Root, LoadLanes(PX, PY, PZ, JointBase));
+		for (int32 Joint = 0; Joint < NumJoints; ++Joint)
+		{
+			const int32 Offset = JointBase + Joint * LaneCount;
+			StoreLanes(Add(LoadLanes(PX, PY, PZ, Offset), Shift), PX, PY, PZ, Offset);
+		}
+	}
+
+	for (int32 Iteration = 0; Iteration < Settings.MaxIterations; ++Iteration)
+	{
+		if (UnsolvedLanes(LoadLanes(PX, PY, PZ, EndOffset), Target, ToleranceSquared, ActiveLanes) == 0)
+		{
+			break;
+		}
+		++Stats.Iterations;
+
+		for (int32 Joint = NumJoints - 2; Joint >= 0; --Joint)
+		{
+			const int32 PivotOffset = JointBase + Joint * LaneCount;
+			const FLaneVector Pivot = LoadLanes(PX, PY, PZ, PivotOffset);
+
+			FLaneVector ToEnd = Sub(LoadLanes(PX, PY, PZ, EndOffset), Pivot);
+			FLaneVector ToTarget = Sub(Target, Pivot);
+			ToEnd = Scale(ToEnd, InvLength(ToEnd));
+			ToTarget = Scale(ToTarget, InvLength(ToTarget));
+
+			// Shortest-arc quaternion from ToEnd to ToTarget: (cross, 1 + dot), normalized.
+			FLaneVector Axis = Cross(ToEnd, ToTarget);
+			VectorRegister W = VectorAdd(VectorOne(), Dot(ToEnd, ToTarget));
+			const VectorRegister InvNorm = VectorReciprocalSqrtAccurate(VectorMax(VectorMultiplyAdd(W, W, Dot(Axis, Axis)), VectorSetFloat1(SMALL_NUMBER)));
+			Axis = Scale(Axis, InvNorm);
+			W = VectorMultiply(W, InvNorm);
+
+			// Rotate the sub-chain below the pivot: v' = v + w * t + axis x t, with t = 2 * (axis x v).
+			for (int32 Child = Joint + 1; Child < NumJoints; ++Child)
+			{
+				const int32 Offset = JointBase + Child * LaneCount;
+				const FLaneVector V = Sub(LoadLanes(PX, PY, PZ, Offset), Pivot);
+				const FLaneVector T = Scale(Cross(Axis, V), Two);
+				const FLaneVector Rotated = Add(MulAdd(V, T, W), Cross(Axis, T));
+				StoreLanes(Add(Pivot, Rotated), PX, PY, PZ, Offset);
+			}
+		}
+
+		if (bHasLimits)
+		{
+			ApplyLimitsForward(Group);
+		}
+	}
+}
+
+void FMultiChainIKSolver::ApplyLimitsForward(int32 Group)
+{
+	const int32 JointBase = Group * NumJoints * LaneCount;
+	const int32 BoneBase = Group * (NumJoints - 1) * LaneCount;
+
+	float* PX = X.GetData();
+	float* PY = Y.GetData();
+	float* PZ = Z.GetData();
+
+	FLaneVector Parent = LoadLanes(PX, PY, PZ, JointBase);
+	FLaneVector ParentDir = { VectorZero(), VectorZero(), VectorZero() };
+
+	for (int32 Joint = 1; Joint < NumJoints; ++Joint)
+	{
+		const int32 Offset = JointBase + Joint * LaneCount;
+		const VectorRegister Length = VectorLoadAligned(Lengths.GetData() + BoneBase + (Joint - 1) * LaneCount);
+
+		FLaneVector Dir = Sub(LoadLanes(PX, PY, PZ, Offset), Parent);
+		Dir = Scale(Dir, InvLength(Dir));
+
+		// The bend at the parent joint is the angle between the incoming and the outgoing bone.
+		const int32 LimitJoint = Joint - 1;
+		if (LimitJoint > 0 && LimitCos[LimitJoint] > -1.0f)
+		{
+			Dir = ClampToCone(Dir, ParentDir, VectorSetFloat1(LimitCos[LimitJoint]), VectorSetFloat1(LimitSin[LimitJoint]));
+		}
+
+		Parent = MulAdd(Parent, Dir, Length);
+		StoreLanes(Parent, PX, PY, PZ, Offset);
+		ParentDir = Dir;
+	}
+}
@@ -0,0 +1,123 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MultiChainIKSolver.generated.h"
+
+UENUM(BlueprintType)
+enum class EIKSolverType : uint8
+{
+	FABRIK,
+	CCD,
+};
+
+USTRUCT(BlueprintType)
+struct UE4IKTEST_API FIKSolveSettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "IK")
+	EIKSolverType Solver = EIKSolverType::FABRIK;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "IK", meta = (ClampMin = "1"))
+	int32 MaxIterations = 10;
+
+	/** Distance between end effector and target below which a chain is considered solved. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "IK", meta = (ClampMin = "0"))
+	float Tolerance = 0.1f;
+
+	/** Start from the previous solution instead of the rest pose. Converges in far fewer iterations for smooth targets. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "IK")
+	bool bWarmStart = true;
+};
+
+struct UE4IKTEST_API FIKSolveStats
+{
+	/** Iterations summed over all SIMD groups. */
+	int32 Iterations = 0;
+	float MeanError = 0.0f;
+	float MaxError = 0.0f;
+};
+
+/**
+ * Solves many IK chains of the same joint count at once.
+ *
+ * Chains are packed four to a group and stored as structure-of-arrays, so every step of FABRIK and CCD works on one
+ * joint of four chains with a single VectorRegister operation. Joint positions persist between solves, which makes the
+ * previous frame's solution the warm start for the next one.
+ */
+class UE4IKTEST_API FMultiChainIKSolver
+{
+public:
+	static constexpr int32 LaneCount = 4;
+
+	FMultiChainIKSolver();
+
+	/** Allocates NumChains chains of NumJoints joints (NumJoints - 1 bones). */
+	void Init(int32 InNumChains, int32 InNumJoints);
+
+	/**
+	 * Changes the chain count keeping the data of every chain that remains, joint limits included. Chains are laid out
+	 * group after group, so growing only appends zeroed chains; call SetChain for them before solving.
+	 */
+	void Resize(int32 InNumChains);
+
+	/** Sets the rest pose of a chain; bone lengths are taken from it and joint 0 becomes the root. */
+	void SetChain(int32 Chain, const FVector* Joints);
+
+	void SetRoot(int32 Chain, const FVector& Root);
+	void SetTarget(int32 Chain, const FVector& Target);
+
+	/** Limits the bend at a joint (angle between its incoming and outgoing bone) for all chains. Negative disables the limit. */
+	void SetJointLimit(int32 Joint, float MaxBendDegrees);
+
+	/** Moves every chain back to its rest pose, translated to its current root. */
+	void ResetToRestPose();
+
+	FIKSolveStats Solve(const FIKSolveSettings& Settings);
+
+	/**
+	 * Solves only the SIMD groups [FirstGroup, FirstGroup + Count). Groups share no state, so disjoint ranges can be
+	 * solved concurrently from different threads.
+	 */
+	FIKSolveStats SolveGroups(int32 FirstGroup, int32 Count, const FIKSolveSettings& Settings);
+
+	void GetChain(int32 Chain, FVector* OutJoints) const;
+	FVector GetRoot(int32 Chain) const { return FVector(RootX[Chain], RootY[Chain], RootZ[Chain]); }
+	FVector GetTarget(int32 Chain) const { return FVector(TargetX[Chain], TargetY[Chain], TargetZ[Chain]); }
+	FVector GetEndEffector(int32 Chain) const;
+
+	int32 GetNumChains() const { return NumChains; }
+	int32 GetNumJoints() const { return NumJoints; }
+	int32 GetNumGroups() const { return NumGroups; }
+
+private:
+	typedef TArray<float, TAlignedHeapAllocator<16>> FLaneArray;
+
+	int32 JointIndex(int32 Chain, int32 Joint) const { return ((Chain / LaneCount) * NumJoints + Joint) * LaneCount + Chain % LaneCount; }
+	int32 BoneIndex(int32 Chain, int32 Bone) const { return ((Chain / LaneCount) * (NumJoints - 1) + Bone) * LaneCount + Chain % LaneCount; }
+
+	void SolveGroupFABRIK(int32 Group, const FIKSolveSettings& Settings, FIKSolveStats& Stats);
+	void SolveGroupCCD(int32 Group, const FIKSolveSettings& Settings, FIKSolveStats& Stats);
+
+	void ResetChainsToRestPose(int32 FirstChain, int32 EndChain);
+
+	/** Re-places joints root to tip, keeping bone lengths and clamping bends to the joint limits. */
+	void ApplyLimitsForward(int32 Group);
+
+	int32 NumChains;
+	int32 NumJoints;
+	int32 NumGroups;
+	bool bHasLimits;
+
+	FLaneArray X, Y, Z;
+	FLaneArray RestX, RestY, RestZ;
+	FLaneArray Lengths;
+	FLaneArray RootX, RootY, RootZ;
+	FLaneArray TargetX, TargetY, TargetZ;
+
+	/** Cosine and sine of the bend limit per joint. */
+	TArray<float> LimitCos;
+	TArray<float> LimitSin;
+};
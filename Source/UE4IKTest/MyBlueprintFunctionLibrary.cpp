@@ -3,3 +3,42 @@
 
 #include "MyBlueprintFunctionLibrary.h"
 
+#include "Components/PoseableMeshComponent.h"
+
+FHandFKRigDesc UMyBlueprintFunctionLibrary::GetDefaultHandFKRigDesc(EHandFKSkeleton Skeleton, bool bRightHand)
+{
+	return FHandFKSolver::GetDefaultRigDesc(Skeleton, bRightHand);
+}
+
+bool UMyBlueprintFunctionLibrary::MakeHandFKRig(USkinnedMeshComponent* Mesh, const FHandFKRigDesc& Desc, FHandFKRig& Rig)
+{
+	return FHandFKSolver::BuildRig(Mesh, Desc, Rig);
+}
+
+void UMyBlueprintFunctionLibrary::SolveHandFK(const FHandFKRig& Rig, const TArray<float>& JointDegrees, TArray<FTransform>& ComponentTransforms)
+{
+	FHandFKSolver::Solve(Rig, JointDegrees.GetData(), JointDegrees.Num(), ComponentTransforms);
+}
+
+void UMyBlueprintFunctionLibrary::ApplyHandFK(UPoseableMeshComponent* Mesh, const FHandFKRig& Rig, const TArray<float>& JointDegrees)
+{
+	if (Mesh == nullptr || !Rig.IsValid())
+	{
+		return;
+	}
+
+	TArray<FTransform> ComponentTransforms;
+	TArray<FTransform> LocalTransforms;
+	FHandFKSolver::Solve(Rig, JointDegrees.GetData(), JointDegrees.Num(), ComponentTransforms, &LocalTransforms);
+
+	for (int32 Slot = 0; Slot < Rig.Num(); ++Slot)
+	{
+		const int32 BoneIndex = Rig.BoneIndices[Slot];
+		if (Mesh->BoneSpaceTransforms.IsValidIndex(BoneIndex))
+		{
+			Mesh->BoneSpaceTransforms[BoneIndex] = LocalTransforms[Slot];
+		}
+	}
+
+	Mesh->MarkRefreshTransformDirty();
+}
@@ -4,8 +4,12 @@
 
 #include "CoreMinimal.h"
 #include "Kismet/BlueprintFunctionLibrary.h"
+#include "HandFKSolver.h"
 #include "MyBlueprintFunctionLibrary.generated.h"
 
+class USkinnedMeshComponent;
+class UPoseableMeshComponent;
+
 /**
  * 
  */
@@ -13,5 +17,21 @@ UCLASS()
 class UE4IKTEST_API UMyBlueprintFunctionLibrary : public UBlueprintFunctionLibrary
 {
 	GENERATED_BODY()
-	
+
+public:
+	/** Default joint-to-bone mapping for Rigged_Hand / Real_Hand. */
+	UFUNCTION(BlueprintPure, Category = "HandFK")
+	static FHandFKRigDesc GetDefaultHandFKRigDesc(EHandFKSkeleton Skeleton, bool bRightHand);
+
+	/** Caches the bind pose of Mesh for the given mapping. Build once (e.g. on BeginPlay) and reuse every frame. */
+	UFUNCTION(BlueprintCallable, Category = "HandFK")
+	static bool MakeHandFKRig(USkinnedMeshComponent* Mesh, const FHandFKRigDesc& Desc, FHandFKRig& Rig);
+
+	/** Converts the 15 joint degrees (GetJointDegreeArray) into component-space transforms, one per rig bone. */
+	UFUNCTION(BlueprintPure, Category = "HandFK")
+	static void SolveHandFK(const FHandFKRig& Rig, const TArray<float>& JointDegrees, TArray<FTransform>& ComponentTransforms);
+
+	/** Solves the rig and writes every finger bone of Mesh in one batch. */
+	UFUNCTION(BlueprintCallable, Category = "HandFK")
+	static void ApplyHandFK(UPoseableMeshComponent* Mesh, const FHandFKRig& Rig, const TArray<float>& JointDegrees);
 };
@@ -9,6 +9,6 @@ public class UE4IKTestEditorTarget : TargetRules
 	{
 		Type = TargetType.Editor;
 
-		ExtraModuleNames.AddRange( new string[] { "UE4IKTest" } );
+		ExtraModuleNames.AddRange( new string[] { "UE4IKTest", "HandAnimation", "HandAnimationEditor" } );
 	}
 }